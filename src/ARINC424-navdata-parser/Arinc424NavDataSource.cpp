@@ -0,0 +1,408 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include "Arinc424NavDataSource.h"
+#include "../Logger.h"
+
+const std::size_t READ_BLOCK_SIZE = 1 << 20;
+const double METERS_PER_FOOT = 0.3048;
+
+// columns are 1-based, as in the ARINC 424 specification
+static std::string_view field(std::string_view record, std::size_t column, std::size_t length)
+{
+	if (column > record.size())
+		return std::string_view();
+
+	return record.substr(column - 1, length);
+}
+
+static std::string_view trim(std::string_view text)
+{
+	std::size_t first = text.find_first_not_of(' ');
+	if (first == std::string_view::npos)
+		return std::string_view();
+
+	return text.substr(first, text.find_last_not_of(' ') - first + 1);
+}
+
+static void assign_field(std::string& target, std::string_view record, std::size_t column, std::size_t length)
+{
+	std::string_view text = trim(field(record, column, length));
+	target.assign(text.data(), text.size());
+}
+
+// signed decimal field. blank or invalid digits: 0
+static int int_field(std::string_view record, std::size_t column, std::size_t length)
+{
+	std::string_view text = trim(field(record, column, length));
+	int sign = 1;
+	if (!text.empty() && (text[0] == '-' || text[0] == '+'))
+	{
+		sign = (text[0] == '-') ? -1 : 1;
+		text.remove_prefix(1);
+	}
+
+	int value = 0;
+	for (char c : text)
+	{
+		if (c < '0' || c > '9')
+			return 0;
+		value = value * 10 + (c - '0');
+	}
+	return sign * value;
+}
+
+static int digits(std::string_view text, std::size_t pos, std::size_t count, bool& valid)
+{
+	int value = 0;
+	for (std::size_t i = pos; i < pos + count; i++)
+	{
+		if (text[i] < '0' || text[i] > '9')
+		{
+			valid = false;
+			return 0;
+		}
+		value = value * 10 + (text[i] - '0');
+	}
+	return value;
+}
+
+static bool decode_angle(std::string_view text, std::size_t degree_digits, char positive, char negative, double& angle)
+{
+	if (text.size() < 7 + degree_digits || (text[0] != positive && text[0] != negative))
+		return false;
+
+	bool valid = true;
+	int degrees = digits(text, 1, degree_digits, valid);
+	int minutes = digits(text, 1 + degree_digits, 2, valid);
+	int centiseconds = digits(text, 3 + degree_digits, 4, valid);
+	if (!valid)
+		return false;
+
+	angle = degrees + minutes / 60.0 + centiseconds / 360000.0;
+	if (text[0] == negative)
+		angle = -angle;
+	return true;
+}
+
+bool Arinc424NavDataSource::decode_latitude(std::string_view field, double& lat)
+{
+	return decode_angle(field, 2, 'N', 'S', lat);
+}
+
+bool Arinc424NavDataSource::decode_longitude(std::string_view field, double& lng)
+{
+	return decode_angle(field, 3, 'E', 'W', lng);
+}
+
+// "E0030": 3.0 degrees east. "T" (true north aligned) and blank: 0
+static double magnetic_variation_field(std::string_view record, std::size_t column)
+{
+	std::string_view text = field(record, column, 5);
+	if (text.size() < 5 || (text[0] != 'E' && text[0] != 'W'))
+		return 0;
+
+	double variation = int_field(record, column + 1, 4) / 10.0;
+	return text[0] == 'W' ? -variation : variation;
+}
+
+// continuation record number: "0" or "1" is the primary record
+static bool is_primary_record(std::string_view record, std::size_t column)
+{
+	std::string_view text = field(record, column, 1);
+	return text.size() == 1 && (text[0] == '0' || text[0] == '1');
+}
+
+Arinc424NavDataSource::Arinc424NavDataSource(std::string _file_path) :
+	file_path(std::move(_file_path)), bytes_read(0), record_count(0)
+{
+
+}
+
+void Arinc424NavDataSource::decode_vhf_navaid(std::string_view record, NavDataSink& sink)
+{
+	//SEEUD        PTB   LH111710VDHW N47090800E018443200PTB N47090800E018443200E005000430      WGEPUSZTASZABOLCS
+	//1234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890
+	//         1         2         3         4         5         6         7         8         9
+	if (!is_primary_record(record, 22))
+		return;
+
+	bool has_vor = (field(record, 28, 1) == "V");
+	std::string_view dme_class = field(record, 29, 1);
+
+	// a DME only station has no VOR position
+	if (!decode_latitude(field(record, 33, 9), nav_point.lat) || !decode_longitude(field(record, 42, 10), nav_point.lng))
+	{
+		if (!decode_latitude(field(record, 56, 9), nav_point.lat) || !decode_longitude(field(record, 65, 10), nav_point.lng))
+			return;
+	}
+
+	if (has_vor)
+	{
+		if (dme_class == "D")
+			nav_point.radio_type = NavPoint::VOR_DME;
+		else if (dme_class == "T" || dme_class == "M")
+			nav_point.radio_type = NavPoint::VORTAC;
+		else
+			nav_point.radio_type = NavPoint::VOR;
+	}
+	else
+		nav_point.radio_type = NavPoint::DME;
+
+	assign_field(nav_point.icao_id, record, 14, 4);
+	assign_field(nav_point.icao_region, record, 20, 2);
+	assign_field(nav_point.name, record, 94, 30);
+	nav_point.radio_frequency = int_field(record, 23, 5);
+	nav_point.magnetic_variation = magnetic_variation_field(record, 75);
+	nav_point.elevation = int_field(record, 80, 5);
+	sink.add_nav_point(nav_point);
+	record_count++;
+}
+
+void Arinc424NavDataSource::decode_ndb(std::string_view record, NavDataSink& sink)
+{
+	if (!is_primary_record(record, 22))
+		return;
+
+	if (!decode_latitude(field(record, 33, 9), nav_point.lat) || !decode_longitude(field(record, 42, 10), nav_point.lng))
+		return;
+
+	assign_field(nav_point.icao_id, record, 14, 4);
+	assign_field(nav_point.icao_region, record, 20, 2);
+	assign_field(nav_point.name, record, 94, 30);
+	nav_point.radio_type = NavPoint::NDB;
+	nav_point.radio_frequency = int_field(record, 23, 5) / 10; // tenths of kHz
+	nav_point.magnetic_variation = magnetic_variation_field(record, 75);
+	nav_point.elevation = 0;
+	sink.add_nav_point(nav_point);
+	record_count++;
+}
+
+void Arinc424NavDataSource::decode_waypoint(std::string_view record, NavDataSink& sink)
+{
+	if (!is_primary_record(record, 22))
+		return;
+
+	if (!decode_latitude(field(record, 33, 9), nav_point.lat) || !decode_longitude(field(record, 42, 10), nav_point.lng))
+		return;
+
+	assign_field(nav_point.icao_id, record, 14, 5);
+	assign_field(nav_point.icao_region, record, 20, 2);
+	assign_field(nav_point.name, record, 99, 25);
+	nav_point.radio_type = NavPoint::NONE;
+	nav_point.radio_frequency = 0;
+	nav_point.magnetic_variation = magnetic_variation_field(record, 75);
+	nav_point.elevation = 0;
+	sink.add_nav_point(nav_point);
+	record_count++;
+}
+
+void Arinc424NavDataSource::decode_airport(std::string_view record, NavDataSink& sink)
+{
+	if (!is_primary_record(record, 22))
+		return;
+
+	assign_field(airport.icao_id, record, 7, 4);
+	assign_field(airport.icao_region, record, 11, 2);
+	assign_field(airport.iata_id, record, 14, 3);
+	assign_field(airport.name, record, 94, 30);
+	airport.has_position = decode_latitude(field(record, 33, 9), airport.lat) && decode_longitude(field(record, 42, 10), airport.lng);
+	airport.elevation = int_field(record, 57, 5);
+	airport.has_magnetic_variation = true;
+	airport.magnetic_variation = magnetic_variation_field(record, 52);
+	airport.transition_alt = int_field(record, 72, 5);
+	sink.add_airport(airport);
+	record_count++;
+}
+
+void Arinc424NavDataSource::decode_runway(std::string_view record, NavDataSink& sink)
+{
+	if (!is_primary_record(record, 22))
+		return;
+
+	//SEEUP LHBPLHGRW13L   0121621311 N47264300E019132200               00496000050148 IBPL2
+	//1234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890
+	//         1         2         3         4         5         6         7         8         9
+	std::string_view runway_id = trim(field(record, 14, 5));
+	if (runway_id.size() < 4 || runway_id.substr(0, 2) != "RW")
+		return;
+
+	assign_field(runway.airport_icao_id, record, 7, 4);
+	runway.name.assign(runway_id.data() + 2, runway_id.size() - 2);
+	runway.length = (int)(int_field(record, 23, 5) * METERS_PER_FOOT);
+	runway.course = int_field(record, 28, 4) / 10; // magnetic bearing in tenths of degrees
+	runway.width = (int)(int_field(record, 78, 3) * METERS_PER_FOOT);
+	runway.ils_freq = 0;
+	runway.has_threshold = decode_latitude(field(record, 33, 9), runway.threshold_lat) && decode_longitude(field(record, 42, 10), runway.threshold_lng);
+	runway.threshold_elevation = int_field(record, 67, 5);
+	assign_field(runway.localizer_id, record, 82, 4);
+	sink.add_runway(runway);
+	record_count++;
+}
+
+void Arinc424NavDataSource::decode_procedure_leg(std::string_view record, RNAVProc::RNAVProcType proc_type, NavDataSink& sink)
+{
+	//SEEUP LHBPLHDBADO2B5RW13L 010BP701LHPC0E       DF
+	//1234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890
+	//         1         2         3         4         5         6         7         8         9
+	if (!is_primary_record(record, 39))
+		return;
+
+	std::string_view proc_id = trim(field(record, 14, 6));
+	std::string_view transition = trim(field(record, 21, 5));
+	if (proc_type == RNAVProc::RNAVProcType::RNAV_APPROACH)
+	{
+		if (field(record, 20, 1) != "A")
+			return;
+
+		leg.proc_name.assign(proc_id.data(), proc_id.size());
+		leg.proc_name += "-";
+		leg.proc_name.append(transition.data(), transition.size());
+	}
+	else
+		leg.proc_name.assign(proc_id.data(), proc_id.size());
+
+	leg.proc_type = proc_type;
+	assign_field(leg.airport_icao_id, record, 7, 4);
+	leg.transition.assign(transition.data(), transition.size());
+	leg.sequence = int_field(record, 27, 3);
+	assign_field(leg.fix_icao_id, record, 30, 5);
+	assign_field(leg.fix_icao_region, record, 35, 2);
+
+	ProcedureLeg& details = leg.details;
+	details = ProcedureLeg();
+	details.path_terminator = ProcedureLeg::parse_path_terminator(field(record, 48, 2));
+	assign_field(details.recommended_navaid_id, record, 51, 4);
+	assign_field(details.recommended_navaid_region, record, 55, 2);
+	bool course_is_time = false;
+	details.course = ProcedureLeg::parse_tenths(field(record, 71, 4), course_is_time);
+	details.distance = ProcedureLeg::parse_tenths(field(record, 75, 4), details.distance_is_time);
+	std::string_view altitude1 = trim(field(record, 85, 5));
+	details.altitude1 = ProcedureLeg::parse_altitude(altitude1);
+	details.altitude2 = ProcedureLeg::parse_altitude(field(record, 90, 5));
+	std::string_view altitude_description = field(record, 83, 1);
+	details.altitude_constraint = ProcedureLeg::parse_altitude_constraint(altitude_description.empty() ? ' ' : altitude_description[0], !altitude1.empty());
+	details.speed_limit = int_field(record, 100, 3);
+	std::string_view speed_description = field(record, 118, 1);
+	details.speed_constraint = ProcedureLeg::parse_speed_constraint(speed_description.empty() ? ' ' : speed_description[0], details.speed_limit > 0);
+	sink.add_procedure_leg(leg);
+	record_count++;
+}
+
+void Arinc424NavDataSource::decode_record(std::string_view record, NavDataSink& sink)
+{
+	// header records ("HDR") and too short lines
+	if (record.size() < 40 || (record[0] != 'S' && record[0] != 'T'))
+		return;
+
+	// section code in column 5, the subsection is in column 6 or (airport section) in column 13
+	switch (record[4])
+	{
+	case 'D':
+		if (record[5] == ' ')
+			decode_vhf_navaid(record, sink);
+		else if (record[5] == 'B')
+			decode_ndb(record, sink);
+		break;
+	case 'E':
+		if (record[5] == 'A')
+			decode_waypoint(record, sink);
+		break;
+	case 'P':
+		switch (record[12])
+		{
+		case 'A':
+			decode_airport(record, sink);
+			break;
+		case 'C':
+			decode_waypoint(record, sink);
+			break;
+		case 'D':
+			decode_procedure_leg(record, RNAVProc::RNAVProcType::RNAV_SID, sink);
+			break;
+		case 'E':
+			decode_procedure_leg(record, RNAVProc::RNAVProcType::RNAV_STAR, sink);
+			break;
+		case 'F':
+			decode_procedure_leg(record, RNAVProc::RNAVProcType::RNAV_APPROACH, sink);
+			break;
+		case 'G':
+			decode_runway(record, sink);
+			break;
+		case 'N':
+			decode_ndb(record, sink);
+			break;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+bool Arinc424NavDataSource::read(NavDataSink& sink)
+{
+	bytes_read = 0;
+	record_count = 0;
+
+	std::ifstream i_str(file_path, std::ios::binary);
+	if (!i_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "Arinc424NavDataSource: can't open file for read: " << file_path << std::endl;
+		return false;
+	}
+
+	// the records are decoded from the read buffer. the partial record at the end of a block is moved to the front
+	std::vector<char> buffer(READ_BLOCK_SIZE);
+	std::size_t carried = 0;
+	while (true)
+	{
+		i_str.read(buffer.data() + carried, buffer.size() - carried);
+		std::size_t filled = carried + (std::size_t)i_str.gcount();
+		bytes_read += (std::uintmax_t)i_str.gcount();
+		bool end_of_file = (i_str.gcount() == 0);
+
+		std::size_t line_start = 0;
+		while (line_start < filled)
+		{
+			const char* line_end = (const char*)memchr(buffer.data() + line_start, '\n', filled - line_start);
+			if (line_end == NULL && !end_of_file)
+				break;
+
+			std::size_t line_length = (line_end != NULL ? line_end - buffer.data() : filled) - line_start;
+			std::string_view record(buffer.data() + line_start, line_length);
+			if (!record.empty() && record.back() == '\r')
+				record.remove_suffix(1);
+
+			decode_record(record, sink);
+			line_start += line_length + 1;
+		}
+
+		if (end_of_file)
+			break;
+
+		carried = filled - line_start;
+		memmove(buffer.data(), buffer.data() + line_start, carried);
+		// a line longer than the whole buffer is not a record
+		if (carried == buffer.size())
+			carried = 0;
+	}
+
+	return true;
+}
+
+std::uintmax_t Arinc424NavDataSource::get_bytes_read() const
+{
+	return bytes_read;
+}
+
+std::size_t Arinc424NavDataSource::get_record_count() const
+{
+	return record_count;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "../NavDataSource.h"
+
+/* Raw ARINC 424 file (132 column records) as a streaming source. The file is read in large
+   blocks and the fixed-column fields are decoded in place: no regex and no copy of the lines.
+   Only the primary records are decoded, the continuation records are skipped:
+     D      VHF navaids (VOR, VOR/DME, VORTAC, DME)
+     DB PN  enroute and terminal NDBs
+     EA PC  enroute and terminal waypoints
+     PA     airport reference points
+     PG     runways
+     PD PE PF  SID, STAR and approach legs. Like the X-Plane CIFP reader, only the approach
+               transitions are kept, each as a separate procedure "<approach>-<transition>".
+   The records of a standard file are sorted by section, so the nav points arrive before
+   the procedure legs which refer to them. */
+class Arinc424NavDataSource : public NavDataSource {
+private:
+	std::string file_path;
+	std::uintmax_t bytes_read;
+	std::size_t record_count;
+	// reused for every record: the strings keep their capacity
+	NavPointRecord nav_point;
+	AirportRecord airport;
+	RunwayRecord runway;
+	ProcedureLegRecord leg;
+	void decode_record(std::string_view record, NavDataSink& sink);
+	void decode_vhf_navaid(std::string_view record, NavDataSink& sink);
+	void decode_ndb(std::string_view record, NavDataSink& sink);
+	void decode_waypoint(std::string_view record, NavDataSink& sink);
+	void decode_airport(std::string_view record, NavDataSink& sink);
+	void decode_runway(std::string_view record, NavDataSink& sink);
+	void decode_procedure_leg(std::string_view record, RNAVProc::RNAVProcType proc_type, NavDataSink& sink);
+public:
+	Arinc424NavDataSource(std::string _file_path);
+	bool read(NavDataSink& sink) override;
+	std::uintmax_t get_bytes_read() const override;
+	// number of the decoded records of the last read
+	std::size_t get_record_count() const;
+	// "N47264352" and "E019152718": hemisphere, degrees, minutes, seconds and hundredths of seconds
+	static bool decode_latitude(std::string_view field, double& lat);
+	static bool decode_longitude(std::string_view field, double& lng);
+};
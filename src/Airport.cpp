@@ -7,32 +7,32 @@
 #include "Logger.h"
 
 Runway::Runway(std::string _name, int _course, int _ils_freq, int _length, int _width) :
-    name(_name), course(_course), ils_freq(_ils_freq), length(_length), width(_width)
+    name(std::move(_name)), course(_course), ils_freq(_ils_freq), length(_length), width(_width)
 {
 
 }
 
-std::string Runway::get_name()
+const std::string& Runway::get_name() const
 {
     return name;
 }
 
-int Runway::get_course()
+int Runway::get_course() const
 {
     return course;
 }
 
-int Runway::get_ils_freq()
+int Runway::get_ils_freq() const
 {
     return ils_freq;
 }
 
-int Runway::get_length()
+int Runway::get_length() const
 {
     return length;
 }
 
-int Runway::get_width()
+int Runway::get_width() const
 {
     return width;
 }
@@ -58,9 +58,61 @@ void Runway::set_width(int _width)
     width = _width;
 }
 
+bool Runway::has_threshold() const
+{
+    return threshold_known;
+}
+
+const Coordinate& Runway::get_threshold() const
+{
+    return threshold;
+}
+
+void Runway::set_threshold(Coordinate _threshold)
+{
+    threshold = _threshold;
+    threshold_known = true;
+}
+
+bool Runway::has_true_heading() const
+{
+    return true_heading_known;
+}
+
+double Runway::get_true_heading() const
+{
+    return true_heading;
+}
+
+void Runway::set_true_heading(double _true_heading)
+{
+    true_heading = _true_heading;
+    true_heading_known = true;
+}
+
+int Runway::get_threshold_elevation() const
+{
+    return threshold_elevation;
+}
+
+void Runway::set_threshold_elevation(int _threshold_elevation)
+{
+    threshold_elevation = _threshold_elevation;
+}
+
+const std::string& Runway::get_localizer_id() const
+{
+    return localizer_id;
+}
+
+void Runway::set_localizer_id(std::string _localizer_id)
+{
+    localizer_id = std::move(_localizer_id);
+}
+
 
 Airport::Airport(std::string _name, std::string _icao_region, Coordinate _coordinate, double _magnetic_variation) :
-    NavPoint(_coordinate, _name, _icao_region, _magnetic_variation)
+    NavPoint(_coordinate, std::move(_name), std::move(_icao_region), _magnetic_variation)
 {
     transition_alt = 0;
     Logger(TLogLevel::logTRACE) << "Airport created" << icao_id << std::endl;
@@ -72,39 +124,18 @@ Airport::Airport():
     transition_alt = 0;
 }
 
-Airport& Airport::operator=(const Airport& other)
-{
-    coordinate = other.coordinate;
-    icao_id = other.icao_id;
-    icao_region = other.icao_region;
-    magnetic_variation = other.magnetic_variation;
-    name = other.name;
-    iata_id = other.iata_id;
-    city = other.city;
-    country = other.country;
-    state = other.state;
-    transition_alt = other.transition_alt;
-
-    for (auto rwy : other.runways)
-    {
-        add_runway(rwy.get_name(),rwy.get_course(),rwy.get_ils_freq(),rwy.get_length(), rwy.get_width());
-    }
-
-    return *this;
-}
-
 void Airport::add_runway(std::string _name, int _course, int _ils_freq, int _length, int _width)
 {
     Logger(TLogLevel::logTRACE) << "Airport " << icao_id << " add new runway: " << _name << std::endl;
-    runways.emplace_back(_name, _course, _ils_freq, _length, _width);
+    runways.emplace_back(std::move(_name), _course, _ils_freq, _length, _width);
 }
 
-std::list<Runway> Airport::get_runways()
+const std::list<Runway>& Airport::get_runways() const
 {
     return runways;
 }
 
-Runway* Airport::get_runway_by_name(std::string rwy_name)
+Runway* Airport::get_runway_by_name(const std::string& rwy_name)
 {
     for (auto& rwy : runways)
     {
@@ -114,47 +145,72 @@ Runway* Airport::get_runway_by_name(std::string rwy_name)
     return NULL;
 }
 
-std::string Airport::get_iata_id()
+const Runway* Airport::get_runway_by_name(const std::string& rwy_name) const
+{
+    for (auto& rwy : runways)
+    {
+        if (rwy.get_name() == rwy_name)
+            return &rwy;
+    }
+    return NULL;
+}
+
+const std::string& Airport::get_iata_id() const
 {
     return iata_id;
 }
 
 void Airport::set_iata_id(std::string _iata_id)
 {
-    iata_id = _iata_id;
+    iata_id = std::move(_iata_id);
 }
 
-std::string Airport::get_city()
+const std::string& Airport::get_city() const
 {
-    return city;
+    return city.str();
 }
 
 void Airport::set_city(std::string _city)
 {
-    city = _city;
+    city = InternedString(_city);
+}
+
+void Airport::set_city(InternedString _city)
+{
+    city = std::move(_city);
 }
 
-std::string Airport::get_country()
+const std::string& Airport::get_country() const
 {
-    return country;
+    return country.str();
 }
 
 void Airport::set_country(std::string _country)
 {
-    country = _country;
+    country = InternedString(_country);
 }
 
-std::string Airport::get_state()
+void Airport::set_country(InternedString _country)
 {
-    return state;
+    country = std::move(_country);
+}
+
+const std::string& Airport::get_state() const
+{
+    return state.str();
 }
 
 void Airport::set_state(std::string _state)
 {
-    state = _state;
+    state = InternedString(_state);
+}
+
+void Airport::set_state(InternedString _state)
+{
+    state = std::move(_state);
 }
 
-int Airport::get_transition_alt()
+int Airport::get_transition_alt() const
 {
     return transition_alt;
 }
@@ -164,7 +220,10 @@ void Airport::set_transition_alt(int _transition_alt)
     transition_alt = _transition_alt;
 }
 
-Airport::~Airport()
+void Airport::detach_strings()
 {
-    runways.clear();
+    NavPoint::detach_strings();
+    city = city.detached();
+    country = country.detached();
+    state = state.detached();
 }
@@ -8,52 +8,73 @@
 #include "NavPoint.h"
 #include <list>
 #include <string>
-#include <list>
 
 class Runway {
 private:
-    const std::string name;
+    std::string name;
     int course;
     int ils_freq;
     int length;
     int width;
+    // landing threshold of this runway end, from apt.dat or the CIFP RWY records
+    Coordinate threshold;
+    bool threshold_known = false;
+    double true_heading = 0; // degrees, from the threshold toward the other end
+    bool true_heading_known = false;
+    int threshold_elevation = 0; // feet
+    std::string localizer_id;
 public:
     Runway(std::string _name, int _course, int _ils_freq, int _length, int _width);
-    std::string get_name();
-    int get_course();
-    int get_ils_freq();
-    int get_length();
-    int get_width();
+    const std::string& get_name() const;
+    int get_course() const;
+    int get_ils_freq() const;
+    int get_length() const;
+    int get_width() const;
     void set_course(int _course);
     void set_ils_freq(int _ils_freq);
     void set_length(int _length);
     void set_width(int _width);
+    bool has_threshold() const;
+    const Coordinate& get_threshold() const;
+    void set_threshold(Coordinate _threshold);
+    bool has_true_heading() const;
+    double get_true_heading() const;
+    void set_true_heading(double _true_heading);
+    int get_threshold_elevation() const;
+    void set_threshold_elevation(int _threshold_elevation);
+    const std::string& get_localizer_id() const;
+    void set_localizer_id(std::string _localizer_id);
 };
 
 class Airport : public NavPoint {
 private:
     std::list<Runway> runways;
     std::string iata_id;
-    std::string city;
-    std::string country;
-    std::string state;
+    InternedString city;
+    InternedString country;
+    InternedString state;
     int transition_alt;
 public:
     Airport(std::string icao_id, std::string _icao_region, Coordinate _coordinate, double _magnetic_deviation);
     Airport();
-    Airport& operator=(const Airport& other);
     void add_runway(std::string _name, int _course, int _ils_freq, int _length, int _width);
-    Runway* get_runway_by_name(std::string rwy_name);
-    std::list<Runway> get_runways();
-    std::string get_iata_id();
+    Runway* get_runway_by_name(const std::string& rwy_name);
+    const Runway* get_runway_by_name(const std::string& rwy_name) const;
+    const std::list<Runway>& get_runways() const;
+    const std::string& get_iata_id() const;
     void set_iata_id(std::string _iata_id);
-    std::string get_city();
+    const std::string& get_city() const;
+    // the std::string setters keep an own copy, not pooled
     void set_city(std::string _city);
-    std::string get_country();
+    void set_city(InternedString _city);
+    const std::string& get_country() const;
     void set_country(std::string _country);
-    std::string get_state();
+    void set_country(InternedString _country);
+    const std::string& get_state() const;
     void set_state(std::string _state);
-    int get_transition_alt();
+    void set_state(InternedString _state);
+    int get_transition_alt() const;
     void set_transition_alt(int _transition_alt);
-    ~Airport();
+    // also of the name (see NavPoint::detach_strings)
+    void detach_strings();
 };
\ No newline at end of file
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <algorithm>
+#include "AirwayGraph.h"
+
+// rough heap cost of a hash map entry: the node, its next pointer and the bucket
+const std::size_t HASH_ENTRY_OVERHEAD = 3 * sizeof(void*);
+
+void AirwayGraph::clear()
+{
+	nodes.clear();
+	node_index.clear();
+	edge_offsets.clear();
+	edges.clear();
+	airway_names.clear();
+	airway_index.clear();
+	airway_chain_offsets.clear();
+	chain_offsets.clear();
+	chain_nodes.clear();
+}
+
+std::size_t AirwayGraph::get_node_count() const
+{
+	return nodes.size();
+}
+
+std::size_t AirwayGraph::get_edge_count() const
+{
+	return edges.size();
+}
+
+std::size_t AirwayGraph::get_airway_count() const
+{
+	return airway_names.size();
+}
+
+const NavPoint* AirwayGraph::get_nav_point(uint32_t node) const
+{
+	return nodes[node];
+}
+
+uint32_t AirwayGraph::find_node(const NavPoint* nav_point) const
+{
+	auto it = node_index.find(nav_point);
+	return it == node_index.end() ? NO_NODE : it->second;
+}
+
+std::span<const AirwayEdge> AirwayGraph::get_edges(uint32_t node) const
+{
+	return std::span<const AirwayEdge>(edges.data() + edge_offsets[node], edge_offsets[node + 1] - edge_offsets[node]);
+}
+
+const std::string& AirwayGraph::get_airway_name(uint32_t airway) const
+{
+	return airway_names[airway];
+}
+
+uint32_t AirwayGraph::find_airway(const std::string& name) const
+{
+	auto it = airway_index.find(name);
+	return it == airway_index.end() ? NO_AIRWAY : it->second;
+}
+
+std::vector<std::span<const uint32_t>> AirwayGraph::get_airway_chains(uint32_t airway) const
+{
+	std::vector<std::span<const uint32_t>> chains;
+	for (uint32_t chain = airway_chain_offsets[airway]; chain < airway_chain_offsets[airway + 1]; chain++)
+		chains.emplace_back(chain_nodes.data() + chain_offsets[chain], chain_offsets[chain + 1] - chain_offsets[chain]);
+	return chains;
+}
+
+std::size_t AirwayGraph::get_memory_bytes() const
+{
+	std::size_t bytes = nodes.capacity() * sizeof(const NavPoint*) + edge_offsets.capacity() * sizeof(uint32_t) +
+		edges.capacity() * sizeof(AirwayEdge) + airway_chain_offsets.capacity() * sizeof(uint32_t) +
+		chain_offsets.capacity() * sizeof(uint32_t) + chain_nodes.capacity() * sizeof(uint32_t);
+	bytes += node_index.size() * (sizeof(std::pair<const NavPoint*, uint32_t>) + HASH_ENTRY_OVERHEAD);
+	for (const std::string& name : airway_names)
+	{
+		// the short names fit into the string object itself
+		std::size_t heap = name.capacity() > 15 ? name.capacity() + 1 : 0;
+		bytes += sizeof(std::string) + heap;
+		bytes += sizeof(std::pair<const std::string, uint32_t>) + heap + HASH_ENTRY_OVERHEAD;
+	}
+	return bytes;
+}
+
+void AirwayGraphBuilder::add_segment(const NavPoint* from, const NavPoint* to, const std::string& airway_name, AirwayDirection direction, AirwayLevel level, int base_fl, int top_fl)
+{
+	auto it = airway_index.find(airway_name);
+	if (it == airway_index.end())
+	{
+		it = airway_index.emplace(airway_name, (uint32_t)airway_names.size()).first;
+		airway_names.push_back(airway_name);
+	}
+
+	Segment segment;
+	segment.from = from;
+	segment.to = to;
+	segment.airway = it->second;
+	segment.base_fl = (uint16_t)std::clamp(base_fl, 0, 0xFFFF);
+	segment.top_fl = (uint16_t)std::clamp(top_fl, 0, 0xFFFF);
+	segment.level = (uint8_t)level;
+	segment.direction = (uint8_t)direction;
+	segments.push_back(segment);
+}
+
+std::size_t AirwayGraphBuilder::get_segment_count() const
+{
+	return segments.size();
+}
+
+void AirwayGraphBuilder::clear()
+{
+	segments.clear();
+	airway_names.clear();
+	airway_index.clear();
+}
+
+void AirwayGraphBuilder::build(AirwayGraph& graph) const
+{
+	graph.clear();
+	graph.airway_names = airway_names;
+	graph.airway_index = airway_index;
+
+	// nodes in the order of their first appearance
+	for (const Segment& segment : segments)
+	{
+		for (const NavPoint* nav_point : { segment.from, segment.to })
+		{
+			if (graph.node_index.emplace(nav_point, (uint32_t)graph.nodes.size()).second)
+				graph.nodes.push_back(nav_point);
+		}
+	}
+
+	// count the outgoing edges, then fill them in place
+	graph.edge_offsets.assign(graph.nodes.size() + 1, 0);
+	std::vector<uint32_t> from_nodes(segments.size());
+	std::vector<uint32_t> to_nodes(segments.size());
+	for (std::size_t i = 0; i < segments.size(); i++)
+	{
+		from_nodes[i] = graph.node_index[segments[i].from];
+		to_nodes[i] = graph.node_index[segments[i].to];
+		if (segments[i].direction != AIRWAY_BACKWARD)
+			graph.edge_offsets[from_nodes[i] + 1]++;
+		if (segments[i].direction != AIRWAY_FORWARD)
+			graph.edge_offsets[to_nodes[i] + 1]++;
+	}
+	for (std::size_t node = 0; node < graph.nodes.size(); node++)
+		graph.edge_offsets[node + 1] += graph.edge_offsets[node];
+
+	graph.edges.resize(graph.edge_offsets.back());
+	std::vector<uint32_t> next_edge(graph.edge_offsets.begin(), graph.edge_offsets.end() - 1);
+	for (std::size_t i = 0; i < segments.size(); i++)
+	{
+		const Segment& segment = segments[i];
+		AirwayEdge edge = { 0, segment.airway, segment.base_fl, segment.top_fl, segment.level, (uint8_t)(segment.direction == AIRWAY_BOTH_WAYS) };
+		if (segment.direction != AIRWAY_BACKWARD)
+		{
+			edge.to = to_nodes[i];
+			graph.edges[next_edge[from_nodes[i]]++] = edge;
+		}
+		if (segment.direction != AIRWAY_FORWARD)
+		{
+			edge.to = from_nodes[i];
+			graph.edges[next_edge[to_nodes[i]]++] = edge;
+		}
+	}
+
+	// the segments grouped by airway, in file order
+	std::vector<std::vector<const Segment*>> airway_segments(airway_names.size());
+	for (const Segment& segment : segments)
+		airway_segments[segment.airway].push_back(&segment);
+
+	graph.airway_chain_offsets.reserve(airway_names.size() + 1);
+	graph.chain_offsets.push_back(0);
+	for (const std::vector<const Segment*>& segments_of_airway : airway_segments)
+	{
+		graph.airway_chain_offsets.push_back((uint32_t)graph.chain_offsets.size() - 1);
+		add_chains(graph, segments_of_airway);
+	}
+	graph.airway_chain_offsets.push_back((uint32_t)graph.chain_offsets.size() - 1);
+}
+
+void AirwayGraphBuilder::add_chains(AirwayGraph& graph, const std::vector<const Segment*>& airway_segments)
+{
+	// segments of the airway at each of its nodes
+	std::unordered_map<uint32_t, std::vector<uint32_t>> node_segments;
+	std::vector<uint32_t> start_nodes;
+	for (uint32_t i = 0; i < airway_segments.size(); i++)
+	{
+		for (const NavPoint* nav_point : { airway_segments[i]->from, airway_segments[i]->to })
+		{
+			uint32_t node = graph.node_index.at(nav_point);
+			std::vector<uint32_t>& at_node = node_segments[node];
+			if (at_node.empty())
+				start_nodes.push_back(node);
+			at_node.push_back(i);
+		}
+	}
+
+	// walk from the ends first, then around the remaining loops
+	std::stable_partition(start_nodes.begin(), start_nodes.end(), [&node_segments](uint32_t node) {
+		return node_segments[node].size() != 2;
+	});
+
+	std::vector<bool> used(airway_segments.size(), false);
+	for (uint32_t start : start_nodes)
+	{
+		while (true)
+		{
+			std::size_t chain_begin = graph.chain_nodes.size();
+			bool against_direction = false;
+			uint32_t node = start;
+			graph.chain_nodes.push_back(node);
+			while (true)
+			{
+				std::vector<uint32_t>& at_node = node_segments[node];
+				auto it = std::find_if(at_node.begin(), at_node.end(), [&used](uint32_t i) { return !used[i]; });
+				if (it == at_node.end())
+					break;
+
+				const Segment* segment = airway_segments[*it];
+				used[*it] = true;
+				bool forward = graph.node_index.at(segment->from) == node;
+				if ((forward && segment->direction == AIRWAY_BACKWARD) || (!forward && segment->direction == AIRWAY_FORWARD))
+					against_direction = true;
+				node = graph.node_index.at(forward ? segment->to : segment->from);
+				graph.chain_nodes.push_back(node);
+			}
+
+			if (graph.chain_nodes.size() - chain_begin < 2)
+			{
+				// no unused segment left at the start
+				graph.chain_nodes.resize(chain_begin);
+				break;
+			}
+
+			// a one way airway is listed in its direction
+			if (against_direction)
+				std::reverse(graph.chain_nodes.begin() + chain_begin, graph.chain_nodes.end());
+			graph.chain_offsets.push_back((uint32_t)graph.chain_nodes.size());
+		}
+	}
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <vector>
+#include <string>
+#include <span>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "NavPoint.h"
+
+typedef enum {
+    AIRWAY_BOTH_WAYS,
+    AIRWAY_FORWARD, // only from the first fix to the second one
+    AIRWAY_BACKWARD // only from the second fix to the first one
+} AirwayDirection;
+
+typedef enum {
+    AIRWAY_LOW = 1,
+    AIRWAY_HIGH = 2
+} AirwayLevel;
+
+// outgoing edge of a fix, 16 bytes
+struct AirwayEdge {
+    uint32_t to; // node
+    uint32_t airway; // see AirwayGraph::get_airway_name
+    uint16_t base_fl; // flight level (hundreds of feet)
+    uint16_t top_fl;
+    uint8_t level; // AirwayLevel
+    uint8_t two_way; // 1 if the airway can be flown in both directions
+};
+
+/* Airway network as a compressed sparse row (CSR) graph. The nodes are the fixes and navaids
+   of the airways, the edges of node n are edges[edge_offsets[n]..edge_offsets[n+1]), one
+   per airway and allowed direction of a segment. The fix sequence of every airway is kept
+   the same way: an airway name reused in several disconnected parts (e.g. by different
+   countries) has one chain per part. Built by AirwayGraphBuilder; the nodes point to nav
+   points which shall outlive the graph. */
+class AirwayGraph {
+    friend class AirwayGraphBuilder;
+public:
+    static const uint32_t NO_NODE = 0xFFFFFFFF;
+    static const uint32_t NO_AIRWAY = 0xFFFFFFFF;
+private:
+    std::vector<const NavPoint*> nodes;
+    std::unordered_map<const NavPoint*, uint32_t> node_index;
+    std::vector<uint32_t> edge_offsets; // nodes + 1
+    std::vector<AirwayEdge> edges;
+    std::vector<std::string> airway_names;
+    std::unordered_map<std::string, uint32_t> airway_index;
+    std::vector<uint32_t> airway_chain_offsets; // airways + 1, into chain_offsets
+    std::vector<uint32_t> chain_offsets; // chains + 1, into chain_nodes
+    std::vector<uint32_t> chain_nodes;
+public:
+    void clear();
+    std::size_t get_node_count() const;
+    std::size_t get_edge_count() const;
+    std::size_t get_airway_count() const;
+    const NavPoint* get_nav_point(uint32_t node) const;
+    // NO_NODE if the nav point is not on an airway
+    uint32_t find_node(const NavPoint* nav_point) const;
+    std::span<const AirwayEdge> get_edges(uint32_t node) const;
+    const std::string& get_airway_name(uint32_t airway) const;
+    // NO_AIRWAY if there is no airway with this name
+    uint32_t find_airway(const std::string& name) const;
+    // the ordered nodes of the parts of an airway
+    std::vector<std::span<const uint32_t>> get_airway_chains(uint32_t airway) const;
+    // estimate of the heap memory of the graph, including the hash indexes
+    std::size_t get_memory_bytes() const;
+};
+
+// collects the airway segments and builds the graph of them
+class AirwayGraphBuilder {
+private:
+    struct Segment {
+        const NavPoint* from;
+        const NavPoint* to;
+        uint32_t airway;
+        uint16_t base_fl;
+        uint16_t top_fl;
+        uint8_t level;
+        uint8_t direction;
+    };
+    std::vector<Segment> segments;
+    std::vector<std::string> airway_names;
+    std::unordered_map<std::string, uint32_t> airway_index;
+    static void add_chains(AirwayGraph& graph, const std::vector<const Segment*>& airway_segments);
+public:
+    void add_segment(const NavPoint* from, const NavPoint* to, const std::string& airway_name, AirwayDirection direction, AirwayLevel level, int base_fl, int top_fl);
+    std::size_t get_segment_count() const;
+    void clear();
+    void build(AirwayGraph& graph) const;
+};
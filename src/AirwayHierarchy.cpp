@@ -0,0 +1,663 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <limits>
+#include "AirwayHierarchy.h"
+#include "Logger.h"
+
+const uint32_t HIERARCHY_FILE_MAGIC = 0x48414D4E; // "NMAH"
+const uint32_t HIERARCHY_FILE_VERSION = 2;
+const double INFINITE_KM = std::numeric_limits<double>::infinity();
+// the witness search gives up after this many nodes and keeps the shortcut: fewer nodes is a
+// faster build with more shortcuts, the routes are the same
+const std::size_t WITNESS_SETTLE_LIMIT = 500;
+// a witness as long as the shortcut up to the rounding errors is enough. without it the many
+// equally long routes of a regular airway grid would all get shortcuts
+const double WITNESS_TOLERANCE = 1e-12;
+
+struct QueueEntry {
+	double km;
+	uint32_t node;
+	bool operator>(const QueueEntry& other) const { return km > other.km; }
+};
+typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> MinQueue;
+
+// edge of the graph under contraction, in the out list of its source and the in list of its target
+struct ContractionEdge {
+	uint32_t node; // the other end
+	double km;
+	uint32_t middle;
+	uint32_t airway;
+};
+
+class Contraction {
+private:
+	std::vector<std::vector<ContractionEdge>> out;
+	std::vector<std::vector<ContractionEdge>> in;
+	std::vector<uint32_t> contracted_neighbors;
+	std::vector<uint32_t> witness_visited;
+	std::vector<double> witness_cost;
+	std::vector<uint32_t> witness_target; // == witness_query at the out neighbors of the contracted node
+	uint32_t witness_query = 0;
+	MinQueue witness_queue;
+
+	static ContractionEdge* find_edge(std::vector<ContractionEdge>& edges, uint32_t node)
+	{
+		for (ContractionEdge& edge : edges)
+		{
+			if (edge.node == node)
+				return &edge;
+		}
+		return NULL;
+	}
+
+	static void erase_edge(std::vector<ContractionEdge>& edges, uint32_t node)
+	{
+		edges.erase(std::remove_if(edges.begin(), edges.end(), [node](const ContractionEdge& edge) { return edge.node == node; }), edges.end());
+	}
+
+	// the costs from the source up to max_km, not through the skipped node. stops when all the
+	// out neighbors of the skipped node are settled
+	void witness_search(uint32_t source, uint32_t skipped, double max_km, std::size_t settle_limit)
+	{
+		if (++witness_query == 0)
+		{
+			std::fill(witness_visited.begin(), witness_visited.end(), 0);
+			std::fill(witness_target.begin(), witness_target.end(), 0);
+			witness_query = 1;
+		}
+
+		std::size_t targets = 0;
+		for (const ContractionEdge& edge : out[skipped])
+		{
+			if (edge.node != source)
+			{
+				witness_target[edge.node] = witness_query;
+				targets++;
+			}
+		}
+
+		witness_queue = MinQueue();
+		witness_visited[source] = witness_query;
+		witness_cost[source] = 0;
+		witness_queue.push({ 0, source });
+		std::size_t settled = 0;
+		while (!witness_queue.empty() && settled < settle_limit && targets > 0)
+		{
+			QueueEntry entry = witness_queue.top();
+			witness_queue.pop();
+			if (entry.km > witness_cost[entry.node])
+				continue;
+			if (entry.km > max_km)
+				break;
+
+			settled++;
+			if (witness_target[entry.node] == witness_query)
+			{
+				witness_target[entry.node] = 0;
+				targets--;
+			}
+			for (const ContractionEdge& edge : out[entry.node])
+			{
+				double km = entry.km + edge.km;
+				if (edge.node == skipped || (witness_visited[edge.node] == witness_query && km >= witness_cost[edge.node]))
+					continue;
+				witness_visited[edge.node] = witness_query;
+				witness_cost[edge.node] = km;
+				witness_queue.push({ km, edge.node });
+			}
+		}
+	}
+
+	// the shortcuts needed to contract the node, added to the graph if add is set
+	int contract_shortcuts(uint32_t node, bool add)
+	{
+		// a shorter witness search while only the priority is estimated
+		std::size_t settle_limit = add ? WITNESS_SETTLE_LIMIT : WITNESS_SETTLE_LIMIT / 10;
+		double max_out_km = 0;
+		for (const ContractionEdge& edge : out[node])
+			max_out_km = std::max(max_out_km, edge.km);
+
+		int shortcuts = 0;
+		for (std::size_t i = 0; i < in[node].size(); i++)
+		{
+			ContractionEdge from = in[node][i];
+			witness_search(from.node, node, from.km + max_out_km, settle_limit);
+			for (std::size_t j = 0; j < out[node].size(); j++)
+			{
+				ContractionEdge to = out[node][j];
+				if (to.node == from.node)
+					continue;
+
+				double km = from.km + to.km;
+				if (witness_visited[to.node] == witness_query && witness_cost[to.node] <= km * (1 + WITNESS_TOLERANCE))
+					continue;
+
+				shortcuts++;
+				if (add)
+					add_edge(from.node, to.node, km, node, AirwayGraph::NO_AIRWAY);
+			}
+		}
+		return shortcuts;
+	}
+
+public:
+	Contraction(std::size_t node_count) :
+		out(node_count), in(node_count), contracted_neighbors(node_count, 0), witness_visited(node_count, 0), witness_cost(node_count), witness_target(node_count, 0)
+	{
+
+	}
+
+	// keeps the shorter one of the parallel edges
+	void add_edge(uint32_t from, uint32_t to, double km, uint32_t middle, uint32_t airway)
+	{
+		ContractionEdge* existing = find_edge(out[from], to);
+		if (existing != NULL)
+		{
+			if (existing->km <= km)
+				return;
+			*existing = { to, km, middle, airway };
+			*find_edge(in[to], from) = { from, km, middle, airway };
+		}
+		else
+		{
+			out[from].push_back({ to, km, middle, airway });
+			in[to].push_back({ from, km, middle, airway });
+		}
+	}
+
+	// edge difference, spread over the graph by the contracted neighbors
+	int priority(uint32_t node)
+	{
+		return 2 * (contract_shortcuts(node, false) - (int)(in[node].size() + out[node].size())) + (int)contracted_neighbors[node];
+	}
+
+	// adds the shortcuts and removes the node, its remaining edges go to higher ranked nodes
+	void contract(uint32_t node, std::vector<ContractionEdge>& up, std::vector<ContractionEdge>& down)
+	{
+		contract_shortcuts(node, true);
+		up = std::move(out[node]);
+		down = std::move(in[node]);
+		out[node].clear();
+		in[node].clear();
+		for (const ContractionEdge& edge : up)
+		{
+			erase_edge(in[edge.node], node);
+			contracted_neighbors[edge.node]++;
+		}
+		for (const ContractionEdge& edge : down)
+		{
+			erase_edge(out[edge.node], node);
+			contracted_neighbors[edge.node]++;
+		}
+	}
+};
+
+template <typename T>
+static void write_value(std::ofstream& o_str, const T& value)
+{
+	o_str.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static bool read_value(std::ifstream& i_str, T& value)
+{
+	return (bool)i_str.read((char*)&value, sizeof(T));
+}
+
+static void write_offsets(std::ofstream& o_str, const std::vector<uint32_t>& values)
+{
+	write_value(o_str, (uint32_t)values.size());
+	o_str.write((const char*)values.data(), values.size() * sizeof(uint32_t));
+}
+
+static bool read_offsets(std::ifstream& i_str, std::vector<uint32_t>& values, uint32_t expected_size)
+{
+	uint32_t size = 0;
+	if (!read_value(i_str, size) || size != expected_size)
+		return false;
+	values.resize(size);
+	return (bool)i_str.read((char*)values.data(), size * sizeof(uint32_t));
+}
+
+// the edges of node n are [offsets[n], offsets[n + 1]), at most edge_limit edges in all
+static bool valid_offsets(const std::vector<uint32_t>& offsets, std::size_t edge_limit)
+{
+	if (offsets.empty() || offsets.front() != 0 || offsets.back() > edge_limit)
+		return false;
+	for (std::size_t i = 1; i < offsets.size(); i++)
+	{
+		if (offsets[i] < offsets[i - 1])
+			return false;
+	}
+	return true;
+}
+
+uint64_t AirwayHierarchy::fingerprint(const AirwayGraph& graph)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	auto add = [&hash](const void* data, std::size_t size) {
+		for (std::size_t i = 0; i < size; i++)
+		{
+			hash ^= ((const unsigned char*)data)[i];
+			hash *= 0x100000001b3ull;
+		}
+	};
+
+	uint64_t counts[] = { graph.get_node_count(), graph.get_edge_count(), graph.get_airway_count() };
+	add(counts, sizeof(counts));
+	for (uint32_t node = 0; node < graph.get_node_count(); node++)
+	{
+		const NavPoint* nav_point = graph.get_nav_point(node);
+		add(nav_point->get_icao_id().data(), nav_point->get_icao_id().size());
+		add(nav_point->get_icao_region().data(), nav_point->get_icao_region().size());
+		// the edge lengths of the hierarchy come from the positions
+		double position[] = { nav_point->get_coordinate().lat.convert_to_double(), nav_point->get_coordinate().lng.convert_to_double() };
+		add(position, sizeof(position));
+		for (const AirwayEdge& edge : graph.get_edges(node))
+		{
+			uint32_t values[] = { edge.to, edge.airway, edge.base_fl, edge.top_fl, edge.level, edge.two_way };
+			add(values, sizeof(values));
+		}
+	}
+	return hash;
+}
+
+bool AirwayHierarchy::build(const AirwayGraph& _graph, const AirwayRouteOptions& _options)
+{
+	graph = &_graph;
+	graph_fingerprint = fingerprint(_graph);
+	options = _options;
+	std::size_t node_count = graph->get_node_count();
+	rank.assign(node_count, 0);
+	up_offsets.assign(1, 0);
+	up_edges.clear();
+	down_offsets.assign(1, 0);
+	down_edges.clear();
+	shortcut_count = 0;
+	reset_search_state();
+	if (node_count == 0)
+		return false;
+
+	Contraction contraction(node_count);
+	for (uint32_t node = 0; node < node_count; node++)
+	{
+		for (const AirwayEdge& edge : graph->get_edges(node))
+		{
+			if (edge.to != node && AirwayRouter::edge_allowed(edge, options))
+			{
+				double km = AirwayRouter::great_circle_km(graph->get_nav_point(node)->get_coordinate(), graph->get_nav_point(edge.to)->get_coordinate());
+				contraction.add_edge(node, edge.to, km, AirwayGraph::NO_NODE, edge.airway);
+			}
+		}
+	}
+
+	// the priorities of the neighbors are updated after each contraction, the queue entries with an
+	// outdated priority are skipped. the priority of the next node is checked once more (lazy update)
+	std::priority_queue<std::pair<int, uint32_t>, std::vector<std::pair<int, uint32_t>>, std::greater<std::pair<int, uint32_t>>> queue;
+	std::vector<int> priorities(node_count);
+	for (uint32_t node = 0; node < node_count; node++)
+	{
+		priorities[node] = contraction.priority(node);
+		queue.push({ priorities[node], node });
+	}
+
+	std::vector<std::vector<ContractionEdge>> up(node_count);
+	std::vector<std::vector<ContractionEdge>> down(node_count);
+	std::vector<bool> contracted(node_count, false);
+	uint32_t next_rank = 0;
+	while (!queue.empty())
+	{
+		std::pair<int, uint32_t> entry = queue.top();
+		uint32_t node = entry.second;
+		queue.pop();
+		if (contracted[node] || entry.first != priorities[node])
+			continue;
+
+		priorities[node] = contraction.priority(node);
+		if (!queue.empty() && priorities[node] > queue.top().first)
+		{
+			queue.push({ priorities[node], node });
+			continue;
+		}
+
+		contraction.contract(node, up[node], down[node]);
+		contracted[node] = true;
+		rank[node] = next_rank++;
+		for (const std::vector<ContractionEdge>* edges : { &up[node], &down[node] })
+		{
+			for (const ContractionEdge& edge : *edges)
+			{
+				int priority = contraction.priority(edge.node);
+				if (priority != priorities[edge.node])
+				{
+					priorities[edge.node] = priority;
+					queue.push({ priority, edge.node });
+				}
+			}
+		}
+	}
+	for (uint32_t node = 0; node < node_count; node++)
+	{
+		for (const ContractionEdge& edge : up[node])
+			up_edges.push_back({ edge.km, edge.node, edge.middle, edge.airway });
+		up_offsets.push_back((uint32_t)up_edges.size());
+		for (const ContractionEdge& edge : down[node])
+			down_edges.push_back({ edge.km, edge.node, edge.middle, edge.airway });
+		down_offsets.push_back((uint32_t)down_edges.size());
+	}
+	count_shortcuts();
+	return true;
+}
+
+bool AirwayHierarchy::save_to_file(const std::string& file_name) const
+{
+	std::ofstream o_str(file_name, std::ios::binary | std::ios::trunc);
+	if (!o_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "AirwayHierarchy: can't open file for write: " << file_name << std::endl;
+		return false;
+	}
+
+	write_value(o_str, HIERARCHY_FILE_MAGIC);
+	write_value(o_str, HIERARCHY_FILE_VERSION);
+	write_value(o_str, graph_fingerprint);
+	write_value(o_str, (int32_t)options.cruise_fl);
+	write_value(o_str, (uint8_t)options.use_low_airways);
+	write_value(o_str, (uint8_t)options.use_high_airways);
+	write_offsets(o_str, rank);
+	write_offsets(o_str, up_offsets);
+	write_offsets(o_str, down_offsets);
+	for (const std::vector<Edge>* edges : { &up_edges, &down_edges })
+	{
+		for (const Edge& edge : *edges)
+		{
+			write_value(o_str, edge.km);
+			write_value(o_str, edge.to);
+			write_value(o_str, edge.middle);
+			write_value(o_str, edge.airway);
+		}
+	}
+	return (bool)o_str;
+}
+
+bool AirwayHierarchy::load_from_file(const std::string& file_name, const AirwayGraph& _graph)
+{
+	std::ifstream i_str(file_name, std::ios::binary);
+	if (!i_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "AirwayHierarchy: can't open file for read: " << file_name << std::endl;
+		return false;
+	}
+
+	graph = NULL;
+	uint32_t magic = 0, version = 0;
+	uint64_t file_fingerprint = 0;
+	int32_t cruise_fl = 0;
+	uint8_t use_low_airways = 0, use_high_airways = 0;
+	if (!read_value(i_str, magic) || magic != HIERARCHY_FILE_MAGIC || !read_value(i_str, version) || version != HIERARCHY_FILE_VERSION)
+	{
+		Logger(TLogLevel::logERROR) << "AirwayHierarchy: not an airway hierarchy file: " << file_name << std::endl;
+		return false;
+	}
+	if (!read_value(i_str, file_fingerprint) || file_fingerprint != fingerprint(_graph))
+	{
+		Logger(TLogLevel::logERROR) << "AirwayHierarchy: the file is built from other airways: " << file_name << std::endl;
+		return false;
+	}
+
+	uint32_t node_count = (uint32_t)_graph.get_node_count();
+	bool valid = read_value(i_str, cruise_fl) && read_value(i_str, use_low_airways) && read_value(i_str, use_high_airways) &&
+		read_offsets(i_str, rank, node_count) && read_offsets(i_str, up_offsets, node_count + 1) && read_offsets(i_str, down_offsets, node_count + 1);
+	if (valid)
+	{
+		// the edges can't be more than the rest of the file holds
+		const std::size_t edge_bytes = sizeof(double) + 3 * sizeof(uint32_t);
+		std::streamoff edges_start = i_str.tellg();
+		i_str.seekg(0, std::ios::end);
+		std::size_t edge_limit = (std::size_t)(i_str.tellg() - edges_start) / edge_bytes;
+		i_str.seekg(edges_start);
+		valid = std::all_of(rank.begin(), rank.end(), [node_count](uint32_t node_rank) { return node_rank < node_count; }) &&
+			valid_offsets(up_offsets, edge_limit) && valid_offsets(down_offsets, edge_limit - up_offsets.back());
+	}
+	if (valid)
+	{
+		up_edges.resize(up_offsets.back());
+		down_edges.resize(down_offsets.back());
+		for (std::vector<Edge>* edges : { &up_edges, &down_edges })
+		{
+			for (Edge& edge : *edges)
+			{
+				valid = valid && read_value(i_str, edge.km) && read_value(i_str, edge.to) && read_value(i_str, edge.middle) &&
+					read_value(i_str, edge.airway) && edge.to < node_count && edge.km >= 0 &&
+					(edge.middle == AirwayGraph::NO_NODE ? edge.airway < _graph.get_airway_count() : edge.middle < node_count);
+			}
+		}
+	}
+	// unpack_edge() finds both halves of a shortcut at its middle node, which is ranked below the ends
+	for (uint32_t node = 0; valid && node < node_count; node++)
+	{
+		for (const std::vector<Edge>* edges : { &up_edges, &down_edges })
+		{
+			const std::vector<uint32_t>& offsets = edges == &up_edges ? up_offsets : down_offsets;
+			for (uint32_t i = offsets[node]; valid && i < offsets[node + 1]; i++)
+			{
+				const Edge& edge = (*edges)[i];
+				if (edge.middle == AirwayGraph::NO_NODE)
+					continue;
+				// up edges lead from the node to edge.to, down edges from edge.to to the node
+				uint32_t from = edges == &up_edges ? node : edge.to;
+				uint32_t to = edges == &up_edges ? edge.to : node;
+				auto first = std::find_if(down_edges.begin() + down_offsets[edge.middle], down_edges.begin() + down_offsets[edge.middle + 1],
+					[from](const Edge& half) { return half.to == from; });
+				auto second = std::find_if(up_edges.begin() + up_offsets[edge.middle], up_edges.begin() + up_offsets[edge.middle + 1],
+					[to](const Edge& half) { return half.to == to; });
+				valid = rank[edge.middle] < rank[from] && rank[edge.middle] < rank[to] &&
+					first != down_edges.begin() + down_offsets[edge.middle + 1] && second != up_edges.begin() + up_offsets[edge.middle + 1];
+			}
+		}
+	}
+	if (!valid)
+	{
+		Logger(TLogLevel::logERROR) << "AirwayHierarchy: corrupt file: " << file_name << std::endl;
+		rank.clear();
+		return false;
+	}
+
+	graph = &_graph;
+	graph_fingerprint = file_fingerprint;
+	options = AirwayRouteOptions();
+	options.cruise_fl = cruise_fl;
+	options.use_low_airways = use_low_airways != 0;
+	options.use_high_airways = use_high_airways != 0;
+	count_shortcuts();
+	reset_search_state();
+	return true;
+}
+
+bool AirwayHierarchy::is_built() const
+{
+	return graph != NULL && !rank.empty();
+}
+
+const AirwayRouteOptions& AirwayHierarchy::get_options() const
+{
+	return options;
+}
+
+void AirwayHierarchy::count_shortcuts()
+{
+	shortcut_count = 0;
+	for (const std::vector<Edge>* edges : { &up_edges, &down_edges })
+		shortcut_count += std::count_if(edges->begin(), edges->end(), [](const Edge& edge) { return edge.middle != AirwayGraph::NO_NODE; });
+}
+
+std::size_t AirwayHierarchy::get_shortcut_count() const
+{
+	return shortcut_count;
+}
+
+std::size_t AirwayHierarchy::get_memory_bytes() const
+{
+	std::size_t bytes = (rank.capacity() + up_offsets.capacity() + down_offsets.capacity()) * sizeof(uint32_t) +
+		(up_edges.capacity() + down_edges.capacity()) * sizeof(Edge);
+	for (const SearchSide* side : { &forward, &backward })
+	{
+		bytes += (side->visited.capacity() + side->parent.capacity() + side->parent_edge.capacity()) * sizeof(uint32_t) +
+			side->cost.capacity() * sizeof(double);
+	}
+	return bytes;
+}
+
+void AirwayHierarchy::reset_search_state()
+{
+	for (SearchSide* side : { &forward, &backward })
+	{
+		side->visited.assign(rank.size(), 0);
+		side->cost.resize(rank.size());
+		side->parent.resize(rank.size());
+		side->parent_edge.resize(rank.size());
+	}
+	query = 0;
+}
+
+void AirwayHierarchy::unpack_edge(uint32_t from, uint32_t to, uint32_t middle, uint32_t airway, AirwayRoute& route) const
+{
+	if (middle == AirwayGraph::NO_NODE)
+	{
+		route.nodes.push_back(to);
+		route.airways.push_back(airway);
+		return;
+	}
+
+	// both halves of a shortcut are edges of its middle node, which has the lower rank
+	const Edge* first = NULL;
+	for (uint32_t i = down_offsets[middle]; i < down_offsets[middle + 1] && first == NULL; i++)
+	{
+		if (down_edges[i].to == from)
+			first = &down_edges[i];
+	}
+	const Edge* second = NULL;
+	for (uint32_t i = up_offsets[middle]; i < up_offsets[middle + 1] && second == NULL; i++)
+	{
+		if (up_edges[i].to == to)
+			second = &up_edges[i];
+	}
+	unpack_edge(from, middle, first->middle, first->airway, route);
+	unpack_edge(middle, to, second->middle, second->airway, route);
+}
+
+bool AirwayHierarchy::find_route(uint32_t from_node, uint32_t to_node, AirwayRoute& route)
+{
+	route = AirwayRoute();
+	if (!is_built() || from_node >= rank.size() || to_node >= rank.size())
+		return false;
+
+	if (++query == 0)
+	{
+		reset_search_state();
+		query = 1;
+	}
+
+	// both searches only go up in the hierarchy and meet at the highest node of the route
+	MinQueue queues[2];
+	SearchSide* sides[2] = { &forward, &backward };
+	const std::vector<uint32_t>* offsets[2] = { &up_offsets, &down_offsets };
+	const std::vector<Edge>* edges[2] = { &up_edges, &down_edges };
+	uint32_t sources[2] = { from_node, to_node };
+	for (int s = 0; s < 2; s++)
+	{
+		sides[s]->visited[sources[s]] = query;
+		sides[s]->cost[sources[s]] = 0;
+		sides[s]->parent[sources[s]] = AirwayGraph::NO_NODE;
+		queues[s].push({ 0, sources[s] });
+	}
+
+	double best_km = INFINITE_KM;
+	uint32_t meeting_node = AirwayGraph::NO_NODE;
+	while (true)
+	{
+		double top_km[2];
+		for (int s = 0; s < 2; s++)
+			top_km[s] = queues[s].empty() ? INFINITE_KM : queues[s].top().km;
+		if (std::min(top_km[0], top_km[1]) >= best_km)
+			break;
+
+		int s = top_km[0] <= top_km[1] ? 0 : 1;
+		SearchSide& side = *sides[s];
+		SearchSide& other = *sides[1 - s];
+		QueueEntry entry = queues[s].top();
+		queues[s].pop();
+		if (entry.km > side.cost[entry.node])
+			continue;
+
+		route.settled_nodes++;
+		if (other.visited[entry.node] == query && entry.km + other.cost[entry.node] < best_km)
+		{
+			best_km = entry.km + other.cost[entry.node];
+			meeting_node = entry.node;
+		}
+
+		// stall on demand: a higher node reached by this search has a shorter way here, the
+		// node can't be on the shortest route, its edges are not followed
+		bool stalled = false;
+		const std::vector<uint32_t>& reverse_offsets = *offsets[1 - s];
+		const std::vector<Edge>& reverse_edges = *edges[1 - s];
+		for (uint32_t i = reverse_offsets[entry.node]; i < reverse_offsets[entry.node + 1] && !stalled; i++)
+		{
+			const Edge& edge = reverse_edges[i];
+			stalled = side.visited[edge.to] == query && side.cost[edge.to] + edge.km < entry.km;
+		}
+		if (stalled)
+			continue;
+
+		for (uint32_t i = (*offsets[s])[entry.node]; i < (*offsets[s])[entry.node + 1]; i++)
+		{
+			const Edge& edge = (*edges[s])[i];
+			double km = entry.km + edge.km;
+			if (side.visited[edge.to] == query && km >= side.cost[edge.to])
+				continue;
+			side.visited[edge.to] = query;
+			side.cost[edge.to] = km;
+			side.parent[edge.to] = entry.node;
+			side.parent_edge[edge.to] = i;
+			queues[s].push({ km, edge.to });
+		}
+	}
+
+	if (meeting_node == AirwayGraph::NO_NODE)
+		return false;
+
+	std::vector<uint32_t> forward_nodes;
+	for (uint32_t node = meeting_node; node != from_node; node = forward.parent[node])
+		forward_nodes.push_back(node);
+
+	route.nodes.push_back(from_node);
+	for (auto it = forward_nodes.rbegin(); it != forward_nodes.rend(); ++it)
+	{
+		const Edge& edge = up_edges[forward.parent_edge[*it]];
+		unpack_edge(forward.parent[*it], *it, edge.middle, edge.airway, route);
+	}
+	for (uint32_t node = meeting_node; node != to_node; node = backward.parent[node])
+	{
+		const Edge& edge = down_edges[backward.parent_edge[node]];
+		unpack_edge(node, backward.parent[node], edge.middle, edge.airway, route);
+	}
+	route.distance_km = best_km;
+	return true;
+}
+
+bool AirwayHierarchy::find_route(const NavPoint* from, const NavPoint* to, AirwayRoute& route)
+{
+	if (!is_built())
+	{
+		route = AirwayRoute();
+		return false;
+	}
+	return find_route(graph->find_node(from), graph->find_node(to), route);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include "AirwayGraph.h"
+#include "AirwayRouter.h"
+
+/* Contraction hierarchy of an AirwayGraph for repeated fix to fix route queries on an unchanged
+   airway network. The fixes are contracted one by one, the shortcuts keep the shortest routes
+   between the remaining ones; a query is a bidirectional search toward the higher ranked fixes
+   only, and touches a few hundred nodes instead of the continent. The airways are filtered by
+   the level options at build time, one hierarchy serves one set of options. It can be saved
+   next to the navdata and loaded back for the same graph. */
+class AirwayHierarchy {
+private:
+    struct Edge {
+        double km;
+        uint32_t to;
+        uint32_t middle; // the contracted fix of a shortcut, AirwayGraph::NO_NODE for an airway leg
+        uint32_t airway; // airway legs only
+    };
+    struct SearchSide {
+        std::vector<uint32_t> visited; // == query where cost is valid
+        std::vector<double> cost;
+        std::vector<uint32_t> parent;
+        std::vector<uint32_t> parent_edge; // index of the edge which reached the node
+    };
+    const AirwayGraph* graph = NULL;
+    uint64_t graph_fingerprint = 0;
+    AirwayRouteOptions options;
+    std::vector<uint32_t> rank;
+    // up: edges from a node to higher ranked ones, down: edges from higher ranked nodes to the node
+    std::vector<uint32_t> up_offsets;
+    std::vector<Edge> up_edges;
+    std::vector<uint32_t> down_offsets;
+    std::vector<Edge> down_edges;
+    std::size_t shortcut_count = 0;
+    SearchSide forward;
+    SearchSide backward;
+    uint32_t query = 0;
+    static uint64_t fingerprint(const AirwayGraph& graph);
+    void reset_search_state();
+    void count_shortcuts();
+    void unpack_edge(uint32_t from, uint32_t to, uint32_t middle, uint32_t airway, AirwayRoute& route) const;
+public:
+    // false if the graph has no nodes
+    bool build(const AirwayGraph& _graph, const AirwayRouteOptions& _options = AirwayRouteOptions());
+    bool save_to_file(const std::string& file_name) const;
+    // false if the file can't be read or it is the hierarchy of another graph
+    bool load_from_file(const std::string& file_name, const AirwayGraph& _graph);
+    bool is_built() const;
+    const AirwayRouteOptions& get_options() const;
+    std::size_t get_shortcut_count() const;
+    std::size_t get_memory_bytes() const;
+    // a shortest route, the same length as AirwayRouter::find_route gives with the options of the hierarchy. not thread safe
+    bool find_route(uint32_t from_node, uint32_t to_node, AirwayRoute& route);
+    bool find_route(const NavPoint* from, const NavPoint* to, AirwayRoute& route);
+};
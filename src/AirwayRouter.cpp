@@ -0,0 +1,228 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <cmath>
+#include <algorithm>
+#include <queue>
+#include <limits>
+#include "AirwayRouter.h"
+
+const double EARTH_RADIUS_KM = 6371;
+const double INFINITE_KM = std::numeric_limits<double>::infinity();
+
+struct OpenEntry {
+	double estimate_km; // cost + heuristic
+	double cost_km;
+	uint32_t node;
+	bool operator>(const OpenEntry& other) const { return estimate_km > other.estimate_km; }
+};
+
+AirwayRouter::AirwayRouter(const AirwayGraph& _graph) :
+	graph(_graph), query(0)
+{
+	std::size_t node_count = graph.get_node_count();
+	node_vectors.reserve(node_count);
+	for (uint32_t node = 0; node < node_count; node++)
+		node_vectors.push_back(to_vector(graph.get_nav_point(node)->get_coordinate()));
+
+	// the leg lengths do not depend on the query
+	edge_begin.reserve(node_count + 1);
+	edge_km.reserve(graph.get_edge_count());
+	for (uint32_t node = 0; node < node_count; node++)
+	{
+		edge_begin.push_back((uint32_t)edge_km.size());
+		for (const AirwayEdge& edge : graph.get_edges(node))
+			edge_km.push_back(chord_to_km(node_vectors[node], node_vectors[edge.to]));
+	}
+	edge_begin.push_back((uint32_t)edge_km.size());
+
+	visited.assign(node_count, 0);
+	cost.resize(node_count);
+	parent.resize(node_count);
+	parent_airway.resize(node_count);
+	target_mark.assign(node_count, 0);
+	target_cost.resize(node_count);
+}
+
+const AirwayGraph& AirwayRouter::get_graph() const
+{
+	return graph;
+}
+
+AirwayRouter::Vector3 AirwayRouter::to_vector(const Coordinate& coordinate)
+{
+	double lat = coordinate.lat.convert_to_radian();
+	double lng = coordinate.lng.convert_to_radian();
+	return { cos(lat) * cos(lng), cos(lat) * sin(lng), sin(lat) };
+}
+
+double AirwayRouter::chord_to_km(const Vector3& a, const Vector3& b)
+{
+	// the chord is exact for the short legs where acos of the dot product loses precision
+	double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+	double chord = sqrt(dx * dx + dy * dy + dz * dz);
+	return 2 * asin(std::min(chord / 2, 1.0)) * EARTH_RADIUS_KM;
+}
+
+double AirwayRouter::great_circle_km(const Coordinate& from, const Coordinate& to)
+{
+	return chord_to_km(to_vector(from), to_vector(to));
+}
+
+bool AirwayRouter::edge_allowed(const AirwayEdge& edge, const AirwayRouteOptions& options)
+{
+	if (edge.level == AIRWAY_HIGH ? !options.use_high_airways : !options.use_low_airways)
+		return false;
+	return options.cruise_fl <= 0 || (edge.base_fl <= options.cruise_fl && options.cruise_fl <= edge.top_fl);
+}
+
+std::vector<AirwayRouter::Target> AirwayRouter::nearest_nodes(const Vector3& position, const AirwayRouteOptions& options) const
+{
+	std::vector<Target> nearest;
+	for (uint32_t node = 0; node < node_vectors.size(); node++)
+	{
+		// cheap reject on the squared chord before the exact distance
+		double dx = node_vectors[node].x - position.x;
+		double dy = node_vectors[node].y - position.y;
+		double dz = node_vectors[node].z - position.z;
+		double max_chord = options.max_connection_km / EARTH_RADIUS_KM;
+		if (dx * dx + dy * dy + dz * dz > max_chord * max_chord)
+			continue;
+
+		double distance = chord_to_km(node_vectors[node], position);
+		if (distance <= options.max_connection_km)
+			nearest.push_back({ node, distance });
+	}
+
+	auto closer = [](const Target& a, const Target& b) { return a.cost_km < b.cost_km; };
+	if (nearest.size() > options.connection_candidates)
+	{
+		std::nth_element(nearest.begin(), nearest.begin() + options.connection_candidates, nearest.end(), closer);
+		nearest.resize(options.connection_candidates);
+	}
+	return nearest;
+}
+
+bool AirwayRouter::search(const std::vector<Target>& starts, const std::vector<Target>& targets, const Vector3& end,
+	const AirwayRouteOptions& options, AirwayRoute& route)
+{
+	route = AirwayRoute();
+	if (starts.empty() || targets.empty())
+		return false;
+
+	if (++query == 0)
+	{
+		std::fill(visited.begin(), visited.end(), 0);
+		std::fill(target_mark.begin(), target_mark.end(), 0);
+		query = 1;
+	}
+
+	for (const Target& target : targets)
+	{
+		if (target_mark[target.node] != query || target.cost_km < target_cost[target.node])
+			target_cost[target.node] = target.cost_km;
+		target_mark[target.node] = query;
+	}
+
+	std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+	for (const Target& start : starts)
+	{
+		if (visited[start.node] == query && cost[start.node] <= start.cost_km)
+			continue;
+		visited[start.node] = query;
+		cost[start.node] = start.cost_km;
+		parent[start.node] = AirwayGraph::NO_NODE;
+		parent_airway[start.node] = AirwayGraph::NO_AIRWAY;
+		open.push({ start.cost_km + chord_to_km(node_vectors[start.node], end), start.cost_km, start.node });
+	}
+
+	// the heuristic is consistent: a node is final when it leaves the open set
+	double best_km = INFINITE_KM;
+	uint32_t best_node = AirwayGraph::NO_NODE;
+	while (!open.empty())
+	{
+		OpenEntry entry = open.top();
+		open.pop();
+		if (entry.cost_km > cost[entry.node])
+			continue;
+		if (entry.estimate_km >= best_km)
+			break;
+
+		route.settled_nodes++;
+		uint32_t node = entry.node;
+		if (target_mark[node] == query && entry.cost_km + target_cost[node] < best_km)
+		{
+			best_km = entry.cost_km + target_cost[node];
+			best_node = node;
+		}
+
+		std::span<const AirwayEdge> edges = graph.get_edges(node);
+		const double* lengths = edge_km.data() + edge_begin[node];
+		for (std::size_t i = 0; i < edges.size(); i++)
+		{
+			const AirwayEdge& edge = edges[i];
+			if (!edge_allowed(edge, options))
+				continue;
+
+			double next_cost = entry.cost_km + lengths[i];
+			if (visited[edge.to] == query && next_cost >= cost[edge.to])
+				continue;
+
+			visited[edge.to] = query;
+			cost[edge.to] = next_cost;
+			parent[edge.to] = node;
+			parent_airway[edge.to] = edge.airway;
+			open.push({ next_cost + chord_to_km(node_vectors[edge.to], end), next_cost, edge.to });
+		}
+	}
+
+	if (best_node == AirwayGraph::NO_NODE)
+		return false;
+
+	for (uint32_t node = best_node; node != AirwayGraph::NO_NODE; node = parent[node])
+	{
+		route.nodes.push_back(node);
+		if (parent[node] != AirwayGraph::NO_NODE)
+			route.airways.push_back(parent_airway[node]);
+	}
+	std::reverse(route.nodes.begin(), route.nodes.end());
+	std::reverse(route.airways.begin(), route.airways.end());
+	route.distance_km = best_km;
+	return true;
+}
+
+bool AirwayRouter::find_route(uint32_t from_node, uint32_t to_node, const AirwayRouteOptions& options, AirwayRoute& route)
+{
+	if (from_node >= node_vectors.size() || to_node >= node_vectors.size())
+	{
+		route = AirwayRoute();
+		return false;
+	}
+	return search({ { from_node, 0 } }, { { to_node, 0 } }, node_vectors[to_node], options, route);
+}
+
+bool AirwayRouter::find_route(const NavPoint* from, const NavPoint* to, const AirwayRouteOptions& options, AirwayRoute& route)
+{
+	return find_route(graph.find_node(from), graph.find_node(to), options, route);
+}
+
+bool AirwayRouter::find_route(const Coordinate& from, const Coordinate& to, const AirwayRouteOptions& options, AirwayRoute& route)
+{
+	Vector3 end = to_vector(to);
+	return search(nearest_nodes(to_vector(from), options), nearest_nodes(end, options), end, options, route);
+}
+
+std::vector<NavPoint> AirwayRouter::get_nav_points(const AirwayRoute& route) const
+{
+	std::vector<NavPoint> nav_points;
+	nav_points.reserve(route.nodes.size());
+	for (uint32_t node : route.nodes)
+	{
+		// the copies may outlive the parser of the graph
+		nav_points.push_back(*graph.get_nav_point(node));
+		nav_points.back().detach_strings();
+	}
+	return nav_points;
+}
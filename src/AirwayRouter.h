@@ -0,0 +1,74 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "AirwayGraph.h"
+#include "Coordinate.h"
+
+struct AirwayRouteOptions {
+    int cruise_fl = 0; // only the airways open at this flight level, 0: any
+    bool use_low_airways = true;
+    bool use_high_airways = true;
+    // coordinate queries: the route joins the airways at a fix this close to the start and the end
+    double max_connection_km = 100;
+    std::size_t connection_candidates = 8;
+};
+
+// legs[i] is the airway from nodes[i] to nodes[i + 1]
+struct AirwayRoute {
+    std::vector<uint32_t> nodes;
+    std::vector<uint32_t> airways;
+    double distance_km = 0; // the direct legs to and from the airways included
+    std::size_t settled_nodes = 0; // work done by the search
+};
+
+/* Shortest routes on an AirwayGraph with A*, the great circle distance to the destination
+   is the heuristic. The one way airways are only used in their direction. The search state is
+   reused between the queries, so a router shall be used by one thread at a time; the graph
+   shall not change while it has routers. */
+class AirwayRouter {
+private:
+    struct Vector3 {
+        double x, y, z;
+    };
+    struct Target {
+        uint32_t node;
+        double cost_km; // the direct leg from the node to the end
+    };
+    const AirwayGraph& graph;
+    std::vector<Vector3> node_vectors;
+    std::vector<uint32_t> edge_begin; // index of the first edge of each node in edge_km
+    std::vector<double> edge_km;
+    // search state, valid where visited == query
+    std::vector<uint32_t> visited;
+    std::vector<double> cost;
+    std::vector<uint32_t> parent;
+    std::vector<uint32_t> parent_airway;
+    std::vector<uint32_t> target_mark; // == query at the nodes where the route may leave the airways
+    std::vector<double> target_cost;
+    uint32_t query;
+    static Vector3 to_vector(const Coordinate& coordinate);
+    static double chord_to_km(const Vector3& a, const Vector3& b);
+    std::vector<Target> nearest_nodes(const Vector3& position, const AirwayRouteOptions& options) const;
+    bool search(const std::vector<Target>& starts, const std::vector<Target>& targets, const Vector3& end,
+        const AirwayRouteOptions& options, AirwayRoute& route);
+public:
+    AirwayRouter(const AirwayGraph& _graph);
+    const AirwayGraph& get_graph() const;
+    // from one airway fix to another, e.g. from the last fix of a SID to the first fix of a STAR
+    bool find_route(uint32_t from_node, uint32_t to_node, const AirwayRouteOptions& options, AirwayRoute& route);
+    bool find_route(const NavPoint* from, const NavPoint* to, const AirwayRouteOptions& options, AirwayRoute& route);
+    // e.g. between two airports: direct to the best airway fix near the start, direct from one near the end
+    bool find_route(const Coordinate& from, const Coordinate& to, const AirwayRouteOptions& options, AirwayRoute& route);
+    // the fixes of the route, to be assigned to FlightRoute::enroute_points
+    std::vector<NavPoint> get_nav_points(const AirwayRoute& route) const;
+    // the level and cruise flight level options
+    static bool edge_allowed(const AirwayEdge& edge, const AirwayRouteOptions& options);
+    // the length of an airway leg as the router measures it
+    static double great_circle_km(const Coordinate& from, const Coordinate& to);
+};
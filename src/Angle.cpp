@@ -10,13 +10,13 @@
 #include "Angle.h"
 #include "GlobalOptions.h"
 
-double Angle::convert_to_double()
+double Angle::convert_to_double() const
 {
 	double res = degree + (double)minute / 60 + (double)second / 3600;
 	return sign_negative ? (- 1 * res) : res;
 }
 
-double Angle::convert_to_radian()
+double Angle::convert_to_radian() const
 {
 	double angle = convert_to_double();
 	return (angle * 3.14159) / 180;
@@ -98,7 +98,7 @@ Angle& Angle::operator=(const double& d_val)
 	return *this;
 }
 
-bool Angle::operator==(const Angle& other)
+bool Angle::operator==(const Angle& other) const
 {
 	if (degree == other.degree && minute == other.minute && second == other.second && sign_negative == other.sign_negative)
 		return true;
@@ -106,37 +106,37 @@ bool Angle::operator==(const Angle& other)
 		return false;
 }
 
-bool Angle::operator!=(const Angle& other)
+bool Angle::operator!=(const Angle& other) const
 {
 	return !(*this == other);
 }
 
-Angle Angle::operator+(Angle& other)
+Angle Angle::operator+(const Angle& other) const
 {
 	return Angle(this->convert_to_double() + other.convert_to_double());
 }
 
-Angle Angle::operator-(Angle& other)
+Angle Angle::operator-(const Angle& other) const
 {
 	return Angle(this->convert_to_double() - other.convert_to_double());
 }
 
-int Angle::get_degree()
+int Angle::get_degree() const
 {
 	return sign_negative ?  (- 1 * degree) : degree;
 }
 
-int Angle::get_minute()
+int Angle::get_minute() const
 {
 	return minute;
 }
 
-int Angle::get_second()
+int Angle::get_second() const
 {
 	return second;
 }
 
-std::string Angle::to_string(bool use_abs)
+std::string Angle::to_string(bool use_abs) const
 {
 	std::ostringstream o_str;
 
@@ -14,17 +14,17 @@ public:
     Angle(int _degree, int _minute, int _second);
     Angle(double angle);
     Angle(int _degree, double minute_dec);
-    double convert_to_double();
-    double convert_to_radian();
-    std::string to_string(bool use_abs);
+    double convert_to_double() const;
+    double convert_to_radian() const;
+    std::string to_string(bool use_abs) const;
     Angle& operator=(const Angle& other);
     Angle& operator=(const double& d_val);
-    bool operator==(const Angle& other);
-    bool operator!=(const Angle& other);
-    Angle operator+(Angle& other);
-    Angle operator-(Angle& other);
-    int get_degree();
-    int get_minute();
-    int get_second();
+    bool operator==(const Angle& other) const;
+    bool operator!=(const Angle& other) const;
+    Angle operator+(const Angle& other) const;
+    Angle operator-(const Angle& other) const;
+    int get_degree() const;
+    int get_minute() const;
+    int get_second() const;
 };
 
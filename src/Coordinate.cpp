@@ -36,7 +36,7 @@ Coordinate::Coordinate(const Coordinate& other)
 	elevation = other.elevation;
 }
 
-std::string Coordinate::to_string()
+std::string Coordinate::to_string() const
 {
 	std::ostringstream o_str;
 	o_str << (lat.get_degree() < 0 ? "S" : "N") << lat.to_string(true) << " " << (lng.get_degree()<0 ? "W" : "E") << lng.to_string(true);
@@ -53,7 +53,7 @@ Coordinate& Coordinate::operator=(const Coordinate& other)
 	return *this;
 }
 
-double Coordinate::calculate_heading_ortho_departure(double lat1, double lng1, double lat2, double lng2)
+double Coordinate::calculate_heading_ortho_departure(double lat1, double lng1, double lat2, double lng2) const
 {
 	// calculate departure heading for orthodrom route. see details: http://www.edwilliams.org/avform147.htm#Crs
 	double direct_angle = (180 / PI) * std::fmod(atan2(sin(lng2 - lng1) * cos(lat2),
@@ -65,7 +65,7 @@ double Coordinate::calculate_heading_ortho_departure(double lat1, double lng1, d
 	return direct_angle;
 }
 
-double Coordinate::calculate_heading_ortho_arrival(double dep_heading, double lat1, double lng1, double lat2, double lng2)
+double Coordinate::calculate_heading_ortho_arrival(double dep_heading, double lat1, double lng1, double lat2, double lng2) const
 {
 	// calculate arrival heading for orthodrom route
 	// use the Clairaut's formula: http://www.edwilliams.org/avform147.htm#Crs
@@ -77,7 +77,7 @@ double Coordinate::calculate_heading_ortho_arrival(double dep_heading, double la
 	return direct_angle;
 }
 
-double Coordinate::calculate_heading_loxo(double lat1, double lng1, double lat2, double lng2)
+double Coordinate::calculate_heading_loxo(double lat1, double lng1, double lat2, double lng2) const
 {
 	//see details at http://www.edwilliams.org/avform147.htm#Rhumb
 	double dlon_W = std::fmod(lng1 - lng2, 2 * PI);
@@ -110,7 +110,7 @@ double Coordinate::calculate_heading_loxo(double lat1, double lng1, double lat2,
 	return direct_angle;
 }
 
-void Coordinate::get_relative_pos_to(Coordinate& destination, RelativePos& rel_pos)
+void Coordinate::get_relative_pos_to(const Coordinate& destination, RelativePos& rel_pos) const
 {
 	double lat1 = lat.convert_to_radian();
 	double lat2 = destination.lat.convert_to_radian();
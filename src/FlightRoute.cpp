@@ -5,22 +5,26 @@
  */
 #include <iostream>
 #include <fstream>
-#include <regex>
+#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include "FlightRoute.h"
 #include "Logger.h"
 
 FlightRoute::FlightRoute(std::string _name)
 {
-	name = _name;
+	name = std::move(_name);
 }
 
-std::vector<NavPoint> FlightRoute::get_all_navpoints()
+std::vector<NavPoint> FlightRoute::get_all_navpoints() const
 {
 	std::vector<NavPoint> all_points;
-	std::vector<NavPoint> sid_points = sid.get_nav_points();
-	std::vector<NavPoint> star_points = star.get_nav_points();
-	std::vector<NavPoint> approach_points = approach.get_nav_points();
+	const SharedNavPoints& sid_points = sid.get_nav_points();
+	const SharedNavPoints& star_points = star.get_nav_points();
+	const SharedNavPoints& approach_points = approach.get_nav_points();
 
+	all_points.reserve(sid_points.size() + enroute_points.size() + star_points.size() + approach_points.size());
 	all_points.insert(all_points.end(), sid_points.begin(), sid_points.end());
 	all_points.insert(all_points.end(), enroute_points.begin(), enroute_points.end());
 	all_points.insert(all_points.end(), star_points.begin(), star_points.end());
@@ -29,7 +33,7 @@ std::vector<NavPoint> FlightRoute::get_all_navpoints()
 	return all_points;
 }
 
-int FlightRoute::get_start_index_of_phase(RNAVProc::RNAVProcType type)
+int FlightRoute::get_start_index_of_phase(RNAVProc::RNAVProcType type) const
 {
 	int index = -1;
 
@@ -66,125 +70,397 @@ int FlightRoute::get_start_index_of_phase(RNAVProc::RNAVProcType type)
 	return index;
 }
 
+const NavPoint& FlightRoute::get_navpoint(std::size_t index) const
+{
+	if (index < sid.get_nav_points().size())
+		return sid.get_nav_points()[index];
+	index -= sid.get_nav_points().size();
+	if (index < enroute_points.size())
+		return enroute_points[index];
+	index -= enroute_points.size();
+	if (index < star.get_nav_points().size())
+		return star.get_nav_points()[index];
+	return approach.get_nav_points()[index - star.get_nav_points().size()];
+}
+
+std::size_t FlightRoute::get_navpoint_count() const
+{
+	return sid.get_nav_points().size() + enroute_points.size() + star.get_nav_points().size() + approach.get_nav_points().size();
+}
+
+bool FlightRoute::LegPhaseStamp::operator==(const LegPhaseStamp& other) const
+{
+	return size == other.size && first == other.first && last == other.last && first_lat == other.first_lat &&
+		first_lng == other.first_lng && last_lat == other.last_lat && last_lng == other.last_lng;
+}
+
+void FlightRoute::stamp_phases(LegPhaseStamp (&stamps)[4]) const
+{
+	auto stamp = [](const auto& points, LegPhaseStamp& phase_stamp) {
+		phase_stamp = LegPhaseStamp();
+		phase_stamp.size = points.size();
+		if (points.empty())
+			return;
+		phase_stamp.first = &points.front();
+		phase_stamp.last = &points.back();
+		phase_stamp.first_lat = points.front().get_coordinate().lat.convert_to_double();
+		phase_stamp.first_lng = points.front().get_coordinate().lng.convert_to_double();
+		phase_stamp.last_lat = points.back().get_coordinate().lat.convert_to_double();
+		phase_stamp.last_lng = points.back().get_coordinate().lng.convert_to_double();
+	};
+	stamp(sid.get_nav_points(), stamps[0]);
+	stamp(enroute_points, stamps[1]);
+	stamp(star.get_nav_points(), stamps[2]);
+	stamp(approach.get_nav_points(), stamps[3]);
+}
+
+bool FlightRoute::leg_metrics_current() const
+{
+	if (!legs_valid)
+		return false;
+
+	LegPhaseStamp stamps[4];
+	stamp_phases(stamps);
+	return std::equal(std::begin(stamps), std::end(stamps), std::begin(leg_phase_stamps));
+}
+
+void FlightRoute::compute_leg(std::size_t leg) const
+{
+	RelativePos rel_pos;
+	get_navpoint(leg).get_coordinate().get_relative_pos_to(get_navpoint(leg + 1).get_coordinate(), rel_pos);
+	// acos of the same point may be out of its domain
+	legs[leg].distance_km = std::isnan(rel_pos.dist_ortho) ? 0 : rel_pos.dist_ortho;
+	legs[leg].initial_true_course = rel_pos.heading_ortho_departure;
+	legs[leg].final_true_course = rel_pos.heading_ortho_arrival;
+}
+
+void FlightRoute::check_leg_metrics() const
+{
+	if (leg_metrics_current())
+		return;
+
+	std::size_t point_count = get_navpoint_count();
+	legs.assign(point_count > 1 ? point_count - 1 : 0, FlightRouteLeg());
+	for (std::size_t leg = 0; leg < legs.size(); leg++)
+		compute_leg(leg);
+	summed_leg_count = 0;
+	stamp_phases(leg_phase_stamps);
+	legs_valid = true;
+}
+
+void FlightRoute::sum_leg_distances() const
+{
+	check_leg_metrics();
+	distance_before_leg.resize(legs.size() + 1);
+	distance_before_leg[0] = 0;
+	for (std::size_t leg = std::max<std::size_t>(summed_leg_count, 1); leg <= legs.size(); leg++)
+		distance_before_leg[leg] = distance_before_leg[leg - 1] + legs[leg - 1].distance_km;
+	summed_leg_count = legs.size() + 1;
+}
+
+void FlightRoute::update_leg_metrics(bool was_current, std::size_t first, std::size_t old_count, std::size_t new_count)
+{
+	if (!was_current)
+	{
+		legs_valid = false;
+		return;
+	}
+
+	// the legs from the point before the replaced points to the point after them
+	std::size_t new_point_count = get_navpoint_count();
+	std::size_t old_point_count = new_point_count + old_count - new_count;
+	std::size_t begin = first > 0 ? first - 1 : 0;
+	std::size_t old_end = std::max(begin, std::min(first + old_count, old_point_count > 0 ? old_point_count - 1 : 0));
+	std::size_t new_end = std::max(begin, std::min(first + new_count, new_point_count > 0 ? new_point_count - 1 : 0));
+
+	legs.erase(legs.begin() + begin, legs.begin() + old_end);
+	legs.insert(legs.begin() + begin, new_end - begin, FlightRouteLeg());
+	for (std::size_t leg = begin; leg < new_end; leg++)
+		compute_leg(leg);
+
+	summed_leg_count = std::min(summed_leg_count, begin + 1);
+	stamp_phases(leg_phase_stamps);
+}
+
+void FlightRoute::insert_enroute_point(std::size_t index, const NavPoint& nav_point)
+{
+	bool was_current = leg_metrics_current();
+	index = std::min(index, enroute_points.size());
+	enroute_points.insert(enroute_points.begin() + index, nav_point);
+	update_leg_metrics(was_current, sid.get_nav_points().size() + index, 0, 1);
+}
+
+void FlightRoute::remove_enroute_point(std::size_t index)
+{
+	if (index >= enroute_points.size())
+		return;
+
+	bool was_current = leg_metrics_current();
+	enroute_points.erase(enroute_points.begin() + index);
+	update_leg_metrics(was_current, sid.get_nav_points().size() + index, 1, 0);
+}
+
+void FlightRoute::set_sid(const RNAVProc& _sid)
+{
+	bool was_current = leg_metrics_current();
+	std::size_t old_count = sid.get_nav_points().size();
+	sid = _sid;
+	update_leg_metrics(was_current, 0, old_count, sid.get_nav_points().size());
+}
+
+void FlightRoute::set_star(const RNAVProc& _star)
+{
+	bool was_current = leg_metrics_current();
+	std::size_t old_count = star.get_nav_points().size();
+	star = _star;
+	update_leg_metrics(was_current, sid.get_nav_points().size() + enroute_points.size(), old_count, star.get_nav_points().size());
+}
+
+void FlightRoute::set_approach(const RNAVProc& _approach)
+{
+	bool was_current = leg_metrics_current();
+	std::size_t old_count = approach.get_nav_points().size();
+	approach = _approach;
+	update_leg_metrics(was_current, sid.get_nav_points().size() + enroute_points.size() + star.get_nav_points().size(), old_count,
+		approach.get_nav_points().size());
+}
+
+void FlightRoute::invalidate_leg_metrics()
+{
+	legs_valid = false;
+}
+
+std::size_t FlightRoute::get_leg_count() const
+{
+	check_leg_metrics();
+	return legs.size();
+}
+
+const FlightRouteLeg& FlightRoute::get_leg(std::size_t leg) const
+{
+	check_leg_metrics();
+	return legs[leg];
+}
+
+double FlightRoute::get_total_distance_km() const
+{
+	sum_leg_distances();
+	return distance_before_leg.back();
+}
+
+double FlightRoute::get_distance_to_go_km(std::size_t leg) const
+{
+	sum_leg_distances();
+	if (leg >= legs.size())
+		return 0;
+	return distance_before_leg.back() - distance_before_leg[leg];
+}
+
+std::vector<FlightRouteFileEntry> FlightRoute::split_route_file(std::string_view content)
+{
+	const char* spaces = " \t\r\n\f\v";
+	auto trim = [spaces](std::string_view text) {
+		std::size_t begin = text.find_first_not_of(spaces);
+		if (begin == std::string_view::npos)
+			return std::string_view();
+		return text.substr(begin, text.find_last_not_of(spaces) - begin + 1);
+	};
+
+	std::vector<FlightRouteFileEntry> entries;
+	std::size_t line_begin = 0;
+	for (std::size_t line = 1; line_begin < content.size(); line++)
+	{
+		std::size_t line_end = std::min(content.find('\n', line_begin), content.size());
+		std::string_view text = content.substr(line_begin, line_end - line_begin);
+		line_begin = line_end + 1;
+
+		std::size_t equal = text.find('=');
+		if (equal == std::string_view::npos)
+			continue;
+
+		FlightRouteFileEntry entry;
+		entry.key = trim(text.substr(0, equal));
+		std::string_view value = text.substr(equal + 1);
+		std::size_t semicolon = value.find(';');
+		entry.first = trim(value.substr(0, semicolon));
+		entry.second = semicolon == std::string_view::npos ? std::string_view() : trim(value.substr(semicolon + 1));
+		entry.line = line;
+		entries.push_back(entry);
+	}
+	return entries;
+}
+
+int FlightRoute::get_route_point_index(std::string_view key)
+{
+	if (key.size() <= 6 || key.substr(0, 6) != "route_")
+		return -1;
+
+	int index = -1;
+	std::from_chars_result result = std::from_chars(key.data() + 6, key.data() + key.size(), index);
+	if (result.ec != std::errc() || result.ptr != key.data() + key.size() || index < 0)
+		return -1;
+	return index;
+}
+
+const NavPoint* FlightRoute::nearest_nav_point(const std::vector<const NavPoint*>& candidates, const NavPoint* previous)
+{
+	const NavPoint* nearest = candidates.empty() ? NULL : candidates.front();
+	if (previous == NULL)
+		return nearest;
+
+	double nearest_km = INFINITY;
+	for (const NavPoint* candidate : candidates)
+	{
+		RelativePos rel_pos;
+		previous->get_coordinate().get_relative_pos_to(candidate->get_coordinate(), rel_pos);
+		double km = std::isnan(rel_pos.dist_ortho) ? 0 : rel_pos.dist_ortho;
+		if (km < nearest_km)
+		{
+			nearest = candidate;
+			nearest_km = km;
+		}
+	}
+	return nearest;
+}
+
 bool FlightRoute::save_to_file(std::string file_name)
 {
 	std::ofstream o_str;
-	o_str.open(std::filesystem::path(file_name).string(), std::ofstream::out | std::ofstream::trunc);
+	o_str.open(std::filesystem::path(file_name).string(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
 	if (!o_str.is_open())
 	{
 		Logger(TLogLevel::logERROR) << "save flight route to file error: can't open file for write: " << file_name << std::endl;
 		return false;
 	}
 
-	o_str << "dep=" << departure_airport.get_icao_id() << ";" << departure_airport.get_icao_region() << std::endl;
-	o_str << "dest=" << destination_airport.get_icao_id() << ";" << destination_airport.get_icao_region() << std::endl;
-	o_str << "sid=" << sid.get_name() <<";"<< sid.get_airport_icao_id() << std::endl;
-	o_str << "star=" << star.get_name() << ";" << star.get_airport_icao_id() << std::endl;
-	o_str << "app=" << approach.get_name() << ";" << approach.get_airport_icao_id() << std::endl;
+	// the whole file is built in memory and written at once
+	std::string content;
+	content.reserve(128 + enroute_points.size() * 24);
+	auto add_line = [&content](const char* key, const std::string& first, const std::string& second) {
+		content += key;
+		content += '=';
+		content += first;
+		content += ';';
+		content += second;
+		content += '\n';
+	};
+
+	add_line("dep", departure_airport.get_icao_id(), departure_airport.get_icao_region());
+	add_line("dest", destination_airport.get_icao_id(), destination_airport.get_icao_region());
+	add_line("sid", sid.get_name(), sid.get_airport_icao_id());
+	add_line("star", star.get_name(), star.get_airport_icao_id());
+	add_line("app", approach.get_name(), approach.get_airport_icao_id());
 
-	int route_point_index = 0;
-	for (auto& nav_pt : enroute_points)
+	std::string key;
+	for (std::size_t route_point_index = 0; route_point_index < enroute_points.size(); route_point_index++)
 	{
-		o_str << "route_" << route_point_index << "=" << nav_pt.get_icao_id() << ";" << nav_pt.get_icao_region() << std::endl;
-		route_point_index++;
+		key = "route_" + std::to_string(route_point_index);
+		add_line(key.c_str(), enroute_points[route_point_index].get_icao_id(), enroute_points[route_point_index].get_icao_region());
 	}
 
+	o_str.write(content.data(), content.size());
 	o_str.close();
+	if (o_str.fail())
+	{
+		Logger(TLogLevel::logERROR) << "save flight route to file error: can't write file: " << file_name << std::endl;
+		return false;
+	}
 	return true;
 }
 
 bool FlightRoute::load_from_file(std::string file_name, XPlaneParser& parser)
 {
 	std::ifstream i_str;
-	i_str.open(std::filesystem::path(file_name).string(), std::ofstream::in);
+	i_str.open(std::filesystem::path(file_name).string(), std::ifstream::in | std::ifstream::binary);
 	if (!i_str.is_open())
 	{
 		Logger(TLogLevel::logERROR) << "load flight route from file error: can't open file for read: " << file_name << std::endl;
 		return false;
 	}
 
+	std::ostringstream content_stream;
+	content_stream << i_str.rdbuf();
+	i_str.close();
+	std::string content = content_stream.str();
+
 	//remove all enroute points before load from file
 	enroute_points.clear();
+	invalidate_leg_metrics();
 
-	std::string line;
-	while (std::getline(i_str, line))
+	// the route points are collected with their index and placed at the end
+	std::vector<std::pair<int, std::vector<const NavPoint*>>> route_points;
+	for (const FlightRouteFileEntry& entry : split_route_file(content))
 	{
-		// remove the leading and trailing whitespace
-		std::regex r("^\\s+");
-		line = std::regex_replace(line, r, "");
-		r = "\\s+$";
-		line = std::regex_replace(line, r, "");
-
-		if (line.size() == 0)
+		if (entry.first.empty() || entry.second.empty())
 			continue;
 
-		std::cmatch m;
-
-		if (std::regex_match(line.c_str(), m, std::regex("dep\\s*=\\s*(.+);(.+)$")))
-		{		
-			if (!parser.get_airport_by_icao_id(m[1], departure_airport)) {
-				Logger(TLogLevel::logERROR) << "error load_from_file: can't load departure airport " << m[1] << std::endl;
+		std::string first(entry.first);
+		if (entry.key == "dep")
+		{
+			if (!parser.get_airport_by_icao_id(first, departure_airport)) {
+				Logger(TLogLevel::logERROR) << "error load_from_file: can't load departure airport " << first << std::endl;
 				return false;
 			}
-
-			continue;
 		}
-
-		if (std::regex_match(line.c_str(), m, std::regex("dest\\s*=\\s*(.+);(.+)$")))
+		else if (entry.key == "dest")
 		{
-			if (!parser.get_airport_by_icao_id(m[1], destination_airport))
+			if (!parser.get_airport_by_icao_id(first, destination_airport))
 			{
-				Logger(TLogLevel::logERROR) << "error load_from_file: can't load destination airport " << m[1] << std::endl;
+				Logger(TLogLevel::logERROR) << "error load_from_file: can't load destination airport " << first << std::endl;
 				return false;
 			}
-			continue;
 		}
-
-		if (std::regex_match(line.c_str(), m, std::regex("sid\\s*=\\s*(.+);(.+)$")))
+		else if (entry.key == "sid")
 		{
-			if (!parser.get_procedure_by_id(m[1], m[2], sid))
+			if (!parser.get_procedure_by_id(first, std::string(entry.second), sid))
 			{
-				Logger(TLogLevel::logERROR) << "error load_from_file: can't load SID " << m[1] << std::endl;
+				Logger(TLogLevel::logERROR) << "error load_from_file: can't load SID " << first << std::endl;
 				return false;
 			}
-			continue;
 		}
-
-		if (std::regex_match(line.c_str(), m, std::regex("star\\s*=\\s*(.+);(.+)$")))
+		else if (entry.key == "star")
 		{
-			if (!parser.get_procedure_by_id(m[1], m[2], star))
+			if (!parser.get_procedure_by_id(first, std::string(entry.second), star))
 			{
-				Logger(TLogLevel::logERROR) << "error load_from_file: can't load STAR " << m[1] << std::endl;
+				Logger(TLogLevel::logERROR) << "error load_from_file: can't load STAR " << first << std::endl;
 				return false;
 			}
-			continue;
 		}
-
-		if (std::regex_match(line.c_str(), m, std::regex("app\\s*=\\s*(.+);(.+)$")))
+		else if (entry.key == "app")
 		{
-			if (!parser.get_procedure_by_id(m[1], m[2], approach)) 
+			if (!parser.get_procedure_by_id(first, std::string(entry.second), approach))
 			{
-				Logger(TLogLevel::logERROR) << "error load_from_file: can't load Approach " << m[1] << std::endl;
-
+				Logger(TLogLevel::logERROR) << "error load_from_file: can't load Approach " << first << std::endl;
 				return false;
 			}
-			continue;
 		}
-
-		if (std::regex_match(line.c_str(), m, std::regex("route_([0-9]+)\\s*=\\s*(.+);(.+)$")))
+		else
 		{
-			std::list<NavPoint> nav_pts = parser.get_nav_points_by_icao_id(m[3], m[2]);
-			if (nav_pts.size() == 0)
+			int index = get_route_point_index(entry.key);
+			if (index < 0)
+				continue;
+
+			std::vector<const NavPoint*> nav_pts = parser.find_nav_points_by_icao_id(std::string(entry.second), first);
+			if (nav_pts.empty())
 			{
-				Logger(TLogLevel::logERROR) << "error load_from_file: can't load enroute point " << m[2] << ";" << m[3] << std::endl;
+				Logger(TLogLevel::logERROR) << "error load_from_file: can't load enroute point " << first << ";" << entry.second << std::endl;
 				return false;
 			}
-
-			enroute_points.emplace(enroute_points.begin() + std::stoi(m[1]), nav_pts.front());
-			continue;
+			route_points.push_back({ index, std::move(nav_pts) });
 		}
+	}
 
+	std::stable_sort(route_points.begin(), route_points.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+	// the same choice of the duplicated idents as RouteValidator makes
+	const NavPoint* previous = !sid.get_nav_points().empty() ? &sid.get_nav_points().back() :
+		!departure_airport.get_icao_id().empty() ? &departure_airport : NULL;
+	enroute_points.reserve(route_points.size());
+	for (const auto& route_point : route_points)
+	{
+		previous = nearest_nav_point(route_point.second, previous);
+		// the route may outlive the parser
+		enroute_points.push_back(*previous);
+		enroute_points.back().detach_strings();
 	}
-	i_str.close();
 	return true;
 }
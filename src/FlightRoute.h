@@ -1,13 +1,57 @@
 #pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
 #include "GlobalOptions.h"
 #include "Airport.h"
 #include "RNAVProc.h"
 #include "NavPoint.h"
 #include "XPlane-navdata-parser/XPlaneParser.h"
 
+// "key=first;second" line of a route file, e.g. "route_3=BADOV;LZ" or "sid=BADO2B;LHBP"
+struct FlightRouteFileEntry {
+    std::string_view key;
+    std::string_view first;
+    std::string_view second; // empty if there is no ';'
+    std::size_t line; // from 1
+};
+
+// leg i of a route is flown from get_navpoint(i) to get_navpoint(i + 1)
+struct FlightRouteLeg {
+    double distance_km = 0; // great circle
+    Angle initial_true_course;
+    Angle final_true_course;
+};
+
 class FlightRoute {
 private:
     std::string name;
+    /* The leg cache. The legs follow the edits of the functions below, the distances before the
+       legs are summed up on demand from the first changed leg. The direct changes of the public
+       members are noticed by the stamps of the phases: a new size, other first or last point
+       objects (an assigned procedure, a reallocated vector) or a moved first or last point
+       rebuild the legs. Only an inner point changed in place needs invalidate_leg_metrics().
+       The const queries fill the cache: a route shall not be queried on several threads at once. */
+    struct LegPhaseStamp {
+        std::size_t size = 0;
+        const NavPoint* first = NULL;
+        const NavPoint* last = NULL;
+        double first_lat = 0, first_lng = 0, last_lat = 0, last_lng = 0;
+        bool operator==(const LegPhaseStamp& other) const;
+    };
+    mutable std::vector<FlightRouteLeg> legs;
+    mutable std::vector<double> distance_before_leg; // legs.size() + 1 items, the last one is the total
+    mutable std::size_t summed_leg_count = 0; // the items of distance_before_leg up to date
+    mutable LegPhaseStamp leg_phase_stamps[4]; // SID, enroute, STAR, approach of the cache
+    mutable bool legs_valid = false;
+    void stamp_phases(LegPhaseStamp (&stamps)[4]) const;
+    bool leg_metrics_current() const;
+    void check_leg_metrics() const;
+    void sum_leg_distances() const;
+    void compute_leg(std::size_t leg) const;
+    // the points [first, first + old_count) of get_all_navpoints() were replaced by new_count points
+    void update_leg_metrics(bool was_current, std::size_t first, std::size_t old_count, std::size_t new_count);
 public:
     FlightRoute(std::string _name);
     Airport departure_airport;
@@ -17,8 +61,33 @@ public:
     RNAVProc approach;
     Airport destination_airport;
     Airport alternate_airport;
-    std::vector<NavPoint> get_all_navpoints();
-    int get_start_index_of_phase(RNAVProc::RNAVProcType type);
+    std::vector<NavPoint> get_all_navpoints() const;
+    int get_start_index_of_phase(RNAVProc::RNAVProcType type) const;
+    // the point of get_all_navpoints() without the copy
+    const NavPoint& get_navpoint(std::size_t index) const;
+    std::size_t get_navpoint_count() const;
+
+    // the edits that keep the leg cache: only the legs next to the edit are computed again
+    void insert_enroute_point(std::size_t index, const NavPoint& nav_point);
+    void remove_enroute_point(std::size_t index);
+    void set_sid(const RNAVProc& _sid);
+    void set_star(const RNAVProc& _star);
+    void set_approach(const RNAVProc& _approach);
+    void invalidate_leg_metrics();
+
+    std::size_t get_leg_count() const;
+    const FlightRouteLeg& get_leg(std::size_t leg) const;
+    double get_total_distance_km() const;
+    // from the start of the leg to the end of the route
+    double get_distance_to_go_km(std::size_t leg) const;
     bool save_to_file(std::string file_name);
+    // the route points are placed by their index, the lines may come in any order
     bool load_from_file(std::string file_name, XPlaneParser& parser);
+    // the trimmed entries of the lines of a route file, the lines without '=' are skipped
+    static std::vector<FlightRouteFileEntry> split_route_file(std::string_view content);
+    // N of a "route_N" key, -1 for the other keys
+    static int get_route_point_index(std::string_view key);
+    // an ident used more than once in a region: the candidate nearest to the previous point
+    // (the first one if there is no previous point). NULL if there are no candidates
+    static const NavPoint* nearest_nav_point(const std::vector<const NavPoint*>& candidates, const NavPoint* previous);
 };
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <functional>
+
+/* ICAO identifier (fix, navaid, airport) packed into an integer, one byte per character,
+   the first character in the most significant byte. Identifiers up to 8 characters are
+   stored lossless, so two keys are equal only if the identifiers are equal.
+   Longer identifiers keep their first 7 characters and get the TRUNCATED marker in the
+   top byte: equal truncated keys still need a string compare. */
+struct IcaoIdKey {
+    static constexpr uint8_t TRUNCATED = 0xFF;
+    static constexpr std::size_t MAX_LENGTH = 8;
+
+    uint64_t value = 0;
+
+    constexpr IcaoIdKey() = default;
+    constexpr explicit IcaoIdKey(std::string_view id) : value(pack(id)) {}
+
+    static constexpr uint64_t pack(std::string_view id)
+    {
+        uint64_t packed = 0;
+        if (id.size() <= MAX_LENGTH)
+        {
+            for (std::size_t i = 0; i < MAX_LENGTH; i++)
+                packed = (packed << 8) | (i < id.size() ? (uint8_t)id[i] : 0);
+        }
+        else
+        {
+            packed = TRUNCATED;
+            for (std::size_t i = 0; i < MAX_LENGTH - 1; i++)
+                packed = (packed << 8) | (uint8_t)id[i];
+        }
+        return packed;
+    }
+
+    constexpr bool is_truncated() const { return (value >> 56) == TRUNCATED; }
+    constexpr bool empty() const { return value == 0; }
+    constexpr bool operator==(const IcaoIdKey& other) const { return value == other.value; }
+    constexpr bool operator!=(const IcaoIdKey& other) const { return value != other.value; }
+    constexpr bool operator<(const IcaoIdKey& other) const { return value < other.value; }
+};
+
+/* Two character ICAO region code packed into 16 bits. Anything longer than two
+   characters (e.g. "all") is mapped to UNPACKABLE. */
+struct IcaoRegionKey {
+    static constexpr uint16_t UNPACKABLE = 0xFFFF;
+
+    uint16_t value = 0;
+
+    constexpr IcaoRegionKey() = default;
+    constexpr explicit IcaoRegionKey(std::string_view region) : value(pack(region)) {}
+
+    static constexpr uint16_t pack(std::string_view region)
+    {
+        if (region.size() > 2)
+            return UNPACKABLE;
+
+        uint16_t packed = 0;
+        for (std::size_t i = 0; i < 2; i++)
+            packed = (uint16_t)((packed << 8) | (i < region.size() ? (uint8_t)region[i] : 0));
+        return packed;
+    }
+
+    constexpr bool is_packed() const { return value != UNPACKABLE; }
+    constexpr bool empty() const { return value == 0; }
+    constexpr bool operator==(const IcaoRegionKey& other) const { return value == other.value; }
+    constexpr bool operator!=(const IcaoRegionKey& other) const { return value != other.value; }
+    constexpr bool operator<(const IcaoRegionKey& other) const { return value < other.value; }
+};
+
+template<> struct std::hash<IcaoIdKey> {
+    std::size_t operator()(const IcaoIdKey& key) const noexcept
+    {
+        // the low bytes are often zero padding: mix the bits before bucketing
+        uint64_t h = key.value * 0x9E3779B97F4A7C15ull;
+        return (std::size_t)(h ^ (h >> 29));
+    }
+};
+
+template<> struct std::hash<IcaoRegionKey> {
+    std::size_t operator()(const IcaoRegionKey& key) const noexcept
+    {
+        return key.value;
+    }
+};
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <cstddef>
+
+struct LruCacheStats {
+    std::size_t hits = 0;
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+};
+
+/* Bounded key-value cache which drops the least recently used entry when it is full.
+   A cache with zero capacity is disabled: it stores nothing and counts no hits or misses. */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+private:
+    typedef std::list<std::pair<Key, Value>> ItemList;
+    ItemList items; // most recently used first
+    std::unordered_map<Key, typename ItemList::iterator, Hash> index;
+    std::size_t capacity;
+    LruCacheStats stats;
+
+    void evict_to(std::size_t max_size)
+    {
+        while (items.size() > max_size)
+        {
+            index.erase(items.back().first);
+            items.pop_back();
+            stats.evictions++;
+        }
+    }
+public:
+    explicit LruCache(std::size_t _capacity = 0) : capacity(_capacity) {}
+
+    bool enabled() const
+    {
+        return capacity > 0;
+    }
+
+    void set_capacity(std::size_t _capacity)
+    {
+        capacity = _capacity;
+        evict_to(capacity);
+    }
+
+    bool get(const Key& key, Value& value)
+    {
+        if (!enabled())
+            return false;
+
+        auto it = index.find(key);
+        if (it == index.end())
+        {
+            stats.misses++;
+            return false;
+        }
+
+        items.splice(items.begin(), items, it->second);
+        value = it->second->second;
+        stats.hits++;
+        return true;
+    }
+
+    void put(const Key& key, Value value)
+    {
+        if (!enabled())
+            return;
+
+        auto it = index.find(key);
+        if (it != index.end())
+        {
+            it->second->second = std::move(value);
+            items.splice(items.begin(), items, it->second);
+            return;
+        }
+
+        items.emplace_front(key, std::move(value));
+        index[key] = items.begin();
+        evict_to(capacity);
+    }
+
+    void erase(const Key& key)
+    {
+        auto it = index.find(key);
+        if (it == index.end())
+            return;
+
+        items.erase(it->second);
+        index.erase(it);
+    }
+
+    template <typename Predicate>
+    void erase_if(Predicate predicate)
+    {
+        for (auto it = items.begin(); it != items.end();)
+        {
+            if (predicate(it->first))
+            {
+                index.erase(it->first);
+                it = items.erase(it);
+            }
+            else
+                it++;
+        }
+    }
+
+    void clear()
+    {
+        items.clear();
+        index.clear();
+    }
+
+    std::size_t size() const
+    {
+        return items.size();
+    }
+
+    LruCacheStats get_stats() const
+    {
+        LruCacheStats current = stats;
+        current.size = items.size();
+        current.capacity = capacity;
+        return current;
+    }
+
+    void reset_stats()
+    {
+        stats = LruCacheStats();
+    }
+};
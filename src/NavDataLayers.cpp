@@ -0,0 +1,182 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <algorithm>
+#include "NavDataLayers.h"
+#include "Logger.h"
+
+// the strings of a procedure are in the string pool of its parser: the handle keeps the parser too
+static RNAVProcHandle layer_proc_handle(const std::shared_ptr<XPlaneParser>& parser, const RNAVProcHandle& proc)
+{
+	auto owner = std::make_shared<std::pair<std::shared_ptr<XPlaneParser>, RNAVProcHandle>>(parser, proc);
+	return RNAVProcHandle(owner, proc.get());
+}
+
+NavDataLayers::NavDataLayers() :
+	layers(std::make_shared<const LayerList>())
+{
+
+}
+
+std::shared_ptr<const NavDataLayers::LayerList> NavDataLayers::get_layers()
+{
+	std::lock_guard<std::mutex> lock(layers_guard);
+	return layers;
+}
+
+bool NavDataLayers::parse_layer(NavDataLayer& layer)
+{
+	layer.parser = std::make_shared<XPlaneParser>(layer.xplane_root_folder);
+	XPlaneParser& parser = *layer.parser;
+
+	if (std::filesystem::exists(parser.get_dat_file_path(EARTH_FIX_DAT)))
+	{
+		if (!parser.parse_earth_fix_dat_file())
+			return false;
+		layer.has_nav_points = true;
+	}
+
+	if (std::filesystem::exists(parser.get_dat_file_path(EARTH_NAV_DAT)))
+	{
+		if (!parser.parse_earth_nav_dat_file())
+			return false;
+		// the ILS records create airports too, but without apt.dat they are stubs: they would hide the real ones below
+		layer.has_nav_points = true;
+	}
+
+	if (std::filesystem::exists(parser.get_dat_file_path(APT_DAT)))
+	{
+		if (!parser.parse_apt_dat_file())
+			return false;
+		layer.has_airports = true;
+	}
+
+	layer.has_cifp_files = std::filesystem::exists(XPlaneParser::get_cifp_folder_path(layer.xplane_root_folder));
+	parser.update_nav_point_table();
+	return true;
+}
+
+bool NavDataLayers::set_layer(const std::string& name, const std::string& xplane_root_folder, int priority)
+{
+	NavDataLayer layer;
+	layer.name = name;
+	layer.xplane_root_folder = xplane_root_folder;
+	layer.priority = priority;
+
+	// the layer is parsed before the lock: the queries use the current layers meanwhile
+	if (!parse_layer(layer))
+	{
+		Logger(TLogLevel::logERROR) << "NavDataLayers: can't parse layer " << name << ": " << xplane_root_folder << std::endl;
+		return false;
+	}
+
+	// e.g. a CIFP only layer has no fixes of its own. the parsers are queried through this object
+	// only, so the resolver is not called after it is destroyed
+	layer.parser->set_fix_resolver([this](const std::string& region, const std::string& icao_id) {
+		std::vector<NavPointHandle> nav_points = find_nav_points_by_icao_id(region, icao_id);
+		return nav_points.empty() ? nullptr : nav_points.back();
+	});
+
+	std::lock_guard<std::mutex> lock(layers_guard);
+	auto next_layers = std::make_shared<LayerList>(*layers);
+	next_layers->erase(std::remove_if(next_layers->begin(), next_layers->end(), [&name](const NavDataLayer& l) { return l.name == name; }), next_layers->end());
+	next_layers->push_back(std::move(layer));
+	std::stable_sort(next_layers->begin(), next_layers->end(), [](const NavDataLayer& a, const NavDataLayer& b) { return a.priority > b.priority; });
+	layers = next_layers;
+	return true;
+}
+
+bool NavDataLayers::remove_layer(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(layers_guard);
+	auto next_layers = std::make_shared<LayerList>(*layers);
+	auto it = std::remove_if(next_layers->begin(), next_layers->end(), [&name](const NavDataLayer& l) { return l.name == name; });
+	if (it == next_layers->end())
+		return false;
+
+	next_layers->erase(it, next_layers->end());
+	layers = next_layers;
+	return true;
+}
+
+std::list<std::string> NavDataLayers::get_layer_names()
+{
+	std::list<std::string> names;
+	for (auto& layer : *get_layers())
+		names.push_back(layer.name);
+	return names;
+}
+
+std::vector<NavPointHandle> NavDataLayers::find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id)
+{
+	std::vector<NavPointHandle> nav_points;
+	for (auto& layer : *get_layers())
+	{
+		if (!layer.has_nav_points)
+			continue;
+
+		for (const NavPoint* nav_point : layer.parser->find_nav_points_by_icao_id(region, icao_id))
+			nav_points.push_back(NavPointHandle(layer.parser, nav_point));
+
+		if (nav_points.size() > 0)
+			break;
+	}
+	return nav_points;
+}
+
+AirportHandle NavDataLayers::find_airport_by_icao_id(const std::string& icao_id)
+{
+	for (auto& layer : *get_layers())
+	{
+		if (!layer.has_airports)
+			continue;
+
+		AirportHandle airport = layer.parser->find_airport_handle_by_icao_id(icao_id, layer.parser);
+		if (airport)
+			return airport;
+	}
+	return nullptr;
+}
+
+std::string NavDataLayers::get_airport_layer_name(const std::string& icao_id)
+{
+	for (auto& layer : *get_layers())
+	{
+		if (layer.has_airports && layer.parser->find_airport_by_icao_id(icao_id) != NULL)
+			return layer.name;
+	}
+	return "";
+}
+
+std::vector<RNAVProcHandle> NavDataLayers::find_rnav_procs_by_airport_icao_id(const std::string& icao_id)
+{
+	// the procedures of an airport come from one layer: the highest one which has them
+	std::vector<RNAVProcHandle> procs;
+	for (auto& layer : *get_layers())
+	{
+		if (!layer.has_cifp_files)
+			continue;
+
+		for (auto& proc : layer.parser->find_rnav_procs_by_airport_icao_id(icao_id))
+			procs.push_back(layer_proc_handle(layer.parser, proc));
+
+		if (procs.size() > 0)
+			break;
+	}
+	return procs;
+}
+
+RNAVProcHandle NavDataLayers::find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao)
+{
+	for (auto& layer : *get_layers())
+	{
+		if (!layer.has_cifp_files || layer.parser->find_rnav_procs_by_airport_icao_id(airport_icao).empty())
+			continue;
+
+		RNAVProcHandle proc = layer.parser->find_procedure_by_id(proc_name, airport_icao);
+		return proc ? layer_proc_handle(layer.parser, proc) : nullptr;
+	}
+	return nullptr;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include "XPlane-navdata-parser/XPlaneParser.h"
+
+struct NavDataLayer {
+    std::string name;
+    std::string xplane_root_folder;
+    int priority = 0; // the higher one wins
+    std::shared_ptr<XPlaneParser> parser;
+    // the files found in the layer. only the layers with apt.dat answer the airport queries
+    bool has_nav_points = false;
+    bool has_airports = false;
+    bool has_cifp_files = false;
+};
+
+/* Stack of independently parsed and indexed navdata sets, e.g. the default X-Plane data,
+   a navdata update and a small user overlay. A lookup asks the layers from the highest
+   priority down and the first layer which knows the ID answers alone: an overlay hides
+   the entities with the same ID in the layers below it. Nothing is copied or merged.
+   A layer may contain any subset of the dat files (and CIFP files). The procedure fixes
+   which are not in the layer of the procedure are looked up in the whole stack.
+   Replacing a layer parses that layer only; the queries running meanwhile see either
+   the old or the new layer, and the returned handles keep their layer alive. */
+class NavDataLayers {
+private:
+    typedef std::vector<NavDataLayer> LayerList;
+    std::shared_ptr<const LayerList> layers; // sorted by priority, highest first
+    std::mutex layers_guard;
+    std::shared_ptr<const LayerList> get_layers();
+    static bool parse_layer(NavDataLayer& layer);
+public:
+    NavDataLayers();
+    // parse the layer and add it or replace the layer with the same name
+    bool set_layer(const std::string& name, const std::string& xplane_root_folder, int priority);
+    bool remove_layer(const std::string& name);
+    std::list<std::string> get_layer_names();
+
+    std::vector<NavPointHandle> find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id);
+    AirportHandle find_airport_by_icao_id(const std::string& icao_id);
+    RNAVProcHandle find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao);
+    std::vector<RNAVProcHandle> find_rnav_procs_by_airport_icao_id(const std::string& icao_id);
+    // name of the layer which answers the airport query, empty if none
+    std::string get_airport_layer_name(const std::string& icao_id);
+};
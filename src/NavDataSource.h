@@ -0,0 +1,119 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <cstdint>
+#include "NavPoint.h"
+#include "RNAVProc.h"
+#include "AirwayGraph.h"
+
+/* Records yielded by a navdata source. The strings are plain copies: the sink interns
+   what it keeps. A source reuses its record objects, so a sink shall not keep references. */
+struct NavPointRecord {
+    std::string icao_id;
+    std::string icao_region;
+    std::string name;
+    double lat = 0;
+    double lng = 0;
+    double elevation = 0; // feet
+    NavPoint::RadioNavType radio_type = NavPoint::NONE;
+    int radio_frequency = 0;
+    double magnetic_variation = 0;
+};
+
+// an airport can arrive in several records: the empty/unset fields keep the already known values
+struct AirportRecord {
+    std::string icao_id;
+    std::string icao_region;
+    std::string name;
+    std::string iata_id;
+    std::string city;
+    std::string country;
+    std::string state;
+    bool has_position = false;
+    // e.g. derived from an ILS record: the position and region are used only for a new airport
+    bool is_estimate = false;
+    double lat = 0;
+    double lng = 0;
+    double elevation = 0; // feet
+    bool has_magnetic_variation = false;
+    double magnetic_variation = 0;
+    int transition_alt = 0;
+};
+
+// the zero fields keep the values of an already known runway
+struct RunwayRecord {
+    std::string airport_icao_id;
+    std::string name; // e.g. "13L"
+    int course = 0;
+    int ils_freq = 0;
+    int length = 0; // meters
+    int width = 0; // meters
+    bool has_threshold = false;
+    double threshold_lat = 0;
+    double threshold_lng = 0;
+    bool has_true_heading = false;
+    double true_heading = 0; // degrees
+    int threshold_elevation = 0; // feet
+    std::string localizer_id;
+};
+
+struct ProcedureLegRecord {
+    std::string airport_icao_id;
+    RNAVProc::RNAVProcType proc_type = RNAVProc::RNAV_OTHER;
+    std::string proc_name; // approaches with their transition: "I13L-CATUZ"
+    std::string transition; // runway ("RW13L") or transition of a SID/STAR
+    int sequence = 0;
+    std::string fix_icao_id;
+    std::string fix_icao_region;
+    // path terminator, constraints and recommended navaid. the fix is resolved by the sink
+    ProcedureLeg details;
+};
+
+typedef enum {
+    AIRWAY_FIX_WAYPOINT,
+    AIRWAY_FIX_NDB,
+    AIRWAY_FIX_VHF // VOR, VOR/DME, VORTAC, DME
+} AirwayFixKind;
+
+// one airway of a segment: a segment on several airways comes as several records
+struct AirwaySegmentRecord {
+    std::string from_icao_id;
+    std::string from_icao_region;
+    AirwayFixKind from_kind = AIRWAY_FIX_WAYPOINT;
+    std::string to_icao_id;
+    std::string to_icao_region;
+    AirwayFixKind to_kind = AIRWAY_FIX_WAYPOINT;
+    std::string airway_name;
+    AirwayDirection direction = AIRWAY_BOTH_WAYS;
+    AirwayLevel level = AIRWAY_LOW;
+    int base_fl = 0;
+    int top_fl = 0;
+};
+
+// receiver of the records, e.g. XPlaneParser
+class NavDataSink {
+public:
+    virtual ~NavDataSink() {}
+    virtual void add_nav_point(const NavPointRecord& record) = 0;
+    virtual void add_airport(const AirportRecord& record) = 0;
+    // the airport of the runway is created if it is not known yet
+    virtual void add_runway(const RunwayRecord& record) = 0;
+    // the legs of a procedure arrive in sequence order, after the nav points they refer to
+    virtual void add_procedure_leg(const ProcedureLegRecord& record) = 0;
+    // after the nav points they refer to. ignored by default
+    virtual void add_airway_segment(const AirwaySegmentRecord& /*record*/) {}
+};
+
+/* A navdata format reader which streams its records into a sink without building
+   its own copy of the data. Implementations: XPlaneNavDataSource, Arinc424NavDataSource. */
+class NavDataSource {
+public:
+    virtual ~NavDataSource() {}
+    // returns false if the source can't be read
+    virtual bool read(NavDataSink& sink) = 0;
+    virtual std::uintmax_t get_bytes_read() const = 0;
+};
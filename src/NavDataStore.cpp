@@ -0,0 +1,170 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "NavDataStore.h"
+#include "Logger.h"
+
+NavDataView::NavDataView(std::shared_ptr<XPlaneParser> _parser) :
+	parser(std::move(_parser))
+{
+
+}
+
+std::list<std::string> NavDataView::get_list_of_airport_iaco_codes() const
+{
+	return parser->get_list_of_airport_iaco_codes();
+}
+
+std::list<NavPoint> NavDataView::get_nav_points_by_icao_id(const std::string& icao_id) const
+{
+	return parser->get_nav_points_by_icao_id(icao_id);
+}
+
+std::list<NavPoint> NavDataView::get_nav_points_by_icao_id(const std::string& region, const std::string& icao_id) const
+{
+	return parser->get_nav_points_by_icao_id(region, icao_id);
+}
+
+bool NavDataView::get_airport_by_icao_id(const std::string& icao_id, Airport& _airport) const
+{
+	return parser->get_airport_by_icao_id(icao_id, _airport);
+}
+
+bool NavDataView::get_procedure_by_id(const std::string& proc_name, const std::string& airport_icao, RNAVProc& proc) const
+{
+	return parser->get_procedure_by_id(proc_name, airport_icao, proc);
+}
+
+std::list<RNAVProc> NavDataView::get_rnav_procs_by_airport_icao_id(const std::string& icao_id) const
+{
+	return parser->get_rnav_procs_by_airport_icao_id(icao_id);
+}
+
+std::vector<const NavPoint*> NavDataView::find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id) const
+{
+	return parser->find_nav_points_by_icao_id(region, icao_id);
+}
+
+const Airport* NavDataView::find_airport_by_icao_id(const std::string& icao_id) const
+{
+	return parser->find_airport_by_icao_id(icao_id);
+}
+
+RNAVProcHandle NavDataView::find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao) const
+{
+	return parser->find_procedure_by_id(proc_name, airport_icao);
+}
+
+std::vector<RNAVProcHandle> NavDataView::find_rnav_procs_by_airport_icao_id(const std::string& icao_id) const
+{
+	return parser->find_rnav_procs_by_airport_icao_id(icao_id);
+}
+
+std::vector<const Airport*> NavDataView::find_airports_within_distance(const Coordinate& center, double radius_km) const
+{
+	return parser->find_airports_within_distance(center, radius_km);
+}
+
+std::shared_ptr<const ProcedurePath> NavDataView::get_procedure_path(const std::string& proc_name, const std::string& airport_icao) const
+{
+	return parser->get_procedure_path(proc_name, airport_icao);
+}
+
+bool NavDataView::prefetch_airport_file(const std::string& airport_icao_code) const
+{
+	return parser->prefetch_airport_file(airport_icao_code);
+}
+
+QueryCacheStats NavDataView::get_query_cache_stats() const
+{
+	return parser->get_query_cache_stats();
+}
+
+std::shared_ptr<const NavPointTable> NavDataView::get_nav_point_table() const
+{
+	return parser->get_nav_point_table();
+}
+
+const AirwayGraph& NavDataView::get_airway_graph() const
+{
+	return parser->get_airway_graph();
+}
+
+std::shared_ptr<const RunwayIndex> NavDataView::get_runway_index() const
+{
+	return parser->get_runway_index();
+}
+
+NavDataStore::NavDataStore(std::string _xplane_root_folder) :
+	xplane_root_folder(std::move(_xplane_root_folder)), generation(0), query_cache_capacity(0)
+{
+
+}
+
+NavDataStore::~NavDataStore()
+{
+	// the background build refers to this object
+	std::lock_guard<std::mutex> lock(pending_reloads_guard);
+	for (const std::shared_future<bool>& reload : pending_reloads)
+		reload.wait();
+}
+
+bool NavDataStore::build_and_publish()
+{
+	std::lock_guard<std::mutex> lock(reload_guard);
+
+	auto next = std::make_shared<XPlaneParser>(xplane_root_folder);
+	if (!next->parse_earth_fix_dat_file() || !next->parse_earth_nav_dat_file() || !next->parse_apt_dat_file())
+	{
+		Logger(TLogLevel::logERROR) << "NavDataStore: can't build navdata snapshot, keep the current one" << std::endl;
+		return false;
+	}
+
+	// the airways are optional: a snapshot without them is still usable
+	if (!next->parse_earth_awy_dat_file())
+		Logger(TLogLevel::logWARNING) << "NavDataStore: no airways in the navdata snapshot" << std::endl;
+
+	// everything which is built lazily from the global data has to be ready before publishing
+	next->update_nav_point_table();
+	next->get_airway_graph();
+	next->enable_query_cache(query_cache_capacity);
+
+	current.store(std::make_shared<const NavDataView>(next));
+	generation++;
+	Logger(TLogLevel::logINFO) << "NavDataStore: navdata snapshot " << generation << " published" << std::endl;
+	return true;
+}
+
+bool NavDataStore::load()
+{
+	return build_and_publish();
+}
+
+std::shared_future<bool> NavDataStore::reload_async()
+{
+	std::shared_future<bool> reload = std::async(std::launch::async, [this]() { return build_and_publish(); }).share();
+	std::lock_guard<std::mutex> lock(pending_reloads_guard);
+	// forget the finished builds, the destructor waits for the others
+	std::erase_if(pending_reloads, [](const std::shared_future<bool>& pending) {
+		return pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	});
+	pending_reloads.push_back(reload);
+	return reload;
+}
+
+NavDataSnapshot NavDataStore::acquire() const
+{
+	return current.load();
+}
+
+uint64_t NavDataStore::get_generation() const
+{
+	return generation;
+}
+
+void NavDataStore::set_query_cache_capacity(std::size_t capacity)
+{
+	query_cache_capacity = capacity;
+}
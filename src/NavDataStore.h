@@ -0,0 +1,78 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <future>
+#include <vector>
+#include <cstdint>
+#include "XPlane-navdata-parser/XPlaneParser.h"
+
+/* Read only view of a fully loaded parser: the query API only, nothing which parses or
+   reloads. The global navdata (fixes, navaids, airways, apt.dat airports) is never modified
+   after it is published. The CIFP files are still loaded on demand by the queries: the
+   parser adds their procedures under its internal locks and publishes the CIFP runways in
+   new airport versions, so the airports already handed out stay unchanged. The returned
+   pointers are valid while the view is held. */
+class NavDataView {
+private:
+    std::shared_ptr<XPlaneParser> parser;
+public:
+    NavDataView(std::shared_ptr<XPlaneParser> _parser);
+    std::list<std::string> get_list_of_airport_iaco_codes() const;
+    std::list<NavPoint> get_nav_points_by_icao_id(const std::string& icao_id) const;
+    std::list<NavPoint> get_nav_points_by_icao_id(const std::string& region, const std::string& icao_id) const;
+    bool get_airport_by_icao_id(const std::string& icao_id, Airport& _airport) const;
+    bool get_procedure_by_id(const std::string& proc_name, const std::string& airport_icao, RNAVProc& proc) const;
+    std::list<RNAVProc> get_rnav_procs_by_airport_icao_id(const std::string& icao_id) const;
+    std::vector<const NavPoint*> find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id) const;
+    const Airport* find_airport_by_icao_id(const std::string& icao_id) const;
+    RNAVProcHandle find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao) const;
+    std::vector<RNAVProcHandle> find_rnav_procs_by_airport_icao_id(const std::string& icao_id) const;
+    std::vector<const Airport*> find_airports_within_distance(const Coordinate& center, double radius_km) const;
+    std::shared_ptr<const ProcedurePath> get_procedure_path(const std::string& proc_name, const std::string& airport_icao) const;
+    // load the CIFP file of an airport ahead of the first query
+    bool prefetch_airport_file(const std::string& airport_icao_code) const;
+    QueryCacheStats get_query_cache_stats() const;
+    std::shared_ptr<const NavPointTable> get_nav_point_table() const;
+    const AirwayGraph& get_airway_graph() const;
+    std::shared_ptr<const RunwayIndex> get_runway_index() const;
+};
+
+typedef std::shared_ptr<const NavDataView> NavDataSnapshot;
+
+/* Owner of the current navdata snapshot. Readers acquire() the snapshot and keep using
+   it as long as they hold the pointer. A reload builds the next snapshot on a background
+   thread and publishes it with an atomic pointer swap, so readers are never blocked;
+   the previous snapshot is released when its last reader drops it. */
+class NavDataStore {
+private:
+    std::string xplane_root_folder;
+    std::atomic<std::shared_ptr<const NavDataView>> current;
+    std::atomic<uint64_t> generation;
+    std::atomic<std::size_t> query_cache_capacity;
+    std::mutex reload_guard; // one snapshot build at a time
+    std::mutex pending_reloads_guard; // reload_async() may be called from several threads
+    std::vector<std::shared_future<bool>> pending_reloads;
+    bool build_and_publish();
+public:
+    NavDataStore(std::string _xplane_root_folder);
+    ~NavDataStore();
+    NavDataStore(const NavDataStore&) = delete;
+    NavDataStore& operator=(const NavDataStore&) = delete;
+    // parse the navdata on the calling thread and publish it
+    bool load();
+    // parse the navdata on a background thread and publish it when it is complete
+    std::shared_future<bool> reload_async();
+    // empty pointer until the first successful load
+    NavDataSnapshot acquire() const;
+    // incremented by every published snapshot
+    uint64_t get_generation() const;
+    // query cache capacity of the snapshots built after this call
+    void set_query_cache_capacity(std::size_t capacity);
+};
@@ -14,8 +14,28 @@
 #include "RelativePos.h"
 #include "NavPoint.h"
 #include "Airport.h"
+#include "ProcedureLeg.h"
 #include "RNAVProc.h"
+#include "ProcedurePath.h"
+#include "StringPool.h"
+#include "IcaoKey.h"
+#include "NavPointTable.h"
+#include "RunwayIndex.h"
+#include "AirwayGraph.h"
+#include "AirwayRouter.h"
+#include "AirwayHierarchy.h"
 #include "FlightRoute.h"
+#include "RouteStringParser.h"
+#include "RouteValidator.h"
+#include "NavDataSource.h"
 #include "XPlane-navdata-parser\XPlaneParser.h"
+#include "XPlane-navdata-parser\XPlaneNavDataSource.h"
+#include "XPlane-navdata-parser\XPlaneIncrementalLoader.h"
+#include "XPlane-navdata-parser\XPlaneAsyncLoader.h"
+#include "XPlane-navdata-parser\XPlaneShards.h"
+#include "XPlane-navdata-parser\CifpPrefetcher.h"
+#include "ARINC424-navdata-parser\Arinc424NavDataSource.h"
+#include "NavDataStore.h"
+#include "NavDataLayers.h"
 
 #define NAVME_LIB_VERSION "v0.5"
\ No newline at end of file
@@ -7,38 +7,24 @@
 #include "Logger.h"
 
 NavPoint::NavPoint(Coordinate _coordinate, std::string _name, std::string _icao_region, Angle _magnetic_variation) :
-	coordinate(_coordinate), icao_id(_name), icao_region(_icao_region), magnetic_variation(_magnetic_variation), radio_frequency(0)
+	magnetic_variation(_magnetic_variation), coordinate(_coordinate), icao_region(std::move(_icao_region)), icao_id(std::move(_name)),
+	icao_region_key(icao_region), icao_id_key(icao_id), radio_type(NONE), radio_frequency(0), planned_altitude(0), max_altitude(0), min_altitude(0)
 {
 	Logger(TLogLevel::logTRACE) << "NavPoint constructor: name=" << icao_id << " region=" << icao_region << " coordinate=" << coordinate.to_string() << std::endl;
 }
 
 NavPoint::NavPoint() :
- coordinate(), icao_id(""), icao_region(""), magnetic_variation(0), radio_frequency(0)
+ magnetic_variation(0), coordinate(), icao_region(""), icao_id(""), radio_type(NONE), radio_frequency(0), planned_altitude(0), max_altitude(0), min_altitude(0)
 {
 
 }
 
-NavPoint& NavPoint::operator=(const NavPoint& other)
-{
-	coordinate = other.coordinate;
-	icao_region = other.icao_region;
-	icao_id = other.icao_id;
-	name = other.name;
-	magnetic_variation = other.magnetic_variation;
-	radio_type = other.radio_type;
-	radio_frequency = other.radio_frequency;
-	max_altitude = other.max_altitude;
-	min_altitude = other.min_altitude;
-
-	return *this;
-}
-
-Coordinate NavPoint::get_coordinate()
+const Coordinate& NavPoint::get_coordinate() const
 {
 	return coordinate;
 }
 
-Angle NavPoint::get_magnetic_variation()
+const Angle& NavPoint::get_magnetic_variation() const
 {
 	return magnetic_variation;
 }
@@ -55,32 +41,54 @@ void NavPoint::set_coordinate(Coordinate _coord)
 
 void NavPoint::set_icao_region(std::string _region)
 {
-	icao_region = _region;
+	icao_region = std::move(_region);
+	icao_region_key = IcaoRegionKey(icao_region);
 }
 
-std::string NavPoint::get_icao_region()
+const std::string& NavPoint::get_icao_region() const
 {
-	return (icao_region);
+	return icao_region;
+}
+
+IcaoRegionKey NavPoint::get_icao_region_key() const
+{
+	return icao_region_key;
 }
 
 void NavPoint::set_icao_id(std::string _name)
 {
-	icao_id = _name;
+	icao_id = std::move(_name);
+	icao_id_key = IcaoIdKey(icao_id);
 }
 
-std::string NavPoint::get_icao_id()
+const std::string& NavPoint::get_icao_id() const
 {
 	return icao_id;
 }
 
+IcaoIdKey NavPoint::get_icao_id_key() const
+{
+	return icao_id_key;
+}
+
 void NavPoint::set_name(std::string _name)
 {
-	name = _name;
+	name = InternedString(_name);
+}
+
+void NavPoint::set_name(InternedString _name)
+{
+	name = std::move(_name);
+}
+
+const std::string& NavPoint::get_name() const
+{
+	return name.str();
 }
 
-std::string NavPoint::get_name()
+void NavPoint::detach_strings()
 {
-	return name;
+	name = name.detached();
 }
 
 void NavPoint::set_radio_type(RadioNavType _type)
@@ -88,7 +96,7 @@ void NavPoint::set_radio_type(RadioNavType _type)
 	radio_type = _type;
 }
 
-NavPoint::RadioNavType NavPoint::get_radio_type()
+NavPoint::RadioNavType NavPoint::get_radio_type() const
 {
 	return radio_type;
 }
@@ -98,7 +106,7 @@ void NavPoint::set_radio_frequency(int _freq)
 	radio_frequency = _freq;
 }
 
-int NavPoint::get_radio_frequency()
+int NavPoint::get_radio_frequency() const
 {
 	return radio_frequency;
 }
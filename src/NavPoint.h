@@ -7,6 +7,8 @@
 #include <string>
 #include "GlobalOptions.h"
 #include "Coordinate.h"
+#include "StringPool.h"
+#include "IcaoKey.h"
 
 class NavPoint {
 public:
@@ -25,27 +27,35 @@ protected:
     Coordinate coordinate;
     std::string icao_region;
     std::string icao_id;
-    std::string name;
+    // packed copies of icao_id and icao_region for fast compare and hashing
+    IcaoRegionKey icao_region_key;
+    IcaoIdKey icao_id_key;
+    InternedString name;
     RadioNavType radio_type;
     int radio_frequency;
 public:
     NavPoint();
     NavPoint(Coordinate _coordinate, std::string _icao_id, std::string _icao_region, Angle _magnetic_variation);
-    NavPoint& operator=(const NavPoint& other);
-    Coordinate get_coordinate();
-    Angle get_magnetic_variation();
+    const Coordinate& get_coordinate() const;
+    const Angle& get_magnetic_variation() const;
     void set_magnetic_variation(Angle _variation);
     void set_coordinate(Coordinate _coord);
     void set_icao_region(std::string _region);
-    std::string get_icao_region();
+    const std::string& get_icao_region() const;
+    IcaoRegionKey get_icao_region_key() const;
     void set_icao_id(std::string _icao_id);
-    std::string get_icao_id();
+    const std::string& get_icao_id() const;
+    IcaoIdKey get_icao_id_key() const;
+    // an own copy of the name, not pooled
     void set_name(std::string _name);
-    std::string get_name();
+    void set_name(InternedString _name);
+    const std::string& get_name() const;
+    // own copies of the pooled strings: the copy of an entity stays valid after its parser is destroyed
+    void detach_strings();
     void set_radio_type(RadioNavType _type);
-    RadioNavType get_radio_type();
+    RadioNavType get_radio_type() const;
     void set_radio_frequency(int _freq);
-    int get_radio_frequency();    
+    int get_radio_frequency() const;
     int planned_altitude;
     int max_altitude;
     int min_altitude;
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <cmath>
+#include <thread>
+#include <algorithm>
+#include "NavPointTable.h"
+
+static const double EARTH_RADIUS_KM = 6371;
+static const double DEG_TO_RAD = 3.14159265358979323846 / 180;
+
+uint32_t NavPointTable::radio_type_mask(NavPoint::RadioNavType type)
+{
+	return 1u << (uint32_t)type;
+}
+
+void NavPointTable::clear()
+{
+	lat.clear();
+	lng.clear();
+	x.clear();
+	y.clear();
+	z.clear();
+	elevation.clear();
+	radio_type.clear();
+	radio_frequency.clear();
+	icao_id_key.clear();
+	icao_region_key.clear();
+	nav_points.clear();
+}
+
+void NavPointTable::reserve(std::size_t rows)
+{
+	lat.reserve(rows);
+	lng.reserve(rows);
+	x.reserve(rows);
+	y.reserve(rows);
+	z.reserve(rows);
+	elevation.reserve(rows);
+	radio_type.reserve(rows);
+	radio_frequency.reserve(rows);
+	icao_id_key.reserve(rows);
+	icao_region_key.reserve(rows);
+	nav_points.reserve(rows);
+}
+
+void NavPointTable::append(const NavPoint* nav_point)
+{
+	const Coordinate& coord = nav_point->get_coordinate();
+	double lat_deg = coord.lat.convert_to_double();
+	double lng_deg = coord.lng.convert_to_double();
+
+	lat.push_back(lat_deg);
+	lng.push_back(lng_deg);
+	x.push_back(cos(lat_deg * DEG_TO_RAD) * cos(lng_deg * DEG_TO_RAD));
+	y.push_back(cos(lat_deg * DEG_TO_RAD) * sin(lng_deg * DEG_TO_RAD));
+	z.push_back(sin(lat_deg * DEG_TO_RAD));
+	elevation.push_back((float)coord.elevation);
+	radio_type.push_back((uint8_t)nav_point->get_radio_type());
+	radio_frequency.push_back(nav_point->get_radio_frequency());
+	icao_id_key.push_back(nav_point->get_icao_id_key().value);
+	icao_region_key.push_back(nav_point->get_icao_region_key().value);
+	nav_points.push_back(nav_point);
+}
+
+std::size_t NavPointTable::size() const
+{
+	return nav_points.size();
+}
+
+const double* NavPointTable::get_lat_data() const
+{
+	return lat.data();
+}
+
+const double* NavPointTable::get_lng_data() const
+{
+	return lng.data();
+}
+
+const float* NavPointTable::get_elevation_data() const
+{
+	return elevation.data();
+}
+
+const uint8_t* NavPointTable::get_radio_type_data() const
+{
+	return radio_type.data();
+}
+
+const int32_t* NavPointTable::get_radio_frequency_data() const
+{
+	return radio_frequency.data();
+}
+
+const uint64_t* NavPointTable::get_icao_id_key_data() const
+{
+	return icao_id_key.data();
+}
+
+const uint16_t* NavPointTable::get_icao_region_key_data() const
+{
+	return icao_region_key.data();
+}
+
+const NavPoint* NavPointTable::get_nav_point(std::size_t row) const
+{
+	return nav_points[row];
+}
+
+void NavPointTable::scan_distance(std::size_t first_row, std::size_t last_row, double px, double py, double pz, double min_dot, uint32_t type_mask, std::vector<std::size_t>& rows) const
+{
+	// great circle distance <= radius  <=>  dot product of the unit vectors >= cos(radius / R)
+	const double* xs = x.data();
+	const double* ys = y.data();
+	const double* zs = z.data();
+	const uint8_t* types = radio_type.data();
+
+	for (std::size_t i = first_row; i < last_row; i++)
+	{
+		double dot = xs[i] * px + ys[i] * py + zs[i] * pz;
+		if (dot >= min_dot && ((1u << types[i]) & type_mask))
+			rows.push_back(i);
+	}
+}
+
+std::vector<std::size_t> NavPointTable::find_within_distance(Coordinate center, double radius_km, uint32_t type_mask, unsigned thread_count) const
+{
+	double center_lat = center.lat.convert_to_double() * DEG_TO_RAD;
+	double center_lng = center.lng.convert_to_double() * DEG_TO_RAD;
+	double px = cos(center_lat) * cos(center_lng);
+	double py = cos(center_lat) * sin(center_lng);
+	double pz = sin(center_lat);
+	double min_dot = cos(std::min(radius_km / EARTH_RADIUS_KM, 3.14159265358979323846));
+
+	std::vector<std::size_t> rows;
+	std::size_t row_count = size();
+	if (thread_count <= 1 || row_count < thread_count)
+	{
+		scan_distance(0, row_count, px, py, pz, min_dot, type_mask, rows);
+		return rows;
+	}
+
+	std::vector<std::vector<std::size_t>> partial_rows(thread_count);
+	std::vector<std::thread> threads;
+	std::size_t chunk = (row_count + thread_count - 1) / thread_count;
+	for (unsigned t = 0; t < thread_count; t++)
+	{
+		std::size_t first_row = t * chunk;
+		std::size_t last_row = std::min(row_count, first_row + chunk);
+		threads.emplace_back([this, first_row, last_row, px, py, pz, min_dot, type_mask, t, &partial_rows]() {
+			scan_distance(first_row, last_row, px, py, pz, min_dot, type_mask, partial_rows[t]);
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	for (auto& part : partial_rows)
+		rows.insert(rows.end(), part.begin(), part.end());
+
+	return rows;
+}
+
+std::vector<std::size_t> NavPointTable::find_by_frequency(int frequency, uint32_t type_mask) const
+{
+	std::vector<std::size_t> rows;
+	for (std::size_t i = 0; i < radio_frequency.size(); i++)
+	{
+		if (radio_frequency[i] == frequency && ((1u << radio_type[i]) & type_mask))
+			rows.push_back(i);
+	}
+	return rows;
+}
+
+std::vector<std::size_t> NavPointTable::find_by_icao_id(IcaoIdKey key) const
+{
+	std::vector<std::size_t> rows;
+	for (std::size_t i = 0; i < icao_id_key.size(); i++)
+	{
+		if (icao_id_key[i] == key.value)
+			rows.push_back(i);
+	}
+	return rows;
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "NavPoint.h"
+#include "IcaoKey.h"
+
+/* Read only, column oriented copy of the nav points for scan heavy queries
+   ("all VORs within 200 km", "all NDBs on 350 kHz"). Row i of every column
+   belongs to the same nav point and get_nav_point(i) refers back to the full
+   object. The columns are plain arrays, so custom scans over them can be
+   vectorized by the compiler and split between threads by row ranges. */
+class NavPointTable {
+public:
+    static const uint32_t ALL_RADIO_TYPES = 0xFFFFFFFF;
+    static uint32_t radio_type_mask(NavPoint::RadioNavType type);
+private:
+    std::vector<double> lat; // degree
+    std::vector<double> lng; // degree
+    std::vector<double> x; // unit vector of the position (earth centered)
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<float> elevation; // feet
+    std::vector<uint8_t> radio_type;
+    std::vector<int32_t> radio_frequency;
+    std::vector<uint64_t> icao_id_key;
+    std::vector<uint16_t> icao_region_key;
+    std::vector<const NavPoint*> nav_points;
+    void scan_distance(std::size_t first_row, std::size_t last_row, double px, double py, double pz, double min_dot, uint32_t type_mask, std::vector<std::size_t>& rows) const;
+public:
+    void clear();
+    void reserve(std::size_t rows);
+    void append(const NavPoint* nav_point);
+    std::size_t size() const;
+
+    const double* get_lat_data() const;
+    const double* get_lng_data() const;
+    const float* get_elevation_data() const;
+    const uint8_t* get_radio_type_data() const;
+    const int32_t* get_radio_frequency_data() const;
+    const uint64_t* get_icao_id_key_data() const;
+    const uint16_t* get_icao_region_key_data() const;
+    const NavPoint* get_nav_point(std::size_t row) const;
+
+    // rows in table order. thread_count > 1 splits the scan between threads
+    std::vector<std::size_t> find_within_distance(Coordinate center, double radius_km, uint32_t type_mask = ALL_RADIO_TYPES, unsigned thread_count = 1) const;
+    std::vector<std::size_t> find_by_frequency(int frequency, uint32_t type_mask = ALL_RADIO_TYPES) const;
+    std::vector<std::size_t> find_by_icao_id(IcaoIdKey key) const;
+};
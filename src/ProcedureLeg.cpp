@@ -0,0 +1,197 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <algorithm>
+#include "ProcedureLeg.h"
+
+static_assert(sizeof(EncodedProcedureLeg) == 24, "the size of an encoded leg is documented");
+
+// in the order of PathTerminator
+static const char* PATH_TERMINATOR_CODES[] = {
+	"", "IF", "TF", "CF", "DF", "FA", "FC", "FD", "FM", "CA", "CD", "CI", "CR", "RF", "AF", "VA", "VD",
+	"VI", "VM", "VR", "PI", "HA", "HF", "HM"
+};
+const int PATH_TERMINATOR_COUNT = sizeof(PATH_TERMINATOR_CODES) / sizeof(PATH_TERMINATOR_CODES[0]);
+
+static std::string_view trim(std::string_view text)
+{
+	std::size_t first = text.find_first_not_of(' ');
+	if (first == std::string_view::npos)
+		return std::string_view();
+
+	return text.substr(first, text.find_last_not_of(' ') - first + 1);
+}
+
+static bool parse_digits(std::string_view text, int& value)
+{
+	value = 0;
+	if (text.empty())
+		return false;
+
+	for (char c : text)
+	{
+		if (c < '0' || c > '9')
+			return false;
+		value = value * 10 + (c - '0');
+	}
+	return true;
+}
+
+PathTerminator ProcedureLeg::parse_path_terminator(std::string_view code)
+{
+	code = trim(code);
+	for (int i = 1; i < PATH_TERMINATOR_COUNT; i++)
+	{
+		if (code == PATH_TERMINATOR_CODES[i])
+			return (PathTerminator)i;
+	}
+	return PATH_UNKNOWN;
+}
+
+const char* ProcedureLeg::path_terminator_code(PathTerminator path_terminator)
+{
+	if (path_terminator < 0 || path_terminator >= PATH_TERMINATOR_COUNT)
+		return "";
+
+	return PATH_TERMINATOR_CODES[path_terminator];
+}
+
+AltitudeConstraint ProcedureLeg::parse_altitude_constraint(char description, bool has_altitude)
+{
+	if (!has_altitude)
+		return ALTITUDE_NONE;
+
+	switch (description)
+	{
+	case '+':
+	case 'C':
+	case 'H':
+	case 'J':
+	case 'V':
+		return ALTITUDE_AT_OR_ABOVE;
+	case '-':
+	case 'Y':
+		return ALTITUDE_AT_OR_BELOW;
+	case 'B':
+		return ALTITUDE_BETWEEN;
+	default:
+		// ' ', '@' and the glide slope variants
+		return ALTITUDE_AT;
+	}
+}
+
+SpeedConstraint ProcedureLeg::parse_speed_constraint(char description, bool has_speed)
+{
+	if (!has_speed)
+		return SPEED_NONE;
+
+	switch (description)
+	{
+	case '+':
+		return SPEED_AT_OR_ABOVE;
+	case '-':
+		return SPEED_AT_OR_BELOW;
+	default:
+		return SPEED_AT;
+	}
+}
+
+int ProcedureLeg::parse_altitude(std::string_view field)
+{
+	field = trim(field);
+	int value = 0;
+	if (field.size() > 2 && field.substr(0, 2) == "FL")
+		return parse_digits(field.substr(2), value) ? value * 100 : 0;
+
+	bool negative = !field.empty() && field[0] == '-';
+	if (negative)
+		field.remove_prefix(1);
+
+	if (!parse_digits(field, value))
+		return 0;
+	return negative ? -value : value;
+}
+
+double ProcedureLeg::parse_tenths(std::string_view field, bool& is_time)
+{
+	field = trim(field);
+	is_time = !field.empty() && field[0] == 'T';
+	if (is_time)
+		field.remove_prefix(1);
+
+	int value = 0;
+	if (!parse_digits(field, value))
+		return 0;
+	return value / 10.0;
+}
+
+static uint16_t clamp_to_uint16(double value)
+{
+	return (uint16_t)std::clamp(value, 0.0, 65535.0);
+}
+
+EncodedProcedureLeg::EncodedProcedureLeg() :
+	recommended_navaid(0), recommended_navaid_region(0), fix_index(NO_FIX), altitude1(0), altitude2(0),
+	speed_limit(0), course(0), distance(0), path_terminator(PATH_UNKNOWN), flags(0)
+{
+
+}
+
+EncodedProcedureLeg::EncodedProcedureLeg(const ProcedureLeg& leg, uint16_t _fix_index) :
+	recommended_navaid(IcaoIdKey(leg.recommended_navaid_id).value),
+	recommended_navaid_region(IcaoRegionKey(leg.recommended_navaid_region).value),
+	fix_index(_fix_index),
+	altitude1(clamp_to_uint16(leg.altitude1)),
+	altitude2(clamp_to_uint16(leg.altitude2)),
+	speed_limit(clamp_to_uint16(leg.speed_limit)),
+	course(clamp_to_uint16(leg.course * 10 + 0.5)),
+	distance(clamp_to_uint16(leg.distance * 10 + 0.5)),
+	path_terminator((uint8_t)leg.path_terminator),
+	flags((uint8_t)(leg.altitude_constraint | (leg.speed_constraint << 3) | (leg.distance_is_time ? 0x20 : 0)))
+{
+
+}
+
+uint16_t EncodedProcedureLeg::get_fix_index() const
+{
+	return fix_index;
+}
+
+PathTerminator EncodedProcedureLeg::get_path_terminator() const
+{
+	return (PathTerminator)path_terminator;
+}
+
+// the packed key bytes back to text, without the zero padding
+static std::string unpack_key(uint64_t value, int bytes)
+{
+	std::string text;
+	for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8)
+	{
+		char c = (char)((value >> shift) & 0xFF);
+		if (c != 0)
+			text += c;
+	}
+	return text;
+}
+
+ProcedureLeg EncodedProcedureLeg::decode(const NavPoint* fix) const
+{
+	ProcedureLeg leg;
+	leg.path_terminator = (PathTerminator)path_terminator;
+	leg.fix = fix;
+	leg.altitude_constraint = (AltitudeConstraint)(flags & 0x07);
+	leg.altitude1 = altitude1;
+	leg.altitude2 = altitude2;
+	leg.speed_constraint = (SpeedConstraint)((flags >> 3) & 0x03);
+	leg.speed_limit = speed_limit;
+	leg.course = course / 10.0;
+	leg.distance = distance / 10.0;
+	leg.distance_is_time = (flags & 0x20) != 0;
+	leg.recommended_navaid_id = unpack_key(recommended_navaid, 8);
+	if (recommended_navaid_region != IcaoRegionKey::UNPACKABLE)
+		leg.recommended_navaid_region = unpack_key(recommended_navaid_region, 2);
+	return leg;
+}
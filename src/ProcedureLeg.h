@@ -0,0 +1,91 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "GlobalOptions.h"
+#include "NavPoint.h"
+#include "IcaoKey.h"
+
+// ARINC 424 path and terminator of a procedure leg
+typedef enum {
+    PATH_UNKNOWN,
+    PATH_IF, PATH_TF, PATH_CF, PATH_DF, PATH_FA, PATH_FC, PATH_FD, PATH_FM,
+    PATH_CA, PATH_CD, PATH_CI, PATH_CR, PATH_RF, PATH_AF, PATH_VA, PATH_VD,
+    PATH_VI, PATH_VM, PATH_VR, PATH_PI, PATH_HA, PATH_HF, PATH_HM
+} PathTerminator;
+
+typedef enum {
+    ALTITUDE_NONE,
+    ALTITUDE_AT,
+    ALTITUDE_AT_OR_ABOVE,
+    ALTITUDE_AT_OR_BELOW,
+    ALTITUDE_BETWEEN // at or below altitude1 and at or above altitude2
+} AltitudeConstraint;
+
+typedef enum {
+    SPEED_NONE,
+    SPEED_AT,
+    SPEED_AT_OR_ABOVE,
+    SPEED_AT_OR_BELOW
+} SpeedConstraint;
+
+// decoded view of a procedure leg, built on access
+struct ProcedureLeg {
+    PathTerminator path_terminator = PATH_UNKNOWN;
+    // points into the nav points of the procedure. NULL if the leg has no (known) fix, e.g. a VA leg
+    const NavPoint* fix = NULL;
+    AltitudeConstraint altitude_constraint = ALTITUDE_NONE;
+    int altitude1 = 0; // feet
+    int altitude2 = 0; // feet
+    SpeedConstraint speed_constraint = SPEED_NONE;
+    int speed_limit = 0; // knots
+    double course = 0; // magnetic, degrees
+    double distance = 0; // nautical miles, or minutes if distance_is_time (holds)
+    bool distance_is_time = false;
+    std::string recommended_navaid_id;
+    std::string recommended_navaid_region;
+
+    // decoders of the ARINC 424 field codes, shared by the CIFP and the raw ARINC 424 readers
+    static PathTerminator parse_path_terminator(std::string_view code);
+    static const char* path_terminator_code(PathTerminator path_terminator);
+    static AltitudeConstraint parse_altitude_constraint(char description, bool has_altitude);
+    static SpeedConstraint parse_speed_constraint(char description, bool has_speed);
+    // "05000" or "FL140" (flight level: 14000). blank or invalid: 0
+    static int parse_altitude(std::string_view field);
+    // tenths in the field: "2229" is 222.9, "T010" is 1.0 with is_time set
+    static double parse_tenths(std::string_view field, bool& is_time);
+};
+
+/* Fixed-size encoding of a procedure leg: 24 bytes per leg. The fix is a handle: the index
+   of its NavPoint in the procedure (see RNAVProc::get_nav_points). The recommended navaid
+   is kept as packed ID and region keys (8 characters at most), the altitudes in feet
+   (0..65535, below sea level is stored as 0), the speed in knots, the course and the
+   distance in tenths. Decoded into a ProcedureLeg only on access. */
+class EncodedProcedureLeg {
+private:
+    uint64_t recommended_navaid; // IcaoIdKey
+    uint16_t recommended_navaid_region; // IcaoRegionKey
+    uint16_t fix_index;
+    uint16_t altitude1;
+    uint16_t altitude2;
+    uint16_t speed_limit;
+    uint16_t course; // tenths of degrees
+    uint16_t distance; // tenths of nautical miles or minutes
+    uint8_t path_terminator;
+    // bits 0-2: AltitudeConstraint, bits 3-4: SpeedConstraint, bit 5: distance is time
+    uint8_t flags;
+public:
+    static const uint16_t NO_FIX = 0xFFFF;
+
+    EncodedProcedureLeg();
+    EncodedProcedureLeg(const ProcedureLeg& leg, uint16_t _fix_index);
+    uint16_t get_fix_index() const;
+    PathTerminator get_path_terminator() const;
+    // fix: the NavPoint of the fix index, NULL if there is none
+    ProcedureLeg decode(const NavPoint* fix) const;
+};
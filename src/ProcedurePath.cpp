@@ -0,0 +1,135 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <cmath>
+#include <algorithm>
+#include "ProcedurePath.h"
+
+const double PI = 3.14159265358979;
+const double EARTH_RADIUS_KM = 6371;
+
+const std::vector<PathPoint>& ProcedurePath::get_points() const
+{
+	return points;
+}
+
+const std::vector<uint32_t>& ProcedurePath::get_fix_point_indices() const
+{
+	return fix_point_indices;
+}
+
+const std::vector<uint32_t>& ProcedurePath::get_polyline_starts() const
+{
+	return polyline_starts;
+}
+
+std::size_t ProcedurePath::get_memory_bytes() const
+{
+	return sizeof(ProcedurePath) + points.capacity() * sizeof(PathPoint) + (fix_point_indices.capacity() + polyline_starts.capacity()) * sizeof(uint32_t);
+}
+
+ProcedurePathBuilder::ProcedurePathBuilder(double _max_segment_km, std::size_t segment_capacity) :
+	max_segment_km(_max_segment_km), segments(segment_capacity)
+{
+
+}
+
+uint64_t ProcedurePathBuilder::pack_position(const Coordinate& coordinate)
+{
+	// 1e-7 degree steps: distinct fixes never share a key
+	uint32_t lat = (uint32_t)(int32_t)std::lround(coordinate.lat.convert_to_double() * 1e7);
+	uint32_t lng = (uint32_t)(int32_t)std::lround(coordinate.lng.convert_to_double() * 1e7);
+	return ((uint64_t)lat << 32) | lng;
+}
+
+std::vector<PathPoint> ProcedurePathBuilder::densify(const Coordinate& from, const Coordinate& to, double max_segment_km)
+{
+	double lat1 = from.lat.convert_to_radian();
+	double lng1 = from.lng.convert_to_radian();
+	double lat2 = to.lat.convert_to_radian();
+	double lng2 = to.lng.convert_to_radian();
+
+	// unit vectors of the ends, the points are interpolated on the great circle between them
+	double x1 = cos(lat1) * cos(lng1), y1 = cos(lat1) * sin(lng1), z1 = sin(lat1);
+	double x2 = cos(lat2) * cos(lng2), y2 = cos(lat2) * sin(lng2), z2 = sin(lat2);
+	double angle = acos(std::clamp(x1 * x2 + y1 * y2 + z1 * z2, -1.0, 1.0));
+	int steps = std::max(1, (int)std::ceil(angle * EARTH_RADIUS_KM / max_segment_km));
+
+	std::vector<PathPoint> points;
+	points.reserve(steps + 1);
+	points.push_back({ (float)from.lat.convert_to_double(), (float)from.lng.convert_to_double() });
+	for (int i = 1; i < steps; i++)
+	{
+		double f = (double)i / steps;
+		double a = sin((1 - f) * angle) / sin(angle);
+		double b = sin(f * angle) / sin(angle);
+		double x = a * x1 + b * x2;
+		double y = a * y1 + b * y2;
+		double z = a * z1 + b * z2;
+		points.push_back({ (float)(atan2(z, sqrt(x * x + y * y)) * 180 / PI), (float)(atan2(y, x) * 180 / PI) });
+	}
+	points.push_back({ (float)to.lat.convert_to_double(), (float)to.lng.convert_to_double() });
+	return points;
+}
+
+ProcedurePathBuilder::Segment ProcedurePathBuilder::get_segment(const Coordinate& from, const Coordinate& to)
+{
+	SegmentKey key = { pack_position(from), pack_position(to) };
+	Segment segment;
+	if (segments.get(key, segment))
+		return segment;
+
+	segment = std::make_shared<const std::vector<PathPoint>>(densify(from, to, max_segment_km));
+	segments.put(key, segment);
+	return segment;
+}
+
+std::shared_ptr<const ProcedurePath> ProcedurePathBuilder::build(const RNAVProc& proc)
+{
+	std::shared_ptr<ProcedurePath> path = std::make_shared<ProcedurePath>();
+	const SharedNavPoints& nav_points = proc.get_nav_points();
+	const std::vector<ProcedureTransition>& transitions = proc.get_transitions();
+	path->fix_point_indices.reserve(nav_points.size());
+
+	std::size_t next_transition = 0;
+	for (std::size_t i = 0; i < nav_points.size(); i++)
+	{
+		// a transition without nav points (e.g. only VA legs) does not start a polyline
+		bool starts_polyline = i == 0;
+		while (next_transition < transitions.size() && transitions[next_transition].first_nav_point <= i)
+		{
+			starts_polyline = true;
+			next_transition++;
+		}
+
+		if (starts_polyline)
+		{
+			const Coordinate& first = nav_points[i].get_coordinate();
+			path->polyline_starts.push_back((uint32_t)path->points.size());
+			path->points.push_back({ (float)first.lat.convert_to_double(), (float)first.lng.convert_to_double() });
+		}
+		else if (pack_position(nav_points[i - 1].get_coordinate()) != pack_position(nav_points[i].get_coordinate()))
+		{
+			// the first point of the segment is the last point of the path
+			Segment segment = get_segment(nav_points[i - 1].get_coordinate(), nav_points[i].get_coordinate());
+			path->points.insert(path->points.end(), segment->begin() + 1, segment->end());
+		}
+		path->fix_point_indices.push_back((uint32_t)path->points.size() - 1);
+	}
+
+	path->points.shrink_to_fit();
+	path->polyline_starts.shrink_to_fit();
+	return path;
+}
+
+LruCacheStats ProcedurePathBuilder::get_segment_stats() const
+{
+	return segments.get_stats();
+}
+
+void ProcedurePathBuilder::clear()
+{
+	segments.clear();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "RNAVProc.h"
+#include "LruCache.h"
+
+// 8 bytes per point: float keeps ~1 m precision, enough to draw a path
+struct PathPoint {
+    float lat; // degree
+    float lng; // degree
+};
+
+/* Lateral path of a procedure: great circle polylines through its fixes, densified so that
+   no segment is longer than the max segment length of the builder. One polyline per
+   transition of the procedure: the transitions are not connected to each other. */
+class ProcedurePath {
+    friend class ProcedurePathBuilder;
+private:
+    std::vector<PathPoint> points;
+    std::vector<uint32_t> fix_point_indices; // index of the point of each fix
+    std::vector<uint32_t> polyline_starts; // index of the first point of each polyline
+public:
+    const std::vector<PathPoint>& get_points() const;
+    // one per nav point of the procedure, in procedure order
+    const std::vector<uint32_t>& get_fix_point_indices() const;
+    // a polyline runs from its start up to the start of the next one (or the last point)
+    const std::vector<uint32_t>& get_polyline_starts() const;
+    std::size_t get_memory_bytes() const;
+};
+
+/* Builds the paths of procedures. The densified segment between two fixes is cached by the
+   positions of its fixes, so the transitions and the approaches which share a part of their
+   route copy those segments instead of computing them again. */
+class ProcedurePathBuilder {
+private:
+    struct SegmentKey {
+        uint64_t from; // packed positions of the fixes
+        uint64_t to;
+        bool operator==(const SegmentKey& other) const { return from == other.from && to == other.to; }
+    };
+    struct SegmentKeyHash {
+        std::size_t operator()(const SegmentKey& key) const noexcept
+        {
+            uint64_t h = (key.from ^ (key.to * 0x9E3779B97F4A7C15ull)) * 0xBF58476D1CE4E5B9ull;
+            return (std::size_t)(h ^ (h >> 31));
+        }
+    };
+    typedef std::shared_ptr<const std::vector<PathPoint>> Segment;
+    double max_segment_km;
+    LruCache<SegmentKey, Segment, SegmentKeyHash> segments;
+    static uint64_t pack_position(const Coordinate& coordinate);
+    Segment get_segment(const Coordinate& from, const Coordinate& to);
+public:
+    ProcedurePathBuilder(double _max_segment_km = 1.852, std::size_t segment_capacity = 4096);
+    std::shared_ptr<const ProcedurePath> build(const RNAVProc& proc);
+    // the points of the great circle from..to, both ends included
+    static std::vector<PathPoint> densify(const Coordinate& from, const Coordinate& to, double max_segment_km);
+    LruCacheStats get_segment_stats() const;
+    void clear();
+};
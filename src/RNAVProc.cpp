@@ -12,70 +12,117 @@ RNAVProc::RNAVProc(std::string _name, std::string _icao_region, RNAVProcType _ty
 
 }
 
-RNAVProc::RNAVProc():
-	name(""), icao_region(""), type(RNAVProcType::RNAV_OTHER)
+RNAVProc::RNAVProc(InternedString _name, InternedString _icao_region, RNAVProcType _type) :
+	name(std::move(_name)), icao_region(std::move(_icao_region)), type(_type)
 {
 
 }
 
-RNAVProc::~RNAVProc()
+RNAVProc::RNAVProc():
+	name(), icao_region(), type(RNAVProcType::RNAV_OTHER)
 {
-	nav_points.clear();
+
 }
 
 void RNAVProc::add_nav_point(NavPoint nav_pnt)
 {
-	nav_points.emplace_back(nav_pnt);
+	nav_points.push_back(std::make_shared<const NavPoint>(std::move(nav_pnt)));
 }
 
-std::vector<NavPoint> RNAVProc::get_nav_points()
+const SharedNavPoints& RNAVProc::get_nav_points() const
 {
 	return nav_points;
 }
 
-std::string RNAVProc::get_name()
+void RNAVProc::add_leg(const ProcedureLeg& leg)
+{
+	add_leg(leg, leg.fix != NULL ? std::make_shared<const NavPoint>(*leg.fix) : nullptr);
+}
+
+void RNAVProc::add_leg(const ProcedureLeg& leg, std::shared_ptr<const NavPoint> fix)
+{
+	uint16_t fix_index = EncodedProcedureLeg::NO_FIX;
+	if (fix && nav_points.size() < EncodedProcedureLeg::NO_FIX)
+	{
+		fix_index = (uint16_t)nav_points.size();
+		nav_points.push_back(std::move(fix));
+	}
+	legs.emplace_back(leg, fix_index);
+}
+
+void RNAVProc::start_transition(InternedString transition_name)
+{
+	transitions.push_back({ std::move(transition_name), (uint32_t)nav_points.size() });
+}
+
+const std::vector<ProcedureTransition>& RNAVProc::get_transitions() const
+{
+	return transitions;
+}
+
+std::size_t RNAVProc::get_leg_count() const
+{
+	return legs.size();
+}
+
+ProcedureLeg RNAVProc::get_leg(std::size_t index) const
+{
+	const EncodedProcedureLeg& leg = legs.at(index);
+	uint16_t fix_index = leg.get_fix_index();
+	return leg.decode(fix_index == EncodedProcedureLeg::NO_FIX ? NULL : &nav_points[fix_index]);
+}
+
+const std::string& RNAVProc::get_name() const
 {
-	return name;
+	return name.str();
 }
 
-std::string RNAVProc::get_region()
+const std::string& RNAVProc::get_region() const
 {
-	return icao_region;
+	return icao_region.str();
 }
 
-RNAVProc::RNAVProcType RNAVProc::get_type()
+RNAVProc::RNAVProcType RNAVProc::get_type() const
 {
 	return type;
 }
 
-std::string RNAVProc::get_airport_icao_id()
+void RNAVProc::detach_strings()
 {
-	return airport_iaco_id;
+	name = name.detached();
+	icao_region = icao_region.detached();
+	airport_iaco_id = airport_iaco_id.detached();
+	rwy = rwy.detached();
+	for (ProcedureTransition& transition : transitions)
+		transition.name = transition.name.detached();
+}
+
+const std::string& RNAVProc::get_airport_icao_id() const
+{
+	return airport_iaco_id.str();
 }
 
 void RNAVProc::set_airport_iaco_id(std::string _airport_icao_id)
 {
-	airport_iaco_id = _airport_icao_id;
+	airport_iaco_id = InternedString(_airport_icao_id);
 }
 
-std::string RNAVProc::get_runway_name()
+void RNAVProc::set_airport_iaco_id(InternedString _airport_icao_id)
 {
-	return rwy;
+	airport_iaco_id = std::move(_airport_icao_id);
 }
 
-void RNAVProc::set_runway_name(std::string _rwy)
+const std::string& RNAVProc::get_runway_name() const
 {
-	rwy = _rwy;
+	return rwy.str();
 }
 
-RNAVProc& RNAVProc::operator=(const RNAVProc& other)
+void RNAVProc::set_runway_name(std::string _rwy)
 {
-	name = other.name;
-	icao_region = other.icao_region;
-	airport_iaco_id = other.airport_iaco_id;
-	rwy = other.rwy;
-	type = other.type;
-	nav_points = other.nav_points;
+	rwy = InternedString(_rwy);
+}
 
-	return *this;
+void RNAVProc::set_runway_name(InternedString _rwy)
+{
+	rwy = std::move(_rwy);
 }
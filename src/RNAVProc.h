@@ -6,8 +6,57 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <memory>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
 #include "GlobalOptions.h"
 #include "NavPoint.h"
+#include "StringPool.h"
+#include "ProcedureLeg.h"
+
+/* The nav points of a procedure, read like a std::vector<NavPoint>. The elements are shared:
+   the legs of the procedures of a parser which have the same fix, and the copies of the
+   procedure, point to the same NavPoint. */
+class SharedNavPoints {
+private:
+    std::vector<std::shared_ptr<const NavPoint>> nav_points;
+public:
+    class const_iterator {
+    private:
+        std::vector<std::shared_ptr<const NavPoint>>::const_iterator it;
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef NavPoint value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const NavPoint* pointer;
+        typedef const NavPoint& reference;
+        const_iterator() = default;
+        explicit const_iterator(std::vector<std::shared_ptr<const NavPoint>>::const_iterator _it) : it(_it) {}
+        reference operator*() const { return **it; }
+        pointer operator->() const { return it->get(); }
+        const_iterator& operator++() { ++it; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++it; return old; }
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+    };
+
+    void push_back(std::shared_ptr<const NavPoint> nav_point) { nav_points.push_back(std::move(nav_point)); }
+    std::size_t size() const { return nav_points.size(); }
+    bool empty() const { return nav_points.empty(); }
+    const NavPoint& operator[](std::size_t index) const { return *nav_points[index]; }
+    const NavPoint& front() const { return *nav_points.front(); }
+    const NavPoint& back() const { return *nav_points.back(); }
+    const_iterator begin() const { return const_iterator(nav_points.begin()); }
+    const_iterator end() const { return const_iterator(nav_points.end()); }
+};
+
+// a runway or enroute transition of a SID/STAR. Its nav points follow each other, up to the
+// first nav point of the next transition
+struct ProcedureTransition {
+    InternedString name;
+    uint32_t first_nav_point; // index in RNAVProc::get_nav_points()
+};
 
 class RNAVProc {
 public:
@@ -18,25 +67,43 @@ public:
         RNAV_OTHER
     } RNAVProcType;
 
+    // the std::string overloads keep own copies, not pooled
     RNAVProc(std::string _name, std::string _icao_region, RNAVProcType _type);
+    RNAVProc(InternedString _name, InternedString _icao_region, RNAVProcType _type);
     RNAVProc();
-    ~RNAVProc();
-    RNAVProc& operator=(const RNAVProc& other);
     void add_nav_point(NavPoint nav_pnt);
-    std::vector<NavPoint> get_nav_points();
-    std::string get_name();
-    std::string get_region();
-    std::string get_airport_icao_id();
-    std::string get_runway_name();
+    const SharedNavPoints& get_nav_points() const;
+    // the fix of the leg (if any) is copied and appended to the nav points
+    void add_leg(const ProcedureLeg& leg);
+    // the fix (if any, leg.fix is not used) is shared and appended to the nav points
+    void add_leg(const ProcedureLeg& leg, std::shared_ptr<const NavPoint> fix);
+    // the legs and nav points added after this call belong to the transition
+    void start_transition(InternedString transition_name);
+    // empty if the procedure was built without transitions
+    const std::vector<ProcedureTransition>& get_transitions() const;
+    std::size_t get_leg_count() const;
+    // decoded on every call, the fix points into get_nav_points()
+    ProcedureLeg get_leg(std::size_t index) const;
+    const std::string& get_name() const;
+    const std::string& get_region() const;
+    const std::string& get_airport_icao_id() const;
+    const std::string& get_runway_name() const;
     void set_runway_name(std::string _rwy);
+    void set_runway_name(InternedString _rwy);
     void set_airport_iaco_id(std::string _airport_icao_id);
-    RNAVProcType get_type();
+    void set_airport_iaco_id(InternedString _airport_icao_id);
+    RNAVProcType get_type() const;
+    /* own copies of the pooled strings of the procedure (see NavPoint::detach_strings). the
+       shared fixes of a parser keep its string pool alive themselves */
+    void detach_strings();
 private:
-    std::string name;
-    std::string icao_region;
-    std::string airport_iaco_id;
-    std::string rwy;
+    InternedString name;
+    InternedString icao_region;
+    InternedString airport_iaco_id;
+    InternedString rwy;
     RNAVProcType type;
     //std::vector<std::string> nav_point_ids;
-    std::vector<NavPoint> nav_points;
+    SharedNavPoints nav_points;
+    std::vector<EncodedProcedureLeg> legs;
+    std::vector<ProcedureTransition> transitions;
 };
@@ -0,0 +1,284 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <algorithm>
+#include "RouteStringParser.h"
+#include "AirwayRouter.h"
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// N0450F350, M082F350, K0830S1130: the speed and the level of the next part of the route
+static bool is_speed_level(std::string_view token)
+{
+	if (token.size() < 8 || (token[0] != 'N' && token[0] != 'K' && token[0] != 'M'))
+		return false;
+
+	std::size_t pos = 1;
+	while (pos < token.size() && is_digit(token[pos]))
+		pos++;
+	if (pos < 4 || pos > 5 || pos >= token.size() || (token[pos] != 'F' && token[pos] != 'A' && token[pos] != 'S' && token[pos] != 'M'))
+		return false;
+
+	std::size_t level = ++pos;
+	while (pos < token.size() && is_digit(token[pos]))
+		pos++;
+	return pos == token.size() && pos - level >= 3 && pos - level <= 4;
+}
+
+static bool same_point(const NavPoint& a, const NavPoint& b)
+{
+	return a.get_icao_id() == b.get_icao_id() && a.get_icao_region() == b.get_icao_region();
+}
+
+// the chain of the airway with the node and the position of the node in it
+static bool find_on_airway(const std::vector<std::span<const uint32_t>>& chains, uint32_t node, std::size_t& chain, std::size_t& position)
+{
+	for (chain = 0; chain < chains.size(); chain++)
+	{
+		auto node_it = std::find(chains[chain].begin(), chains[chain].end(), node);
+		if (node_it != chains[chain].end())
+		{
+			position = node_it - chains[chain].begin();
+			return true;
+		}
+	}
+	return false;
+}
+
+RouteStringParser::RouteStringParser(XPlaneParser& _parser) :
+	parser(_parser)
+{
+
+}
+
+const std::vector<RouteStringError>& RouteStringParser::get_errors() const
+{
+	return errors;
+}
+
+std::vector<std::string_view> RouteStringParser::tokenize(std::string_view route_string)
+{
+	std::vector<std::string_view> tokens;
+	std::size_t pos = 0;
+	while (pos < route_string.size())
+	{
+		while (pos < route_string.size() && is_space(route_string[pos]))
+			pos++;
+		std::size_t start = pos;
+		while (pos < route_string.size() && !is_space(route_string[pos]))
+			pos++;
+
+		// BADOV/N0450F350: the new speed and level from the point
+		std::string_view token = route_string.substr(start, pos - start);
+		token = token.substr(0, token.find('/'));
+		if (!token.empty() && token != "DCT" && !is_speed_level(token))
+			tokens.push_back(token);
+	}
+	return tokens;
+}
+
+bool RouteStringParser::find_airport(std::string_view token, Airport& airport)
+{
+	if (token.size() != 4)
+		return false;
+
+	// the handle keeps a CIFP version of the airport alive while it is copied
+	AirportHandle airport_handle = parser.find_airport_handle_by_icao_id(std::string(token));
+	if (!airport_handle)
+		return false;
+
+	// the route may outlive the parser
+	airport = *airport_handle;
+	airport.detach_strings();
+	return true;
+}
+
+bool RouteStringParser::find_procedure(std::string_view token, const Airport& airport, RNAVProc::RNAVProcType type, RNAVProc& proc)
+{
+	// the procedure designators have a validity number (BADO2B), most of the fix idents are not looked up
+	if (std::none_of(token.begin(), token.end(), is_digit))
+		return false;
+
+	// no copy and no error log for the airports without procedures: only a match is copied
+	RNAVProcHandle handle = parser.find_procedure_by_id(std::string(token), airport.get_icao_id());
+	if (!handle || handle->get_type() != type)
+	{
+		proc = RNAVProc();
+		return false;
+	}
+
+	proc = *handle;
+	proc.detach_strings();
+	return true;
+}
+
+const NavPoint* RouteStringParser::find_fix(const AirwayGraph& graph, std::string_view token, uint32_t next_airway, const Coordinate* reference)
+{
+	std::vector<const NavPoint*> candidates = parser.find_nav_points_by_icao_id("all", std::string(token));
+	if (candidates.size() == 1)
+		return candidates.front();
+
+	std::vector<std::span<const uint32_t>> chains;
+	if (next_airway != AirwayGraph::NO_AIRWAY)
+		chains = graph.get_airway_chains(next_airway);
+
+	// the fixes of the next airway first, then the nearest one
+	const NavPoint* nearest = NULL;
+	bool nearest_on_airway = false;
+	double nearest_km = 0;
+	for (const NavPoint* candidate : candidates)
+	{
+		std::size_t chain, position;
+		bool on_airway = find_on_airway(chains, graph.find_node(candidate), chain, position);
+		double km = reference != NULL ? AirwayRouter::great_circle_km(*reference, candidate->get_coordinate()) : 0;
+		if (nearest == NULL || on_airway > nearest_on_airway || (on_airway == nearest_on_airway && km < nearest_km))
+		{
+			nearest = candidate;
+			nearest_on_airway = on_airway;
+			nearest_km = km;
+		}
+	}
+	return nearest;
+}
+
+const NavPoint* RouteStringParser::follow_airway(const AirwayGraph& graph, uint32_t airway, const NavPoint* entry, std::size_t token_index,
+	const std::vector<std::string_view>& tokens, FlightRoute& route)
+{
+	std::string_view exit_id = tokens[token_index + 1];
+	std::vector<std::span<const uint32_t>> chains = graph.get_airway_chains(airway);
+	std::size_t chain, entry_position;
+	if (!find_on_airway(chains, graph.find_node(entry), chain, entry_position))
+		return NULL;
+
+	// the exit with this ident nearest to the entry along the airway
+	const std::span<const uint32_t>& fixes = chains[chain];
+	std::size_t exit_position = entry_position;
+	for (std::size_t distance = 1; distance < fixes.size() && exit_position == entry_position; distance++)
+	{
+		if (entry_position + distance < fixes.size() && graph.get_nav_point(fixes[entry_position + distance])->get_icao_id() == exit_id)
+			exit_position = entry_position + distance;
+		else if (distance <= entry_position && graph.get_nav_point(fixes[entry_position - distance])->get_icao_id() == exit_id)
+			exit_position = entry_position - distance;
+	}
+	if (exit_position == entry_position)
+		return NULL;
+
+	bool against_one_way = false;
+	std::size_t position = entry_position;
+	while (position != exit_position)
+	{
+		uint32_t from = fixes[position];
+		position = exit_position > position ? position + 1 : position - 1;
+		bool allowed = false;
+		for (const AirwayEdge& edge : graph.get_edges(from))
+			allowed = allowed || (edge.to == fixes[position] && edge.airway == airway);
+		against_one_way = against_one_way || !allowed;
+		route.enroute_points.push_back(*graph.get_nav_point(fixes[position]));
+		route.enroute_points.back().detach_strings();
+	}
+	if (against_one_way)
+		errors.push_back({ ROUTE_STRING_AGAINST_ONE_WAY, token_index, std::string(tokens[token_index]) });
+	return graph.get_nav_point(fixes[exit_position]);
+}
+
+bool RouteStringParser::parse(std::string_view route_string, FlightRoute& route)
+{
+	errors.clear();
+	route.departure_airport = Airport();
+	route.sid = RNAVProc();
+	route.enroute_points.clear();
+	route.star = RNAVProc();
+	route.destination_airport = Airport();
+	route.invalidate_leg_metrics();
+
+	std::vector<std::string_view> tokens = tokenize(route_string);
+	std::size_t first = 0; // the enroute tokens are [first, last)
+	std::size_t last = tokens.size();
+	if (tokens.size() > 1 && find_airport(tokens.front(), route.departure_airport))
+		first++;
+	if (last > first && find_airport(tokens[last - 1], route.destination_airport))
+		last--;
+	if (first > 0 && first < last && find_procedure(tokens[first], route.departure_airport, RNAVProc::RNAVProcType::RNAV_SID, route.sid))
+		first++;
+	if (last < tokens.size() && last > first && find_procedure(tokens[last - 1], route.destination_airport, RNAVProc::RNAVProcType::RNAV_STAR, route.star))
+		last--;
+
+	// the duplicate idents are resolved by the distance to the last point
+	const NavPoint* last_point = NULL;
+	if (!route.sid.get_nav_points().empty())
+		last_point = &route.sid.get_nav_points().back();
+	else if (first > 0)
+		last_point = &route.departure_airport;
+	else if (last < tokens.size())
+		last_point = &route.destination_airport;
+	const NavPoint* last_fix = NULL; // the entry of the next airway
+
+	const AirwayGraph& graph = parser.get_airway_graph();
+	for (std::size_t i = first; i < last; i++)
+	{
+		uint32_t airway = graph.find_airway(std::string(tokens[i]));
+		if (airway != AirwayGraph::NO_AIRWAY)
+		{
+			// the airway can follow the SID at once
+			const NavPoint* entry = last_fix;
+			if (entry == NULL && !route.sid.get_nav_points().empty())
+				entry = find_fix(graph, last_point->get_icao_id(), airway, &last_point->get_coordinate());
+			if (entry == NULL || i + 1 >= last)
+			{
+				errors.push_back({ ROUTE_STRING_MISSING_FIX, i, std::string(tokens[i]) });
+				continue;
+			}
+
+			const NavPoint* exit = follow_airway(graph, airway, entry, i, tokens, route);
+			if (exit == NULL)
+			{
+				// the route goes on from the exit fix
+				uint32_t next_airway = i + 3 < last ? graph.find_airway(std::string(tokens[i + 2])) : AirwayGraph::NO_AIRWAY;
+				exit = find_fix(graph, tokens[i + 1], next_airway, &entry->get_coordinate());
+				if (exit == NULL)
+				{
+					errors.push_back({ ROUTE_STRING_UNKNOWN_FIX, i + 1, std::string(tokens[i + 1]) });
+					i++;
+					continue;
+				}
+				errors.push_back({ ROUTE_STRING_NOT_ON_AIRWAY, i, std::string(tokens[i]) });
+				route.enroute_points.push_back(*exit);
+				route.enroute_points.back().detach_strings();
+			}
+			last_fix = last_point = exit;
+			i++;
+			continue;
+		}
+
+		uint32_t next_airway = i + 2 < last ? graph.find_airway(std::string(tokens[i + 1])) : AirwayGraph::NO_AIRWAY;
+		const NavPoint* fix = find_fix(graph, tokens[i], next_airway, last_point != NULL ? &last_point->get_coordinate() : NULL);
+		if (fix == NULL)
+		{
+			errors.push_back({ ROUTE_STRING_UNKNOWN_FIX, i, std::string(tokens[i]) });
+			continue;
+		}
+
+		// the first fix is often the end of the SID
+		if (last_point == NULL || !same_point(*fix, *last_point))
+		{
+			route.enroute_points.push_back(*fix);
+			route.enroute_points.back().detach_strings();
+		}
+		last_fix = last_point = fix;
+	}
+
+	// and the last one the start of the STAR
+	if (!route.enroute_points.empty() && !route.star.get_nav_points().empty() && same_point(route.enroute_points.back(), route.star.get_nav_points().front()))
+		route.enroute_points.pop_back();
+	return errors.empty();
+}
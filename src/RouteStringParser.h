@@ -0,0 +1,53 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "AirwayGraph.h"
+#include "FlightRoute.h"
+#include "XPlane-navdata-parser/XPlaneParser.h"
+
+typedef enum {
+    ROUTE_STRING_UNKNOWN_FIX, // neither a known fix nor an airway between two fixes
+    ROUTE_STRING_NOT_ON_AIRWAY, // the entry or the exit fix is not on the airway, the route goes direct to the exit
+    ROUTE_STRING_AGAINST_ONE_WAY, // the airway is flown against its direction
+    ROUTE_STRING_MISSING_FIX // an airway without entry or exit fix
+} RouteStringErrorType;
+
+struct RouteStringError {
+    RouteStringErrorType type;
+    std::size_t token_index; // into RouteStringParser::tokenize
+    std::string token;
+};
+
+/* Reads ICAO route strings like "LHBP BADO2B BADOV UL851 ... LOWI" into a FlightRoute in one
+   pass over the tokens. The first and the last token are the airports if they are known
+   airports, the tokens next to them the SID and the STAR if the airports have such a procedure.
+   An airway between two fixes is expanded to its fixes, a fix ident used in several places is
+   the one nearest to the previous point (or the one on the following airway). The speed/level
+   groups and DCT are skipped. The parser shall not be changed during the parse. */
+class RouteStringParser {
+private:
+    XPlaneParser& parser;
+    std::vector<RouteStringError> errors;
+    bool find_airport(std::string_view token, Airport& airport);
+    bool find_procedure(std::string_view token, const Airport& airport, RNAVProc::RNAVProcType type, RNAVProc& proc);
+    const NavPoint* find_fix(const AirwayGraph& graph, std::string_view token, uint32_t next_airway, const Coordinate* reference);
+    const NavPoint* follow_airway(const AirwayGraph& graph, uint32_t airway, const NavPoint* entry, std::size_t token_index,
+        const std::vector<std::string_view>& tokens, FlightRoute& route);
+public:
+    RouteStringParser(XPlaneParser& _parser);
+    // whitespace separated tokens without DCT, the speed/level groups and the /speed level suffixes
+    static std::vector<std::string_view> tokenize(std::string_view route_string);
+    /* Replaces the airports, the SID, the STAR and the enroute points of the route (the approach
+       and the alternate are kept). False if a token is not resolved: the route holds the rest. */
+    bool parse(std::string_view route_string, FlightRoute& route);
+    // the problems of the last parse, in token order
+    const std::vector<RouteStringError>& get_errors() const;
+};
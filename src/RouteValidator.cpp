@@ -0,0 +1,267 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <unordered_set>
+#include "RouteValidator.h"
+#include "AirwayRouter.h"
+
+bool RouteValidationReport::is_valid() const
+{
+	return issues.empty();
+}
+
+RouteValidator::RouteValidator(XPlaneParser& _parser, RouteValidationOptions _options) :
+	parser(_parser), options(_options)
+{
+
+}
+
+void RouteValidator::run_parallel(std::size_t count, const std::function<void(std::size_t, RouteStringParser&)>& validate) const
+{
+	// built before the threads share it
+	parser.get_airway_graph();
+
+	unsigned thread_count = options.thread_count > 0 ? options.thread_count : std::max(1u, std::thread::hardware_concurrency());
+	thread_count = (unsigned)std::min<std::size_t>(thread_count, std::max<std::size_t>(count, 1));
+
+	// the routes are handed out one by one: a few long routes don't hold back a thread
+	std::atomic<std::size_t> next_route(0);
+	auto worker = [&]() {
+		RouteStringParser route_parser(parser);
+		for (std::size_t i = next_route++; i < count; i = next_route++)
+			validate(i, route_parser);
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < thread_count; t++)
+		threads.emplace_back(worker);
+	worker();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void RouteValidator::check_legs(const std::vector<const NavPoint*>& points, RouteValidationReport& report) const
+{
+	report.point_count = points.size();
+	report.distance_km = 0;
+	for (std::size_t i = 1; i < points.size(); i++)
+	{
+		double km = AirwayRouter::great_circle_km(points[i - 1]->get_coordinate(), points[i]->get_coordinate());
+		report.distance_km += km;
+		if (km > options.max_leg_km)
+			report.issues.push_back({ ROUTE_ISSUE_LONG_LEG, i - 1, points[i - 1]->get_icao_id() + "-" + points[i]->get_icao_id(), km });
+	}
+}
+
+std::string RouteValidator::procedure_key(std::string_view proc_name, std::string_view airport_icao)
+{
+	std::string key(airport_icao);
+	key += ' ';
+	key += proc_name;
+	return key;
+}
+
+RouteValidator::RouteFileLookups RouteValidator::resolve_lookups(const std::vector<std::vector<FlightRouteFileEntry>>& route_files) const
+{
+	// the distinct airports and procedures of the batch
+	RouteFileLookups lookups;
+	std::unordered_set<std::string> cifp_airports;
+	for (const std::vector<FlightRouteFileEntry>& entries : route_files)
+	{
+		for (const FlightRouteFileEntry& entry : entries)
+		{
+			// skipped by FlightRoute::load_from_file as well
+			if (entry.first.empty() || entry.second.empty())
+				continue;
+
+			if (entry.key == "dep" || entry.key == "dest")
+			{
+				lookups.airports.emplace(std::string(entry.first), nullptr);
+				cifp_airports.emplace(entry.first);
+			}
+			else if (entry.key == "sid" || entry.key == "star" || entry.key == "app")
+			{
+				lookups.procedures.emplace(procedure_key(entry.first, entry.second), nullptr);
+				cifp_airports.emplace(entry.second);
+			}
+		}
+	}
+
+	// the CIFP files are parsed in parallel without the query lock, the lookups below find them loaded
+	std::vector<std::string> airport_icao_codes(cifp_airports.begin(), cifp_airports.end());
+	run_parallel(airport_icao_codes.size(), [&](std::size_t i, RouteStringParser&) {
+		if (!parser.is_airport_file_parsed(airport_icao_codes[i]))
+			parser.prefetch_airport_file(airport_icao_codes[i]);
+	});
+
+	// one lookup per airport and procedure, not one per route
+	for (auto& airport : lookups.airports)
+		airport.second = parser.find_airport_handle_by_icao_id(airport.first);
+	for (auto& procedure : lookups.procedures)
+	{
+		std::size_t separator = procedure.first.find(' ');
+		procedure.second = parser.find_procedure_by_id(procedure.first.substr(separator + 1), procedure.first.substr(0, separator));
+	}
+	return lookups;
+}
+
+void RouteValidator::validate_route_file_entries(const std::vector<FlightRouteFileEntry>& entries, const RouteFileLookups& lookups, RouteValidationReport& report) const
+{
+	// the handles keep the CIFP versions of the airports alive during the check
+	AirportHandle departure, destination;
+	RNAVProcHandle sid, star, approach;
+	std::vector<std::pair<int, FlightRouteFileEntry>> route_entries;
+
+	for (const FlightRouteFileEntry& entry : entries)
+	{
+		// skipped by FlightRoute::load_from_file as well
+		if (entry.first.empty() || entry.second.empty())
+			continue;
+
+		if (entry.key == "dep" || entry.key == "dest")
+		{
+			AirportHandle airport = lookups.airports.at(std::string(entry.first));
+			if (!airport)
+				report.issues.push_back({ ROUTE_ISSUE_MISSING_AIRPORT, entry.line, std::string(entry.first), 0 });
+			(entry.key == "dep" ? departure : destination) = airport;
+		}
+		else if (entry.key == "sid" || entry.key == "star" || entry.key == "app")
+		{
+			RNAVProcHandle procedure = lookups.procedures.at(procedure_key(entry.first, entry.second));
+			if (!procedure)
+				report.issues.push_back({ ROUTE_ISSUE_MISSING_PROCEDURE, entry.line, std::string(entry.first), 0 });
+			(entry.key == "sid" ? sid : entry.key == "star" ? star : approach) = procedure;
+		}
+		else
+		{
+			int index = FlightRoute::get_route_point_index(entry.key);
+			if (index >= 0)
+				route_entries.push_back({ index, entry });
+		}
+	}
+
+	// the points of the route in flight order
+	std::vector<const NavPoint*> points;
+	if (departure)
+		points.push_back(departure.get());
+	if (sid)
+	{
+		for (const NavPoint& nav_point : sid->get_nav_points())
+			points.push_back(&nav_point);
+	}
+
+	std::stable_sort(route_entries.begin(), route_entries.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+	for (const auto& route_entry : route_entries)
+	{
+		const FlightRouteFileEntry& entry = route_entry.second;
+		std::vector<const NavPoint*> candidates = parser.find_nav_points_by_icao_id(std::string(entry.second), std::string(entry.first));
+		if (candidates.empty())
+		{
+			report.issues.push_back({ ROUTE_ISSUE_MISSING_FIX, entry.line, std::string(entry.first), 0 });
+			continue;
+		}
+
+		points.push_back(FlightRoute::nearest_nav_point(candidates, points.empty() ? NULL : points.back()));
+	}
+
+	for (const RNAVProcHandle* procedure : { &star, &approach })
+	{
+		if (*procedure)
+		{
+			for (const NavPoint& nav_point : (*procedure)->get_nav_points())
+				points.push_back(&nav_point);
+		}
+	}
+	if (destination)
+		points.push_back(destination.get());
+
+	// the issues of the lines first, in line order
+	std::stable_sort(report.issues.begin(), report.issues.end(), [](const RouteIssue& a, const RouteIssue& b) { return a.position < b.position; });
+	check_legs(points, report);
+}
+
+void RouteValidator::validate_route_string(std::string_view route_string, RouteStringParser& route_parser, RouteValidationReport& report) const
+{
+	FlightRoute route("");
+	route_parser.parse(route_string, route);
+	for (const RouteStringError& error : route_parser.get_errors())
+	{
+		RouteIssueType type = error.type == ROUTE_STRING_UNKNOWN_FIX ? ROUTE_ISSUE_MISSING_FIX : ROUTE_ISSUE_AIRWAY;
+		report.issues.push_back({ type, error.token_index, error.token, 0 });
+	}
+
+	std::vector<const NavPoint*> points;
+	if (!route.departure_airport.get_icao_id().empty())
+		points.push_back(&route.departure_airport);
+	for (const NavPoint& nav_point : route.sid.get_nav_points())
+		points.push_back(&nav_point);
+	for (const NavPoint& nav_point : route.enroute_points)
+		points.push_back(&nav_point);
+	for (const NavPoint& nav_point : route.star.get_nav_points())
+		points.push_back(&nav_point);
+	if (!route.destination_airport.get_icao_id().empty())
+		points.push_back(&route.destination_airport);
+	check_legs(points, report);
+}
+
+void RouteValidator::validate_contents(const std::vector<std::string>& contents, std::vector<RouteValidationReport>& reports) const
+{
+	std::vector<std::vector<FlightRouteFileEntry>> route_files(contents.size());
+	run_parallel(contents.size(), [&](std::size_t i, RouteStringParser&) {
+		route_files[i] = FlightRoute::split_route_file(contents[i]);
+	});
+
+	RouteFileLookups lookups = resolve_lookups(route_files);
+	run_parallel(contents.size(), [&](std::size_t i, RouteStringParser&) {
+		validate_route_file_entries(route_files[i], lookups, reports[i]);
+	});
+}
+
+std::vector<RouteValidationReport> RouteValidator::validate_route_files(const std::vector<std::string>& file_names) const
+{
+	std::vector<RouteValidationReport> reports(file_names.size());
+	// an unreadable file is checked as an empty one: it has no other issue
+	std::vector<std::string> contents(file_names.size());
+	run_parallel(file_names.size(), [&](std::size_t i, RouteStringParser&) {
+		reports[i].source = file_names[i];
+		std::ifstream i_str(std::filesystem::path(file_names[i]), std::ios::binary);
+		if (!i_str.is_open())
+		{
+			reports[i].issues.push_back({ ROUTE_ISSUE_UNREADABLE, 0, file_names[i], 0 });
+			return;
+		}
+
+		std::ostringstream content;
+		content << i_str.rdbuf();
+		contents[i] = content.str();
+	});
+	validate_contents(contents, reports);
+	return reports;
+}
+
+std::vector<RouteValidationReport> RouteValidator::validate_route_file_contents(const std::vector<std::string>& contents) const
+{
+	std::vector<RouteValidationReport> reports(contents.size());
+	for (std::size_t i = 0; i < contents.size(); i++)
+		reports[i].source = contents[i];
+	validate_contents(contents, reports);
+	return reports;
+}
+
+std::vector<RouteValidationReport> RouteValidator::validate_route_strings(const std::vector<std::string>& route_strings) const
+{
+	std::vector<RouteValidationReport> reports(route_strings.size());
+	run_parallel(route_strings.size(), [&](std::size_t i, RouteStringParser& route_parser) {
+		reports[i].source = route_strings[i];
+		validate_route_string(route_strings[i], route_parser, reports[i]);
+	});
+	return reports;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <cstddef>
+#include "RouteStringParser.h"
+#include "XPlane-navdata-parser/XPlaneParser.h"
+
+struct RouteValidationOptions {
+    double max_leg_km = 1000; // a longer leg is reported, e.g. a fix ident resolved on another continent
+    unsigned thread_count = 0; // 0: std::thread::hardware_concurrency()
+};
+
+typedef enum {
+    ROUTE_ISSUE_UNREADABLE, // the route file can't be read
+    ROUTE_ISSUE_MISSING_AIRPORT,
+    ROUTE_ISSUE_MISSING_PROCEDURE,
+    ROUTE_ISSUE_MISSING_FIX,
+    ROUTE_ISSUE_AIRWAY, // route strings: the airway does not lead from the entry to the exit fix
+    ROUTE_ISSUE_LONG_LEG
+} RouteIssueType;
+
+struct RouteIssue {
+    RouteIssueType type;
+    // route files: the line (from 1), route strings: the token (see RouteStringParser::tokenize),
+    // long legs: the leg in the points of the route (from 0, the departure airport is the first point)
+    std::size_t position;
+    std::string item; // the ident, the procedure name or the leg as "FROM-TO"
+    double leg_km;
+};
+
+struct RouteValidationReport {
+    std::string source; // the file name, the file content or the route string
+    std::vector<RouteIssue> issues;
+    std::size_t point_count = 0; // with the airports
+    double distance_km = 0;
+    bool is_valid() const;
+};
+
+/* Checks many stored routes against one loaded parser, e.g. after an AIRAC update, on several
+   threads. The global dat files and the airway file shall be parsed before (the parser is only
+   read, the CIFP files are loaded on demand as usual). The entries are read like
+   FlightRoute::load_from_file reads them, but the check goes on after the first problem and no
+   error or warning is logged: every problem is in the report.
+   The airport and procedure lookups of the parser take its query lock. The distinct airports
+   and procedures of a batch of route files are looked up once (their CIFP files are loaded in
+   parallel before), then the routes are checked in parallel against these results. The nav
+   point lookups share the read lock of the parser. */
+class RouteValidator {
+private:
+    XPlaneParser& parser;
+    RouteValidationOptions options;
+    // the airports and procedures of a batch of route files, procedures by "AIRPORT PROC"
+    struct RouteFileLookups {
+        std::unordered_map<std::string, AirportHandle> airports;
+        std::unordered_map<std::string, RNAVProcHandle> procedures;
+    };
+    static std::string procedure_key(std::string_view proc_name, std::string_view airport_icao);
+    void run_parallel(std::size_t count, const std::function<void(std::size_t, RouteStringParser&)>& validate) const;
+    RouteFileLookups resolve_lookups(const std::vector<std::vector<FlightRouteFileEntry>>& route_files) const;
+    void validate_contents(const std::vector<std::string>& contents, std::vector<RouteValidationReport>& reports) const;
+    void validate_route_file_entries(const std::vector<FlightRouteFileEntry>& entries, const RouteFileLookups& lookups, RouteValidationReport& report) const;
+    void validate_route_string(std::string_view route_string, RouteStringParser& route_parser, RouteValidationReport& report) const;
+    void check_legs(const std::vector<const NavPoint*>& points, RouteValidationReport& report) const;
+public:
+    RouteValidator(XPlaneParser& _parser, RouteValidationOptions _options = RouteValidationOptions());
+    // route files of FlightRoute::save_to_file, the reports are in the order of the files
+    std::vector<RouteValidationReport> validate_route_files(const std::vector<std::string>& file_names) const;
+    // the contents of such files
+    std::vector<RouteValidationReport> validate_route_file_contents(const std::vector<std::string>& contents) const;
+    // ICAO route strings, see RouteStringParser
+    std::vector<RouteValidationReport> validate_route_strings(const std::vector<std::string>& route_strings) const;
+};
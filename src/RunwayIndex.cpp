@@ -0,0 +1,256 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <cmath>
+#include <algorithm>
+#include "RunwayIndex.h"
+
+const double PI = 3.14159265358979;
+const double METERS_PER_DEG_LAT = 111195; // on the average earth radius
+const int LAT_CELLS = (int)(180 / RunwayIndex::CELL_SIZE_DEG);
+const int LNG_CELLS = (int)(360 / RunwayIndex::CELL_SIZE_DEG);
+const double DEFAULT_RUNWAY_WIDTH_M = 45;
+
+// -180..180
+static double normalize_angle(double degree)
+{
+	degree = std::fmod(degree, 360);
+	if (degree > 180)
+		degree -= 360;
+	else if (degree < -180)
+		degree += 360;
+	return degree;
+}
+
+static int lat_cell(double lat)
+{
+	return std::clamp((int)std::floor((lat + 90) / RunwayIndex::CELL_SIZE_DEG), 0, LAT_CELLS - 1);
+}
+
+static int lng_cell(double lng)
+{
+	int cell = (int)std::floor((lng + 180) / RunwayIndex::CELL_SIZE_DEG) % LNG_CELLS;
+	return cell < 0 ? cell + LNG_CELLS : cell;
+}
+
+// "13L" -> "31R", "08" -> "26". empty if the name is not a runway number
+static std::string opposite_runway_name(const std::string& name)
+{
+	if (name.size() < 2 || name[0] < '0' || name[0] > '9' || name[1] < '0' || name[1] > '9')
+		return "";
+
+	int number = (name[0] - '0') * 10 + (name[1] - '0');
+	int opposite = (number + 17) % 36 + 1;
+	std::string opposite_name = { (char)('0' + opposite / 10), (char)('0' + opposite % 10) };
+	if (name.size() > 2)
+	{
+		if (name[2] == 'L')
+			opposite_name += 'R';
+		else if (name[2] == 'R')
+			opposite_name += 'L';
+		else
+			opposite_name += name[2];
+	}
+	return opposite_name;
+}
+
+uint32_t RunwayIndex::cell_key(int lat_cell, int lng_cell)
+{
+	return (uint32_t)lat_cell * LNG_CELLS + (uint32_t)lng_cell;
+}
+
+void RunwayIndex::clear()
+{
+	ends.clear();
+	cells.clear();
+	airport_ends.clear();
+	airport_owners.clear();
+	removed_ends = 0;
+}
+
+std::size_t RunwayIndex::size() const
+{
+	return ends.size() - removed_ends;
+}
+
+void RunwayIndex::build(const std::vector<const Airport*>& airports)
+{
+	clear();
+	for (const Airport* airport : airports)
+		add_airport(*airport);
+}
+
+void RunwayIndex::add_airport(const Airport& airport)
+{
+	for (const Runway& runway : airport.get_runways())
+	{
+		if (!runway.has_threshold())
+			continue;
+
+		const Runway* opposite = airport.get_runway_by_name(opposite_runway_name(runway.get_name()));
+		double heading = 0;
+		if (runway.has_true_heading())
+			heading = runway.get_true_heading();
+		else if (opposite != NULL && opposite->has_threshold())
+		{
+			RelativePos rel_pos;
+			runway.get_threshold().get_relative_pos_to(opposite->get_threshold(), rel_pos);
+			heading = rel_pos.heading_ortho_departure.convert_to_double();
+		}
+		else
+		{
+			// the runway number is the rounded magnetic course
+			int magnetic_course = runway.get_course() != 0 ? runway.get_course() : atoi(runway.get_name().c_str()) * 10;
+			heading = magnetic_course + airport.get_magnetic_variation().convert_to_double();
+		}
+		add_runway_end(airport, runway, heading);
+	}
+}
+
+void RunwayIndex::add_airport(const std::shared_ptr<const Airport>& airport)
+{
+	airport_owners[airport->get_icao_id()] = airport;
+	add_airport(*airport);
+}
+
+void RunwayIndex::remove_airport(const std::string& icao_id)
+{
+	airport_owners.erase(icao_id);
+	auto it = airport_ends.find(icao_id);
+	if (it == airport_ends.end())
+		return;
+
+	for (uint32_t index : it->second)
+	{
+		ends[index].airport = NULL;
+		ends[index].runway = NULL;
+	}
+	removed_ends += it->second.size();
+	airport_ends.erase(it);
+}
+
+void RunwayIndex::add_runway_end(const Airport& airport, const Runway& runway, double heading)
+{
+	RunwayEnd end;
+	end.airport = &airport;
+	end.runway = &runway;
+	end.lat = runway.get_threshold().lat.convert_to_double();
+	end.lng = runway.get_threshold().lng.convert_to_double();
+	end.heading = std::fmod(heading + 360, 360);
+	end.sin_heading = std::sin(end.heading * PI / 180);
+	end.cos_heading = std::cos(end.heading * PI / 180);
+	end.length_m = runway.get_length();
+	end.half_width_m = (runway.get_width() > 0 ? runway.get_width() : DEFAULT_RUNWAY_WIDTH_M) / 2;
+
+	uint32_t index = (uint32_t)ends.size();
+	ends.push_back(end);
+	airport_ends[airport.get_icao_id()].push_back(index);
+
+	// bounding box of the approach, the runway and the lateral margin around them
+	double meters_per_deg_lng = METERS_PER_DEG_LAT * std::max(std::cos(end.lat * PI / 180), 0.01);
+	double north_first = -APPROACH_LENGTH_M * end.cos_heading;
+	double north_last = end.length_m * end.cos_heading;
+	double east_first = -APPROACH_LENGTH_M * end.sin_heading;
+	double east_last = end.length_m * end.sin_heading;
+	double margin = LATERAL_MARGIN_M + end.half_width_m;
+	double min_lat = end.lat + (std::min(north_first, north_last) - margin) / METERS_PER_DEG_LAT;
+	double max_lat = end.lat + (std::max(north_first, north_last) + margin) / METERS_PER_DEG_LAT;
+	double min_lng = end.lng + (std::min(east_first, east_last) - margin) / meters_per_deg_lng;
+	double max_lng = end.lng + (std::max(east_first, east_last) + margin) / meters_per_deg_lng;
+
+	int lng_cell_count = std::min((int)std::ceil((max_lng - min_lng) / CELL_SIZE_DEG) + 1, LNG_CELLS);
+	for (int lat_i = lat_cell(min_lat); lat_i <= lat_cell(max_lat); lat_i++)
+	{
+		// the longitude cells wrap around at the antimeridian
+		for (int lng_i = 0; lng_i < lng_cell_count; lng_i++)
+		{
+			std::vector<uint32_t>& cell = cells[cell_key(lat_i, (lng_cell(min_lng) + lng_i) % LNG_CELLS)];
+			if (cell.empty() || cell.back() != index)
+				cell.push_back(index);
+		}
+	}
+}
+
+const std::vector<uint32_t>* RunwayIndex::cell_entries(const Coordinate& position) const
+{
+	auto it = cells.find(cell_key(lat_cell(position.lat.convert_to_double()), lng_cell(position.lng.convert_to_double())));
+	return it == cells.end() ? NULL : &it->second;
+}
+
+void RunwayIndex::relative_position(const RunwayEnd& end, double lat, double lng, double heading, RunwayMatch& match) const
+{
+	double north = (lat - end.lat) * METERS_PER_DEG_LAT;
+	double east = normalize_angle(lng - end.lng) * METERS_PER_DEG_LAT * std::cos(end.lat * PI / 180);
+	match.airport = end.airport;
+	match.runway = end.runway;
+	match.along_track_m = east * end.sin_heading + north * end.cos_heading;
+	match.cross_track_m = east * end.cos_heading - north * end.sin_heading;
+	match.heading_difference = std::abs(normalize_angle(heading - end.heading));
+}
+
+bool RunwayIndex::find_runway_at(const Coordinate& position, double true_heading, RunwayMatch& match, double margin_m) const
+{
+	const std::vector<uint32_t>* entries = cell_entries(position);
+	if (entries == NULL)
+		return false;
+
+	margin_m = std::min(margin_m, LATERAL_MARGIN_M);
+	double lat = position.lat.convert_to_double();
+	double lng = position.lng.convert_to_double();
+	bool found = false;
+	RunwayMatch candidate;
+	for (uint32_t index : *entries)
+	{
+		const RunwayEnd& end = ends[index];
+		if (end.runway == NULL)
+			continue;
+
+		relative_position(end, lat, lng, true_heading, candidate);
+		if (candidate.along_track_m < -margin_m || candidate.along_track_m > end.length_m + margin_m ||
+			std::abs(candidate.cross_track_m) > end.half_width_m + margin_m)
+			continue;
+
+		// both ends of the runway contain the position: the one in the direction of travel
+		if (!found || candidate.heading_difference < match.heading_difference)
+		{
+			match = candidate;
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool RunwayIndex::find_lined_up_runway(const Coordinate& position, double true_track, RunwayMatch& match,
+	double max_distance_m, double max_cross_track_m, double max_heading_difference) const
+{
+	const std::vector<uint32_t>* entries = cell_entries(position);
+	if (entries == NULL)
+		return false;
+
+	max_distance_m = std::min(max_distance_m, APPROACH_LENGTH_M);
+	max_cross_track_m = std::min(max_cross_track_m, LATERAL_MARGIN_M);
+	double lat = position.lat.convert_to_double();
+	double lng = position.lng.convert_to_double();
+	bool found = false;
+	RunwayMatch candidate;
+	for (uint32_t index : *entries)
+	{
+		const RunwayEnd& end = ends[index];
+		if (end.runway == NULL)
+			continue;
+
+		relative_position(end, lat, lng, true_track, candidate);
+		if (candidate.heading_difference > max_heading_difference || std::abs(candidate.cross_track_m) > max_cross_track_m ||
+			candidate.along_track_m < -max_distance_m || candidate.along_track_m > end.length_m)
+			continue;
+
+		if (!found || std::abs(candidate.along_track_m) < std::abs(match.along_track_m))
+		{
+			match = candidate;
+			found = true;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include "Airport.h"
+
+// a runway end found by a RunwayIndex query, with the position relative to its centerline
+struct RunwayMatch {
+    const Airport* airport = NULL;
+    const Runway* runway = NULL;
+    double along_track_m = 0; // from the threshold toward the other end, negative before the threshold
+    double cross_track_m = 0; // right of the centerline is positive
+    double heading_difference = 0; // degrees between the query heading and the runway heading
+};
+
+/* Grid index over the runway ends for the "which runway am I on / lined up with" queries,
+   cheap enough for every simulator frame. A runway end is known by its threshold and true
+   heading. Runway ends without a threshold are left out; a missing heading is taken from
+   the threshold of the opposite end or from the magnetic course and the variation of the
+   airport. Every end is stored in the grid cells touched by the runway and its approach
+   (APPROACH_LENGTH_M before the threshold, LATERAL_MARGIN_M beside the centerline), so a
+   query reads one cell. The distances are measured on a local flat projection around the
+   threshold, which is precise enough at runway scale.
+   The index keeps pointers into the airports: rebuild it, or replace the changed airports,
+   when they change. An airport added by handle is kept alive by the index (and by its
+   copies) until it is removed. XPlaneParser hands out immutable snapshots of it. */
+class RunwayIndex {
+public:
+    static constexpr double CELL_SIZE_DEG = 0.05;
+    static constexpr double APPROACH_LENGTH_M = 9260; // 5 NM
+    // the cells cover this much on both sides of the centerline, the lateral query limits are clamped to it
+    static constexpr double LATERAL_MARGIN_M = 200;
+private:
+    struct RunwayEnd {
+        const Airport* airport;
+        const Runway* runway;
+        double lat; // threshold, degree
+        double lng;
+        double sin_heading; // of the true heading
+        double cos_heading;
+        double heading; // degree
+        double length_m;
+        double half_width_m;
+    };
+    std::vector<RunwayEnd> ends; // the removed ends stay with a NULL runway, the cells still refer to them
+    std::unordered_map<uint32_t, std::vector<uint32_t>> cells;
+    std::unordered_map<std::string, std::vector<uint32_t>> airport_ends; // by icao id
+    std::unordered_map<std::string, std::shared_ptr<const Airport>> airport_owners; // by icao id
+    std::size_t removed_ends = 0;
+    static uint32_t cell_key(int lat_cell, int lng_cell);
+    void add_runway_end(const Airport& airport, const Runway& runway, double heading);
+    const std::vector<uint32_t>* cell_entries(const Coordinate& position) const;
+    void relative_position(const RunwayEnd& end, double lat, double lng, double heading, RunwayMatch& match) const;
+public:
+    void clear();
+    void build(const std::vector<const Airport*>& airports);
+    void add_airport(const Airport& airport);
+    void add_airport(const std::shared_ptr<const Airport>& airport);
+    // drop the runway ends of the airport, e.g. before its new version is added
+    void remove_airport(const std::string& icao_id);
+    // number of the runway ends
+    std::size_t size() const;
+
+    // the runway end whose surface (plus margin_m around it) contains the position and whose
+    // heading is the closest to true_heading. false if the position is not on a runway
+    bool find_runway_at(const Coordinate& position, double true_heading, RunwayMatch& match, double margin_m = 10) const;
+    /* the runway end ahead of the position: before its threshold (up to max_distance_m,
+       at most APPROACH_LENGTH_M) or on the runway, within max_cross_track_m of the extended
+       centerline and max_heading_difference of its heading. the closest one to the threshold wins */
+    bool find_lined_up_runway(const Coordinate& position, double true_track, RunwayMatch& match,
+        double max_distance_m = APPROACH_LENGTH_M, double max_cross_track_m = 60, double max_heading_difference = 10) const;
+};
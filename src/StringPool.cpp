@@ -0,0 +1,134 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "StringPool.h"
+
+static const std::string empty_string = "";
+
+InternedString::InternedString() :
+	value(&empty_string), owned(false)
+{
+
+}
+
+InternedString::InternedString(const std::string* _value, bool _owned) :
+	value(_value), owned(_owned)
+{
+
+}
+
+InternedString::InternedString(std::string_view _value) :
+	value(_value.empty() ? &empty_string : new std::string(_value)), owned(!_value.empty())
+{
+
+}
+
+InternedString::InternedString(const InternedString& other) :
+	value(other.owned ? new std::string(*other.value) : other.value), owned(other.owned)
+{
+
+}
+
+InternedString::InternedString(InternedString&& other) noexcept :
+	value(other.value), owned(other.owned)
+{
+	other.value = &empty_string;
+	other.owned = false;
+}
+
+InternedString& InternedString::operator=(const InternedString& other)
+{
+	if (this != &other)
+		*this = InternedString(other);
+	return *this;
+}
+
+InternedString& InternedString::operator=(InternedString&& other) noexcept
+{
+	std::swap(value, other.value);
+	std::swap(owned, other.owned);
+	return *this;
+}
+
+InternedString::~InternedString()
+{
+	if (owned)
+		delete value;
+}
+
+InternedString InternedString::detached() const
+{
+	return InternedString(view());
+}
+
+const std::string& InternedString::str() const
+{
+	return *value;
+}
+
+std::string_view InternedString::view() const
+{
+	return *value;
+}
+
+bool InternedString::empty() const
+{
+	return value->empty();
+}
+
+bool InternedString::operator==(const InternedString& other) const
+{
+	// same pool: pointer equality. different pools or own copies: fall back to the content
+	return value == other.value || *value == *other.value;
+}
+
+bool InternedString::operator!=(const InternedString& other) const
+{
+	return !(*this == other);
+}
+
+bool InternedString::operator==(std::string_view other) const
+{
+	// a view of the very same pooled string doesn't need a character compare
+	if (other.data() == value->data())
+		return other.size() == value->size();
+
+	return *value == other;
+}
+
+bool InternedString::operator!=(std::string_view other) const
+{
+	return !(*this == other);
+}
+
+InternedString StringPool::intern(std::string_view value)
+{
+	if (value.empty())
+		return InternedString();
+
+	std::lock_guard<std::mutex> lock(guard);
+	auto it = strings.find(value);
+	if (it == strings.end())
+		it = strings.emplace(value).first;
+
+	return InternedString(&(*it), false);
+}
+
+std::size_t StringPool::size()
+{
+	std::lock_guard<std::mutex> lock(guard);
+	return strings.size();
+}
+
+/* Approximate heap usage of the pool in bytes */
+std::size_t StringPool::memory_usage()
+{
+	std::lock_guard<std::mutex> lock(guard);
+	std::size_t bytes = strings.bucket_count() * sizeof(void*);
+	for (auto& s : strings)
+		bytes += sizeof(std::string) + sizeof(void*) + (s.capacity() > 15 ? s.capacity() + 1 : 0);
+
+	return bytes;
+}
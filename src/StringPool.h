@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+
+class StringPool;
+
+/* Handle of a string stored in a StringPool, or an own copy of a string which is not in a
+   pool. A pooled handle is a plain pointer: it is copied and compared without touching the
+   pool, and it is valid as long as the pool is alive (the parser keeps its pool alive for
+   the entities it hands out). detached() makes an own copy, which is independent of the pool. */
+class InternedString {
+private:
+    const std::string* value; // never null
+    bool owned; // value is an own copy, deleted with the handle
+    InternedString(const std::string* _value, bool _owned);
+    friend class StringPool;
+public:
+    InternedString();
+    // an own copy of the string, e.g. for the std::string setters of the entities
+    explicit InternedString(std::string_view _value);
+    InternedString(const InternedString& other);
+    InternedString(InternedString&& other) noexcept;
+    InternedString& operator=(const InternedString& other);
+    InternedString& operator=(InternedString&& other) noexcept;
+    ~InternedString();
+    // an own copy of a pooled string, valid after the pool is destroyed
+    InternedString detached() const;
+    const std::string& str() const;
+    std::string_view view() const;
+    bool empty() const;
+    bool operator==(const InternedString& other) const;
+    bool operator!=(const InternedString& other) const;
+    bool operator==(std::string_view other) const;
+    bool operator!=(std::string_view other) const;
+};
+
+class StringPool {
+private:
+    struct TransparentHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+    };
+    // node based container: the address of a stored string never changes
+    std::unordered_set<std::string, TransparentHash, std::equal_to<>> strings;
+    std::mutex guard;
+public:
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    InternedString intern(std::string_view value);
+    std::size_t size();
+    std::size_t memory_usage();
+};
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <algorithm>
+#include <cmath>
+#include "CifpPrefetcher.h"
+#include "../Logger.h"
+#include "../framework.h"
+
+CifpPrefetcher::CifpPrefetcher(XPlaneParser& _parser, CifpPrefetchOptions _options) :
+	parser(_parser), options(_options), stop_requested(false), busy(false), position_changed(false), track_deg(0), prefetched_files(0)
+{
+	worker = std::thread(&CifpPrefetcher::run, this);
+}
+
+CifpPrefetcher::~CifpPrefetcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		stop_requested = true;
+	}
+	wakeup.notify_all();
+	worker.join();
+}
+
+void CifpPrefetcher::update_position(const Coordinate& _position, double _track_deg)
+{
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		position = _position;
+		track_deg = _track_deg;
+		position_changed = true;
+	}
+	wakeup.notify_all();
+}
+
+void CifpPrefetcher::add_requested_airport(const std::string& airport_icao_code)
+{
+	if (airport_icao_code.empty())
+		return;
+
+	if (std::find(requested_airports.begin(), requested_airports.end(), airport_icao_code) == requested_airports.end())
+		requested_airports.push_back(airport_icao_code);
+}
+
+void CifpPrefetcher::update_route(const FlightRoute& route)
+{
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		add_requested_airport(route.destination_airport.get_icao_id());
+		add_requested_airport(route.departure_airport.get_icao_id());
+		add_requested_airport(route.alternate_airport.get_icao_id());
+	}
+	wakeup.notify_all();
+}
+
+void CifpPrefetcher::request_airports(const std::list<std::string>& airport_icao_codes)
+{
+	{
+		std::lock_guard<std::mutex> lock(guard);
+		for (auto& airport_icao_code : airport_icao_codes)
+			add_requested_airport(airport_icao_code);
+	}
+	wakeup.notify_all();
+}
+
+std::vector<std::string> CifpPrefetcher::predict_airports(const Coordinate& _position, double _track_deg)
+{
+	struct Candidate {
+		const Airport* airport;
+		bool nearby;
+		double distance_km;
+	};
+	std::vector<Candidate> candidates;
+
+	double search_radius_km = std::max(options.nearby_radius_km, options.lookahead_km);
+	for (const Airport* airport : parser.find_airports_within_distance(_position, search_radius_km))
+	{
+		RelativePos rel_pos;
+		_position.get_relative_pos_to(airport->get_coordinate(), rel_pos);
+		if (rel_pos.dist_ortho <= options.nearby_radius_km)
+		{
+			candidates.push_back({ airport, true, rel_pos.dist_ortho });
+			continue;
+		}
+
+		// along track and cross track distance of the airport
+		double relative_bearing = Angle(rel_pos.heading_ortho_departure.convert_to_double() - _track_deg).convert_to_radian();
+		double along_track_km = rel_pos.dist_ortho * cos(relative_bearing);
+		double cross_track_km = rel_pos.dist_ortho * sin(relative_bearing);
+		if (along_track_km > 0 && along_track_km <= options.lookahead_km && abs(cross_track_km) <= options.corridor_half_width_km)
+			candidates.push_back({ airport, false, along_track_km });
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		if (a.nearby != b.nearby)
+			return a.nearby;
+		return a.distance_km < b.distance_km;
+	});
+
+	std::vector<std::string> airport_icao_codes;
+	for (auto& candidate : candidates)
+	{
+		if (airport_icao_codes.size() >= options.max_predicted_airports)
+			break;
+		airport_icao_codes.push_back(candidate.airport->get_icao_id());
+	}
+	return airport_icao_codes;
+}
+
+void CifpPrefetcher::wait_idle()
+{
+	std::unique_lock<std::mutex> lock(guard);
+	idle.wait(lock, [this]() { return stop_requested || (!busy && !position_changed && requested_airports.empty() && predicted_airports.empty()); });
+}
+
+std::size_t CifpPrefetcher::get_prefetched_files() const
+{
+	return prefetched_files;
+}
+
+void CifpPrefetcher::run()
+{
+	// the prefetch can wait, the simulator frames can not
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+	std::unique_lock<std::mutex> lock(guard);
+	while (!stop_requested)
+	{
+		if (position_changed)
+		{
+			Coordinate predict_position = position;
+			double predict_track = track_deg;
+			position_changed = false;
+			busy = true;
+
+			lock.unlock();
+			std::vector<std::string> airport_icao_codes = predict_airports(predict_position, predict_track);
+			lock.lock();
+
+			// the previous prediction is out of date
+			predicted_airports.assign(airport_icao_codes.begin(), airport_icao_codes.end());
+			busy = false;
+			continue;
+		}
+
+		std::deque<std::string>& queue = requested_airports.empty() ? predicted_airports : requested_airports;
+		if (queue.empty())
+		{
+			idle.notify_all();
+			wakeup.wait(lock);
+			continue;
+		}
+
+		std::string airport_icao_code = queue.front();
+		queue.pop_front();
+		busy = true;
+		lock.unlock();
+
+		if (!parser.is_airport_file_parsed(airport_icao_code))
+		{
+			if (parser.prefetch_airport_file(airport_icao_code))
+				prefetched_files++;
+			else
+				Logger(TLogLevel::logDEBUG) << "CifpPrefetcher: no CIFP file for " << airport_icao_code << std::endl;
+			std::this_thread::sleep_for(options.pause_between_files);
+		}
+
+		lock.lock();
+		busy = false;
+	}
+	idle.notify_all();
+}
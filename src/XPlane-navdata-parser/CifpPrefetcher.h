@@ -0,0 +1,74 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <list>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include "XPlaneParser.h"
+#include "../FlightRoute.h"
+
+struct CifpPrefetchOptions {
+	double nearby_radius_km = 60; // airports around the aircraft
+	double lookahead_km = 400; // airports ahead of the aircraft along the track...
+	double corridor_half_width_km = 60; // ...within this distance from the track line
+	std::size_t max_predicted_airports = 20;
+	// the worker thread runs below the normal priority, the pause lets the queries in between two files
+	std::chrono::milliseconds pause_between_files = std::chrono::milliseconds(2);
+};
+
+/* Loads the CIFP files which are likely to be queried soon on a background thread, so the
+   first procedure query of an airport does not have to parse the file. The prediction
+   is done on the background thread from the last reported position and track: the
+   airports around the aircraft (closest first) and ahead of it along the track. The
+   airports of the active route and the explicitly requested ones (e.g. alternates) are
+   loaded before the predicted ones. The loaded procedures are published through the
+   normal query functions of the parser.
+   The worker thread runs at THREAD_PRIORITY_BELOW_NORMAL, so it takes the CPU time left
+   over by the simulator. It loads one file at a time with XPlaneParser::prefetch_airport_file,
+   which reads and parses the file without holding the query lock: the queries wait only
+   while the result is published. */
+class CifpPrefetcher {
+private:
+	XPlaneParser& parser;
+	CifpPrefetchOptions options;
+	std::thread worker;
+	std::mutex guard;
+	std::condition_variable wakeup;
+	std::condition_variable idle;
+	bool stop_requested;
+	bool busy;
+	bool position_changed;
+	Coordinate position;
+	double track_deg;
+	std::deque<std::string> requested_airports;
+	std::deque<std::string> predicted_airports;
+	std::atomic<std::size_t> prefetched_files;
+	void run();
+	void add_requested_airport(const std::string& airport_icao_code);
+public:
+	CifpPrefetcher(XPlaneParser& _parser, CifpPrefetchOptions _options = CifpPrefetchOptions());
+	~CifpPrefetcher();
+	CifpPrefetcher(const CifpPrefetcher&) = delete;
+	CifpPrefetcher& operator=(const CifpPrefetcher&) = delete;
+	// cheap: the prediction runs on the background thread
+	void update_position(const Coordinate& _position, double _track_deg);
+	// departure, destination and alternate airports of the route
+	void update_route(const FlightRoute& route);
+	void request_airports(const std::list<std::string>& airport_icao_codes);
+	// airports to prefetch for the position and track, most important first. the airports are
+	// looked up in the airport grid of the parser, see XPlaneParser::find_airports_within_distance
+	std::vector<std::string> predict_airports(const Coordinate& _position, double _track_deg);
+	// wait until the queues are empty
+	void wait_idle();
+	// number of the CIFP files loaded by the prefetcher
+	std::size_t get_prefetched_files() const;
+};
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <fstream>
+#include "XPlaneAsyncLoader.h"
+#include "XPlaneNavDataSource.h"
+#include "../Logger.h"
+
+const std::size_t READ_BLOCK_SIZE = 1 << 20;
+const std::size_t BATCH_LINES = 4096;
+const std::size_t MAX_QUEUED_BATCHES = 8;
+
+// file indexes in the order of the load
+const int FIX_FILE = 0;
+const int NAV_FILE = 1;
+const int APT_FILE = 2;
+
+XPlaneAsyncLoader::XPlaneAsyncLoader(XPlaneParser& _parser) :
+	parser(_parser), total_bytes(0), parsed_bytes(0), cancel_requested(false)
+{
+	file_paths.push_back(parser.get_dat_file_path(EARTH_FIX_DAT));
+	file_paths.push_back(parser.get_dat_file_path(EARTH_NAV_DAT));
+	file_paths.push_back(parser.get_dat_file_path(APT_DAT));
+
+	for (auto& file_path : file_paths)
+	{
+		std::error_code error;
+		std::uintmax_t size = std::filesystem::file_size(file_path, error);
+		if (!error)
+			total_bytes += size;
+	}
+
+	futures.fix_loaded = file_promises[FIX_FILE].get_future().share();
+	futures.nav_loaded = file_promises[NAV_FILE].get_future().share();
+	futures.apt_loaded = file_promises[APT_FILE].get_future().share();
+	futures.cifp_loaded = cifp_promise.get_future().share();
+}
+
+XPlaneAsyncLoader::~XPlaneAsyncLoader()
+{
+	cancel();
+	wait();
+}
+
+AsyncLoadFutures XPlaneAsyncLoader::start(LoadProgressCallback _progress_callback, std::list<std::string> cifp_warm_up_airports)
+{
+	if (reader_thread.joinable() || parser_thread.joinable())
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneAsyncLoader: load is already started" << std::endl;
+		return futures;
+	}
+
+	progress_callback = std::move(_progress_callback);
+	cifp_warm_up = std::move(cifp_warm_up_airports);
+	reader_thread = std::thread(&XPlaneAsyncLoader::read_files, this);
+	parser_thread = std::thread(&XPlaneAsyncLoader::parse_batches, this);
+	return futures;
+}
+
+void XPlaneAsyncLoader::cancel()
+{
+	{
+		std::lock_guard<std::mutex> lock(batch_queue_guard);
+		cancel_requested = true;
+	}
+	batch_pushed.notify_all();
+	batch_popped.notify_all();
+}
+
+void XPlaneAsyncLoader::wait()
+{
+	if (reader_thread.joinable())
+		reader_thread.join();
+	if (parser_thread.joinable())
+		parser_thread.join();
+}
+
+std::uintmax_t XPlaneAsyncLoader::get_parsed_bytes() const
+{
+	return parsed_bytes;
+}
+
+std::uintmax_t XPlaneAsyncLoader::get_total_bytes() const
+{
+	return total_bytes;
+}
+
+void XPlaneAsyncLoader::push_batch(LineBatch&& batch)
+{
+	std::unique_lock<std::mutex> lock(batch_queue_guard);
+	batch_popped.wait(lock, [this]() { return batch_queue.size() < MAX_QUEUED_BATCHES || cancel_requested; });
+	if (cancel_requested)
+		return;
+
+	batch_queue.push_back(std::move(batch));
+	lock.unlock();
+	batch_pushed.notify_one();
+}
+
+bool XPlaneAsyncLoader::pop_batch(LineBatch& batch)
+{
+	std::unique_lock<std::mutex> lock(batch_queue_guard);
+	batch_pushed.wait(lock, [this]() { return !batch_queue.empty() || cancel_requested; });
+	if (cancel_requested)
+		return false;
+
+	batch = std::move(batch_queue.front());
+	batch_queue.pop_front();
+	lock.unlock();
+	batch_popped.notify_one();
+	return true;
+}
+
+void XPlaneAsyncLoader::read_files()
+{
+	std::vector<char> block(READ_BLOCK_SIZE);
+	for (int file_index = FIX_FILE; file_index <= APT_FILE && !cancel_requested; file_index++)
+	{
+		LineBatch batch;
+		batch.file_index = file_index;
+
+		std::ifstream i_str(file_paths[file_index], std::ios::binary);
+		if (!i_str.is_open())
+		{
+			Logger(TLogLevel::logERROR) << "XPlaneAsyncLoader: can't open file for read: " << file_paths[file_index] << std::endl;
+			batch.failed = true;
+			batch.end_of_file = true;
+			push_batch(std::move(batch));
+			continue;
+		}
+
+		// the last line of a block continues in the next one
+		std::string partial_line;
+		while (!cancel_requested)
+		{
+			i_str.read(block.data(), block.size());
+			std::size_t block_size = (std::size_t)i_str.gcount();
+			if (block_size == 0)
+				break;
+
+			batch.bytes += block_size;
+			std::size_t line_start = 0;
+			for (std::size_t i = 0; i < block_size; i++)
+			{
+				if (block[i] != '\n')
+					continue;
+
+				std::size_t line_end = (i > line_start && block[i - 1] == '\r') ? i - 1 : i;
+				if (partial_line.empty())
+				{
+					batch.lines.emplace_back(block.data() + line_start, line_end - line_start);
+				}
+				else
+				{
+					partial_line.append(block.data() + line_start, line_end - line_start);
+					if (!partial_line.empty() && partial_line.back() == '\r')
+						partial_line.pop_back();
+					batch.lines.push_back(std::move(partial_line));
+					partial_line.clear();
+				}
+				line_start = i + 1;
+			}
+			partial_line.append(block.data() + line_start, block_size - line_start);
+
+			if (batch.lines.size() >= BATCH_LINES)
+			{
+				push_batch(std::move(batch));
+				batch = LineBatch();
+				batch.file_index = file_index;
+			}
+		}
+
+		if (!partial_line.empty())
+		{
+			if (partial_line.back() == '\r')
+				partial_line.pop_back();
+			batch.lines.push_back(std::move(partial_line));
+		}
+		batch.end_of_file = true;
+		push_batch(std::move(batch));
+	}
+}
+
+void XPlaneAsyncLoader::parse_batches()
+{
+	int finished_files = 0;
+	int line_count = 0; // parsed lines of the current file
+	XPlaneRecordDecoder decoder(&parser.get_load_filter());
+	LineBatch batch;
+
+	while (finished_files <= APT_FILE && pop_batch(batch))
+	{
+		{
+			std::lock_guard<std::recursive_mutex> lock(parser.query_guard);
+			if (line_count == 0)
+				parser.clear_query_cache();
+
+			for (const std::string& line : batch.lines)
+			{
+				// the header lines of the fix and nav files
+				if (++line_count <= 3 && batch.file_index != APT_FILE)
+					continue;
+
+				switch (batch.file_index)
+				{
+				case FIX_FILE:
+					decoder.decode_earth_fix_line(line, parser);
+					break;
+				case NAV_FILE:
+					decoder.decode_earth_nav_line(line, parser);
+					break;
+				default:
+					decoder.decode_apt_line(line, parser);
+					break;
+				}
+			}
+
+			if (batch.end_of_file)
+				decoder.flush(parser);
+
+			if (batch.end_of_file && batch.file_index != APT_FILE)
+				parser.update_nav_point_table();
+		}
+
+		parsed_bytes += batch.bytes;
+		if (progress_callback)
+			progress_callback(parsed_bytes, total_bytes);
+
+		if (batch.end_of_file)
+		{
+			file_promises[batch.file_index].set_value(!batch.failed);
+			finished_files++;
+			line_count = 0;
+		}
+	}
+
+	for (int file_index = finished_files; file_index <= APT_FILE; file_index++)
+		file_promises[file_index].set_value(false);
+
+	bool cifp_loaded = true;
+	for (auto& airport_icao_code : cifp_warm_up)
+	{
+		if (cancel_requested)
+		{
+			cifp_loaded = false;
+			break;
+		}
+
+		std::lock_guard<std::recursive_mutex> lock(parser.query_guard);
+		cifp_loaded &= parser.parse_airport_file(airport_icao_code);
+	}
+	cifp_promise.set_value(cifp_loaded);
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <list>
+#include <vector>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include "XPlaneParser.h"
+
+// called from the parser thread of the loader after every parsed batch of lines
+typedef std::function<void(std::uintmax_t parsed_bytes, std::uintmax_t total_bytes)> LoadProgressCallback;
+
+// every future is true if its part was loaded completely
+struct AsyncLoadFutures {
+	std::shared_future<bool> fix_loaded;
+	std::shared_future<bool> nav_loaded;
+	std::shared_future<bool> apt_loaded;
+	std::shared_future<bool> cifp_loaded; // CIFP files of the warm-up list
+};
+
+/* Loads the global dat files (and optionally the CIFP files of some airports) in the
+   background. A reader thread reads the files in large blocks and hands over the lines
+   in batches to a parser thread, so reading the next part of the files overlaps with
+   parsing the previous one. The parser thread takes the query lock of the parser for each
+   batch only, the nav point lookups lock against the new points: the already parsed data is
+   queryable during the load, with the limits of XPlaneIncrementalLoader (copy the airports
+   with get_airport_by_icao_id until apt_loaded, get_nav_points is for after the load).
+   The loader shall not be destroyed before the parser; the destructor cancels the load. */
+class XPlaneAsyncLoader {
+private:
+	struct LineBatch {
+		int file_index = 0;
+		std::vector<std::string> lines;
+		std::uintmax_t bytes = 0;
+		bool end_of_file = false;
+		bool failed = false;
+	};
+
+	XPlaneParser& parser;
+	std::vector<std::filesystem::path> file_paths;
+	std::list<std::string> cifp_warm_up;
+	LoadProgressCallback progress_callback;
+	std::uintmax_t total_bytes;
+	std::atomic<std::uintmax_t> parsed_bytes;
+	std::atomic<bool> cancel_requested;
+	std::promise<bool> file_promises[3];
+	std::promise<bool> cifp_promise;
+	AsyncLoadFutures futures;
+	std::deque<LineBatch> batch_queue;
+	std::mutex batch_queue_guard;
+	std::condition_variable batch_pushed;
+	std::condition_variable batch_popped;
+	std::thread reader_thread;
+	std::thread parser_thread;
+	void push_batch(LineBatch&& batch);
+	bool pop_batch(LineBatch& batch);
+	void read_files();
+	void parse_batches();
+public:
+	XPlaneAsyncLoader(XPlaneParser& _parser);
+	~XPlaneAsyncLoader();
+	XPlaneAsyncLoader(const XPlaneAsyncLoader&) = delete;
+	XPlaneAsyncLoader& operator=(const XPlaneAsyncLoader&) = delete;
+	// start the load once. the CIFP files of cifp_warm_up_airports are parsed after apt.dat
+	AsyncLoadFutures start(LoadProgressCallback _progress_callback = nullptr, std::list<std::string> cifp_warm_up_airports = {});
+	// the running phase stops at the next batch, the futures of the unfinished parts become false
+	void cancel();
+	// wait for the end of the load (or the cancellation)
+	void wait();
+	std::uintmax_t get_parsed_bytes() const;
+	std::uintmax_t get_total_bytes() const;
+};
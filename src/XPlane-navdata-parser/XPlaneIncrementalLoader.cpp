@@ -0,0 +1,180 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include "XPlaneIncrementalLoader.h"
+#include "../Logger.h"
+
+// the clock is checked only after every few lines
+const std::size_t TIME_CHECK_LINES = 32;
+
+XPlaneIncrementalLoader::XPlaneIncrementalLoader(XPlaneParser& _parser) :
+	parser(_parser), stage(STAGE_FIX), file_position(0), line_count(0), decoder(&_parser.get_load_filter()), total_bytes(0), finished_files_bytes(0),
+	parsed_bytes(0), status_flag(LOAD_IN_PROGRESS), cancel_requested(false)
+{
+	for (LoadStage s : { STAGE_FIX, STAGE_NAV, STAGE_APT })
+	{
+		std::error_code error;
+		std::uintmax_t size = std::filesystem::file_size(stage_file_path(s), error);
+		if (!error)
+			total_bytes += size;
+	}
+}
+
+std::filesystem::path XPlaneIncrementalLoader::stage_file_path(LoadStage _stage)
+{
+	switch (_stage)
+	{
+	case STAGE_FIX:
+		return parser.get_dat_file_path(EARTH_FIX_DAT);
+	case STAGE_NAV:
+		return parser.get_dat_file_path(EARTH_NAV_DAT);
+	case STAGE_APT:
+		return parser.get_dat_file_path(APT_DAT);
+	default:
+		return std::filesystem::path();
+	}
+}
+
+bool XPlaneIncrementalLoader::open_stage_file()
+{
+	std::filesystem::path file_path = stage_file_path(stage);
+	// binary mode: the file position is the number of the parsed bytes
+	i_str.open(file_path, std::ios::binary);
+	if (!i_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneIncrementalLoader: can't open file for read: " << file_path << std::endl;
+		return false;
+	}
+
+	if (file_position == 0)
+		parser.clear_query_cache();
+	else
+		i_str.seekg(file_position);
+
+	return true;
+}
+
+void XPlaneIncrementalLoader::parse_line(const std::string& line)
+{
+	// the header lines of the fix and nav files
+	if (stage != STAGE_APT && line_count <= 3)
+		return;
+
+	switch (stage)
+	{
+	case STAGE_FIX:
+		decoder.decode_earth_fix_line(line, parser);
+		break;
+	case STAGE_NAV:
+		decoder.decode_earth_nav_line(line, parser);
+		break;
+	case STAGE_APT:
+		decoder.decode_apt_line(line, parser);
+		break;
+	default:
+		break;
+	}
+}
+
+void XPlaneIncrementalLoader::finish_stage()
+{
+	decoder.flush(parser);
+	i_str.close();
+	finished_files_bytes += file_position;
+	parsed_bytes = finished_files_bytes;
+	file_position = 0;
+	line_count = 0;
+	stage = (LoadStage)(stage + 1);
+}
+
+LoadStatus XPlaneIncrementalLoader::set_status(LoadStatus status)
+{
+	status_flag = status;
+	return status;
+}
+
+LoadStatus XPlaneIncrementalLoader::step(std::chrono::microseconds time_budget, std::size_t line_budget)
+{
+	LoadStatus status = status_flag;
+	if (status != LOAD_IN_PROGRESS)
+		return status;
+
+	if (cancel_requested)
+	{
+		i_str.close();
+		return set_status(LOAD_CANCELLED);
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + time_budget;
+	std::lock_guard<std::recursive_mutex> lock(parser.query_guard);
+
+	std::string line;
+	std::size_t parsed_lines = 0;
+	while (stage != STAGE_DONE)
+	{
+		if (!i_str.is_open() && !open_stage_file())
+			return set_status(LOAD_FAILED);
+
+		if (!std::getline(i_str, line))
+		{
+			finish_stage();
+			continue;
+		}
+
+		file_position += line.length();
+		if (!i_str.eof())
+			file_position++; // new line
+
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		line_count++;
+		parse_line(line);
+		parsed_lines++;
+
+		if (line_budget > 0 && parsed_lines >= line_budget)
+			break;
+
+		if (time_budget.count() > 0 && parsed_lines % TIME_CHECK_LINES == 0 && std::chrono::steady_clock::now() >= deadline)
+			break;
+	}
+
+	parsed_bytes = finished_files_bytes + file_position;
+	if (stage == STAGE_DONE)
+	{
+		parser.update_nav_point_table();
+		return set_status(LOAD_FINISHED);
+	}
+
+	return LOAD_IN_PROGRESS;
+}
+
+void XPlaneIncrementalLoader::cancel()
+{
+	cancel_requested = true;
+}
+
+LoadStatus XPlaneIncrementalLoader::get_status() const
+{
+	return status_flag;
+}
+
+double XPlaneIncrementalLoader::get_progress() const
+{
+	if (total_bytes == 0)
+		return status_flag == LOAD_FINISHED ? 1.0 : 0.0;
+
+	return (double)parsed_bytes / (double)total_bytes;
+}
+
+std::uintmax_t XPlaneIncrementalLoader::get_parsed_bytes() const
+{
+	return parsed_bytes;
+}
+
+std::uintmax_t XPlaneIncrementalLoader::get_total_bytes() const
+{
+	return total_bytes;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "XPlaneNavDataSource.h"
+
+typedef enum {
+	LOAD_IN_PROGRESS,
+	LOAD_FINISHED,
+	LOAD_CANCELLED,
+	LOAD_FAILED
+} LoadStatus;
+
+/* Cooperative loader of the global dat files (earth_fix.dat, earth_nav.dat and apt.dat,
+   in this order) for hosts which can give only a few milliseconds per frame to the
+   parser. Every step() continues from the file position where the previous one stopped
+   and returns when its time or line budget is used up.
+   The nav points and airports are queryable through the parser as soon as their line
+   is parsed. A step holds the query lock of the parser and add_nav_point the lock of the
+   nav points, so the lookups of other threads are safe during the load. The airports get
+   their runways and details until apt.dat is done: meanwhile copy them with
+   get_airport_by_icao_id instead of reading through the pointer of find_airport_by_icao_id.
+   get_nav_points and get_nav_point_table are for after the load. */
+class XPlaneIncrementalLoader {
+private:
+	typedef enum {
+		STAGE_FIX,
+		STAGE_NAV,
+		STAGE_APT,
+		STAGE_DONE
+	} LoadStage;
+
+	XPlaneParser& parser;
+	LoadStage stage;
+	std::ifstream i_str;
+	std::uintmax_t file_position; // start of the next unparsed line in the current file
+	int line_count; // parsed lines of the current file
+	XPlaneRecordDecoder decoder;
+	std::uintmax_t total_bytes;
+	std::uintmax_t finished_files_bytes;
+	std::atomic<std::uintmax_t> parsed_bytes;
+	std::atomic<LoadStatus> status_flag; // status for the other threads
+	std::atomic<bool> cancel_requested;
+	std::filesystem::path stage_file_path(LoadStage _stage);
+	bool open_stage_file();
+	void parse_line(const std::string& line);
+	void finish_stage();
+	LoadStatus set_status(LoadStatus status);
+public:
+	XPlaneIncrementalLoader(XPlaneParser& _parser);
+	XPlaneIncrementalLoader(const XPlaneIncrementalLoader&) = delete;
+	XPlaneIncrementalLoader& operator=(const XPlaneIncrementalLoader&) = delete;
+	// parse until the time budget or the line budget is used up. 0 means no limit
+	LoadStatus step(std::chrono::microseconds time_budget, std::size_t line_budget = 0);
+	// the functions below can be called from any thread. cancel stops the load at the next step
+	void cancel();
+	LoadStatus get_status() const;
+	// parsed part of the three files in bytes: 0.0 ... 1.0
+	double get_progress() const;
+	std::uintmax_t get_parsed_bytes() const;
+	std::uintmax_t get_total_bytes() const;
+};
@@ -0,0 +1,705 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <cmath>
+#include "XPlaneNavDataSource.h"
+#include "../ARINC424-navdata-parser/Arinc424NavDataSource.h"
+#include "../Logger.h"
+
+XPlaneRecordDecoder::XPlaneRecordDecoder(const NavDataLoadFilter* _load_filter) :
+	load_filter(_load_filter), vor_pending(false), airport_pending(false), skip_airport(false),
+	region_seen(false), datum_lat_seen(false), datum_lon_seen(false)
+{
+	if (load_filter != NULL && !load_filter->is_active())
+		load_filter = NULL;
+}
+
+std::string XPlaneRecordDecoder::normalize_rwy_name(std::string name)
+{
+	//remove trailing and leading whitespaces
+	name = name.erase(name.find_last_not_of(" \t\n\r\f\v") + 1);
+	name = name.erase(0, name.find_first_not_of(" \t\n\r\f\v"));
+
+	if (name.length() < 2)
+		name += "0" + name;
+
+	if (!(name[0] >= '0' && name[0] <= '9') || !(name[1] >= '0' && name[1] <= '9'))
+	{
+		name = "0" + name;
+	}
+
+	return name;
+}
+
+void XPlaneRecordDecoder::decode_earth_fix_line(const std::string& line, NavDataSink& sink)
+{
+	if (line.length() < 50)
+		return;
+
+	//-21.014086111   26.872350000  ABFNV ENRT FB 2115154 ABEAM FRANCISTOWN VOR
+	// 47.483388889   18.258777778  GILEP ENRT LH 4478275 GILEP
+	//0123456789012234567890123456789012345678901234567890123456789
+	//          1          2         3         4         5
+	if (load_filter != NULL && !load_filter->accepts_region(IcaoRegionKey(std::string_view(line).substr(41, 2))))
+		return;
+
+	double lat = std::stod(line.substr(0, 13));
+	double lng = std::stod(line.substr(14, 13));
+	if (load_filter != NULL && !load_filter->accepts_position(lat, lng))
+		return;
+
+	nav_point.icao_id.assign(line, 30, 5);
+	nav_point.icao_region.assign(line, 41, 2);
+	nav_point.name.clear();
+	nav_point.lat = lat;
+	nav_point.lng = lng;
+	nav_point.elevation = 0;
+	nav_point.radio_type = NavPoint::NONE;
+	nav_point.radio_frequency = 0;
+	nav_point.magnetic_variation = 0;
+	sink.add_nav_point(nav_point);
+}
+
+static bool decode_airway_fix_kind(const std::string& code, AirwayFixKind& kind)
+{
+	if (code == "11")
+		kind = AIRWAY_FIX_WAYPOINT;
+	else if (code == "2")
+		kind = AIRWAY_FIX_NDB;
+	else if (code == "3")
+		kind = AIRWAY_FIX_VHF;
+	else
+		return false;
+	return true;
+}
+
+void XPlaneRecordDecoder::decode_earth_awy_line(const std::string& line, NavDataSink& sink)
+{
+	//ABCDE  K1 11 BCDEF  K1 11 N 1 180 450 J1-J2
+	//from id, region, fix type, to id, region, fix type, direction, low/high, base FL, top FL, airway names
+	std::string fields[11];
+	std::size_t field_count = 0;
+	std::size_t pos = line.find_first_not_of(" \t\r");
+	while (pos != std::string::npos && field_count < 11)
+	{
+		std::size_t end = line.find_first_of(" \t\r", pos);
+		fields[field_count++].assign(line, pos, end == std::string::npos ? std::string::npos : end - pos);
+		pos = line.find_first_not_of(" \t\r", end);
+	}
+	if (field_count < 11)
+		return;
+
+	airway_segment.from_icao_id = fields[0];
+	airway_segment.from_icao_region = fields[1];
+	airway_segment.to_icao_id = fields[3];
+	airway_segment.to_icao_region = fields[4];
+	if (!decode_airway_fix_kind(fields[2], airway_segment.from_kind) || !decode_airway_fix_kind(fields[5], airway_segment.to_kind))
+		return;
+
+	if (fields[6] == "N")
+		airway_segment.direction = AIRWAY_BOTH_WAYS;
+	else if (fields[6] == "F")
+		airway_segment.direction = AIRWAY_FORWARD;
+	else if (fields[6] == "B")
+		airway_segment.direction = AIRWAY_BACKWARD;
+	else
+		return;
+
+	airway_segment.level = fields[7] == "2" ? AIRWAY_HIGH : AIRWAY_LOW;
+	airway_segment.base_fl = atoi(fields[8].c_str());
+	airway_segment.top_fl = atoi(fields[9].c_str());
+
+	// a segment shared by several airways lists all of their names
+	std::size_t name_begin = 0;
+	while (name_begin <= fields[10].length())
+	{
+		std::size_t name_end = fields[10].find('-', name_begin);
+		if (name_end == std::string::npos)
+			name_end = fields[10].length();
+		if (name_end > name_begin)
+		{
+			airway_segment.airway_name.assign(fields[10], name_begin, name_end - name_begin);
+			sink.add_airway_segment(airway_segment);
+		}
+		name_begin = name_end + 1;
+	}
+}
+
+void XPlaneRecordDecoder::flush_vor(NavDataSink& sink)
+{
+	if (!vor_pending)
+		return;
+
+	vor_pending = false;
+	sink.add_nav_point(pending_vor);
+}
+
+void XPlaneRecordDecoder::decode_earth_nav_line(const std::string& line, NavDataSink& sink)
+{
+	if (line.length() <= 80)
+		return;
+
+	// 3  47.152222222   18.742222222      430    11710   130      5.000  PTB ENRT LH PUSZTASZABOLCS VOR/DME
+	//12  47.152222222   18.742222222      430    11710   130      0.000  PTB ENRT LH PUSZTASZABOLCS VOR/DME
+	// 4  47.420805556   19.297333333      499    10915    18  45852.474  BPL LHBP LH 13L ILS-cat-II
+	// 4  47.466605556 -122.317833333      359    11075    18 123840.337 IBEJ KSEA K1 34L ILS-cat-II
+	//0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890
+	//          1         2         3         4         5         6         7         8         9
+	// the filter rejects the record before the rest of the line is parsed
+	if (load_filter != NULL && !load_filter->accepts_region(IcaoRegionKey(std::string_view(line).substr(77, 2))))
+		return;
+
+	double lat = std::stod(line.substr(3, 13));// lat
+	double lng = std::stod(line.substr(17, 13));// lng
+	if (load_filter != NULL && !load_filter->accepts_position(lat, lng))
+		return;
+
+	int type = std::stoi(line.substr(0, 2)); // type
+	int alt = std::stoi(line.substr(35, 5)); // alt
+	int freq = std::stoi(line.substr(44, 5)); //freq
+	double course_combined = std::stod(line.substr(56, 10)); // ILS course. 360 x magnetic course + true course
+	std::string id = line.substr(67, 4); //id
+	id = id.substr(id.find_first_not_of(' ', 0));
+
+	int true_course = (int)std::fmod(course_combined, 360);
+	int magnetic_course = (int)((course_combined - true_course) / 360);
+
+	// DME collocated with the VOR. the VOR should be the previously parsed item
+	if (type == 12)
+	{
+		if (vor_pending && pending_vor.icao_id == id)
+		{
+			pending_vor.radio_type = NavPoint::VOR_DME;
+			flush_vor(sink);
+		}
+		else
+			Logger(TLogLevel::logERROR) << "XplaneParser: VOR-DME detected but can't find the VOR entity: " << id << std::endl;
+		return;
+	}
+
+	flush_vor(sink);
+
+	NavPointRecord& record = (type == 3) ? pending_vor : nav_point;
+	switch (type)
+	{
+	case 2:
+	case 3:
+	case 13:
+		record.icao_id = id;
+		record.icao_region.assign(line, 77, 2);
+		record.name.assign(line, 80);
+		record.lat = lat;
+		record.lng = lng;
+		record.elevation = alt;
+		record.radio_frequency = freq;
+		record.magnetic_variation = 0;
+		if (type == 2)
+			record.radio_type = NavPoint::NDB;
+		else if (type == 13)
+			record.radio_type = NavPoint::DME;
+		else
+		{
+			record.radio_type = NavPoint::VOR;
+			record.magnetic_variation = true_course - magnetic_course;
+			vor_pending = true;
+			break;
+		}
+		sink.add_nav_point(record);
+		break;
+	case 4:
+	{
+		AirportRecord ils_airport;
+		ils_airport.icao_id = line.substr(72, 4); // only for ILS
+		ils_airport.icao_region = ils_airport.icao_id.substr(0, 2);
+		ils_airport.has_position = true;
+		ils_airport.is_estimate = true;
+		ils_airport.lat = lat;
+		ils_airport.lng = lng;
+		ils_airport.elevation = alt;
+		ils_airport.has_magnetic_variation = true;
+		ils_airport.magnetic_variation = true_course - magnetic_course;
+		sink.add_airport(ils_airport);
+
+		RunwayRecord runway;
+		runway.airport_icao_id = ils_airport.icao_id;
+		runway.name = normalize_rwy_name(line.substr(80, 3));
+		runway.course = magnetic_course;
+		runway.ils_freq = freq;
+		sink.add_runway(runway);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+bool XPlaneRecordDecoder::airport_accepted() const
+{
+	if (load_filter == NULL)
+		return true;
+
+	// an airport without the data needed by the filter is dropped
+	if (load_filter->icao_regions.size() > 0 && (!region_seen || !load_filter->accepts_region(IcaoRegionKey(airport.icao_region))))
+		return false;
+
+	if (load_filter->use_bounding_box && (!datum_lat_seen || !datum_lon_seen || !load_filter->accepts_position(airport.lat, airport.lng)))
+		return false;
+
+	return true;
+}
+
+void XPlaneRecordDecoder::flush_airport(NavDataSink& sink)
+{
+	if (!airport_pending)
+		return;
+
+	airport_pending = false;
+	if (skip_airport || !airport_accepted())
+		return;
+
+	airport.has_position = datum_lat_seen && datum_lon_seen && abs(airport.lat) > 0 && abs(airport.lng) > 0;
+	sink.add_airport(airport);
+	for (const RunwayRecord& runway : runways)
+		sink.add_runway(runway);
+}
+
+void XPlaneRecordDecoder::add_apt_runway(const std::string& name, int length, int width, double threshold_lat, double threshold_lng, double true_heading)
+{
+	runways.emplace_back();
+	RunwayRecord& runway = runways.back();
+	runway.airport_icao_id = airport.icao_id;
+	runway.name = name;
+	runway.length = length;
+	runway.width = width;
+	runway.has_threshold = true;
+	runway.threshold_lat = threshold_lat;
+	runway.threshold_lng = threshold_lng;
+	runway.has_true_heading = true;
+	runway.true_heading = true_heading;
+}
+
+// split at the runs of whitespace in place. returns the number of the tokens, at most max_tokens
+static std::size_t split_whitespace(std::string_view line, std::string_view* tokens, std::size_t max_tokens)
+{
+	const char* whitespace = " \t\r\n\f\v";
+	std::size_t count = 0;
+	std::size_t pos = line.find_first_not_of(whitespace);
+	while (count < max_tokens && pos != std::string_view::npos)
+	{
+		std::size_t end = line.find_first_of(whitespace, pos);
+		if (end == std::string_view::npos)
+			end = line.size();
+		tokens[count++] = line.substr(pos, end - pos);
+		pos = line.find_first_not_of(whitespace, end);
+	}
+	return count;
+}
+
+void XPlaneRecordDecoder::decode_apt_line(const std::string& line, NavDataSink& sink)
+{
+	//1    495 0 0 LHBP Budapest Ferenc Liszt Intl
+	//012345678901234567890
+	//          1         2
+	if (line.substr(0, 4) == "1   ")
+	{
+		// the rows of the previous airport are complete
+		flush_airport(sink);
+
+		airport = AirportRecord();
+		airport.icao_id = line.substr(13, 4);
+		airport.elevation = stoi(line.substr(4, 4));
+		airport.name = line.substr(18);
+		runways.clear();
+		airport_pending = true;
+		skip_airport = false;
+		region_seen = false;
+		datum_lat_seen = false;
+		datum_lon_seen = false;
+		return;
+	}
+
+	// seaplane base and heliport headers end the rows of the airport
+	if (line.substr(0, 3) == "16 " || line.substr(0, 3) == "17 ")
+	{
+		flush_airport(sink);
+		return;
+	}
+
+	if (!airport_pending || skip_airport)
+		return;
+
+	//100 29.87 1 0 0.15 0 2 1 13L 47.53801700 -122.30746100 73.15 0.00 2  0  0  1  31R 47.52919200 -122.30000000 110.95 0.00 2  0  0  1
+	//0   1     2 3 4    5 6 7 8   9           10            11    12   13 14 15 16 17  18          19            20     21   22 23 24 25
+	if (line.substr(0, 4) == "100 ")
+	{
+		std::string_view tokenized[20];
+		if (split_whitespace(line, tokenized, 20) < 20)
+			return;
+
+		int width = (int)stod(std::string(tokenized[1]));
+		double lat1 = stod(std::string(tokenized[9]));
+		double lon1 = stod(std::string(tokenized[10]));
+		double lat2 = stod(std::string(tokenized[18]));
+		double lon2 = stod(std::string(tokenized[19]));
+		Coordinate coord1(lat1, lon1, 0);
+		Coordinate coord2(lat2, lon2, 0);
+
+		RelativePos rel_pos;
+		coord1.get_relative_pos_to(coord2, rel_pos);
+		int lenght = (int)(1000*rel_pos.dist_loxo); // rwy length in meters
+		RelativePos rel_pos_back;
+		coord2.get_relative_pos_to(coord1, rel_pos_back);
+
+		// both ends of the runway. the sink merges them with the runways from earth_nav.dat
+		add_apt_runway(normalize_rwy_name(std::string(tokenized[8])), lenght, width, lat1, lon1, rel_pos.heading_ortho_departure.convert_to_double());
+		add_apt_runway(normalize_rwy_name(std::string(tokenized[17])), lenght, width, lat2, lon2, rel_pos_back.heading_ortho_departure.convert_to_double());
+		return;
+	}
+
+	//1302 datum_lat 47.439444444
+	//0123456789012345
+	if (line.substr(0, 14) == "1302 datum_lat")
+	{
+		airport.lat = stod(line.substr(15));
+		datum_lat_seen = true;
+		if (load_filter != NULL && datum_lon_seen && !load_filter->accepts_position(airport.lat, airport.lng))
+			skip_airport = true;
+		return;
+	}
+
+	if (line.substr(0, 14) == "1302 datum_lon")
+	{
+		airport.lng = stod(line.substr(15));
+		datum_lon_seen = true;
+		if (load_filter != NULL && datum_lat_seen && !load_filter->accepts_position(airport.lat, airport.lng))
+			skip_airport = true;
+		return;
+	}
+
+	//1302 region_code LH
+	//01234567890123456789
+	if (line.substr(0, 16) == "1302 region_code")
+	{
+		airport.icao_region = line.substr(17);
+		region_seen = true;
+		// the rest of the rows of a rejected airport are skipped
+		if (load_filter != NULL && !load_filter->accepts_region(IcaoRegionKey(airport.icao_region)))
+			skip_airport = true;
+		return;
+	}
+
+	//1302 city Budapest
+	//01234567890123456789
+	if (line.substr(0, 9) == "1302 city")
+	{
+		airport.city = line.substr(10);
+		return;
+	}
+
+	//1302 country HUN Hungary
+	//01234567890123456789
+	if (line.substr(0, 12) == "1302 country")
+	{
+		airport.country = line.substr(13);
+		return;
+	}
+
+	//1302 iata_code BUD
+	//01234567890123456789
+	if (line.substr(0, 14) == "1302 iata_code")
+	{
+		airport.iata_id = line.substr(15);
+		return;
+	}
+
+	//1302 state Pest
+	//01234567890123456789
+	if (line.substr(0, 10) == "1302 state")
+	{
+		airport.state = line.substr(11);
+		return;
+	}
+
+	//1302 transition_alt 10000
+	//012345678901234567890
+	if (line.substr(0, 19) == "1302 transition_alt")
+	{
+		int transition_alt = 0;
+		try
+		{
+			transition_alt = stoi(line.substr(20));
+		}
+		catch (const std::exception& e)
+		{
+			transition_alt = 0;
+		}
+
+		airport.transition_alt = transition_alt;
+		return;
+	}
+}
+
+void XPlaneRecordDecoder::flush(NavDataSink& sink)
+{
+	flush_vor(sink);
+	flush_airport(sink);
+}
+
+// the comma separated fields of a procedure leg after the "SID:", "STAR:" or "APPCH:" prefix
+typedef enum {
+	CIFP_SEQUENCE = 0,
+	CIFP_ROUTE_TYPE = 1,
+	CIFP_PROC_ID = 2,
+	CIFP_TRANSITION = 3,
+	CIFP_FIX = 4,
+	CIFP_FIX_REGION = 5,
+	CIFP_PATH_TERMINATOR = 11,
+	CIFP_RECOMMENDED_NAVAID = 13,
+	CIFP_RECOMMENDED_NAVAID_REGION = 14,
+	CIFP_COURSE = 20,
+	CIFP_DISTANCE = 21,
+	CIFP_ALTITUDE_DESCRIPTION = 22,
+	CIFP_ALTITUDE1 = 23,
+	CIFP_ALTITUDE2 = 24,
+	CIFP_SPEED_DESCRIPTION = 26,
+	CIFP_SPEED_LIMIT = 27,
+	CIFP_FIELD_COUNT = 28
+} CifpProcField;
+
+static std::string_view trim_field(std::string_view field)
+{
+	std::size_t first = field.find_first_not_of(" \t\r\n;");
+	if (first == std::string_view::npos)
+		return std::string_view();
+	return field.substr(first, field.find_last_not_of(" \t\r\n;") - first + 1);
+}
+
+//SID:060,5,BADO2B,RW13L,BADOV,LZ,E,A,EEC , ,   ,TF, , , , , ,      ,    ,    ,    ,    ,+,FL140,     ,     , ,   ,    ,   , , , , , , , , ;
+//SID:020,5,BADO2B,RW13L,BP701,LH,P,C,EY  , ,   ,CF, ,BUD,LH,D, ,      ,1191,0066,1140,0040, ,     ,     ,     ,-,230,    ,   , , , , , , , , ;
+//APPCH:010,A,I31R,ATICO,ATICO,LH,P,C,E  A, ,   ,IF, , , , , ,      ,    ,    ,    ,    ,+,04000,     ,     ,-,230,    ,   , , , , , ,0,N,S;
+bool XPlaneRecordDecoder::decode_cifp_proc_line(const std::string& line, const std::string& airport_icao_id, ProcedureLegRecord& leg)
+{
+	std::string_view record = trim_field(line);
+	std::size_t colon = record.find(':');
+	if (colon == std::string_view::npos)
+		return false;
+
+	std::string_view type = record.substr(0, colon);
+	if (type == "SID")
+		leg.proc_type = RNAVProc::RNAVProcType::RNAV_SID;
+	else if (type == "STAR")
+		leg.proc_type = RNAVProc::RNAVProcType::RNAV_STAR;
+	else if (type == "APPCH")
+		leg.proc_type = RNAVProc::RNAVProcType::RNAV_APPROACH;
+	else
+		return false;
+
+	// split in place, the missing optional fields stay empty
+	std::string_view fields[CIFP_FIELD_COUNT];
+	std::size_t count = 0;
+	std::size_t pos = colon + 1;
+	while (count < CIFP_FIELD_COUNT && pos <= record.size())
+	{
+		std::size_t comma = record.find(',', pos);
+		if (comma == std::string_view::npos)
+			comma = record.size();
+		fields[count++] = trim_field(record.substr(pos, comma - pos));
+		pos = comma + 1;
+	}
+	if (count <= CIFP_FIX_REGION || fields[CIFP_PROC_ID].empty() || fields[CIFP_SEQUENCE].empty())
+		return false;
+
+	leg.sequence = 0;
+	for (char c : fields[CIFP_SEQUENCE])
+	{
+		if (c < '0' || c > '9')
+			return false;
+		leg.sequence = leg.sequence * 10 + (c - '0');
+	}
+
+	// only the approach transitions are kept, as separate procedures
+	if (leg.proc_type == RNAVProc::RNAVProcType::RNAV_APPROACH)
+	{
+		if (fields[CIFP_ROUTE_TYPE] != "A")
+			return false;
+
+		leg.proc_name.assign(fields[CIFP_PROC_ID]);
+		leg.proc_name += "-";
+		leg.proc_name += fields[CIFP_TRANSITION];
+	}
+	else
+		leg.proc_name.assign(fields[CIFP_PROC_ID]);
+
+	leg.airport_icao_id = airport_icao_id;
+	leg.transition.assign(fields[CIFP_TRANSITION]);
+	leg.fix_icao_id.assign(fields[CIFP_FIX]);
+	leg.fix_icao_region.assign(fields[CIFP_FIX_REGION]);
+
+	ProcedureLeg& details = leg.details;
+	details = ProcedureLeg();
+	details.path_terminator = ProcedureLeg::parse_path_terminator(fields[CIFP_PATH_TERMINATOR]);
+	details.recommended_navaid_id.assign(fields[CIFP_RECOMMENDED_NAVAID]);
+	details.recommended_navaid_region.assign(fields[CIFP_RECOMMENDED_NAVAID_REGION]);
+	bool course_is_time = false;
+	details.course = ProcedureLeg::parse_tenths(fields[CIFP_COURSE], course_is_time);
+	details.distance = ProcedureLeg::parse_tenths(fields[CIFP_DISTANCE], details.distance_is_time);
+	details.altitude1 = ProcedureLeg::parse_altitude(fields[CIFP_ALTITUDE1]);
+	details.altitude2 = ProcedureLeg::parse_altitude(fields[CIFP_ALTITUDE2]);
+	std::string_view altitude_description = fields[CIFP_ALTITUDE_DESCRIPTION];
+	details.altitude_constraint = ProcedureLeg::parse_altitude_constraint(altitude_description.empty() ? ' ' : altitude_description[0],
+		!fields[CIFP_ALTITUDE1].empty());
+	// knots, the same plain digits as an altitude
+	details.speed_limit = ProcedureLeg::parse_altitude(fields[CIFP_SPEED_LIMIT]);
+	std::string_view speed_description = fields[CIFP_SPEED_DESCRIPTION];
+	details.speed_constraint = ProcedureLeg::parse_speed_constraint(speed_description.empty() ? ' ' : speed_description[0],
+		details.speed_limit > 0);
+	return true;
+}
+
+//RWY:RW13L,     ,      ,00496, ,BPL ,2,   ;N47264352,E019152718,0000;
+//RWY:RW26, +0198, , 01894, , OEV, 1, ; N47154182, E011212524, 0000;
+bool XPlaneRecordDecoder::decode_cifp_rwy_line(const std::string& line, const std::string& airport_icao_id, RunwayRecord& runway)
+{
+	std::string_view record = trim_field(line);
+	if (record.substr(0, 6) != "RWY:RW")
+		return false;
+
+	// the runway fields, then the threshold fields after the semicolon
+	std::size_t semicolon = record.find(';');
+	if (semicolon == std::string_view::npos)
+		return false;
+
+	std::string_view fields[6];
+	std::size_t count = 0;
+	std::size_t pos = 6;
+	while (count < 6 && pos <= semicolon)
+	{
+		std::size_t comma = std::min(record.find(',', pos), semicolon);
+		fields[count++] = trim_field(record.substr(pos, comma - pos));
+		pos = comma + 1;
+	}
+
+	std::string_view threshold = record.substr(semicolon + 1);
+	std::size_t comma = threshold.find(',');
+	if (fields[0].empty() || comma == std::string_view::npos)
+		return false;
+
+	runway = RunwayRecord();
+	runway.airport_icao_id = airport_icao_id;
+	runway.name = normalize_rwy_name(std::string(fields[0]));
+	std::string_view lat = trim_field(threshold.substr(0, comma));
+	std::string_view lng = trim_field(threshold.substr(comma + 1, threshold.find(',', comma + 1) - comma - 1));
+	runway.has_threshold = Arinc424NavDataSource::decode_latitude(lat, runway.threshold_lat) &&
+		Arinc424NavDataSource::decode_longitude(lng, runway.threshold_lng);
+	if (count > 3)
+		runway.threshold_elevation = ProcedureLeg::parse_altitude(fields[3]);
+	if (count > 5)
+		runway.localizer_id.assign(fields[5]);
+	return true;
+}
+
+XPlaneNavDataSource::XPlaneNavDataSource(std::string _xplane_root_folder, bool _include_cifp) :
+	xplane_root_folder(std::move(_xplane_root_folder)), include_cifp(_include_cifp), bytes_read(0)
+{
+
+}
+
+void XPlaneNavDataSource::set_load_filter(const NavDataLoadFilter& filter)
+{
+	load_filter = filter;
+}
+
+bool XPlaneNavDataSource::read_file(GlobalDatFile file, NavDataSink& sink)
+{
+	std::filesystem::path file_absolute_path = XPlaneParser::get_dat_file_path(xplane_root_folder, file);
+	std::ifstream i_str;
+	i_str.open(file_absolute_path);
+	if (!i_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneNavDataSource: can't open file for read: " << file_absolute_path.filename() << std::endl;
+		Logger(TLogLevel::logINFO) << "full path: " << file_absolute_path.string() << std::endl;
+		return false;
+	}
+
+	XPlaneRecordDecoder decoder(&load_filter);
+	std::string line;
+	int line_count = 0;
+	while (std::getline(i_str, line))
+	{
+		bytes_read += line.length() + 1;
+
+		// the header lines of the fix, nav and awy files
+		if (++line_count <= 3 && file != APT_DAT)
+			continue;
+
+		switch (file)
+		{
+		case EARTH_FIX_DAT:
+			decoder.decode_earth_fix_line(line, sink);
+			break;
+		case EARTH_NAV_DAT:
+			decoder.decode_earth_nav_line(line, sink);
+			break;
+		case EARTH_AWY_DAT:
+			decoder.decode_earth_awy_line(line, sink);
+			break;
+		default:
+			decoder.decode_apt_line(line, sink);
+			break;
+		}
+	}
+
+	decoder.flush(sink);
+	return true;
+}
+
+bool XPlaneNavDataSource::read_cifp_files(NavDataSink& sink)
+{
+	std::error_code error;
+	std::filesystem::path cifp_folder = XPlaneParser::get_cifp_folder_path(xplane_root_folder);
+	std::filesystem::directory_iterator dir_it(cifp_folder, error);
+	if (error)
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneNavDataSource: can't open CIFP folder: " << cifp_folder << std::endl;
+		return false;
+	}
+
+	ProcedureLegRecord leg;
+	RunwayRecord runway;
+	for (auto& dir_entry : dir_it)
+	{
+		std::ifstream i_str(dir_entry.path());
+		std::string airport_icao_id = dir_entry.path().filename().replace_extension().string();
+		std::string line;
+		while (std::getline(i_str, line))
+		{
+			bytes_read += line.length() + 1;
+			if (XPlaneRecordDecoder::decode_cifp_proc_line(line, airport_icao_id, leg))
+				sink.add_procedure_leg(leg);
+			else if (XPlaneRecordDecoder::decode_cifp_rwy_line(line, airport_icao_id, runway))
+				sink.add_runway(runway);
+		}
+	}
+	return true;
+}
+
+bool XPlaneNavDataSource::read(NavDataSink& sink)
+{
+	bytes_read = 0;
+	// the order matters: the ILS records create the runways which are completed by apt.dat,
+	// the airway segments and the procedure legs refer to the nav points
+	for (GlobalDatFile file : { EARTH_FIX_DAT, EARTH_NAV_DAT, EARTH_AWY_DAT, APT_DAT })
+	{
+		if (!read_file(file, sink))
+			return false;
+	}
+
+	return !include_cifp || read_cifp_files(sink);
+}
+
+std::uintmax_t XPlaneNavDataSource::get_bytes_read() const
+{
+	return bytes_read;
+}
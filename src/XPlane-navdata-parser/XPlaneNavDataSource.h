@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <string_view>
+#include <cstdint>
+#include "XPlaneParser.h"
+#include "../NavDataSource.h"
+
+/* Decodes the lines of earth_fix.dat, earth_nav.dat and apt.dat into records. The decoder
+   keeps the state between the lines of one file: a VOR is held back until the next line
+   (it may have a collocated DME) and the rows of an apt.dat airport are collected until the
+   next airport, so flush() shall be called at the end of every file.
+   The load filter rejects the records before the rest of the line is decoded. */
+class XPlaneRecordDecoder {
+private:
+	const NavDataLoadFilter* load_filter; // NULL: no filter
+	bool vor_pending;
+	NavPointRecord pending_vor;
+	NavPointRecord nav_point;
+	bool airport_pending;
+	bool skip_airport;
+	bool region_seen;
+	bool datum_lat_seen;
+	bool datum_lon_seen;
+	AirportRecord airport;
+	std::vector<RunwayRecord> runways;
+	AirwaySegmentRecord airway_segment;
+	void flush_vor(NavDataSink& sink);
+	void flush_airport(NavDataSink& sink);
+	bool airport_accepted() const;
+	void add_apt_runway(const std::string& name, int length, int width, double threshold_lat, double threshold_lng, double true_heading);
+public:
+	XPlaneRecordDecoder(const NavDataLoadFilter* _load_filter = NULL);
+	void decode_earth_fix_line(const std::string& line, NavDataSink& sink);
+	void decode_earth_nav_line(const std::string& line, NavDataSink& sink);
+	void decode_apt_line(const std::string& line, NavDataSink& sink);
+	// one segment per airway name of the line
+	void decode_earth_awy_line(const std::string& line, NavDataSink& sink);
+	// emit the held back records at the end of a file
+	void flush(NavDataSink& sink);
+	// decode a SID/STAR/APPCH line of a CIFP file with the leg details. false if it is not a procedure leg
+	static bool decode_cifp_proc_line(const std::string& line, const std::string& airport_icao_id, ProcedureLegRecord& leg);
+	// decode a RWY line of a CIFP file: threshold, threshold elevation and localizer. false if it is not a runway
+	static bool decode_cifp_rwy_line(const std::string& line, const std::string& airport_icao_id, RunwayRecord& runway);
+	// runway names shall be in a format "[0-9]{2}[LRC]*"
+	static std::string normalize_rwy_name(std::string name);
+};
+
+/* The X-Plane navdata (earth_fix.dat, earth_nav.dat, earth_awy.dat, apt.dat and optionally all CIFP
+   files) as a streaming source. XPlaneParser reads its global dat files through it. */
+class XPlaneNavDataSource : public NavDataSource {
+private:
+	std::string xplane_root_folder;
+	bool include_cifp;
+	NavDataLoadFilter load_filter;
+	std::uintmax_t bytes_read;
+	bool read_cifp_files(NavDataSink& sink);
+public:
+	XPlaneNavDataSource(std::string _xplane_root_folder, bool _include_cifp = false);
+	void set_load_filter(const NavDataLoadFilter& filter);
+	// read one of the global dat files
+	bool read_file(GlobalDatFile file, NavDataSink& sink);
+	bool read(NavDataSink& sink) override;
+	std::uintmax_t get_bytes_read() const override;
+};
@@ -3,7 +3,9 @@
  *
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
+#include <cmath>
 #include "XPlaneParser.h"
+#include "XPlaneNavDataSource.h"
 #include "../NavMeLib.h"
 #include "../Logger.h"
 
@@ -17,470 +19,655 @@ std::filesystem::path XPlaneParser::absolute_path(std::string root_folder, std::
 	return init_path;
 }
 
-void XPlaneParser::trim_line(std::string& line)
+std::filesystem::path XPlaneParser::custom_or_default_data_path(const std::string& root_folder, const std::string& file_name)
 {
-	// remove the leading and trailing whitespace
-	std::regex r("^\\s+");
-	line = std::regex_replace(line, r, "");
-	r = "\\s+$";
-	line = std::regex_replace(line, r, "");
+	std::filesystem::path custom_path = absolute_path(root_folder, "Custom Data", file_name);
+	if (std::filesystem::exists(custom_path))
+		return custom_path;
+
+	std::filesystem::path default_path = absolute_path(root_folder, "Resources/default data", file_name);
+	if (std::filesystem::exists(default_path))
+		return default_path;
+
+	// neither exists: the error messages show the preferred one
+	return custom_path;
 }
 
-/* Runway names shall be in a format "[0-9]{2}[LRC]*" */
-std::string XPlaneParser::normalize_rwy_name(std::string name)
+std::filesystem::path XPlaneParser::get_dat_file_path(GlobalDatFile file)
 {
-	//remove trailing and leading whitespaces
-	name = name.erase(name.find_last_not_of(" \t\n\r\f\v") + 1);
-	name = name.erase(0, name.find_first_not_of(" \t\n\r\f\v"));
-
-	if (name.length() < 2)
-		name += "0" + name;
+	return get_dat_file_path(xplane_root_folder, file);
+}
 
-	if (!(name[0] >= '0' && name[0] <= '9') || !(name[1] >= '0' && name[1] <= '9'))
+std::filesystem::path XPlaneParser::get_dat_file_path(const std::string& root_folder, GlobalDatFile file)
+{
+	switch (file)
 	{
-		name = "0" + name;
+	case EARTH_FIX_DAT:
+		return custom_or_default_data_path(root_folder, "earth_fix.dat");
+	case EARTH_NAV_DAT:
+		return custom_or_default_data_path(root_folder, "earth_nav.dat");
+	case EARTH_AWY_DAT:
+		return custom_or_default_data_path(root_folder, "earth_awy.dat");
+	default:
+		return absolute_path(root_folder, "Global Scenery/Global Airports/Earth nav data", "apt.dat");
 	}
+}
 
-	return name;
+std::filesystem::path XPlaneParser::get_cifp_folder_path(const std::string& root_folder)
+{
+	return custom_or_default_data_path(root_folder, "CIFP");
 }
 
 bool XPlaneParser::parse_apt_dat_file()
 {
-	std::filesystem::path file_absolute_path = absolute_path(xplane_root_folder, "Global Scenery/Global Airports/Earth nav data", "apt.dat");
-	std::ifstream i_str;
-	i_str.open(file_absolute_path);
-	if (!i_str.is_open())
+	clear_query_cache();
+
+	XPlaneNavDataSource source(xplane_root_folder);
+	source.set_load_filter(load_filter);
+	return source.read_file(APT_DAT, *this);
+}
+
+bool XPlaneParser::parse_earth_fix_dat_file()
+{
+	clear_query_cache();
+
+	XPlaneNavDataSource source(xplane_root_folder);
+	source.set_load_filter(load_filter);
+	return source.read_file(EARTH_FIX_DAT, *this);
+}
+
+bool XPlaneParser::parse_earth_nav_dat_file()
+{
+	clear_query_cache();
+
+	XPlaneNavDataSource source(xplane_root_folder);
+	source.set_load_filter(load_filter);
+	return source.read_file(EARTH_NAV_DAT, *this);
+}
+
+bool XPlaneParser::parse_earth_awy_dat_file()
+{
+	XPlaneNavDataSource source(xplane_root_folder);
+	source.set_load_filter(load_filter);
+	return source.read_file(EARTH_AWY_DAT, *this);
+}
+
+bool XPlaneParser::load_nav_data_source(NavDataSource& source)
+{
+	clear_query_cache();
+
+	bool result = source.read(*this);
+	update_nav_point_table();
+	return result;
+}
+
+void XPlaneParser::add_nav_point(const NavPointRecord& record)
+{
+	std::unique_lock<std::shared_mutex> lock(nav_point_guard);
+	_nav_points.emplace_back(Coordinate(Angle(record.lat), Angle(record.lng), record.elevation), record.icao_id, record.icao_region, Angle(record.magnetic_variation));
+	NavPoint& nav_point = _nav_points.back();
+	if (record.radio_type != NavPoint::NONE)
 	{
-		Logger(TLogLevel::logERROR) << "parse_apt_dat_file: can't open file for read: apt.dat.dat" << std::endl;
-		Logger(TLogLevel::logERROR) << "full path: " << file_absolute_path.string() << std::endl;
-		return false;
+		nav_point.set_radio_type(record.radio_type);
+		nav_point.set_radio_frequency(record.radio_frequency);
 	}
 
-	std::string line;
-	int line_count = 0;
+	if (!record.name.empty())
+		nav_point.set_name(string_pool->intern(record.name));
 
-	double datum_lat = 0;
-	double datum_lon = 0;
-	int elevation = 0;
-	Airport* apt_ptr = NULL;
+	index_nav_point(&nav_point);
+}
 
-	while (std::getline(i_str, line))
+void XPlaneParser::add_airport(const AirportRecord& record)
+{
+	Airport* apt_ptr = get_airport_ptr(record.icao_id);
+	if (apt_ptr == NULL)
 	{
-		//1    495 0 0 LHBP Budapest Ferenc Liszt Intl
-		//012345678901234567890
-		//          1         2
-		if (line.substr(0, 4) == "1   ")
-		{
-			//save the previouss parsed airport before start a new session
-			std::string icao = line.substr(13, 4);
-			elevation = stoi(line.substr(4, 4));
-			std::string name = line.substr(18);
+		Coordinate coordinate(0, 0, record.elevation);
+		if (record.has_position)
+			coordinate = Coordinate(record.lat, record.lng, record.elevation);
 
-			apt_ptr = get_airport_ptr(icao);
-			if (apt_ptr == NULL)
-			{
-				_airports.emplace_back(icao, "", Coordinate(0, 0, elevation), 0);
-				apt_ptr = &_airports.back();
-			}
-			apt_ptr->set_name(name);
+		_airports.emplace_back(record.icao_id, record.icao_region, coordinate, record.magnetic_variation);
+		apt_ptr = &_airports.back();
+		index_airport(apt_ptr);
+	}
+	else if (!record.is_estimate)
+	{
+		if (record.has_position)
+			apt_ptr->set_coordinate(Coordinate(record.lat, record.lng, record.elevation));
+		if (!record.icao_region.empty())
+			apt_ptr->set_icao_region(record.icao_region);
+	}
 
-			datum_lat = 0;
-			datum_lon = 0;
-			continue;
-		}
+	if (record.has_magnetic_variation)
+		apt_ptr->set_magnetic_variation(record.magnetic_variation);
+	if (!record.name.empty())
+		apt_ptr->set_name(string_pool->intern(record.name));
+	if (!record.iata_id.empty())
+		apt_ptr->set_iata_id(record.iata_id);
+	if (!record.city.empty())
+		apt_ptr->set_city(string_pool->intern(record.city));
+	if (!record.country.empty())
+		apt_ptr->set_country(string_pool->intern(record.country));
+	if (!record.state.empty())
+		apt_ptr->set_state(string_pool->intern(record.state));
+	if (record.transition_alt > 0)
+		apt_ptr->set_transition_alt(record.transition_alt);
+	_runway_index_dirty = true;
+	_airport_grid_dirty = true;
+}
 
-		//100 29.87 1 0 0.15 0 2 1 13L 47.53801700 -122.30746100 73.15 0.00 2  0  0  1  31R 47.52919200 -122.30000000 110.95 0.00 2  0  0  1
-		//0   1     2 3 4    5 6 7 8   9           10            11    12   13 14 15 16 17  18          19            20     21   22 23 24 25
-		if (line.substr(0, 4) == "100 ")
-		{
-			std::regex re("\\s+");
-			std::sregex_token_iterator it{ line.begin(), line.end(), re, -1 };
-			std::vector<std::string> tokenized{ it, {} };
-
-			int width = (int)stod(tokenized[1]);
-			double lat1 = stod(tokenized[9]);
-			double lon1 = stod(tokenized[10]);
-			double lat2 = stod(tokenized[18]);
-			double lon2 = stod(tokenized[19]);
-			Coordinate coord1(lat1, lon1, 0);
-			Coordinate coord2(lat2, lon2, 0);
-
-			RelativePos rel_pos;
-			coord1.get_relative_pos_to(coord2, rel_pos);
-			int lenght = (int)(1000*rel_pos.dist_loxo); // rwy length in meters
-
-			// check whether the runway is alredy exists (probably from earth_nav.dat file)
-			std::string rwy_name = normalize_rwy_name(tokenized[8]);
-
-			Runway* rwy = apt_ptr->get_runway_by_name(rwy_name);
-			if (rwy != NULL)
-			{
-				rwy->set_width(width);
-				rwy->set_length(lenght);
-			}
-			else
-			{
-				apt_ptr->add_runway(rwy_name, 0, 0, lenght, width);				
-			}
+// add the runway to the airport or update the already known one with the known fields of the record
+static void merge_runway(Airport& airport, const RunwayRecord& record)
+{
+	// check whether the runway is alredy exists (e.g. from an ILS record)
+	Runway* rwy = airport.get_runway_by_name(record.name);
+	if (rwy == NULL)
+	{
+		airport.add_runway(record.name, record.course, record.ils_freq, record.length, record.width);
+		rwy = airport.get_runway_by_name(record.name);
+	}
+	else
+	{
+		if (record.course != 0)
+			rwy->set_course(record.course);
+		if (record.ils_freq != 0)
+			rwy->set_ils_freq(record.ils_freq);
+		if (record.length != 0)
+			rwy->set_length(record.length);
+		if (record.width != 0)
+			rwy->set_width(record.width);
+	}
 
-			// do the same for the other end of the runway
-			rwy_name = normalize_rwy_name(tokenized[17]);
-			rwy = apt_ptr->get_runway_by_name(rwy_name);
-			if (rwy != NULL)
-			{
-				rwy->set_width(width);
-				rwy->set_length(lenght);
-			}
-			else
-			{
-				apt_ptr->add_runway(rwy_name, 0, 0, lenght, width);
-			}
+	if (record.has_threshold)
+		rwy->set_threshold(Coordinate(Angle(record.threshold_lat), Angle(record.threshold_lng), record.threshold_elevation));
+	if (record.has_true_heading)
+		rwy->set_true_heading(record.true_heading);
+	if (record.threshold_elevation != 0)
+		rwy->set_threshold_elevation(record.threshold_elevation);
+	if (!record.localizer_id.empty())
+		rwy->set_localizer_id(record.localizer_id);
+}
 
-			continue;
-		}
+void XPlaneParser::add_runway(const RunwayRecord& record)
+{
+	Airport* apt_ptr = get_airport_ptr(record.airport_icao_id);
+	if (apt_ptr == NULL)
+	{
+		_airports.emplace_back(record.airport_icao_id, record.airport_icao_id.substr(0, 2), Coordinate(0, 0, 0), 0);
+		apt_ptr = &_airports.back();
+		index_airport(apt_ptr);
+	}
 
-		//1302 datum_lat 47.439444444
-		//0123456789012345
-		if (line.substr(0, 14) == "1302 datum_lat")
-		{
-			datum_lat = stod(line.substr(15));
-			if (abs(datum_lon) > 0 && abs(datum_lon) > 0)
-			{
-				double elevation = _airports.back().get_coordinate().elevation;
-				apt_ptr->set_coordinate(Coordinate(datum_lat, datum_lon, elevation));
-			}
-			continue;
-		}
+	merge_runway(*apt_ptr, record);
+	_runway_index_dirty = true;
+}
 
-		if (line.substr(0, 14) == "1302 datum_lon")
-		{
-			datum_lon = stod(line.substr(15));
-			if (abs(datum_lon) > 0 && abs(datum_lon) > 0)
-			{
-				double elevation = _airports.back().get_coordinate().elevation;
-				apt_ptr->set_coordinate(Coordinate(datum_lat, datum_lon, elevation));
-			}
-			continue;
-		}
+void XPlaneParser::add_procedure_leg(const ProcedureLegRecord& record)
+{
+	if (get_airport_ptr(record.airport_icao_id) == NULL)
+	{
+		_airports.emplace_back();
+		Airport* apt_ptr = &_airports.back();
+		apt_ptr->set_icao_id(record.airport_icao_id);
+		apt_ptr->set_icao_region(record.airport_icao_id.substr(0, 2));
+		index_airport(apt_ptr);
+	}
 
-		//1302 region_code LH
-		//01234567890123456789
-		if (line.substr(0, 16) == "1302 region_code")
-		{
-			apt_ptr->set_icao_region(line.substr(17));
-			continue;
-		}
+	append_procedure_leg(record, _rnav_procs[IcaoIdKey(record.airport_icao_id)]);
+	if (_streamed_proc_airports.insert(record.airport_icao_id).second)
+		invalidate_query_cache(record.airport_icao_id);
+}
 
-		//1302 city Budapest
-		//01234567890123456789
-		if (line.substr(0, 9) == "1302 city")
+const NavPoint* XPlaneParser::find_airway_fix(const std::string& region, const std::string& icao_id, AirwayFixKind kind)
+{
+	for (const NavPoint* nav_point : find_nav_points_by_icao_id(region, icao_id))
+	{
+		NavPoint::RadioNavType radio_type = nav_point->get_radio_type();
+		bool is_ndb = (radio_type == NavPoint::NDB || radio_type == NavPoint::NDB_DME);
+		switch (kind)
 		{
-			apt_ptr->set_city(line.substr(10));
-			continue;
+		case AIRWAY_FIX_WAYPOINT:
+			if (radio_type == NavPoint::NONE)
+				return nav_point;
+			break;
+		case AIRWAY_FIX_NDB:
+			if (is_ndb)
+				return nav_point;
+			break;
+		default:
+			if (radio_type != NavPoint::NONE && !is_ndb)
+				return nav_point;
+			break;
 		}
+	}
+	return NULL;
+}
 
-		//1302 country HUN Hungary
-		//01234567890123456789
-		if (line.substr(0, 12) == "1302 country")
-		{
-			apt_ptr->set_country(line.substr(13));
-			continue;
-		}
+void XPlaneParser::add_airway_segment(const AirwaySegmentRecord& record)
+{
+	const NavPoint* from = find_airway_fix(record.from_icao_region, record.from_icao_id, record.from_kind);
+	const NavPoint* to = find_airway_fix(record.to_icao_region, record.to_icao_id, record.to_kind);
+	if (from == NULL || to == NULL)
+	{
+		_unresolved_airway_segments++;
+		return;
+	}
 
-		//1302 iata_code BUD
-		//01234567890123456789
-		if (line.substr(0, 14) == "1302 iata_code")
-		{
-			apt_ptr->set_iata_id(line.substr(15));
-			continue;
-		}
+	_airway_builder.add_segment(from, to, record.airway_name, record.direction, record.level, record.base_fl, record.top_fl);
+	_airway_graph_dirty = true;
+}
+
+void XPlaneParser::append_procedure_leg(const ProcedureLegRecord& leg, std::vector<std::shared_ptr<RNAVProc>>& procs)
+{
+	std::vector<const NavPoint*> nav_points = find_nav_points_by_icao_id(leg.fix_icao_region, leg.fix_icao_id);
+	std::shared_ptr<const NavPoint> fix;
+	if (nav_points.size() > 0)
+	{
+		// one copy per fix, shared by the legs of all procedures: it outlives the parser with the procedures (and its pool)
+		std::lock_guard<std::mutex> lock(procedure_fixes_guard);
+		std::shared_ptr<const NavPoint>& shared_fix = _procedure_fixes[nav_points.back()];
+		if (!shared_fix)
+			shared_fix = make_shared_with_pool<const NavPoint>(*nav_points.back());
+		fix = shared_fix;
+	}
+	else if (fix_resolver && !leg.fix_icao_id.empty())
+	{
+		fix = fix_resolver(leg.fix_icao_region, leg.fix_icao_id);
+	}
 
-		//1302 state Pest
-		//01234567890123456789
-		if (line.substr(0, 10) == "1302 state")
+	// the legs of a procedure follow each other: the last procedures are checked first
+	for (auto it = procs.rbegin(); it != procs.rend(); it++)
+	{
+		RNAVProc& proc = **it;
+		if (proc.get_type() == leg.proc_type && proc.get_name() == leg.proc_name)
 		{
-			apt_ptr->set_state(line.substr(11));
-			continue;
+			// the transitions of a SID/STAR are separate routes, e.g. one per runway
+			if (proc.get_transitions().back().name != leg.transition)
+				proc.start_transition(string_pool->intern(leg.transition));
+			proc.add_leg(leg.details, fix);
+			return;
 		}
+	}
 
-		//1302 transition_alt 10000
-		//012345678901234567890
-		if (line.substr(0, 19) == "1302 transition_alt")
-		{
-			int transition_alt = 0;
-			try 
-			{
-				transition_alt = stoi(line.substr(20));
-			}
-			catch (const std::exception& e)
-			{
-				transition_alt = 0;
-			}
+	procs.emplace_back(make_shared_with_pool<RNAVProc>(string_pool->intern(leg.proc_name), string_pool->intern(leg.fix_icao_region), leg.proc_type));
+	procs.back()->start_transition(string_pool->intern(leg.transition));
+	procs.back()->add_leg(leg.details, fix);
 
-			apt_ptr->set_transition_alt(transition_alt);
-			continue;
-		}
+	if (leg.proc_type != RNAVProc::RNAVProcType::RNAV_APPROACH)
+		procs.back()->set_runway_name(string_pool->intern(leg.transition));
+	procs.back()->set_airport_iaco_id(string_pool->intern(leg.airport_icao_id));
+}
 
+static uint64_t fnv1a_hash(const std::string& content)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (unsigned char c : content)
+	{
+		hash ^= c;
+		hash *= 0x100000001b3ull;
 	}
+	return hash;
+}
 
-	return true;
+std::filesystem::path XPlaneParser::cifp_file_path(const std::string& airport_icao_code)
+{
+	return custom_or_default_data_path(cifp_root_folder, "CIFP/" + airport_icao_code + ".dat");
 }
 
-bool XPlaneParser::parse_earth_fix_dat_file()
+bool XPlaneParser::read_cifp_file(const std::string& airport_icao_code, std::string& content, CifpFileStamp& stamp)
 {
-	std::filesystem::path file_absolute_path = absolute_path(xplane_root_folder, "Custom Data", "earth_fix.dat");
+	std::filesystem::path file_path = cifp_file_path(airport_icao_code);
+
 	std::ifstream i_str;
-	i_str.open(file_absolute_path);
+	i_str.open(file_path, std::ios::binary);
 	if (!i_str.is_open())
 	{
-		Logger(TLogLevel::logERROR) << "parse_earth_fix_dat_file: can't open file for read: earth_fix.dat" << std::endl;
-		Logger(TLogLevel::logINFO) << "full path: " << file_absolute_path.string() << std::endl;
+		// many airports have no CIFP file: the callers which need one report it
+		std::error_code error;
+		if (std::filesystem::exists(file_path, error))
+			Logger(TLogLevel::logERROR) << "parse_airport_file: can't open file for read: " << file_path << std::endl;
+		else
+			Logger(TLogLevel::logDEBUG) << "parse_airport_file: no CIFP file: " << file_path << std::endl;
 		return false;
 	}
 
+	std::error_code error;
+	stamp.modification_time = std::filesystem::last_write_time(file_path, error);
+	stamp.size = std::filesystem::file_size(file_path, error);
+
+	std::ostringstream o_str;
+	o_str << i_str.rdbuf();
+	content = o_str.str();
+	stamp.content_hash = fnv1a_hash(content);
+	return true;
+}
+
+void XPlaneParser::parse_cifp_content(const std::string& content, const std::string& airport_icao_code, std::vector<std::shared_ptr<RNAVProc>>& procs, std::vector<RunwayRecord>& runways)
+{
+	std::istringstream i_str(content);
 	std::string line;
-	int line_count = 0;
+	ProcedureLegRecord leg;
+	RunwayRecord runway;
 	while (std::getline(i_str, line))
 	{
-		if (++line_count <= 3 || line.length() < 50)
-			continue;
+		if (XPlaneRecordDecoder::decode_cifp_proc_line(line, airport_icao_code, leg))
+			append_procedure_leg(leg, procs);
+		else if (XPlaneRecordDecoder::decode_cifp_rwy_line(line, airport_icao_code, runway))
+			runways.push_back(runway);
+	}
+}
+
+bool XPlaneParser::parse_airport_file(const std::string& airport_icao_code)
+{
+	//if airport file already parsed, we don't need to parse it again
+	if (_airport_files_parsed.count(airport_icao_code) > 0 || _streamed_proc_airports.count(airport_icao_code) > 0)
+		return true;
+	if (_missing_cifp_files.count(airport_icao_code) > 0)
+		return false;
+
+	// the airports outside of the load filter are not created from their CIFP file
+	if (load_filter.is_active() && get_airport_ptr(airport_icao_code) == NULL)
+		return false;
 
-		//-21.014086111   26.872350000  ABFNV ENRT FB 2115154 ABEAM FRANCISTOWN VOR
-		// 47.483388889   18.258777778  GILEP ENRT LH 4478275 GILEP
-		//0123456789012234567890123456789012345678901234567890123456789
-		//          1          2         3         4         5
-		_nav_points.emplace_back(Coordinate(Angle(std::stod(line.substr(0, 13))), Angle(std::stod(line.substr(14, 13))), 0), line.substr(30, 5), line.substr(41, 2), 0);
+	Logger(TLogLevel::logTRACE) << "Parse airport file: " << cifp_file_path(airport_icao_code) << std::endl;
+
+	std::string content;
+	CifpFileStamp stamp;
+	if (!read_cifp_file(airport_icao_code, content, stamp))
+	{
+		_missing_cifp_files.insert(airport_icao_code);
+		return false;
 	}
 
-	i_str.close();
+	std::vector<std::shared_ptr<RNAVProc>> procs;
+	std::vector<RunwayRecord> runways;
+	parse_cifp_content(content, airport_icao_code, procs, runways);
+	publish_airport_procs(airport_icao_code, procs, runways, stamp);
 	return true;
 }
 
-bool XPlaneParser::parse_earth_nav_dat_file()
+void XPlaneParser::publish_airport_procs(const std::string& airport_icao_code, std::vector<std::shared_ptr<RNAVProc>>& procs, const std::vector<RunwayRecord>& runways, const CifpFileStamp& stamp)
 {
-	std::filesystem::path file_absolute_path = absolute_path(xplane_root_folder, "Custom Data", "earth_nav.dat");
-	std::ifstream i_str;
-	i_str.open(file_absolute_path);
-	if (!i_str.is_open())
+	if (get_airport_ptr(airport_icao_code) == NULL)
 	{
-		Logger(TLogLevel::logERROR) << "parse_earth_nav_dat_file: can't open file for read: earth_nav.dat" << std::endl;
-		Logger(TLogLevel::logINFO) << "full path: " << file_absolute_path.string() << std::endl;
-		return false;
+		// a new airport is complete before it is indexed
+		Airport airport;
+		airport.set_icao_id(airport_icao_code);
+		airport.set_icao_region(airport_icao_code.substr(0, 2));
+		for (const RunwayRecord& runway : runways)
+			merge_runway(airport, runway);
+
+		_airports.push_back(std::move(airport));
+		index_airport(&_airports.back());
+		_runway_index_changed_airports.push_back(airport_icao_code);
+	}
+	else
+	{
+		publish_cifp_runways(airport_icao_code, runways);
 	}
 
-	std::string line;
-	int line_count = 0;
+	_rnav_procs[IcaoIdKey(airport_icao_code)] = std::move(procs);
+	_airport_files_parsed[airport_icao_code] = stamp;
+	invalidate_query_cache(airport_icao_code);
+}
 
-	while (std::getline(i_str, line))
+void XPlaneParser::publish_cifp_runways(const std::string& airport_icao_code, const std::vector<RunwayRecord>& runways)
+{
+	const Airport* apt_ptr = get_airport_ptr(airport_icao_code);
+	if (apt_ptr == NULL)
+		return;
+
+	if (runways.empty())
 	{
-		if (++line_count <= 3)
-			continue;
+		// no CIFP runways (any more): the airport falls back to its apt.dat data
+		if (_cifp_airports.erase(airport_icao_code) > 0)
+			_runway_index_changed_airports.push_back(airport_icao_code);
+		return;
+	}
 
-		if (line.length() <= 80)
-			continue;
+	// the airport may be held by readers: the runways go into a new copy, which is published when it is complete
+	std::shared_ptr<Airport> merged_airport = make_shared_with_pool<Airport>(*apt_ptr);
+	if (merged_airport->get_icao_region().empty())
+		merged_airport->set_icao_region(airport_icao_code.substr(0, 2));
+	for (const RunwayRecord& runway : runways)
+		merge_runway(*merged_airport, runway);
 
-		// 3  47.152222222   18.742222222      430    11710   130      5.000  PTB ENRT LH PUSZTASZABOLCS VOR/DME
-		//12  47.152222222   18.742222222      430    11710   130      0.000  PTB ENRT LH PUSZTASZABOLCS VOR/DME
-		// 4  47.420805556   19.297333333      499    10915    18  45852.474  BPL LHBP LH 13L ILS-cat-II 
-		// 4  47.466605556 -122.317833333      359    11075    18 123840.337 IBEJ KSEA K1 34L ILS-cat-II
-		//0123456789012345678901234567890123456789012345678901234567890123456789012345678901234567890
-		//          1         2         3         4         5         6         7         8         9
-		int type = std::stoi(line.substr(0, 2)); // type
-		double lat = std::stod(line.substr(3, 13));// lat
-		double lng = std::stod(line.substr(17, 13));// lng
-		int alt = std::stoi(line.substr(35, 5)); // alt
-		int freq = std::stoi(line.substr(44, 5)); //freq
-		double course_combined = std::stod(line.substr(56, 10)); // ILS course. 360 x magnetic course + true course
-		std::string id = line.substr(67, 4); //id
-		id = id.substr(id.find_first_not_of(' ', 0));
-		std::string ils_airport_icao = line.substr(72, 4); // only for ILS
-		std::string ils_rwy_name = normalize_rwy_name(line.substr(80, 3)); // only for ILS
-		std::string ils_name = line.substr(84); // only for ILS
-		std::string region = line.substr(77, 2); //region
-		std::string name = line.substr(80); //name
-
-		int true_course = 0;
-		int magnetic_course = 0;
-		Airport* airport_ptr = NULL;
-		bool rwy_found = false;
-
-		switch (type)
-		{
-		case 2:
-			_nav_points.emplace_back(Coordinate(Angle(lat), Angle(lng), alt), id, region, 0);
-			_nav_points.back().set_radio_type(NavPoint::NDB);
-			_nav_points.back().set_radio_frequency(freq);
-			_nav_points.back().set_name(name);
-			break;
-		case 12:
-			// DME collocated with DME. the VOR should be the previously parsed item
-			if (_nav_points.back().get_icao_id() == id)
-				_nav_points.back().set_radio_type(NavPoint::VOR_DME);
-			else
-				Logger(TLogLevel::logERROR) << "XplaneParser: VOR-DME detected but can't find the VOR entity: " << id << std::endl;
-			break;
-		case 13:
-			_nav_points.emplace_back(Coordinate(Angle(lat), Angle(lng), alt), id, region, 0);
-			_nav_points.back().set_radio_type(NavPoint::DME);
-			_nav_points.back().set_radio_frequency(freq);
-			_nav_points.back().set_name(name);
-			break;
-		case 3:
-			true_course = (int)fmod(course_combined, 360);
-			magnetic_course = (int)((course_combined - true_course) / 360);
-
-			_nav_points.emplace_back(Coordinate(Angle(lat), Angle(lng), alt), id, region, 0);
-			_nav_points.back().set_radio_type(NavPoint::VOR);
-			_nav_points.back().set_radio_frequency(freq);
-			_nav_points.back().set_name(name);
-			_nav_points.back().set_magnetic_variation(true_course - magnetic_course);
-			break;
-		case 4:
-			true_course = (int)fmod(course_combined, 360);
-			magnetic_course = (int)((course_combined - true_course) / 360);
+	_cifp_airports[airport_icao_code] = merged_airport;
+	_runway_index_changed_airports.push_back(airport_icao_code);
+}
 
-			airport_ptr = get_airport_ptr(ils_airport_icao);
-			if (!airport_ptr)
-			{
-				_airports.emplace_back(ils_airport_icao, ils_airport_icao.substr(0, 2), Coordinate(lat, lng, alt), true_course - magnetic_course);
-				airport_ptr = &_airports.back();
-			}
+const Airport* XPlaneParser::published_airport(const Airport* airport)
+{
+	if (airport == NULL || _cifp_airports.empty())
+		return airport;
 
-			airport_ptr->set_magnetic_variation(true_course - magnetic_course);
+	auto it = _cifp_airports.find(airport->get_icao_id());
+	return it == _cifp_airports.end() ? airport : it->second.get();
+}
 
-			for (auto& rwy : airport_ptr->get_runways())
-			{
-				if (rwy.get_name() == ils_rwy_name)
-				{
-					rwy.set_course(magnetic_course);
-					rwy.set_ils_freq(freq);
-					rwy_found = true;
-				}
-			}
-			if (!rwy_found)
-				airport_ptr->add_runway(ils_rwy_name, magnetic_course, freq, 0, 0);
-			break;
+bool XPlaneParser::prefetch_airport_file(const std::string& airport_icao_code)
+{
+	{
+		std::lock_guard<std::recursive_mutex> lock(query_guard);
+		if (_airport_files_parsed.count(airport_icao_code) > 0 || _streamed_proc_airports.count(airport_icao_code) > 0)
+			return true;
 
-		default:
-			break;
-		}
+		if (_missing_cifp_files.count(airport_icao_code) > 0 || (load_filter.is_active() && get_airport_ptr(airport_icao_code) == NULL))
+			return false;
+	}
+
+	// the file is read and parsed without the lock: the queries are not blocked meanwhile
+	std::string content;
+	CifpFileStamp stamp;
+	if (!read_cifp_file(airport_icao_code, content, stamp))
+	{
+		std::lock_guard<std::recursive_mutex> lock(query_guard);
+		_missing_cifp_files.insert(airport_icao_code);
+		return false;
 	}
 
-	i_str.close();
+	std::vector<std::shared_ptr<RNAVProc>> procs;
+	std::vector<RunwayRecord> runways;
+	parse_cifp_content(content, airport_icao_code, procs, runways);
+
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	// a query may have loaded the file meanwhile
+	if (_airport_files_parsed.count(airport_icao_code) == 0)
+		publish_airport_procs(airport_icao_code, procs, runways, stamp);
 	return true;
 }
 
-//APPCH:010,A,I31R,ATICO,ATICO,LH,P,C,E  A, ,   ,IF, , , , , ,      ,    ,    ,    ,    ,+,04000,     ,     ,-,230,    ,   , , , , , ,0,N,S;
-//APPCH:020, A, I31R, ATICO, BP865, LH, P, C, EE B, , , TF, , BPR, LH, P, I, , , , , , +, 03000, , , -, 230, , , , , , , , 0, N, S;
-//SID:060,5,BADO2B,RW13L,BADOV,LZ,E,A,EEC , ,   ,TF, , , , , ,      ,    ,    ,    ,    ,+,FL140,     ,     , ,   ,    ,   , , , , , , , , ;
-void XPlaneParser::parse_approach_proc_line(std::cmatch& m, std::string airport_iaco_id)
+bool XPlaneParser::is_airport_file_parsed(const std::string& airport_icao_code)
 {
-	if (m[3] != "A")
-		return;
-
-	RNAVProc::RNAVProcType proc_type = RNAVProc::RNAVProcType::RNAV_APPROACH;
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	return _airport_files_parsed.count(airport_icao_code) > 0;
+}
 
-	if (m[2] == "010")
-	{
-		std::string app_name_with_transition = std::string(m[4]) + "-" + std::string(m[5]);
+static const double PI = 3.14159265358979;
+static const double KM_PER_DEG_LAT = 111.2;
+static const int AIRPORT_GRID_LAT_CELLS = 180;
+static const int AIRPORT_GRID_LNG_CELLS = 360;
 
-		_rnav_procs.emplace_back(app_name_with_transition, m[7], proc_type);
-		_rnav_procs.back().set_airport_iaco_id(airport_iaco_id);
-	}
+static int airport_grid_lat_cell(double lat)
+{
+	return std::clamp((int)std::floor(lat + 90), 0, AIRPORT_GRID_LAT_CELLS - 1);
+}
 
-	std::list<NavPoint> np_list = get_nav_points_by_icao_id(m[7],m[6]);
-	if (np_list.size()>0)
-		_rnav_procs.back().add_nav_point(np_list.back());
+static int airport_grid_lng_cell(double lng)
+{
+	int cell = (int)std::floor(lng + 180) % AIRPORT_GRID_LNG_CELLS;
+	return cell < 0 ? cell + AIRPORT_GRID_LNG_CELLS : cell;
 }
 
-void XPlaneParser::parse_proc_line(std::cmatch& m, std::string airport_icao_id)
+static uint32_t airport_grid_key(int lat_cell, int lng_cell)
 {
-	RNAVProc::RNAVProcType proc_type;
-	if (m[1] == "SID")
-		proc_type = RNAVProc::RNAVProcType::RNAV_SID;
-	else if (m[1] == "STAR")
-		proc_type = RNAVProc::RNAVProcType::RNAV_STAR;
-	else if (m[1] == "APPCH") {
-		return parse_approach_proc_line(m, airport_icao_id);
-	}
-	else
-		proc_type = RNAVProc::RNAVProcType::RNAV_OTHER;
+	return (uint32_t)lat_cell * AIRPORT_GRID_LNG_CELLS + (uint32_t)lng_cell;
+}
 
-	bool rnav_proc_already_exists = false;
-	for (auto it = _rnav_procs.begin(); it != _rnav_procs.end(); it++)
+std::shared_ptr<const XPlaneParser::AirportGrid> XPlaneParser::get_airport_grid()
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	if (_airport_grid_dirty || !_airport_grid)
 	{
-		if (it->get_name() == m[4] && it->get_airport_icao_id() == airport_icao_id)
+		auto grid = std::make_shared<AirportGrid>();
+		for (const Airport& airport : _airports)
 		{
-			std::list<NavPoint> np_list = get_nav_points_by_icao_id(m[7],m[6]);
-			if (np_list.size() > 0)
-				_rnav_procs.back().add_nav_point(np_list.back());
-
-			rnav_proc_already_exists = true;
+			const Coordinate& coordinate = airport.get_coordinate();
+			int lat_cell = airport_grid_lat_cell(coordinate.lat.convert_to_double());
+			int lng_cell = airport_grid_lng_cell(coordinate.lng.convert_to_double());
+			(*grid)[airport_grid_key(lat_cell, lng_cell)].push_back({ &airport, coordinate });
 		}
+		_airport_grid = grid;
+		_airport_grid_dirty = false;
 	}
+	return _airport_grid;
+}
 
-	if (!rnav_proc_already_exists)
+std::vector<const Airport*> XPlaneParser::find_airports_within_distance(const Coordinate& center, double radius_km)
+{
+	std::vector<const Airport*> airports;
+	std::shared_ptr<const AirportGrid> grid = get_airport_grid();
+	double center_lat = center.lat.convert_to_double();
+	double center_lng = center.lng.convert_to_double();
+	double max_delta_lat = radius_km / KM_PER_DEG_LAT;
+
+	// the longitude span of the radius grows toward the poles, up to the whole row of cells
+	double max_lat = std::min(std::abs(center_lat) + max_delta_lat, 90.0);
+	double cos_max_lat = std::cos(max_lat * PI / 180);
+	int first_lng_cell = 0;
+	int lng_cell_count = AIRPORT_GRID_LNG_CELLS;
+	if (cos_max_lat > 0.01)
 	{
-		_rnav_procs.emplace_back(m[4], m[7], proc_type);
-		std::list<NavPoint> np_list = get_nav_points_by_icao_id(m[7],m[6]);
-		if (np_list.size() > 0)
-			_rnav_procs.back().add_nav_point(np_list.back());
-		
-		_rnav_procs.back().set_runway_name(m[5]);
-		_rnav_procs.back().set_airport_iaco_id(airport_icao_id);
+		double max_delta_lng = max_delta_lat / cos_max_lat;
+		first_lng_cell = (int)std::floor(center_lng - max_delta_lng);
+		lng_cell_count = std::min((int)std::floor(center_lng + max_delta_lng) - first_lng_cell + 1, AIRPORT_GRID_LNG_CELLS);
+		first_lng_cell = airport_grid_lng_cell(first_lng_cell);
 	}
 
-}
-
-bool XPlaneParser::parse_airport_file(std::string airport_icao_code)
-{
-	//if airport file already parsed, we don't need to parse it again
-	for (auto& ap_str : _airport_files_parsed)
+	for (int lat_cell = airport_grid_lat_cell(center_lat - max_delta_lat); lat_cell <= airport_grid_lat_cell(center_lat + max_delta_lat); lat_cell++)
 	{
-		if (ap_str == airport_icao_code)
-			return true;
+		for (int lng_i = 0; lng_i < lng_cell_count; lng_i++)
+		{
+			auto cell_it = grid->find(airport_grid_key(lat_cell, (first_lng_cell + lng_i) % AIRPORT_GRID_LNG_CELLS));
+			if (cell_it == grid->end())
+				continue;
+
+			for (const AirportGridEntry& entry : cell_it->second)
+			{
+				// cheap latitude check before the great circle distance
+				if (std::abs(entry.coordinate.lat.convert_to_double() - center_lat) > max_delta_lat)
+					continue;
+
+				RelativePos rel_pos;
+				center.get_relative_pos_to(entry.coordinate, rel_pos);
+				if (rel_pos.dist_ortho <= radius_km)
+					airports.push_back(entry.airport);
+			}
+		}
 	}
 
-	std::string file_name = airport_icao_code + ".dat";
-	std::filesystem::path file_path = std::filesystem::path(xplane_root_folder) / "Custom Data" / "CIFP" / file_name;
+	// the lock is needed for the CIFP versions only
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	for (const Airport*& airport : airports)
+		airport = published_airport(airport);
+	return airports;
+}
 
-	Logger(TLogLevel::logTRACE) << "Parse airport file: " << file_path << std::endl;
+std::list<std::string> XPlaneParser::reload_changed_cifp_files()
+{
+	std::list<std::string> reloaded_airports;
 
-	std::ifstream i_str;
-	i_str.open(file_path);
-	if (!i_str.is_open())
+	std::unordered_map<std::string, CifpFileStamp> parsed_files;
 	{
-		Logger(TLogLevel::logERROR) << "parse_airport_file: can't open file for read: " << file_path << std::endl;
-		return false;
+		std::lock_guard<std::recursive_mutex> lock(query_guard);
+		parsed_files = _airport_files_parsed;
+		// the missing files may have been added since
+		_missing_cifp_files.clear();
 	}
 
-	Airport* apt_ptr = get_airport_ptr(airport_icao_code);
-	if (apt_ptr == NULL)
+	// the files are read and parsed without the lock: the queries of the other airports are not blocked
+	for (auto& parsed_file : parsed_files)
 	{
-		_airports.emplace_back();
-		apt_ptr = &_airports.back();
-	}
+		const std::string& airport_icao_code = parsed_file.first;
+		const CifpFileStamp& old_stamp = parsed_file.second;
+
+		std::error_code error;
+		std::filesystem::path file_path = cifp_file_path(airport_icao_code);
+		if (!std::filesystem::exists(file_path, error))
+		{
+			Logger(TLogLevel::logWARNING) << "reload_changed_cifp_files: file removed: " << file_path << std::endl;
+			std::lock_guard<std::recursive_mutex> lock(query_guard);
+			_rnav_procs.erase(IcaoIdKey(airport_icao_code));
+			_airport_files_parsed.erase(airport_icao_code);
+			// the runways of the file are gone too: the airport falls back to its apt.dat data
+			_cifp_airports.erase(airport_icao_code);
+			_runway_index_changed_airports.push_back(airport_icao_code);
+			invalidate_query_cache(airport_icao_code);
+			reloaded_airports.push_back(airport_icao_code);
+			continue;
+		}
 
-	apt_ptr->set_icao_id(airport_icao_code);
-	apt_ptr->set_icao_region(airport_icao_code.substr(0, 2));
+		if (std::filesystem::last_write_time(file_path, error) == old_stamp.modification_time &&
+			std::filesystem::file_size(file_path, error) == old_stamp.size)
+			continue;
 
-	std::string line;
-	auto re_apt_rwy_line = std::regex(APT_RWY_LINE);
-	auto re_apt_proc_line = std::regex(APT_PROC_LINE);
-	while (std::getline(i_str, line))
-	{
-		trim_line(line);
+		std::string content;
+		CifpFileStamp new_stamp;
+		if (!read_cifp_file(airport_icao_code, content, new_stamp))
+			continue;
+
+		std::vector<std::shared_ptr<RNAVProc>> procs;
+		std::vector<RunwayRecord> runways;
+		bool content_changed = (new_stamp.content_hash != old_stamp.content_hash || new_stamp.size != old_stamp.size);
+		if (content_changed)
+			parse_cifp_content(content, airport_icao_code, procs, runways);
+
+		std::lock_guard<std::recursive_mutex> lock(query_guard);
+		_airport_files_parsed[airport_icao_code] = new_stamp;
+		if (!content_changed)
+			continue;
 
-		std::cmatch m;		
-		if (std::regex_match(line.c_str(), m, re_apt_proc_line))
-			parse_proc_line(m, airport_icao_code);
+		Logger(TLogLevel::logINFO) << "reload_changed_cifp_files: reload " << file_path << std::endl;
+		_rnav_procs[IcaoIdKey(airport_icao_code)].swap(procs);
+		publish_cifp_runways(airport_icao_code, runways);
+		invalidate_query_cache(airport_icao_code);
+		reloaded_airports.push_back(airport_icao_code);
 	}
 
-	_airport_files_parsed.emplace_back(airport_icao_code);
-	return true;
+	return reloaded_airports;
+}
+
+void XPlaneParser::start_cifp_watcher(std::chrono::milliseconds poll_interval)
+{
+	stop_cifp_watcher();
+
+	cifp_watcher_stop = false;
+	cifp_watcher = std::thread([this, poll_interval]() {
+		std::unique_lock<std::mutex> lock(cifp_watcher_guard);
+		while (!cifp_watcher_wakeup.wait_for(lock, poll_interval, [this]() { return cifp_watcher_stop; }))
+		{
+			lock.unlock();
+			reload_changed_cifp_files();
+			lock.lock();
+		}
+	});
+}
+
+void XPlaneParser::stop_cifp_watcher()
+{
+	if (!cifp_watcher.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(cifp_watcher_guard);
+		cifp_watcher_stop = true;
+	}
+	cifp_watcher_wakeup.notify_all();
+	cifp_watcher.join();
 }
 
-std::list<RNAVProc> XPlaneParser::get_rnav_procs_by_airport_icao_id(std::string icao_id)
+std::list<RNAVProc> XPlaneParser::get_rnav_procs_by_airport_icao_id(const std::string& icao_id)
 {
 	std::list<RNAVProc> rnav_procs;
 
@@ -490,97 +677,430 @@ std::list<RNAVProc> XPlaneParser::get_rnav_procs_by_airport_icao_id(std::string
 		return rnav_procs;
 	}
 
-	for (auto& proc : _rnav_procs) {
-		if (proc.get_airport_icao_id() == icao_id)
-			rnav_procs.emplace_back(proc);
+	for (auto& proc : find_rnav_procs_by_airport_icao_id(icao_id))
+	{
+		rnav_procs.emplace_back(*proc);
+		rnav_procs.back().detach_strings();
 	}
 
 	return rnav_procs;
 }
 
+std::vector<RNAVProcHandle> XPlaneParser::find_rnav_procs_by_airport_icao_id(const std::string& icao_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	std::vector<RNAVProcHandle> handles;
+	if (_airport_procs_cache.get(icao_id, handles))
+		return handles;
+
+	if (!parse_airport_file(icao_id))
+		return handles;
+
+	auto procs_it = _rnav_procs.find(IcaoIdKey(icao_id));
+	if (procs_it == _rnav_procs.end())
+		return handles;
+
+	handles.reserve(procs_it->second.size());
+	for (auto& proc : procs_it->second)
+	{
+		if (proc->get_airport_icao_id() == icao_id)
+			handles.emplace_back(proc);
+	}
+
+	_airport_procs_cache.put(icao_id, handles);
+	return handles;
+}
+
 std::list<std::string> XPlaneParser::get_list_of_airport_iaco_codes()
 {
 	std::list<std::string> icao_codes;
-	for (auto& dir_entry : std::filesystem::directory_iterator{ std::filesystem::path(xplane_root_folder) / "CIFP" })
+	for (auto& dir_entry : std::filesystem::directory_iterator{ get_cifp_folder_path(cifp_root_folder) })
 		icao_codes.emplace_back(dir_entry.path().filename().replace_extension().string());
 
 	return icao_codes;
 }
 
-XPlaneParser::XPlaneParser(std::string _xplane_root_folder)
+XPlaneParser::XPlaneParser(std::string _xplane_root_folder) :
+	string_pool(std::make_shared<StringPool>()), _procedure_path_cache(DEFAULT_PROCEDURE_PATH_CACHE_CAPACITY)
 {
 	xplane_root_folder = _xplane_root_folder;
+	cifp_root_folder = _xplane_root_folder;
+}
+
+bool NavDataLoadFilter::is_active() const
+{
+	return icao_regions.size() > 0 || use_bounding_box;
+}
+
+bool NavDataLoadFilter::accepts_region(IcaoRegionKey region) const
+{
+	// a few regions: a linear search is the cheapest
+	if (icao_regions.empty())
+		return true;
+
+	return std::find(icao_regions.begin(), icao_regions.end(), region) != icao_regions.end();
+}
+
+bool NavDataLoadFilter::accepts_position(double lat, double lng) const
+{
+	if (!use_bounding_box)
+		return true;
+
+	return lat >= min_lat && lat <= max_lat && lng >= min_lng && lng <= max_lng;
+}
+
+void XPlaneParser::set_cifp_root_folder(std::string _cifp_root_folder)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	cifp_root_folder = std::move(_cifp_root_folder);
+}
+
+void XPlaneParser::set_fix_resolver(FixResolver resolver)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	fix_resolver = std::move(resolver);
+}
+
+void XPlaneParser::set_load_filter(const NavDataLoadFilter& filter)
+{
+	load_filter = filter;
+}
+
+const NavDataLoadFilter& XPlaneParser::get_load_filter() const
+{
+	return load_filter;
+}
+
+XPlaneParser::~XPlaneParser()
+{
+	stop_cifp_watcher();
+}
+
+std::shared_ptr<StringPool> XPlaneParser::get_string_pool()
+{
+	return string_pool;
 }
 
-std::list<NavPoint>& XPlaneParser::get_nav_points()
+const std::list<NavPoint>& XPlaneParser::get_nav_points()
 {
 	return _nav_points;
 }
 
-std::list<NavPoint> XPlaneParser::get_nav_points_by_icao_id(std::string icao_id)
+std::list<NavPoint> XPlaneParser::get_nav_points_by_icao_id(const std::string& icao_id)
 {
 	return get_nav_points_by_icao_id("all", icao_id);
 }
 
-std::list<NavPoint> XPlaneParser::get_nav_points_by_icao_id(std::string region, std::string icao_id)
+std::list<NavPoint> XPlaneParser::get_nav_points_by_icao_id(const std::string& region, const std::string& icao_id)
 {
 	std::list<NavPoint> return_list;
+	for (const NavPoint* nav_point : find_nav_points_by_icao_id(region, icao_id))
+	{
+		return_list.emplace_back(*nav_point);
+		return_list.back().detach_strings();
+	}
+
+	return return_list;
+}
+
+std::vector<const NavPoint*> XPlaneParser::find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id)
+{
+	std::vector<const NavPoint*> return_list;
+
+	IcaoIdKey id_key(icao_id);
+	std::shared_lock<std::shared_mutex> lock(nav_point_guard);
+	auto index_it = _nav_point_index.find(id_key);
+	if (index_it == _nav_point_index.end())
+		return return_list;
 
-	for (auto& nav_point : _nav_points)
+	bool any_region = (region == "all");
+	IcaoRegionKey region_key(region);
+	for (NavPoint* nav_point : index_it->second)
 	{
-		if (nav_point.get_icao_id() == icao_id && (region == "all" || nav_point.get_icao_region() == region))
-			return_list.emplace_back(nav_point);
+		// packed keys are exact except for the truncated/unpackable ones
+		if (id_key.is_truncated() && nav_point->get_icao_id() != icao_id)
+			continue;
+
+		if (!any_region && (nav_point->get_icao_region_key() != region_key || (!region_key.is_packed() && nav_point->get_icao_region() != region)))
+			continue;
+
+		return_list.push_back(nav_point);
 	}
 	return return_list;
 }
 
-bool XPlaneParser::get_airport_by_icao_id(std::string icao_id, Airport& _airport)
+bool XPlaneParser::get_airport_by_icao_id(const std::string& icao_id, Airport& _airport)
 {
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
 	if (!parse_airport_file(icao_id))
-	{
 		Logger(TLogLevel::logERROR) << "Can't open airport file for " << icao_id << std::endl;
-		//return false;
-	}
 
-	for (auto& ap : _airports)
+	const Airport* apt_ptr = find_airport_by_icao_id(icao_id);
+	if (apt_ptr != NULL)
 	{
-		if (ap.get_icao_id() == icao_id)
-		{
-			_airport = ap;
-			return true;
-		}
+		_airport = *apt_ptr;
+		_airport.detach_strings();
+		return true;
 	}
 
 	Logger(TLogLevel::logERROR) << "Can't find airport " << icao_id << std::endl;
 	return false;
 }
 
-Airport* XPlaneParser::get_airport_ptr(std::string airport_icao_code)
+const Airport* XPlaneParser::find_airport_by_icao_id(const std::string& icao_id)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	const Airport* apt_ptr = NULL;
+	if (_airport_cache.get(icao_id, apt_ptr))
+		return apt_ptr;
+
+	// a missing CIFP file is not an error here: the airport may come from apt.dat only
+	parse_airport_file(icao_id);
+	apt_ptr = published_airport(get_airport_ptr(icao_id));
+	if (apt_ptr != NULL)
+		_airport_cache.put(icao_id, apt_ptr);
+
+	return apt_ptr;
+}
+
+AirportHandle XPlaneParser::find_airport_handle_by_icao_id(const std::string& icao_id, const std::shared_ptr<const void>& parser_owner)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	const Airport* apt_ptr = find_airport_by_icao_id(icao_id);
+	if (apt_ptr == NULL)
+		return nullptr;
+
+	auto it = _cifp_airports.find(icao_id);
+	if (it == _cifp_airports.end() || it->second.get() != apt_ptr)
+		return AirportHandle(parser_owner, apt_ptr);
+	if (!parser_owner)
+		return it->second;
+
+	// the handle keeps both the CIFP version and the parser alive
+	auto owners = std::make_shared<std::pair<std::shared_ptr<const void>, AirportHandle>>(parser_owner, it->second);
+	return AirportHandle(owners, apt_ptr);
+}
+
+Airport* XPlaneParser::get_airport_ptr(const std::string& airport_icao_code)
+{
+	IcaoIdKey id_key(airport_icao_code);
+	auto index_it = _airport_index.find(id_key);
+	if (index_it == _airport_index.end())
+		return NULL;
+
+	for (Airport* ap : index_it->second)
+	{
+		if (!id_key.is_truncated() || ap->get_icao_id() == airport_icao_code)
+			return ap;
+	}
+	return NULL;
+}
+
+void XPlaneParser::update_nav_point_table()
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	std::shared_lock<std::shared_mutex> nav_point_lock(nav_point_guard);
+	std::size_t table_rows = _nav_point_table ? _nav_point_table->size() : 0;
+	if (_nav_point_table && table_rows == _nav_points.size())
+		return;
+
+	// the nav points are only appended: walk back to the first one which is not in the table yet.
+	// the readers may still scan the current table, the new rows go into a copy of it
+	std::size_t new_rows = _nav_points.size() - table_rows;
+	auto it = _nav_points.end();
+	std::advance(it, -(std::ptrdiff_t)new_rows);
+
+	std::shared_ptr<NavPointTable> next = _nav_point_table ? std::make_shared<NavPointTable>(*_nav_point_table) : std::make_shared<NavPointTable>();
+	next->reserve(_nav_points.size());
+	for (; it != _nav_points.end(); it++)
+		next->append(&(*it));
+	_nav_point_table = next;
+}
+
+std::shared_ptr<const NavPointTable> XPlaneParser::get_nav_point_table()
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	update_nav_point_table();
+	return _nav_point_table;
+}
+
+const AirwayGraph& XPlaneParser::get_airway_graph()
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	if (_airway_graph_dirty)
+	{
+		_airway_builder.build(_airway_graph);
+		_airway_graph_dirty = false;
+	}
+	return _airway_graph;
+}
+
+std::size_t XPlaneParser::get_unresolved_airway_segment_count()
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	return _unresolved_airway_segments;
+}
+
+std::shared_ptr<const RunwayIndex> XPlaneParser::get_runway_index()
 {
-	for (auto& ap : _airports)
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	if (_runway_index_dirty || !_runway_index)
+	{
+		std::vector<const Airport*> airports;
+		airports.reserve(_airports.size());
+		for (const Airport& airport : _airports)
+		{
+			if (_cifp_airports.count(airport.get_icao_id()) == 0)
+				airports.push_back(&airport);
+		}
+
+		auto runway_index = std::make_shared<RunwayIndex>();
+		runway_index->build(airports);
+		// the CIFP versions are kept alive by the snapshots which refer to them
+		for (auto& cifp_airport : _cifp_airports)
+			runway_index->add_airport(cifp_airport.second);
+		_runway_index = runway_index;
+		_runway_index_dirty = false;
+		_runway_index_changed_airports.clear();
+	}
+	else if (!_runway_index_changed_airports.empty())
 	{
-		if (ap.get_icao_id() == airport_icao_code)
+		// the CIFP loads replace some airports only: the new snapshot is updated for them
+		auto runway_index = std::make_shared<RunwayIndex>(*_runway_index);
+		for (const std::string& airport_icao_code : _runway_index_changed_airports)
 		{
-			return &ap;
+			runway_index->remove_airport(airport_icao_code);
+			auto it = _cifp_airports.find(airport_icao_code);
+			const Airport* airport = get_airport_ptr(airport_icao_code);
+			if (it != _cifp_airports.end())
+				runway_index->add_airport(it->second);
+			else if (airport != NULL)
+				runway_index->add_airport(*airport);
 		}
+		_runway_index = runway_index;
+		_runway_index_changed_airports.clear();
 	}
-	return NULL;
+	return _runway_index;
+}
+
+void XPlaneParser::index_nav_point(NavPoint* nav_point)
+{
+	_nav_point_index[nav_point->get_icao_id_key()].push_back(nav_point);
+}
+
+void XPlaneParser::index_airport(Airport* airport)
+{
+	_airport_index[airport->get_icao_id_key()].push_back(airport);
+	_airport_grid_dirty = true;
 }
 
-bool XPlaneParser::get_procedure_by_id(std::string proc_name, std::string airport_icao, RNAVProc& proc)
+bool XPlaneParser::get_procedure_by_id(const std::string& proc_name, const std::string& airport_icao, RNAVProc& proc)
 {
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
 	if (!parse_airport_file(airport_icao))
 	{
 		Logger(TLogLevel::logERROR) << "Can't open airport file for " << airport_icao << std::endl;
 		return false;
 	}
 
-	for (auto it = _rnav_procs.begin(); it != _rnav_procs.end(); it++)
+	RNAVProcHandle handle = find_procedure_by_id(proc_name, airport_icao);
+	if (!handle)
+		return false;
+
+	proc = *handle;
+	proc.detach_strings();
+	return true;
+}
+
+RNAVProcHandle XPlaneParser::find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	// airport ids never contain a space
+	std::string cache_key = airport_icao + " " + proc_name;
+	RNAVProcHandle handle;
+	if (_procedure_cache.get(cache_key, handle))
+		return handle;
+
+	if (!parse_airport_file(airport_icao))
+		return nullptr;
+
+	auto procs_it = _rnav_procs.find(IcaoIdKey(airport_icao));
+	if (procs_it == _rnav_procs.end())
+		return nullptr;
+
+	for (auto& proc : procs_it->second)
 	{
-		if (it->get_name() == proc_name && it->get_airport_icao_id() == airport_icao) {
-			proc = *it;
-			return true;
+		if (proc->get_name() == proc_name && proc->get_airport_icao_id() == airport_icao)
+		{
+			_procedure_cache.put(cache_key, proc);
+			return proc;
 		}
 	}
-	return false;
+	return nullptr;
+}
+
+std::shared_ptr<const ProcedurePath> XPlaneParser::get_procedure_path(const std::string& proc_name, const std::string& airport_icao)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	std::string cache_key = airport_icao + " " + proc_name;
+	std::shared_ptr<const ProcedurePath> path;
+	if (_procedure_path_cache.get(cache_key, path))
+		return path;
+
+	RNAVProcHandle proc = find_procedure_by_id(proc_name, airport_icao);
+	if (proc == nullptr)
+		return nullptr;
+
+	path = _procedure_path_builder.build(*proc);
+	_procedure_path_cache.put(cache_key, path);
+	return path;
+}
+
+void XPlaneParser::set_procedure_path_cache_capacity(std::size_t capacity)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	_procedure_path_cache.set_capacity(capacity);
+}
+
+void XPlaneParser::enable_query_cache(std::size_t capacity)
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	_airport_cache.set_capacity(capacity);
+	_procedure_cache.set_capacity(capacity);
+	_airport_procs_cache.set_capacity(capacity);
+}
+
+QueryCacheStats XPlaneParser::get_query_cache_stats()
+{
+	std::lock_guard<std::recursive_mutex> lock(query_guard);
+	QueryCacheStats stats;
+	stats.airports = _airport_cache.get_stats();
+	stats.procedures = _procedure_cache.get_stats();
+	stats.airport_procedures = _airport_procs_cache.get_stats();
+	stats.procedure_paths = _procedure_path_cache.get_stats();
+	stats.procedure_path_segments = _procedure_path_builder.get_segment_stats();
+	return stats;
+}
+
+void XPlaneParser::invalidate_query_cache(const std::string& airport_icao_code)
+{
+	std::string proc_key_prefix = airport_icao_code + " ";
+	_airport_cache.erase(airport_icao_code);
+	_airport_procs_cache.erase(airport_icao_code);
+	_procedure_cache.erase_if([&proc_key_prefix](const std::string& key) {
+		return key.compare(0, proc_key_prefix.size(), proc_key_prefix) == 0;
+	});
+	_procedure_path_cache.erase_if([&proc_key_prefix](const std::string& key) {
+		return key.compare(0, proc_key_prefix.size(), proc_key_prefix) == 0;
+	});
+}
+
+void XPlaneParser::clear_query_cache()
+{
+	_airport_cache.clear();
+	_procedure_cache.clear();
+	_airport_procs_cache.clear();
+	// the fixes may have moved: the cached segments are dropped too
+	_procedure_path_cache.clear();
+	_procedure_path_builder.clear();
 }
\ No newline at end of file
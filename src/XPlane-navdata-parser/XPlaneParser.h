@@ -8,17 +8,30 @@
 #include <list>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 #include <regex>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include "../NavPoint.h"
 #include "../Airport.h"
 #include "../RNAVProc.h"
-
-const std::string RE_FLOAT = "([+-]*[0-9\\.]+)";
-const std::string RE_INT = "([+-]*[0-9]+)";
-const std::string RE_ID = "([a-zA-Z0-9\\/_\\-]+)";
-const std::string RE_ID_S = "([a-zA-Z0-9\\/_\\-\\s]+)"; // ID with space
-const std::string RE_TEXT = "(.+)";
+#include "../StringPool.h"
+#include "../IcaoKey.h"
+#include "../NavPointTable.h"
+#include "../RunwayIndex.h"
+#include "../ProcedurePath.h"
+#include "../LruCache.h"
+#include "../NavDataSource.h"
 
 //RWY:RW13L,     ,      ,00496, ,BPL ,2,   ;N47264352,E019152718,0000;
 //RWY:RW17L,+0080,      ,00283, ,    , ,   ;N46412110,E021094215,0000;
@@ -26,18 +39,7 @@ const std::string RE_TEXT = "(.+)";
 //RWY:RW04R,+0080,      ,00355, ,DCN ,1,   ;N47285299,E021361079,0000;
 //RWY:RW08 ,-0198,      ,01907, ,OEJ ,0,   ;N47153197,E011195411,0197;
 //RWY:RW26, +0198, , 01894, , OEV, 1, ; N47154182, E011212524, 0000;
-const std::string APT_RWY_LINE ="RWY:RW" +
-								RE_ID_S + "," + //[1] RWY name
-								".+" + "," +
-								".+" + "," +
-								"\\s*"+RE_INT + "," + //[2] elevation
-								".+" + "," +
-								RE_ID_S + "," + //[3] ???
-								".+" + "," +
-								".+" + ";" +
-								RE_ID_S + "," + //[4] lat
-								RE_ID_S + "," + //[5] lng
-								".+;";
+// the fields are decoded by XPlaneRecordDecoder::decode_cifp_rwy_line
 
 //SID:010,5,NARK6D,RW04R,DC008,LH,P,C,EY  , ,   ,DF, , , , , ,      ,    ,    ,    ,    ,-,03000,     ,10000,-,230,    ,   ,LHDC,LH,P,A, , , , ;
 //SID:010,5,BADO2J,RW13R,BP711,LH,P,C,EY  , ,   ,DF, , , , , ,      ,    ,    ,    ,    , ,     ,     ,10000,-,230,    ,   ,LHBP,LH,P,A, , , , ;
@@ -46,38 +48,237 @@ const std::string APT_RWY_LINE ="RWY:RW" +
 //APPCH:030, I, I04R, , RW04R, LH, P, G, G  M, , , CF, , DCN, LH, P, I, , 2229, 0015, 0430, 0064, , 00410, , , , , -300, , , , , , , 0, D, S;
 //APPCH:010,A,I13L,CATUZ,CATUZ,LH,P,C,E  A, ,   ,IF, , , , , ,      ,    ,    ,    ,    ,+,05000,     ,     ,-,230,    ,   , , , , , ,0,N,S;
 //APPCH:010,A,I31L,ATICO,ATICO,LH,P,C,E  A, ,   ,IF, , , , , ,      ,    ,    ,    ,    ,+,04000,     ,     ,-,230,    ,   , , , , , ,0,D,S;
-const std::string APT_PROC_LINE = "(SID|STAR|APPCH):([0-9]+)," +
-									RE_ID_S + "," + //3: not used/approach type
-									RE_ID_S + "," + //4: Proc ID
-									RE_ID_S + "," + //5: RWY name/Transition
-									RE_ID_S + "," + //6: Nav point ID
-									RE_ID_S + "," + //7: Region ID
-									".+;";
+// the comma separated fields are decoded by XPlaneRecordDecoder::decode_cifp_proc_line
+
+typedef enum {
+	EARTH_FIX_DAT,
+	EARTH_NAV_DAT,
+	APT_DAT,
+	EARTH_AWY_DAT
+} GlobalDatFile;
+
+// Procedures are shared with the callers: a handle keeps its procedure alive and unchanged
+typedef std::shared_ptr<const RNAVProc> RNAVProcHandle;
+// handles which share the ownership of the parser of the entity
+typedef std::shared_ptr<const NavPoint> NavPointHandle;
+typedef std::shared_ptr<const Airport> AirportHandle;
+// looks up a procedure fix outside of the parser, e.g. in the other layers of NavDataLayers
+typedef std::function<NavPointHandle(const std::string& region, const std::string& icao_id)> FixResolver;
+
+// state of a parsed CIFP file, used to detect the changed files
+struct CifpFileStamp {
+	std::filesystem::file_time_type modification_time;
+	std::uintmax_t size = 0;
+	uint64_t content_hash = 0;
+};
+
+/* Restricts the parse of the global dat files to some ICAO regions and/or to a lat/lng box.
+   The default filter accepts everything. Airports are checked by their "1302 region_code"
+   and datum rows: an airport without them is dropped by an active filter. */
+struct NavDataLoadFilter {
+	std::vector<IcaoRegionKey> icao_regions; // empty: all regions
+	bool use_bounding_box = false;
+	double min_lat = -90;
+	double max_lat = 90;
+	double min_lng = -180;
+	double max_lng = 180;
+
+	bool is_active() const;
+	bool accepts_region(IcaoRegionKey region) const;
+	bool accepts_position(double lat, double lng) const;
+};
 
-class XPlaneParser {
+struct QueryCacheStats {
+	LruCacheStats airports;
+	LruCacheStats procedures;
+	LruCacheStats airport_procedures;
+	LruCacheStats procedure_paths;
+	LruCacheStats procedure_path_segments;
+};
+
+const std::size_t DEFAULT_PROCEDURE_PATH_CACHE_CAPACITY = 256;
+
+class XPlaneParser : public NavDataSink {
+	friend class XPlaneIncrementalLoader;
+	friend class XPlaneAsyncLoader;
 private:
 	std::list<NavPoint> _nav_points;
 	std::list<Airport> _airports;
-	std::list<RNAVProc> _rnav_procs;
+	// procedures of the parsed CIFP files grouped by airport, in file order
+	std::unordered_map<IcaoIdKey, std::vector<std::shared_ptr<RNAVProc>>> _rnav_procs;
 	std::string xplane_root_folder;
-	std::list<std::string> _airport_files_parsed;
-	std::filesystem::path absolute_path(std::string root_folder, std::string nav_folder, std::string file_name);
-	void trim_line(std::string& line);
-	void parse_proc_line(std::cmatch& m, std::string airport_iaco_id);
-	void parse_approach_proc_line(std::cmatch& m, std::string airport_iaco_id);
-	bool parse_airport_file(std::string airport_icao_code);
-	Airport* get_airport_ptr(std::string airport_icao_code);
-	std::string normalize_rwy_name(std::string name);
+	std::string cifp_root_folder;
+	std::unordered_map<std::string, CifpFileStamp> _airport_files_parsed;
+	// airports without a CIFP file: not looked for again until the next reload_changed_cifp_files()
+	std::unordered_set<std::string> _missing_cifp_files;
+	// airports whose procedures came from a NavDataSource instead of a CIFP file
+	std::unordered_set<std::string> _streamed_proc_airports;
+	// lookup indexes by packed icao id. the lists above never move their elements
+	std::unordered_map<IcaoIdKey, std::vector<NavPoint*>> _nav_point_index;
+	// _nav_points and _nav_point_index: add_nav_point writes them (e.g. from a loader thread), the lookups read them
+	std::shared_mutex nav_point_guard;
+	std::unordered_map<IcaoIdKey, std::vector<Airport*>> _airport_index;
+	/* The CIFP loads do not change the airports of _airports: they may be held by readers.
+	   The runways of a CIFP file go into a copy of the airport, which the lookups return
+	   from then on. A reload replaces the copy: the superseded one is freed when its last
+	   handle (e.g. in a runway index snapshot) is gone. */
+	std::unordered_map<std::string, AirportHandle> _cifp_airports;
+	void publish_cifp_runways(const std::string& airport_icao_code, const std::vector<RunwayRecord>& runways);
+	// the CIFP version of the airport if there is one
+	const Airport* published_airport(const Airport* airport);
+	void index_nav_point(NavPoint* nav_point);
+	void index_airport(Airport* airport);
+	// copied and extended by the next update after new nav points, the snapshots already handed out are not changed
+	std::shared_ptr<const NavPointTable> _nav_point_table;
+	// rebuilt on the next get_runway_index() call after a change by a global load, the snapshots
+	// already handed out are not changed. a CIFP load only updates the next snapshot for its airport
+	std::shared_ptr<const RunwayIndex> _runway_index;
+	bool _runway_index_dirty = true;
+	std::vector<std::string> _runway_index_changed_airports;
+	// the airports by 1 degree cell, with their position at the time of the build: the distance
+	// queries scan the cells around the center without the query lock
+	struct AirportGridEntry {
+		const Airport* airport;
+		Coordinate coordinate;
+	};
+	typedef std::unordered_map<uint32_t, std::vector<AirportGridEntry>> AirportGrid;
+	// rebuilt by the next distance query after an airport is added or moved
+	std::shared_ptr<const AirportGrid> _airport_grid;
+	bool _airport_grid_dirty = true;
+	std::shared_ptr<const AirportGrid> get_airport_grid();
+	// names, cities, countries and procedure ids of the parsed entities are stored here
+	std::shared_ptr<StringPool> string_pool;
+	// the entities handed out with shared ownership (procedures, their fixes, CIFP airport versions) keep the pool alive
+	template<class T, class... Args> std::shared_ptr<T> make_shared_with_pool(Args&&... args)
+	{
+		std::shared_ptr<StringPool> pool = string_pool;
+		return std::shared_ptr<T>(new T(std::forward<Args>(args)...), [pool](T* entity) { delete entity; });
+	}
+	// optional result caches of the airport/procedure queries (disabled by default)
+	LruCache<std::string, const Airport*> _airport_cache;
+	LruCache<std::string, RNAVProcHandle> _procedure_cache;
+	LruCache<std::string, std::vector<RNAVProcHandle>> _airport_procs_cache;
+	// path geometry of the procedures, enabled by default. dropped with the procedures of a reloaded airport
+	LruCache<std::string, std::shared_ptr<const ProcedurePath>> _procedure_path_cache;
+	ProcedurePathBuilder _procedure_path_builder;
+	// the airway segments are collected here, the graph is built on the next get_airway_graph() call
+	AirwayGraphBuilder _airway_builder;
+	AirwayGraph _airway_graph;
+	bool _airway_graph_dirty = false;
+	std::size_t _unresolved_airway_segments = 0;
+	const NavPoint* find_airway_fix(const std::string& region, const std::string& icao_id, AirwayFixKind kind);
+	void invalidate_query_cache(const std::string& airport_icao_code);
+	void clear_query_cache();
+	// the airport/procedure queries load CIFP files on demand and update the caches:
+	// they are serialized by this lock so a loaded parser can be shared between threads
+	std::recursive_mutex query_guard;
+	static std::filesystem::path absolute_path(std::string root_folder, std::string nav_folder, std::string file_name);
+	static std::filesystem::path custom_or_default_data_path(const std::string& root_folder, const std::string& file_name);
+	NavDataLoadFilter load_filter;
+	FixResolver fix_resolver;
+	// the shared copies of the procedure fixes by nav point. the CIFP files are parsed also without query_guard
+	std::unordered_map<const NavPoint*, std::shared_ptr<const NavPoint>> _procedure_fixes;
+	std::mutex procedure_fixes_guard;
+	void append_procedure_leg(const ProcedureLegRecord& leg, std::vector<std::shared_ptr<RNAVProc>>& procs);
+	bool parse_airport_file(const std::string& airport_icao_code);
+	std::filesystem::path cifp_file_path(const std::string& airport_icao_code);
+	bool read_cifp_file(const std::string& airport_icao_code, std::string& content, CifpFileStamp& stamp);
+	void parse_cifp_content(const std::string& content, const std::string& airport_icao_code, std::vector<std::shared_ptr<RNAVProc>>& procs, std::vector<RunwayRecord>& runways);
+	void publish_airport_procs(const std::string& airport_icao_code, std::vector<std::shared_ptr<RNAVProc>>& procs, const std::vector<RunwayRecord>& runways, const CifpFileStamp& stamp);
+	std::thread cifp_watcher;
+	std::mutex cifp_watcher_guard;
+	std::condition_variable cifp_watcher_wakeup;
+	bool cifp_watcher_stop = false;
+	Airport* get_airport_ptr(const std::string& airport_icao_code);
 public:
 	XPlaneParser(std::string _xplane_root_folder);
+	~XPlaneParser();
+	/* The navdata files are read from "Custom Data" (navdata update) if they are there,
+	   otherwise from "Resources/default data" (shipped with X-Plane). Also for the CIFP files. */
+	std::filesystem::path get_dat_file_path(GlobalDatFile file);
+	static std::filesystem::path get_dat_file_path(const std::string& xplane_root_folder, GlobalDatFile file);
+	static std::filesystem::path get_cifp_folder_path(const std::string& xplane_root_folder);
+	// folder of "Custom Data/CIFP" if it is not the X-Plane root folder
+	void set_cifp_root_folder(std::string _cifp_root_folder);
+	// the procedure fixes which are not among the own nav points are looked up with the resolver.
+	// set it before the parser is shared between threads
+	void set_fix_resolver(FixResolver resolver);
+	// applies to the global dat files parsed after this call
+	void set_load_filter(const NavDataLoadFilter& filter);
+	const NavDataLoadFilter& get_load_filter() const;
+	// the global dat files shall be parsed before the parser is shared between threads
 	bool parse_earth_fix_dat_file();
 	bool parse_earth_nav_dat_file();
 	bool parse_apt_dat_file();
+	// after earth_fix.dat and earth_nav.dat: the airway fixes are looked up among the parsed nav points
+	bool parse_earth_awy_dat_file();
+	// stream the records of any navdata source (e.g. Arinc424NavDataSource) into the parser
+	bool load_nav_data_source(NavDataSource& source);
+	// NavDataSink: the records are merged with the already known entities
+	void add_nav_point(const NavPointRecord& record) override;
+	void add_airport(const AirportRecord& record) override;
+	void add_runway(const RunwayRecord& record) override;
+	void add_procedure_leg(const ProcedureLegRecord& record) override;
+	void add_airway_segment(const AirwaySegmentRecord& record) override;
 	std::list<std::string> get_list_of_airport_iaco_codes();
-	std::list<NavPoint> get_nav_points_by_icao_id(std::string icao_id);
-	std::list<NavPoint> get_nav_points_by_icao_id(std::string region, std::string icao_id);
-	bool get_airport_by_icao_id(std::string icao_id, Airport& _airport);
-	bool get_procedure_by_id(std::string proc_name, std::string airport_icao, RNAVProc& proc);
-	std::list<RNAVProc> get_rnav_procs_by_airport_icao_id(std::string icao_id);
-	std::list<NavPoint>& get_nav_points();
+	std::list<NavPoint> get_nav_points_by_icao_id(const std::string& icao_id);
+	std::list<NavPoint> get_nav_points_by_icao_id(const std::string& region, const std::string& icao_id);
+	bool get_airport_by_icao_id(const std::string& icao_id, Airport& _airport);
+	bool get_procedure_by_id(const std::string& proc_name, const std::string& airport_icao, RNAVProc& proc);
+	std::list<RNAVProc> get_rnav_procs_by_airport_icao_id(const std::string& icao_id);
+
+	/* Lookups without copy. NavPoint and Airport pointers point into the parser and stay
+	   valid (also across the lazy CIFP loads) until the parser is destroyed. A returned
+	   airport is never changed: once its CIFP file is loaded (e.g. by a prefetch), the
+	   lookups return a new version of it with the CIFP runways. That version is valid until
+	   the CIFP file of the airport is reloaded or removed; hold find_airport_handle_by_icao_id()
+	   to keep it across the reloads. A procedure
+	   handle keeps its procedure alive and unchanged, even if the parser drops it later;
+	   its strings live in the string pool of the parser, which the handle keeps alive as well.
+	   The copying get_* lookups above return entities with own copies of their strings. */
+	std::vector<const NavPoint*> find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id);
+	const Airport* find_airport_by_icao_id(const std::string& icao_id);
+	// the handle owns the CIFP version of the airport and shares parser_owner (e.g. the shared_ptr of the parser), if given
+	AirportHandle find_airport_handle_by_icao_id(const std::string& icao_id, const std::shared_ptr<const void>& parser_owner = nullptr);
+	RNAVProcHandle find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao);
+	std::vector<RNAVProcHandle> find_rnav_procs_by_airport_icao_id(const std::string& icao_id);
+	std::vector<const Airport*> find_airports_within_distance(const Coordinate& center, double radius_km);
+	// densified great circle polyline of a procedure (see ProcedurePathBuilder), memoized. nullptr if the procedure is unknown
+	std::shared_ptr<const ProcedurePath> get_procedure_path(const std::string& proc_name, const std::string& airport_icao);
+	// number of memoized procedure paths, 0 disables the memoization
+	void set_procedure_path_cache_capacity(std::size_t capacity);
+
+	// load the CIFP file of an airport ahead of the first query. the file is parsed without holding the query lock
+	bool prefetch_airport_file(const std::string& airport_icao_code);
+	bool is_airport_file_parsed(const std::string& airport_icao_code);
+
+	/* Compare the size, modification time and content hash of the already parsed CIFP files
+	   with the files on the disk and parse again the changed ones. The procedures of a changed
+	   airport are replaced at once; handles of the old procedures stay valid. The airports
+	   whose CIFP file was missing are looked for again on their next query.
+	   Returns the ICAO codes of the reloaded airports. */
+	std::list<std::string> reload_changed_cifp_files();
+	// run reload_changed_cifp_files periodically on a background thread
+	void start_cifp_watcher(std::chrono::milliseconds poll_interval);
+	void stop_cifp_watcher();
+
+	// capacity is the number of entries per query type, 0 disables the cache
+	void enable_query_cache(std::size_t capacity);
+	QueryCacheStats get_query_cache_stats();
+	// read only: the nav points are added through add_nav_point, which keeps the lookup index.
+	// not for the time of a load (see XPlaneIncrementalLoader): the list grows meanwhile
+	const std::list<NavPoint>& get_nav_points();
+	// the interned strings of the returned entities are valid as long as the pool is alive
+	std::shared_ptr<StringPool> get_string_pool();
+	// publishes a new table with the nav points parsed since the last call appended
+	void update_nav_point_table();
+	// an immutable snapshot: it stays valid and unchanged while the caller holds it
+	std::shared_ptr<const NavPointTable> get_nav_point_table();
+	// the airway network of the parsed airway segments
+	const AirwayGraph& get_airway_graph();
+	// airway segments dropped because a fix of them is not known (e.g. outside of the load filter)
+	std::size_t get_unresolved_airway_segment_count();
+	// spatial index over the runway thresholds of all known airports (also of the parsed CIFP files)
+	// an immutable snapshot: it stays valid and unchanged while the caller holds it
+	std::shared_ptr<const RunwayIndex> get_runway_index();
 };
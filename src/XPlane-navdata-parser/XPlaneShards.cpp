@@ -0,0 +1,656 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "XPlaneShards.h"
+#include "../Logger.h"
+
+const std::size_t TILE_BUFFER_FLUSH_SIZE = 1 << 20;
+const std::string TILE_FILE_HEADER = "I\n1100 Version - split into tiles by NavMe-lib\n\n";
+
+typedef enum {
+	TILE_FIX_FILE,
+	TILE_NAV_FILE,
+	TILE_APT_FILE
+} TileFileKind;
+
+static std::filesystem::path tile_file_path(const std::filesystem::path& tile_folder, TileFileKind kind)
+{
+	switch (kind)
+	{
+	case TILE_FIX_FILE:
+		return tile_folder / "Custom Data" / "earth_fix.dat";
+	case TILE_NAV_FILE:
+		return tile_folder / "Custom Data" / "earth_nav.dat";
+	default:
+		return tile_folder / "Global Scenery" / "Global Airports" / "Earth nav data" / "apt.dat";
+	}
+}
+
+/* Collects the lines of the tile files and appends them to the files in large blocks:
+   there are too many tiles to keep all of their files open. */
+struct TileFileWriter {
+	std::filesystem::path tiles_root_folder;
+	int tile_size_deg = 10;
+	std::map<std::pair<int, TileFileKind>, std::string> buffers;
+	std::set<std::pair<int, TileFileKind>> created_files;
+	std::set<int> tile_indexes;
+	bool failed = false;
+
+	std::filesystem::path tile_folder(int tile_index)
+	{
+		return tiles_root_folder / XPlaneShardedNavData::tile_name(tile_index, tile_size_deg);
+	}
+
+	void add_line(int tile_index, TileFileKind kind, const std::string& line)
+	{
+		std::string& buffer = buffers[std::make_pair(tile_index, kind)];
+		buffer += line;
+		buffer += '\n';
+		if (buffer.size() >= TILE_BUFFER_FLUSH_SIZE)
+			flush(tile_index, kind, buffer);
+	}
+
+	void flush(int tile_index, TileFileKind kind, std::string& buffer)
+	{
+		auto file_key = std::make_pair(tile_index, kind);
+		std::filesystem::path file_path = tile_file_path(tile_folder(tile_index), kind);
+		bool first_write = created_files.insert(file_key).second;
+		if (first_write)
+		{
+			std::error_code error;
+			std::filesystem::create_directories(file_path.parent_path(), error);
+		}
+
+		std::ofstream o_str(file_path, first_write ? std::ios::trunc : std::ios::app);
+		if (!o_str.is_open())
+		{
+			Logger(TLogLevel::logERROR) << "XPlaneTileBuilder: can't open file for write: " << file_path << std::endl;
+			failed = true;
+			return;
+		}
+
+		if (first_write)
+			o_str << TILE_FILE_HEADER;
+		o_str << buffer;
+		buffer.clear();
+		tile_indexes.insert(tile_index);
+	}
+
+	void flush_all()
+	{
+		for (auto& buffer : buffers)
+			flush(buffer.first.first, buffer.first.second, buffer.second);
+
+		// every tile has all of the three files, so a tile can be parsed like an X-Plane root
+		for (int tile_index : tile_indexes)
+		{
+			for (TileFileKind kind : { TILE_FIX_FILE, TILE_NAV_FILE, TILE_APT_FILE })
+			{
+				std::string empty_buffer;
+				if (created_files.count(std::make_pair(tile_index, kind)) == 0)
+					flush(tile_index, kind, empty_buffer);
+			}
+		}
+	}
+};
+
+// the tile of the coordinate as XPlaneParser stores it: the tile queries compare with that
+static int nav_point_tile_index(double lat, double lng, int tile_size_deg)
+{
+	return XPlaneShardedNavData::tile_index_of(Angle(lat).convert_to_double(), Angle(lng).convert_to_double(), tile_size_deg);
+}
+
+// the tiles within margin_deg of the position, the home tile first
+static std::vector<int> nav_point_tile_indexes(double lat, double lng, int tile_size_deg, int margin_deg)
+{
+	std::vector<int> tile_indexes = { nav_point_tile_index(lat, lng, tile_size_deg) };
+	int rows = (180 + tile_size_deg - 1) / tile_size_deg;
+	int columns = (360 + tile_size_deg - 1) / tile_size_deg;
+	int first_row = std::clamp((int)std::floor((lat - margin_deg + 90) / tile_size_deg), 0, rows - 1);
+	int last_row = std::clamp((int)std::floor((lat + margin_deg + 90) / tile_size_deg), 0, rows - 1);
+	int first_column = (int)std::floor((lng - margin_deg + 180) / tile_size_deg);
+	int last_column = (int)std::floor((lng + margin_deg + 180) / tile_size_deg);
+	for (int row = first_row; row <= last_row; row++)
+	{
+		for (int column = first_column; column <= last_column; column++)
+		{
+			int wrapped_column = ((column % columns) + columns) % columns;
+			int tile_index = row * columns + wrapped_column;
+			if (std::find(tile_indexes.begin(), tile_indexes.end(), tile_index) == tile_indexes.end())
+				tile_indexes.push_back(tile_index);
+		}
+	}
+	return tile_indexes;
+}
+
+XPlaneTileBuilder::XPlaneTileBuilder(std::string _xplane_root_folder, std::string _tiles_root_folder, int _tile_size_deg, int _margin_deg) :
+	xplane_root_folder(std::move(_xplane_root_folder)), tiles_root_folder(std::move(_tiles_root_folder)), tile_size_deg(_tile_size_deg),
+	margin_deg(_margin_deg)
+{
+
+}
+
+bool XPlaneTileBuilder::build()
+{
+	if (tile_size_deg < 1 || tile_size_deg > 90)
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneTileBuilder: invalid tile size: " << tile_size_deg << std::endl;
+		return false;
+	}
+	if (margin_deg < 0 || margin_deg > tile_size_deg)
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneTileBuilder: invalid margin: " << margin_deg << std::endl;
+		return false;
+	}
+
+	XPlaneParser source(xplane_root_folder);
+	std::ifstream apt_str(source.get_dat_file_path(APT_DAT));
+	std::ifstream fix_str(source.get_dat_file_path(EARTH_FIX_DAT));
+	std::ifstream nav_str(source.get_dat_file_path(EARTH_NAV_DAT));
+	if (!apt_str.is_open() || !fix_str.is_open() || !nav_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneTileBuilder: can't open the global dat files in " << xplane_root_folder << std::endl;
+		return false;
+	}
+
+	TileFileWriter writer;
+	writer.tiles_root_folder = tiles_root_folder;
+	writer.tile_size_deg = tile_size_deg;
+	std::vector<TileDirectoryEntry> directory;
+	std::unordered_map<std::string, int> airport_tiles; // for the ILS records
+
+	// apt.dat: an airport is the block of lines from its "1" row to the next one
+	std::vector<std::string> airport_lines;
+	auto write_airport = [&]() {
+		if (airport_lines.empty())
+			return;
+
+		double lat = 0;
+		double lng = 0;
+		bool lat_found = false;
+		bool lng_found = false;
+		for (const std::string& line : airport_lines)
+		{
+			if (line.substr(0, 14) == "1302 datum_lat")
+			{
+				lat = std::stod(line.substr(15));
+				lat_found = true;
+			}
+			else if (line.substr(0, 14) == "1302 datum_lon")
+			{
+				lng = std::stod(line.substr(15));
+				lng_found = true;
+			}
+			else if (line.substr(0, 4) == "100 " && !(lat_found && lng_found))
+			{
+				// no datum: the first runway end is close enough
+				std::istringstream tokens(line);
+				std::string token;
+				for (int i = 0; i <= 10 && tokens >> token; i++)
+				{
+					if (i == 9)
+						lat = std::stod(token);
+					if (i == 10)
+						lng = std::stod(token);
+				}
+				lat_found = lng_found = true;
+				break;
+			}
+		}
+
+		std::string icao = airport_lines.front().substr(13, 4);
+		if (lat_found && lng_found)
+		{
+			int tile_index = XPlaneShardedNavData::tile_index_of(lat, lng, tile_size_deg);
+			airport_tiles[icao] = tile_index;
+			directory.push_back({ IcaoIdKey(icao), (uint16_t)tile_index, TileDirectoryEntry::AIRPORT });
+			for (const std::string& line : airport_lines)
+				writer.add_line(tile_index, TILE_APT_FILE, line);
+		}
+		else
+		{
+			Logger(TLogLevel::logWARNING) << "XPlaneTileBuilder: airport without position is skipped: " << icao << std::endl;
+		}
+		airport_lines.clear();
+	};
+
+	std::string line;
+	while (std::getline(apt_str, line))
+	{
+		if (line.substr(0, 4) == "1   ")
+			write_airport();
+
+		// the lines before the first airport are the file header
+		if (line.substr(0, 4) == "1   " || !airport_lines.empty())
+			airport_lines.push_back(line);
+	}
+	write_airport();
+
+	// the column positions are the same as in XPlaneParser
+	int line_count = 0;
+	while (std::getline(fix_str, line))
+	{
+		if (++line_count <= 3 || line.length() < 50)
+			continue;
+
+		std::vector<int> tile_indexes = nav_point_tile_indexes(std::stod(line.substr(0, 13)), std::stod(line.substr(14, 13)), tile_size_deg, margin_deg);
+		directory.push_back({ IcaoIdKey(line.substr(30, 5)), (uint16_t)tile_indexes.front(), TileDirectoryEntry::NAV_POINT });
+		for (int tile_index : tile_indexes)
+			writer.add_line(tile_index, TILE_FIX_FILE, line);
+	}
+
+	line_count = 0;
+	std::vector<int> vor_tile_indexes; // the DME row of a VOR-DME has to follow its VOR in every tile
+	while (std::getline(nav_str, line))
+	{
+		if (++line_count <= 3 || line.length() <= 80)
+			continue;
+
+		int type = std::stoi(line.substr(0, 2));
+		double lat = std::stod(line.substr(3, 13));
+		double lng = std::stod(line.substr(17, 13));
+		std::vector<int> tile_indexes;
+		if (type == 2 || type == 3 || type == 13)
+		{
+			tile_indexes = nav_point_tile_indexes(lat, lng, tile_size_deg, margin_deg);
+			std::string id = line.substr(67, 4);
+			id = id.substr(id.find_first_not_of(' ', 0));
+			directory.push_back({ IcaoIdKey(id), (uint16_t)tile_indexes.front(), TileDirectoryEntry::NAV_POINT });
+		}
+		else if (type == 12 && !vor_tile_indexes.empty())
+		{
+			tile_indexes = vor_tile_indexes;
+		}
+		else
+		{
+			tile_indexes = { XPlaneShardedNavData::tile_index_of(lat, lng, tile_size_deg) };
+			if (type == 4)
+			{
+				auto airport_it = airport_tiles.find(line.substr(72, 4));
+				if (airport_it != airport_tiles.end())
+					tile_indexes = { airport_it->second };
+			}
+		}
+
+		if (type == 3)
+			vor_tile_indexes = tile_indexes;
+		else
+			vor_tile_indexes.clear();
+		for (int tile_index : tile_indexes)
+			writer.add_line(tile_index, TILE_NAV_FILE, line);
+	}
+
+	writer.flush_all();
+	if (writer.failed)
+		return false;
+
+	std::sort(directory.begin(), directory.end(), [](const TileDirectoryEntry& a, const TileDirectoryEntry& b) {
+		if (a.id_key != b.id_key)
+			return a.id_key < b.id_key;
+		if (a.kind != b.kind)
+			return a.kind < b.kind;
+		return a.tile_index < b.tile_index;
+	});
+	directory.erase(std::unique(directory.begin(), directory.end(), [](const TileDirectoryEntry& a, const TileDirectoryEntry& b) {
+		return a.id_key == b.id_key && a.kind == b.kind && a.tile_index == b.tile_index;
+	}), directory.end());
+
+	std::filesystem::path directory_path = std::filesystem::path(tiles_root_folder) / TILE_DIRECTORY_FILE;
+	std::ofstream o_str(directory_path, std::ios::trunc);
+	if (!o_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneTileBuilder: can't open file for write: " << directory_path << std::endl;
+		return false;
+	}
+
+	//TILESIZE 10
+	//T 1234 56789         tile index, size of the tile files
+	//N 4250373031000000 1234  nav point id key (hex), tile index
+	//A 4c48425000000000 1234  airport id key (hex), tile index
+	o_str << "TILESIZE " << tile_size_deg << "\n";
+	for (int tile_index : writer.tile_indexes)
+	{
+		std::uintmax_t bytes = 0;
+		for (TileFileKind kind : { TILE_FIX_FILE, TILE_NAV_FILE, TILE_APT_FILE })
+		{
+			std::error_code error;
+			std::uintmax_t size = std::filesystem::file_size(tile_file_path(writer.tile_folder(tile_index), kind), error);
+			if (!error)
+				bytes += size;
+		}
+		o_str << "T " << tile_index << " " << bytes << "\n";
+	}
+
+	for (auto& entry : directory)
+		o_str << (entry.kind == TileDirectoryEntry::AIRPORT ? "A " : "N ") << std::hex << entry.id_key.value << std::dec << " " << entry.tile_index << "\n";
+
+	Logger(TLogLevel::logINFO) << "XPlaneTileBuilder: " << writer.tile_indexes.size() << " tiles written to " << tiles_root_folder << std::endl;
+	return true;
+}
+
+XPlaneShardedNavData::XPlaneShardedNavData(std::string _tiles_root_folder, std::string _xplane_root_folder) :
+	tiles_root_folder(std::move(_tiles_root_folder)), xplane_root_folder(std::move(_xplane_root_folder)), tile_size_deg(10),
+	tile_columns(36), memory_cap(UINTMAX_MAX), loaded_bytes(0)
+{
+
+}
+
+std::string XPlaneShardedNavData::tile_name(int tile_index, int tile_size_deg)
+{
+	int columns = (360 + tile_size_deg - 1) / tile_size_deg;
+	int south = (tile_index / columns) * tile_size_deg - 90;
+	int west = (tile_index % columns) * tile_size_deg - 180;
+
+	// large enough for any int pair, not only for the valid corners
+	char name[32];
+	snprintf(name, sizeof(name), "%+03d%+04d", south, west);
+	return std::string(name);
+}
+
+int XPlaneShardedNavData::tile_index_of(double lat, double lng, int tile_size_deg)
+{
+	int rows = (180 + tile_size_deg - 1) / tile_size_deg;
+	int columns = (360 + tile_size_deg - 1) / tile_size_deg;
+	int row = std::clamp((int)std::floor((lat + 90) / tile_size_deg), 0, rows - 1);
+	int column = std::clamp((int)std::floor((lng + 180) / tile_size_deg), 0, columns - 1);
+	return row * columns + column;
+}
+
+bool XPlaneShardedNavData::open()
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::filesystem::path directory_path = std::filesystem::path(tiles_root_folder) / TILE_DIRECTORY_FILE;
+	std::ifstream i_str(directory_path);
+	if (!i_str.is_open())
+	{
+		Logger(TLogLevel::logERROR) << "XPlaneShardedNavData: can't open file for read: " << directory_path << std::endl;
+		return false;
+	}
+
+	tiles.clear();
+	lru_tiles.clear();
+	dropped_tiles.clear();
+	directory.clear();
+	loaded_bytes = 0;
+
+	std::string line;
+	while (std::getline(i_str, line))
+	{
+		std::istringstream fields(line);
+		std::string kind;
+		fields >> kind;
+		if (kind == "TILESIZE")
+		{
+			fields >> tile_size_deg;
+			tile_columns = (360 + tile_size_deg - 1) / tile_size_deg;
+		}
+		else if (kind == "T")
+		{
+			int tile_index = 0;
+			std::uintmax_t bytes = 0;
+			fields >> tile_index >> bytes;
+			tiles[(uint16_t)tile_index].file_bytes = bytes;
+		}
+		else if (kind == "N" || kind == "A")
+		{
+			TileDirectoryEntry entry;
+			int tile_index = 0;
+			fields >> std::hex >> entry.id_key.value >> std::dec >> tile_index;
+			entry.tile_index = (uint16_t)tile_index;
+			entry.kind = (kind == "A" ? TileDirectoryEntry::AIRPORT : TileDirectoryEntry::NAV_POINT);
+			directory.push_back(entry);
+		}
+	}
+
+	// the builder writes the directory sorted
+	return true;
+}
+
+void XPlaneShardedNavData::set_memory_cap(std::uintmax_t bytes)
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	memory_cap = bytes;
+	evict_tiles({});
+}
+
+std::shared_ptr<XPlaneParser> XPlaneShardedNavData::load_tile(uint16_t tile_index)
+{
+	auto tile_it = tiles.find(tile_index);
+	if (tile_it == tiles.end())
+		return nullptr;
+
+	Tile& tile = tile_it->second;
+	if (tile.parser)
+	{
+		lru_tiles.splice(lru_tiles.begin(), lru_tiles, tile.lru_position);
+		return tile.parser;
+	}
+
+	// a dropped tile which is still kept alive by handles is reused: no second copy in memory
+	std::shared_ptr<XPlaneParser> parser = tile.dropped_parser.lock();
+	tile.dropped_parser.reset();
+	if (!parser)
+	{
+		std::string tile_folder = (std::filesystem::path(tiles_root_folder) / tile_name(tile_index, tile_size_deg)).string();
+		Logger(TLogLevel::logTRACE) << "XPlaneShardedNavData: load tile " << tile_folder << std::endl;
+
+		parser = std::make_shared<XPlaneParser>(tile_folder);
+		parser->set_cifp_root_folder(xplane_root_folder);
+		if (!parser->parse_earth_fix_dat_file() || !parser->parse_earth_nav_dat_file() || !parser->parse_apt_dat_file())
+			Logger(TLogLevel::logERROR) << "XPlaneShardedNavData: tile is incomplete: " << tile_folder << std::endl;
+		parser->update_nav_point_table();
+	}
+
+	tile.parser = parser;
+	lru_tiles.push_front(tile_index);
+	tile.lru_position = lru_tiles.begin();
+	loaded_bytes += tile.file_bytes;
+	return parser;
+}
+
+void XPlaneShardedNavData::evict_tiles(const std::vector<uint16_t>& pinned_tiles)
+{
+	auto it = lru_tiles.end();
+	while (loaded_bytes > memory_cap && it != lru_tiles.begin())
+	{
+		it--;
+		if (std::find(pinned_tiles.begin(), pinned_tiles.end(), *it) != pinned_tiles.end())
+			continue;
+
+		Tile& tile = tiles[*it];
+		tile.dropped_parser = tile.parser;
+		tile.parser.reset();
+		if (std::find(dropped_tiles.begin(), dropped_tiles.end(), *it) == dropped_tiles.end())
+			dropped_tiles.push_back(*it);
+		loaded_bytes -= tile.file_bytes;
+		it = lru_tiles.erase(it);
+	}
+}
+
+std::vector<uint16_t> XPlaneShardedNavData::tiles_in_area(const Coordinate& center, double radius_km) const
+{
+	const double KM_PER_DEG = 111.2;
+	double lat = center.lat.convert_to_double();
+	double lng = center.lng.convert_to_double();
+	double delta_lat = radius_km / KM_PER_DEG;
+	double delta_lng = delta_lat / std::max(std::cos(center.lat.convert_to_radian()), 0.01);
+
+	int rows = (180 + tile_size_deg - 1) / tile_size_deg;
+	int first_row = std::clamp((int)std::floor((lat - delta_lat + 90) / tile_size_deg), 0, rows - 1);
+	int last_row = std::clamp((int)std::floor((lat + delta_lat + 90) / tile_size_deg), 0, rows - 1);
+	int first_column = (int)std::floor((lng - delta_lng + 180) / tile_size_deg);
+	int last_column = (int)std::floor((lng + delta_lng + 180) / tile_size_deg);
+	if (last_column - first_column + 1 >= tile_columns)
+	{
+		first_column = 0;
+		last_column = tile_columns - 1;
+	}
+
+	std::vector<uint16_t> tile_indexes;
+	for (int row = first_row; row <= last_row; row++)
+	{
+		for (int column = first_column; column <= last_column; column++)
+		{
+			// the area can cross the antimeridian
+			int wrapped_column = ((column % tile_columns) + tile_columns) % tile_columns;
+			uint16_t tile_index = (uint16_t)(row * tile_columns + wrapped_column);
+			if (tiles.count(tile_index) > 0)
+				tile_indexes.push_back(tile_index);
+		}
+	}
+	return tile_indexes;
+}
+
+std::vector<uint16_t> XPlaneShardedNavData::directory_tiles(IcaoIdKey id_key, uint8_t kind) const
+{
+	TileDirectoryEntry first_entry;
+	first_entry.id_key = id_key;
+	first_entry.kind = kind;
+	auto it = std::lower_bound(directory.begin(), directory.end(), first_entry, [](const TileDirectoryEntry& a, const TileDirectoryEntry& b) {
+		if (a.id_key != b.id_key)
+			return a.id_key < b.id_key;
+		return a.kind < b.kind;
+	});
+
+	std::vector<uint16_t> tile_indexes;
+	for (; it != directory.end() && it->id_key == id_key && it->kind == kind; it++)
+		tile_indexes.push_back(it->tile_index);
+	return tile_indexes;
+}
+
+bool XPlaneShardedNavData::is_home_tile(const NavPoint* nav_point, uint16_t tile_index) const
+{
+	// the other tiles have a copy of the point in their margin
+	const Coordinate& coordinate = nav_point->get_coordinate();
+	return tile_index_of(coordinate.lat.convert_to_double(), coordinate.lng.convert_to_double(), tile_size_deg) == tile_index;
+}
+
+void XPlaneShardedNavData::set_position(const Coordinate& position, double radius_km)
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::vector<uint16_t> tile_indexes = tiles_in_area(position, radius_km);
+	for (uint16_t tile_index : tile_indexes)
+		load_tile(tile_index);
+	evict_tiles(tile_indexes);
+}
+
+std::vector<NavPointHandle> XPlaneShardedNavData::find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id)
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::vector<NavPointHandle> nav_points;
+	std::vector<uint16_t> tile_indexes = directory_tiles(IcaoIdKey(icao_id), TileDirectoryEntry::NAV_POINT);
+	for (uint16_t tile_index : tile_indexes)
+	{
+		std::shared_ptr<XPlaneParser> parser = load_tile(tile_index);
+		if (!parser)
+			continue;
+
+		// the handle shares the ownership of the tile
+		for (const NavPoint* nav_point : parser->find_nav_points_by_icao_id(region, icao_id))
+		{
+			if (is_home_tile(nav_point, tile_index))
+				nav_points.push_back(NavPointHandle(parser, nav_point));
+		}
+	}
+	evict_tiles(tile_indexes);
+	return nav_points;
+}
+
+std::vector<NavPointHandle> XPlaneShardedNavData::find_nav_points_within_distance(const Coordinate& center, double radius_km)
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::vector<NavPointHandle> nav_points;
+	std::vector<uint16_t> tile_indexes = tiles_in_area(center, radius_km);
+	for (uint16_t tile_index : tile_indexes)
+	{
+		std::shared_ptr<XPlaneParser> parser = load_tile(tile_index);
+		if (!parser)
+			continue;
+
+		std::shared_ptr<const NavPointTable> table = parser->get_nav_point_table();
+		for (std::size_t row : table->find_within_distance(center, radius_km))
+		{
+			if (is_home_tile(table->get_nav_point(row), tile_index))
+				nav_points.push_back(NavPointHandle(parser, table->get_nav_point(row)));
+		}
+	}
+	evict_tiles(tile_indexes);
+	return nav_points;
+}
+
+AirportHandle XPlaneShardedNavData::find_airport_by_icao_id(const std::string& icao_id)
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::vector<uint16_t> tile_indexes = directory_tiles(IcaoIdKey(icao_id), TileDirectoryEntry::AIRPORT);
+	AirportHandle airport;
+	for (uint16_t tile_index : tile_indexes)
+	{
+		std::shared_ptr<XPlaneParser> parser = load_tile(tile_index);
+		airport = parser ? parser->find_airport_handle_by_icao_id(icao_id, parser) : nullptr;
+		if (airport)
+			break;
+	}
+	evict_tiles(tile_indexes);
+	return airport;
+}
+
+RNAVProcHandle XPlaneShardedNavData::find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao)
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::vector<uint16_t> tile_indexes = directory_tiles(IcaoIdKey(airport_icao), TileDirectoryEntry::AIRPORT);
+	RNAVProcHandle proc;
+	for (uint16_t tile_index : tile_indexes)
+	{
+		std::shared_ptr<XPlaneParser> parser = load_tile(tile_index);
+		RNAVProcHandle tile_proc = parser ? parser->find_procedure_by_id(proc_name, airport_icao) : nullptr;
+		if (tile_proc)
+		{
+			// the strings of the procedure are in the string pool of the tile: keep the tile with the procedure
+			auto owner = std::make_shared<std::pair<std::shared_ptr<XPlaneParser>, RNAVProcHandle>>(parser, tile_proc);
+			proc = RNAVProcHandle(owner, tile_proc.get());
+			break;
+		}
+	}
+	evict_tiles(tile_indexes);
+	return proc;
+}
+
+std::size_t XPlaneShardedNavData::get_loaded_tile_count()
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	return lru_tiles.size();
+}
+
+std::uintmax_t XPlaneShardedNavData::get_loaded_bytes()
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	return loaded_bytes;
+}
+
+std::uintmax_t XPlaneShardedNavData::get_retained_bytes()
+{
+	std::lock_guard<std::mutex> lock(tiles_guard);
+	std::uintmax_t bytes = 0;
+	auto it = dropped_tiles.begin();
+	while (it != dropped_tiles.end())
+	{
+		Tile& tile = tiles[*it];
+		if (tile.dropped_parser.expired())
+		{
+			it = dropped_tiles.erase(it);
+			continue;
+		}
+		bytes += tile.file_bytes;
+		it++;
+	}
+	return bytes;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2023 Norbert Takacs
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "XPlaneParser.h"
+#include "../Coordinate.h"
+#include "../IcaoKey.h"
+
+const std::string TILE_DIRECTORY_FILE = "tiles.dat";
+
+/* One time preprocessing step of the sharded mode: splits earth_fix.dat, earth_nav.dat
+   and apt.dat into tile_size_deg x tile_size_deg lat/lng tiles. Every tile is written
+   as a small X-Plane root folder (named by its south-west corner, e.g. "+40+010"), so a
+   tile is loaded by a normal XPlaneParser. Airports go to the tile of their datum, ILS
+   records to the tile of their airport. The tile list and the ID -> tile directory are
+   written into TILE_DIRECTORY_FILE. The CIFP files are not split.
+   The fixes and navaids within margin_deg of a tile are copied into the tile as well, so
+   the procedures of the tile resolve their fixes across the tile border. A copy is not
+   in the directory and the tile queries skip it: only its home tile returns the point. */
+class XPlaneTileBuilder {
+private:
+	std::string xplane_root_folder;
+	std::string tiles_root_folder;
+	int tile_size_deg;
+	int margin_deg;
+public:
+	XPlaneTileBuilder(std::string _xplane_root_folder, std::string _tiles_root_folder, int _tile_size_deg = 10, int _margin_deg = 1);
+	bool build();
+};
+
+// one ID of the directory. an ID (e.g. a fix name) can be in several tiles
+struct TileDirectoryEntry {
+	static const uint8_t NAV_POINT = 0;
+	static const uint8_t AIRPORT = 1;
+
+	IcaoIdKey id_key;
+	uint16_t tile_index = 0;
+	uint8_t kind = NAV_POINT;
+};
+
+/* Navdata split into tiles by XPlaneTileBuilder. The tiles are loaded on demand when a
+   query or the aircraft position touches them and the least recently used tiles are
+   dropped above the memory cap (estimated by the size of the tile files).
+   The returned handles keep their tile in memory, even if it is dropped meanwhile. Such a
+   tile is reused when it is needed again, and get_retained_bytes() counts it.
+   ID lookups find their tiles in a compact directory which is always in memory. */
+class XPlaneShardedNavData {
+private:
+	struct Tile {
+		std::shared_ptr<XPlaneParser> parser; // empty if the tile is not loaded
+		std::weak_ptr<XPlaneParser> dropped_parser; // a dropped tile, as long as handles keep it alive
+		std::uintmax_t file_bytes = 0;
+		std::list<uint16_t>::iterator lru_position;
+	};
+
+	std::string tiles_root_folder;
+	std::string xplane_root_folder; // for the CIFP files
+	int tile_size_deg;
+	int tile_columns;
+	std::vector<TileDirectoryEntry> directory; // sorted by id, then kind
+	std::unordered_map<uint16_t, Tile> tiles; // existing tiles
+	std::list<uint16_t> lru_tiles; // loaded tiles, most recently used first
+	std::vector<uint16_t> dropped_tiles; // dropped tiles, possibly kept alive by handles
+	std::uintmax_t memory_cap;
+	std::uintmax_t loaded_bytes;
+	std::mutex tiles_guard;
+	std::shared_ptr<XPlaneParser> load_tile(uint16_t tile_index);
+	void evict_tiles(const std::vector<uint16_t>& pinned_tiles);
+	std::vector<uint16_t> tiles_in_area(const Coordinate& center, double radius_km) const;
+	std::vector<uint16_t> directory_tiles(IcaoIdKey id_key, uint8_t kind) const;
+	bool is_home_tile(const NavPoint* nav_point, uint16_t tile_index) const;
+public:
+	XPlaneShardedNavData(std::string _tiles_root_folder, std::string _xplane_root_folder);
+	// read the tile directory
+	bool open();
+	void set_memory_cap(std::uintmax_t bytes);
+	// load the tiles around the aircraft
+	void set_position(const Coordinate& position, double radius_km);
+	std::vector<NavPointHandle> find_nav_points_by_icao_id(const std::string& region, const std::string& icao_id);
+	std::vector<NavPointHandle> find_nav_points_within_distance(const Coordinate& center, double radius_km);
+	AirportHandle find_airport_by_icao_id(const std::string& icao_id);
+	RNAVProcHandle find_procedure_by_id(const std::string& proc_name, const std::string& airport_icao);
+	std::size_t get_loaded_tile_count();
+	std::uintmax_t get_loaded_bytes();
+	// the dropped tiles which are still kept alive by handles
+	std::uintmax_t get_retained_bytes();
+	static std::string tile_name(int tile_index, int tile_size_deg);
+	static int tile_index_of(double lat, double lng, int tile_size_deg);
+};
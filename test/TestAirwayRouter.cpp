@@ -0,0 +1,353 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <random>
+#include <queue>
+#include <limits>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestAirwayRouter)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+		std::vector<NavPoint> fixes;
+		AirwayGraph graph;
+
+		const NavPoint* fix(const std::string& icao_id)
+		{
+			for (const NavPoint& nav_point : fixes)
+			{
+				if (nav_point.get_icao_id() == icao_id)
+					return &nav_point;
+			}
+			return NULL;
+		}
+
+		// plain Dijkstra over the whole graph, the reference of the faster searches
+		static double dijkstra_km(const AirwayGraph& graph, uint32_t from, uint32_t to, const AirwayRouteOptions& options)
+		{
+			std::vector<double> cost(graph.get_node_count(), std::numeric_limits<double>::infinity());
+			std::priority_queue<std::pair<double, uint32_t>, std::vector<std::pair<double, uint32_t>>, std::greater<std::pair<double, uint32_t>>> queue;
+			cost[from] = 0;
+			queue.push({ 0, from });
+			while (!queue.empty())
+			{
+				std::pair<double, uint32_t> entry = queue.top();
+				queue.pop();
+				if (entry.first > cost[entry.second])
+					continue;
+				if (entry.second == to)
+					return entry.first;
+				for (const AirwayEdge& edge : graph.get_edges(entry.second))
+				{
+					if (!AirwayRouter::edge_allowed(edge, options))
+						continue;
+					double km = entry.first + AirwayRouter::great_circle_km(graph.get_nav_point(entry.second)->get_coordinate(), graph.get_nav_point(edge.to)->get_coordinate());
+					if (km < cost[edge.to])
+					{
+						cost[edge.to] = km;
+						queue.push({ km, edge.to });
+					}
+				}
+			}
+			return -1;
+		}
+
+		// every leg of the route is an allowed edge on its airway, and the legs add up to the distance
+		static void check_route_legs(const AirwayGraph& graph, const AirwayRoute& route, const AirwayRouteOptions& options)
+		{
+			Assert::AreEqual(route.nodes.size(), route.airways.size() + 1);
+			double km = 0;
+			for (std::size_t i = 0; i + 1 < route.nodes.size(); i++)
+			{
+				bool found = false;
+				for (const AirwayEdge& edge : graph.get_edges(route.nodes[i]))
+					found = found || (edge.to == route.nodes[i + 1] && edge.airway == route.airways[i] && AirwayRouter::edge_allowed(edge, options));
+				Assert::IsTrue(found);
+				km += AirwayRouter::great_circle_km(graph.get_nav_point(route.nodes[i])->get_coordinate(), graph.get_nav_point(route.nodes[i + 1])->get_coordinate());
+			}
+			Assert::AreEqual(km, route.distance_km, 1e-6);
+		}
+
+		std::string route_ids(const AirwayRoute& route)
+		{
+			std::string ids;
+			for (uint32_t node : route.nodes)
+				ids += (ids.empty() ? "" : " ") + graph.get_nav_point(node)->get_icao_id();
+			return ids;
+		}
+	public:
+		TEST_METHOD_INITIALIZE(TestAirwayRouterInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+
+			// X1 high over BBBBB, Y1 low over DDDDD, Z1 one way from CCCCC to EEEEE
+			fixes.clear();
+			fixes.emplace_back(Coordinate(47, 17, 0), "AAAAA", "LH", Angle(0));
+			fixes.emplace_back(Coordinate(47.5, 18, 0), "BBBBB", "LH", Angle(0));
+			fixes.emplace_back(Coordinate(47, 19, 0), "CCCCC", "LH", Angle(0));
+			fixes.emplace_back(Coordinate(46, 18, 0), "DDDDD", "LH", Angle(0));
+			fixes.emplace_back(Coordinate(47, 20, 0), "EEEEE", "LH", Angle(0));
+
+			AirwayGraphBuilder builder;
+			builder.add_segment(fix("AAAAA"), fix("BBBBB"), "X1", AIRWAY_BOTH_WAYS, AIRWAY_HIGH, 245, 460);
+			builder.add_segment(fix("BBBBB"), fix("CCCCC"), "X1", AIRWAY_BOTH_WAYS, AIRWAY_HIGH, 245, 460);
+			builder.add_segment(fix("AAAAA"), fix("DDDDD"), "Y1", AIRWAY_BOTH_WAYS, AIRWAY_LOW, 50, 245);
+			builder.add_segment(fix("DDDDD"), fix("CCCCC"), "Y1", AIRWAY_BOTH_WAYS, AIRWAY_LOW, 50, 245);
+			builder.add_segment(fix("CCCCC"), fix("EEEEE"), "Z1", AIRWAY_FORWARD, AIRWAY_LOW, 50, 460);
+			builder.build(graph);
+		}
+
+		TEST_METHOD(TestShortestRoute)
+		{
+			AirwayRouter router(graph);
+			AirwayRoute route;
+			Assert::IsTrue(router.find_route(fix("AAAAA"), fix("EEEEE"), AirwayRouteOptions(), route));
+			Assert::AreEqual("AAAAA BBBBB CCCCC EEEEE", route_ids(route).c_str());
+			Assert::AreEqual(3, (int)route.airways.size());
+			Assert::AreEqual("X1", graph.get_airway_name(route.airways[0]).c_str());
+			Assert::AreEqual("Z1", graph.get_airway_name(route.airways[2]).c_str());
+
+			double distance = AirwayRouter::great_circle_km(fix("AAAAA")->get_coordinate(), fix("BBBBB")->get_coordinate()) +
+				AirwayRouter::great_circle_km(fix("BBBBB")->get_coordinate(), fix("CCCCC")->get_coordinate()) +
+				AirwayRouter::great_circle_km(fix("CCCCC")->get_coordinate(), fix("EEEEE")->get_coordinate());
+			Assert::AreEqual(distance, route.distance_km, 0.001);
+
+			std::vector<NavPoint> nav_points = router.get_nav_points(route);
+			Assert::AreEqual(4, (int)nav_points.size());
+			Assert::AreEqual("EEEEE", nav_points.back().get_icao_id().c_str());
+
+			// the same fix
+			Assert::IsTrue(router.find_route(fix("CCCCC"), fix("CCCCC"), AirwayRouteOptions(), route));
+			Assert::AreEqual(1, (int)route.nodes.size());
+			Assert::AreEqual(0.0, route.distance_km);
+		}
+
+		TEST_METHOD(TestRouteConstraints)
+		{
+			AirwayRouter router(graph);
+			AirwayRoute route;
+
+			// Z1 is one way
+			Assert::IsFalse(router.find_route(fix("EEEEE"), fix("AAAAA"), AirwayRouteOptions(), route));
+			Assert::IsTrue(route.nodes.empty());
+			Assert::IsTrue(router.find_route(fix("CCCCC"), fix("AAAAA"), AirwayRouteOptions(), route));
+			Assert::AreEqual("CCCCC BBBBB AAAAA", route_ids(route).c_str());
+
+			AirwayRouteOptions low_only;
+			low_only.use_high_airways = false;
+			Assert::IsTrue(router.find_route(fix("AAAAA"), fix("CCCCC"), low_only, route));
+			Assert::AreEqual("AAAAA DDDDD CCCCC", route_ids(route).c_str());
+
+			AirwayRouteOptions fl100;
+			fl100.cruise_fl = 100;
+			Assert::IsTrue(router.find_route(fix("AAAAA"), fix("EEEEE"), fl100, route));
+			Assert::AreEqual("AAAAA DDDDD CCCCC EEEEE", route_ids(route).c_str());
+			AirwayRouteOptions fl300;
+			fl300.cruise_fl = 300;
+			Assert::IsTrue(router.find_route(fix("AAAAA"), fix("CCCCC"), fl300, route));
+			Assert::AreEqual("AAAAA BBBBB CCCCC", route_ids(route).c_str());
+			AirwayRouteOptions fl500;
+			fl500.cruise_fl = 500;
+			Assert::IsFalse(router.find_route(fix("AAAAA"), fix("CCCCC"), fl500, route));
+
+			// not on an airway
+			NavPoint off_airway(Coordinate(47, 18, 0), "OFFAW", "LH", Angle(0));
+			Assert::IsFalse(router.find_route(&off_airway, fix("CCCCC"), AirwayRouteOptions(), route));
+		}
+
+		TEST_METHOD(TestRouteBetweenCoordinates)
+		{
+			AirwayRouter router(graph);
+			AirwayRoute route;
+			Coordinate departure(47.05, 16.9, 0);
+			Coordinate destination(47.05, 20.1, 0);
+			AirwayRouteOptions options;
+			options.max_connection_km = 50;
+			Assert::IsTrue(router.find_route(departure, destination, options, route));
+			Assert::AreEqual("AAAAA BBBBB CCCCC EEEEE", route_ids(route).c_str());
+			double airways_km = AirwayRouter::great_circle_km(fix("AAAAA")->get_coordinate(), fix("BBBBB")->get_coordinate()) +
+				AirwayRouter::great_circle_km(fix("BBBBB")->get_coordinate(), fix("CCCCC")->get_coordinate()) +
+				AirwayRouter::great_circle_km(fix("CCCCC")->get_coordinate(), fix("EEEEE")->get_coordinate());
+			double direct_km = AirwayRouter::great_circle_km(departure, fix("AAAAA")->get_coordinate()) +
+				AirwayRouter::great_circle_km(fix("EEEEE")->get_coordinate(), destination);
+			Assert::AreEqual(airways_km + direct_km, route.distance_km, 0.001);
+
+			// no airway fix in reach
+			AirwayRouteOptions short_connection;
+			short_connection.max_connection_km = 5;
+			Assert::IsFalse(router.find_route(departure, destination, short_connection, route));
+		}
+
+		TEST_METHOD(TestRouteOnParsedAirways)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_earth_awy_dat_file();
+			const AirwayGraph& parsed_graph = parser.get_airway_graph();
+			AirwayRouter router(parsed_graph);
+
+			// L601 starts at the PTB VOR/DME
+			const NavPoint* ptb = parsed_graph.get_nav_point(parsed_graph.get_airway_chains(parsed_graph.find_airway("L601"))[0][0]);
+			const NavPoint* badov = parser.find_nav_points_by_icao_id("LZ", "BADOV").front();
+			Assert::AreEqual("PTB", ptb->get_icao_id().c_str());
+			AirwayRoute route;
+			Assert::IsTrue(router.find_route(ptb, badov, AirwayRouteOptions(), route));
+			Assert::AreEqual(4, (int)route.nodes.size());
+			Assert::AreEqual("UL601", parsed_graph.get_airway_name(route.airways.back()).c_str());
+
+			FlightRoute flight_route("PTB-BADOV");
+			flight_route.enroute_points = router.get_nav_points(route);
+			Assert::AreEqual("BP701", flight_route.enroute_points[1].get_icao_id().c_str());
+			Assert::AreEqual("BADOV", flight_route.enroute_points[3].get_icao_id().c_str());
+
+			// UL601 is one way toward BADOV
+			Assert::IsFalse(router.find_route(badov, ptb, AirwayRouteOptions(), route));
+		}
+
+		TEST_METHOD(TestHierarchyMatchesDijkstra)
+		{
+			// a jittered 20x20 grid, some of the airways one way, high or closed at some levels
+			std::mt19937 random(7);
+			std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+			std::uniform_int_distribution<int> dice(0, 9);
+			std::vector<NavPoint> grid_fixes;
+			grid_fixes.reserve(400);
+			for (int i = 0; i < 400; i++)
+				grid_fixes.emplace_back(Coordinate(40 + i / 20 + jitter(random), 10 + i % 20 + jitter(random), 0), "F" + std::to_string(i), "LH", Angle(0));
+
+			AirwayGraphBuilder builder;
+			for (int i = 0; i < 400; i++)
+			{
+				for (int next : { i % 20 < 19 ? i + 1 : -1, i < 380 ? i + 20 : -1, i % 20 < 19 && i < 380 ? i + 21 : -1 })
+				{
+					if (next < 0 || dice(random) == 0)
+						continue;
+					int kind = dice(random);
+					AirwayDirection direction = kind == 0 ? AIRWAY_FORWARD : (kind == 1 ? AIRWAY_BACKWARD : AIRWAY_BOTH_WAYS);
+					AirwayLevel level = kind < 7 ? AIRWAY_LOW : AIRWAY_HIGH;
+					builder.add_segment(&grid_fixes[i], &grid_fixes[next], "A" + std::to_string(next - i) + "-" + std::to_string(i / 20), direction, level,
+						level == AIRWAY_LOW ? 50 : 245, level == AIRWAY_HIGH ? 460 : (kind == 3 ? 180 : 245));
+				}
+			}
+			AirwayGraph grid;
+			builder.build(grid);
+			AirwayRouter router(grid);
+
+			AirwayRouteOptions default_options;
+			AirwayRouteOptions low_only;
+			low_only.use_high_airways = false;
+			AirwayRouteOptions fl200;
+			fl200.cruise_fl = 200;
+			std::uniform_int_distribution<uint32_t> random_node(0, (uint32_t)grid.get_node_count() - 1);
+			for (const AirwayRouteOptions& options : { default_options, low_only, fl200 })
+			{
+				AirwayHierarchy hierarchy;
+				Assert::IsTrue(hierarchy.build(grid, options));
+				Assert::IsTrue(hierarchy.is_built());
+				int found = 0;
+				for (int i = 0; i < 300; i++)
+				{
+					uint32_t from = random_node(random);
+					uint32_t to = random_node(random);
+					double reference_km = dijkstra_km(grid, from, to, options);
+					AirwayRoute route;
+					Assert::AreEqual(reference_km >= 0, hierarchy.find_route(from, to, route));
+					if (reference_km < 0)
+						continue;
+
+					found++;
+					Assert::AreEqual(reference_km, route.distance_km, 1e-6);
+					Assert::AreEqual(from, route.nodes.front());
+					Assert::AreEqual(to, route.nodes.back());
+					check_route_legs(grid, route, options);
+
+					Assert::IsTrue(router.find_route(from, to, options, route));
+					Assert::AreEqual(reference_km, route.distance_km, 1e-6);
+					check_route_legs(grid, route, options);
+				}
+				Assert::IsTrue(found > 100);
+			}
+		}
+
+		TEST_METHOD(TestHierarchyFile)
+		{
+			std::filesystem::path file_path = std::filesystem::temp_directory_path() / "navme-test-airways.hierarchy";
+			AirwayRouteOptions fl100;
+			fl100.cruise_fl = 100;
+			AirwayHierarchy hierarchy;
+			Assert::IsTrue(hierarchy.build(graph, fl100));
+			Assert::IsTrue(hierarchy.save_to_file(file_path.string()));
+
+			AirwayHierarchy loaded;
+			Assert::IsFalse(loaded.is_built());
+			Assert::IsTrue(loaded.load_from_file(file_path.string(), graph));
+			Assert::AreEqual(100, loaded.get_options().cruise_fl);
+			Assert::AreEqual(hierarchy.get_shortcut_count(), loaded.get_shortcut_count());
+			AirwayRoute route;
+			Assert::IsTrue(loaded.find_route(fix("AAAAA"), fix("EEEEE"), route));
+			Assert::AreEqual("AAAAA DDDDD CCCCC EEEEE", route_ids(route).c_str());
+			Assert::IsFalse(loaded.find_route(fix("EEEEE"), fix("AAAAA"), route));
+
+			// another airway network
+			AirwayGraphBuilder builder;
+			builder.add_segment(fix("AAAAA"), fix("BBBBB"), "X1", AIRWAY_BOTH_WAYS, AIRWAY_HIGH, 245, 460);
+			AirwayGraph other_graph;
+			builder.build(other_graph);
+			Assert::IsFalse(loaded.load_from_file(file_path.string(), other_graph));
+			Assert::IsFalse(loaded.is_built());
+			Assert::IsFalse(loaded.load_from_file((file_path.parent_path() / "navme-no-such-file").string(), graph));
+
+			// the same airways over a moved fix: other edge lengths
+			std::vector<NavPoint> moved_fixes = fixes;
+			moved_fixes[3] = NavPoint(Coordinate(45, 18, 0), "DDDDD", "LH", Angle(0));
+			AirwayGraphBuilder moved_builder;
+			moved_builder.add_segment(&moved_fixes[0], &moved_fixes[1], "X1", AIRWAY_BOTH_WAYS, AIRWAY_HIGH, 245, 460);
+			moved_builder.add_segment(&moved_fixes[1], &moved_fixes[2], "X1", AIRWAY_BOTH_WAYS, AIRWAY_HIGH, 245, 460);
+			moved_builder.add_segment(&moved_fixes[0], &moved_fixes[3], "Y1", AIRWAY_BOTH_WAYS, AIRWAY_LOW, 50, 245);
+			moved_builder.add_segment(&moved_fixes[3], &moved_fixes[2], "Y1", AIRWAY_BOTH_WAYS, AIRWAY_LOW, 50, 245);
+			moved_builder.add_segment(&moved_fixes[2], &moved_fixes[4], "Z1", AIRWAY_FORWARD, AIRWAY_LOW, 50, 460);
+			AirwayGraph moved_graph;
+			moved_builder.build(moved_graph);
+			Assert::AreEqual(graph.get_node_count(), moved_graph.get_node_count());
+			Assert::IsFalse(loaded.load_from_file(file_path.string(), moved_graph));
+
+			// corrupt offsets and shortcuts are rejected. offsets in the file: 22 the rank, 46 the up offsets,
+			// 74 the down offsets, 102 the edges (20 bytes: km, to, middle, airway)
+			std::string content;
+			{
+				std::ifstream i_str(file_path, std::ios::binary);
+				content.assign(std::istreambuf_iterator<char>(i_str), std::istreambuf_iterator<char>());
+			}
+			auto load_patched = [&](std::size_t offset, uint32_t value) {
+				std::string patched = content;
+				memcpy(&patched[offset], &value, sizeof(value));
+				std::ofstream o_str(file_path, std::ios::binary | std::ios::trunc);
+				o_str << patched;
+				o_str.close();
+				return loaded.load_from_file(file_path.string(), graph);
+			};
+			Assert::IsTrue(load_patched(0, 0x48414D4E));
+			Assert::IsFalse(load_patched(46 + 4, 1)); // the first node's edges don't start at 0
+			Assert::IsFalse(load_patched(46 + 4 + 5 * 4, 0x7FFFFFFF)); // more edges than the file
+			Assert::IsFalse(load_patched(102 + 12, 99)); // no such middle node
+			Assert::IsFalse(load_patched(102 + 12, 4)); // a middle node without the halves of the shortcut
+			Assert::IsFalse(loaded.is_built());
+			std::filesystem::remove(file_path);
+		}
+
+		TEST_METHOD_CLEANUP(TestAirwayRouterCleanup)
+		{
+
+		}
+	};
+}
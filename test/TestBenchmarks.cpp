@@ -0,0 +1,626 @@
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <cmath>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	// counts the records without storing them: measures the decoding alone
+	class CountingSink : public NavDataSink {
+	public:
+		std::size_t nav_points = 0;
+		std::size_t airports = 0;
+		std::size_t runways = 0;
+		std::size_t procedure_legs = 0;
+		std::size_t airway_segments = 0;
+		void add_nav_point(const NavPointRecord& /*record*/) override { nav_points++; }
+		void add_airport(const AirportRecord& /*record*/) override { airports++; }
+		void add_runway(const RunwayRecord& /*record*/) override { runways++; }
+		void add_procedure_leg(const ProcedureLegRecord& /*record*/) override { procedure_legs++; }
+		void add_airway_segment(const AirwaySegmentRecord& /*record*/) override { airway_segments++; }
+	};
+
+	/* Throughput benchmarks on synthetic data. The timings are written to the test output;
+	   the asserts only check that the measured code did the full work. */
+	TEST_CLASS(TestBenchmarks)
+	{
+	private:
+		static const int FIX_COUNT = 50000;
+		static const int VOR_COUNT = 5000;
+		static const int AIRPORT_COUNT = 2000;
+		// about the size of the worldwide earth_awy.dat
+		static const int AIRWAY_COUNT = 5000;
+		static const int AIRWAY_SEGMENTS = 20;
+
+		std::filesystem::path bench_path;
+
+		static double bench_lat(int i) { return -80.0 + (i * 7919LL % 160000) / 1000.0; }
+		static double bench_lng(int i) { return -179.0 + (i * 104729LL % 358000) / 1000.0; }
+		static std::string bench_region(int i) { static const char* regions[] = { "LH", "LO", "ED", "K1", "LF" }; return regions[i % 5]; }
+
+		static std::string bench_id(int i, int length)
+		{
+			std::string id(length, 'A');
+			for (int pos = length - 1; pos >= 0; pos--, i /= 26)
+				id[pos] = 'A' + i % 26;
+			return id;
+		}
+
+		static std::string fixed(double value, int width, int precision)
+		{
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(precision) << std::setw(width) << value;
+			return o_str.str();
+		}
+
+		// fixed column line: the text is written from the 0-based column
+		static void put(std::string& line, std::size_t column, const std::string& text)
+		{
+			if (line.size() < column + text.size())
+				line.resize(column + text.size(), ' ');
+			line.replace(column, text.size(), text);
+		}
+
+		static std::string arinc_coordinate(double value, int degree_digits, char positive, char negative)
+		{
+			char hemisphere = value >= 0 ? positive : negative;
+			int centiseconds = (int)(abs(value) * 360000 + 0.5);
+			std::ostringstream o_str;
+			o_str << hemisphere << std::setfill('0') << std::setw(degree_digits) << centiseconds / 360000
+				<< std::setw(2) << centiseconds / 6000 % 60 << std::setw(4) << centiseconds % 6000;
+			return o_str.str();
+		}
+
+		static std::string arinc_record(char section, char subsection)
+		{
+			std::string record(132, ' ');
+			record[0] = 'S';
+			put(record, 1, "EEU");
+			record[4] = section;
+			if (section == 'P')
+				record[12] = subsection;
+			else
+				record[5] = subsection;
+			return record;
+		}
+
+		void write_xplane_data(const std::filesystem::path& root)
+		{
+			std::filesystem::create_directories(root / "Custom Data");
+			std::ofstream fix_str(root / "Custom Data" / "earth_fix.dat");
+			fix_str << "I\n1101 Version - benchmark\n\n";
+			for (int i = 0; i < FIX_COUNT; i++)
+			{
+				std::string line;
+				put(line, 0, fixed(bench_lat(i), 13, 9));
+				put(line, 14, fixed(bench_lng(i), 14, 9));
+				put(line, 30, bench_id(i, 5) + " ENRT " + bench_region(i) + " 4478275 " + bench_id(i, 5));
+				fix_str << line << "\n";
+			}
+			fix_str << "99\n";
+
+			std::ofstream nav_str(root / "Custom Data" / "earth_nav.dat");
+			nav_str << "I\n1100 Version - benchmark\n\n";
+			for (int i = 0; i < VOR_COUNT; i++)
+			{
+				std::string line;
+				put(line, 0, " 3");
+				put(line, 3, fixed(bench_lat(i + FIX_COUNT), 13, 9));
+				put(line, 17, fixed(bench_lng(i + FIX_COUNT), 13, 9));
+				put(line, 35, "  430    11710   130      5.000 ");
+				put(line, 67, " " + bench_id(i, 3) + " ENRT " + bench_region(i) + " BENCHMARK VOR");
+				nav_str << line << "\n";
+			}
+			nav_str << "99\n";
+
+			// every airway starts at a VOR and goes through fixes spread over the whole fix list
+			std::ofstream awy_str(root / "Custom Data" / "earth_awy.dat");
+			awy_str << "I\n1100 Version - benchmark\n\n";
+			for (int a = 0; a < AIRWAY_COUNT; a++)
+			{
+				std::string name = (a % 2 == 0 ? "UL" : "M") + std::to_string(a);
+				std::string from = bench_id(a % VOR_COUNT, 3) + " " + bench_region(a % VOR_COUNT) + " 3";
+				for (int k = 0; k < AIRWAY_SEGMENTS; k++)
+				{
+					int fix = (a * 20 + k * 997) % FIX_COUNT;
+					std::string to = bench_id(fix, 5) + " " + bench_region(fix) + " 11";
+					awy_str << from << " " << to << (a % 10 == 0 ? " F " : " N ") << (a % 2 == 0 ? "2 245 460 " : "1 50 245 ") << name << "\n";
+					from = to;
+				}
+			}
+			awy_str << "99\n";
+
+			std::filesystem::path apt_folder = root / "Global Scenery" / "Global Airports" / "Earth nav data";
+			std::filesystem::create_directories(apt_folder);
+			std::ofstream apt_str(apt_folder / "apt.dat");
+			apt_str << "I\n1100 Version - benchmark\n\n";
+			for (int i = 0; i < AIRPORT_COUNT; i++)
+			{
+				double lat = bench_lat(i + 2 * FIX_COUNT);
+				double lng = bench_lng(i + 2 * FIX_COUNT);
+				apt_str << "1    495 0 0 " << bench_id(i, 4) << " Benchmark Airport\n";
+				apt_str << "1302 region_code " << bench_region(i) << "\n";
+				apt_str << "1302 datum_lat " << fixed(lat, 0, 9) << "\n";
+				apt_str << "1302 datum_lon " << fixed(lng, 0, 9) << "\n";
+				apt_str << "100 45.00 1 0 0.15 0 2 1 13L " << fixed(lat, 0, 8) << " " << fixed(lng, 0, 8) << " 0.00 0.00 2 0 0 1 31R "
+					<< fixed(lat - 0.02, 0, 8) << " " << fixed(lng + 0.02, 0, 8) << " 0.00 0.00 2 0 0 1\n";
+			}
+			apt_str << "99\n";
+		}
+
+		void write_arinc_data(const std::filesystem::path& file_path)
+		{
+			std::ofstream o_str(file_path);
+			for (int i = 0; i < VOR_COUNT; i++)
+			{
+				std::string record = arinc_record('D', ' ');
+				put(record, 13, bench_id(i, 3));
+				put(record, 19, bench_region(i) + "111710V    " + arinc_coordinate(bench_lat(i + FIX_COUNT), 2, 'N', 'S') + arinc_coordinate(bench_lng(i + FIX_COUNT), 3, 'E', 'W'));
+				put(record, 74, "E005000430");
+				put(record, 93, "BENCHMARK VOR");
+				o_str << record << "\n";
+			}
+
+			for (int i = 0; i < FIX_COUNT; i++)
+			{
+				std::string record = arinc_record('E', 'A');
+				put(record, 6, "ENRT");
+				put(record, 13, bench_id(i, 5));
+				put(record, 19, bench_region(i) + "1");
+				put(record, 32, arinc_coordinate(bench_lat(i), 2, 'N', 'S') + arinc_coordinate(bench_lng(i), 3, 'E', 'W'));
+				put(record, 98, bench_id(i, 5));
+				o_str << record << "\n";
+			}
+
+			for (int i = 0; i < AIRPORT_COUNT; i++)
+			{
+				double lat = bench_lat(i + 2 * FIX_COUNT);
+				double lng = bench_lng(i + 2 * FIX_COUNT);
+				std::string record = arinc_record('P', 'A');
+				put(record, 6, bench_id(i, 4) + bench_region(i));
+				put(record, 21, "0");
+				put(record, 32, arinc_coordinate(lat, 2, 'N', 'S') + arinc_coordinate(lng, 3, 'E', 'W') + "E005000495");
+				put(record, 93, "BENCHMARK AIRPORT");
+				o_str << record << "\n";
+
+				for (const char* runway : { "RW13L", "RW31R" })
+				{
+					record = arinc_record('P', 'G');
+					put(record, 6, bench_id(i, 4) + bench_region(i));
+					put(record, 13, runway);
+					put(record, 21, "0097401311 " + arinc_coordinate(lat, 2, 'N', 'S') + arinc_coordinate(lng, 3, 'E', 'W'));
+					put(record, 77, "148");
+					o_str << record << "\n";
+				}
+			}
+		}
+
+		// worldwide 1 degree airway grid: the parallels are high airways, the meridians low ones and every 7th of them one way north.
+		// with a spacing the airways only cross at every spacing degrees
+		void build_airway_grid(std::vector<NavPoint>& fixes, AirwayGraph& graph, int spacing = 1)
+		{
+			fixes.reserve(131 * 360);
+			for (int lat = -60; lat <= 70; lat++)
+			{
+				for (int lng = -180; lng < 180; lng++)
+					fixes.emplace_back(Coordinate(lat, lng, 0), bench_id((int)fixes.size(), 5), bench_region(lat + lng + 240), Angle(0));
+			}
+
+			AirwayGraphBuilder builder;
+			for (int row = 0; row <= 130; row++)
+			{
+				for (int col = 0; col < 360; col++)
+				{
+					const NavPoint* fix = &fixes[row * 360 + col];
+					if (row % spacing == 0)
+						builder.add_segment(fix, &fixes[row * 360 + (col + 1) % 360], "UL" + std::to_string(row), AIRWAY_BOTH_WAYS, AIRWAY_HIGH, 245, 460);
+					if (row < 130 && col % spacing == 0)
+						builder.add_segment(fix, &fixes[(row + 1) * 360 + col], "M" + std::to_string(col), col % 7 == 0 ? AIRWAY_FORWARD : AIRWAY_BOTH_WAYS, AIRWAY_LOW, 50, 460);
+				}
+			}
+			builder.build(graph);
+		}
+
+		static double read_seconds(NavDataSource& source, NavDataSink& sink)
+		{
+			auto start = std::chrono::steady_clock::now();
+			Assert::IsTrue(source.read(sink));
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		static void report(const std::string& name, const NavDataSource& source, std::size_t records, double seconds)
+		{
+			double megabytes = source.get_bytes_read() / 1e6;
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(1) << name << ": " << records << " records, " << megabytes << " MB in "
+				<< seconds * 1000 << " ms: " << megabytes / seconds << " MB/s, " << records / seconds << " records/s\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+		}
+	public:
+		TEST_METHOD_INITIALIZE(TestBenchmarksInit)
+		{
+			bench_path = std::filesystem::temp_directory_path() / "navme-benchmark";
+			std::filesystem::remove_all(bench_path);
+		}
+
+		TEST_METHOD_CLEANUP(TestBenchmarksCleanup)
+		{
+			std::filesystem::remove_all(bench_path);
+		}
+
+		// the same synthetic navdata through every NavDataSource implementation
+		TEST_METHOD(BenchmarkNavDataSourceThroughput)
+		{
+			std::filesystem::path xplane_root = bench_path / "xplane";
+			std::filesystem::path arinc_file = bench_path / "navdata.arinc424";
+			write_xplane_data(xplane_root);
+			write_arinc_data(arinc_file);
+
+			XPlaneNavDataSource xplane_source(xplane_root.string());
+			Arinc424NavDataSource arinc_source(arinc_file.string());
+			NavDataSource* sources[] = { &xplane_source, &arinc_source };
+			const char* names[] = { "X-Plane", "ARINC 424" };
+
+			for (int s = 0; s < 2; s++)
+			{
+				CountingSink sink;
+				double seconds = read_seconds(*sources[s], sink);
+				report(std::string(names[s]) + " decode", *sources[s], sink.nav_points + sink.airports + sink.runways, seconds);
+				Assert::AreEqual((std::size_t)(FIX_COUNT + VOR_COUNT), sink.nav_points);
+				Assert::AreEqual((std::size_t)AIRPORT_COUNT, sink.airports);
+				Assert::AreEqual((std::size_t)(2 * AIRPORT_COUNT), sink.runways);
+				if (s == 0)
+					Assert::AreEqual((std::size_t)(AIRWAY_COUNT * AIRWAY_SEGMENTS), sink.airway_segments);
+
+				// decode and store into the parser
+				XPlaneParser parser(xplane_root.string());
+				auto start = std::chrono::steady_clock::now();
+				Assert::IsTrue(parser.load_nav_data_source(*sources[s]));
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				report(std::string(names[s]) + " load into XPlaneParser", *sources[s], parser.get_nav_points().size(), seconds);
+				Assert::AreEqual((std::size_t)(FIX_COUNT + VOR_COUNT), parser.get_nav_points().size());
+				Assert::AreEqual(2, (int)parser.find_airport_by_icao_id(bench_id(7, 4))->get_runways().size());
+			}
+		}
+
+		// A* routes between random city pairs on the airway grid
+		TEST_METHOD(BenchmarkAirwayRouter)
+		{
+			const int ROUTE_COUNT = 2000;
+			std::vector<NavPoint> fixes;
+			AirwayGraph graph;
+			build_airway_grid(fixes, graph);
+			AirwayRouter router(graph);
+
+			std::mt19937 random(42);
+			std::uniform_real_distribution<double> random_lat(-55, 65);
+			std::uniform_real_distribution<double> random_lng(-180, 180);
+			AirwayRouteOptions options;
+			AirwayRoute route;
+			double total_seconds = 0;
+			double max_seconds = 0;
+			std::size_t settled_nodes = 0;
+			int found = 0;
+			for (int i = 0; i < ROUTE_COUNT; i++)
+			{
+				Coordinate departure(random_lat(random), random_lng(random), 0);
+				Coordinate destination(random_lat(random), random_lng(random), 0);
+				auto start = std::chrono::steady_clock::now();
+				found += router.find_route(departure, destination, options, route) ? 1 : 0;
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				total_seconds += seconds;
+				max_seconds = std::max(max_seconds, seconds);
+				settled_nodes += route.settled_nodes;
+			}
+
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(3) << "airway router: " << graph.get_node_count() << " nodes, " << graph.get_edge_count()
+				<< " edges, " << ROUTE_COUNT << " routes: " << total_seconds * 1000 / ROUTE_COUNT << " ms average, " << max_seconds * 1000
+				<< " ms max, " << settled_nodes / ROUTE_COUNT << " settled nodes average\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+			Assert::AreEqual(ROUTE_COUNT, found);
+		}
+
+		// contraction hierarchy build, file round trip and fix to fix queries against A* on a sparser airway grid
+		TEST_METHOD(BenchmarkAirwayHierarchy)
+		{
+			const int ROUTE_COUNT = 2000;
+			std::vector<NavPoint> fixes;
+			AirwayGraph graph;
+			// most fixes are on a single airway between two crossings, like on the real airways. the
+			// dense grid of the A* benchmark is the worst case of the contraction
+			build_airway_grid(fixes, graph, 4);
+
+			AirwayHierarchy hierarchy;
+			auto start = std::chrono::steady_clock::now();
+			Assert::IsTrue(hierarchy.build(graph));
+			double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::filesystem::create_directories(bench_path);
+			std::string file_name = (bench_path / "airways.hierarchy").string();
+			Assert::IsTrue(hierarchy.save_to_file(file_name));
+			start = std::chrono::steady_clock::now();
+			Assert::IsTrue(hierarchy.load_from_file(file_name, graph));
+			double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::mt19937 random(42);
+			std::uniform_int_distribution<uint32_t> random_node(0, (uint32_t)graph.get_node_count() - 1);
+			std::vector<std::pair<uint32_t, uint32_t>> pairs;
+			for (int i = 0; i < ROUTE_COUNT; i++)
+				pairs.push_back({ random_node(random), random_node(random) });
+
+			AirwayRouter router(graph);
+			AirwayRoute route;
+			std::vector<double> distances;
+			start = std::chrono::steady_clock::now();
+			for (const std::pair<uint32_t, uint32_t>& pair : pairs)
+			{
+				// the fixes north of the last parallel on a one way meridian are dead ends
+				bool found = router.find_route(pair.first, pair.second, AirwayRouteOptions(), route);
+				distances.push_back(found ? route.distance_km : -1);
+			}
+			double router_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::size_t settled_nodes = 0;
+			start = std::chrono::steady_clock::now();
+			for (int i = 0; i < ROUTE_COUNT; i++)
+			{
+				Assert::AreEqual(distances[i] >= 0, hierarchy.find_route(pairs[i].first, pairs[i].second, route));
+				settled_nodes += route.settled_nodes;
+				if (distances[i] >= 0)
+					Assert::AreEqual(distances[i], route.distance_km, 1e-6);
+			}
+			double hierarchy_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(1) << "airway hierarchy: built in " << build_seconds * 1000 << " ms, loaded in "
+				<< load_seconds * 1000 << " ms, " << hierarchy.get_shortcut_count() << " shortcuts, " << hierarchy.get_memory_bytes() / 1e6 << " MB. "
+				<< ROUTE_COUNT << " routes: " << hierarchy_seconds * 1e6 / ROUTE_COUNT << " us average (A*: " << router_seconds * 1e6 / ROUTE_COUNT
+				<< " us), " << settled_nodes / ROUTE_COUNT << " settled nodes average\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+		}
+
+		// earth_awy.dat parse and the CSR graph build, with the memory of the graph
+		TEST_METHOD(BenchmarkAirwayGraph)
+		{
+			std::filesystem::path xplane_root = bench_path / "xplane";
+			write_xplane_data(xplane_root);
+			XPlaneParser parser(xplane_root.string());
+			Assert::IsTrue(parser.parse_earth_fix_dat_file());
+			Assert::IsTrue(parser.parse_earth_nav_dat_file());
+
+			auto start = std::chrono::steady_clock::now();
+			Assert::IsTrue(parser.parse_earth_awy_dat_file());
+			double parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			start = std::chrono::steady_clock::now();
+			const AirwayGraph& graph = parser.get_airway_graph();
+			double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(1) << "earth_awy.dat: " << AIRWAY_COUNT * AIRWAY_SEGMENTS << " segments parsed in "
+				<< parse_seconds * 1000 << " ms, graph built in " << build_seconds * 1000 << " ms: " << graph.get_node_count() << " nodes, "
+				<< graph.get_edge_count() << " edges, " << graph.get_airway_count() << " airways, " << graph.get_memory_bytes() / 1e6 << " MB\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+
+			Assert::AreEqual(0, (int)parser.get_unresolved_airway_segment_count());
+			Assert::AreEqual((std::size_t)AIRWAY_COUNT, graph.get_airway_count());
+			// the one way airways have one edge per segment, the others two
+			Assert::AreEqual((std::size_t)(AIRWAY_COUNT * AIRWAY_SEGMENTS * 2 - AIRWAY_COUNT / 10 * AIRWAY_SEGMENTS), graph.get_edge_count());
+			std::vector<std::span<const uint32_t>> chains = graph.get_airway_chains(graph.find_airway("M7"));
+			Assert::AreEqual(1, (int)chains.size());
+			Assert::AreEqual(AIRWAY_SEGMENTS + 1, (int)chains[0].size());
+		}
+
+		// ICAO route strings with two airways each, resolved and expanded against the generated navdata
+		TEST_METHOD(BenchmarkRouteStrings)
+		{
+			const int ROUTE_COUNT = 20000;
+			std::filesystem::path xplane_root = bench_path / "xplane";
+			write_xplane_data(xplane_root);
+			XPlaneParser parser(xplane_root.string());
+			Assert::IsTrue(parser.parse_earth_fix_dat_file());
+			Assert::IsTrue(parser.parse_earth_nav_dat_file());
+			Assert::IsTrue(parser.parse_apt_dat_file());
+			Assert::IsTrue(parser.parse_earth_awy_dat_file());
+			parser.get_airway_graph();
+			// the airports have no CIFP file, the cache spares the file lookup of every query
+			parser.enable_query_cache(AIRPORT_COUNT);
+
+			// the fix k of an airway, see write_xplane_data
+			auto airway_fix = [](int airway, int k) { return bench_id((airway * 20 + k * 997) % FIX_COUNT, 5); };
+			auto airway_name = [](int airway) { return (airway % 2 == 0 ? "UL" : "M") + std::to_string(airway); };
+			std::vector<std::string> route_strings;
+			for (int r = 0; r < ROUTE_COUNT; r++)
+			{
+				int first = (r * 7) % AIRWAY_COUNT;
+				int second = (r * 13 + 1) % AIRWAY_COUNT;
+				route_strings.push_back(bench_id(r % AIRPORT_COUNT, 4) + " " + airway_fix(first, 2) + " " + airway_name(first) + " " + airway_fix(first, 12) +
+					" DCT " + airway_fix(second, 3) + "/N0450F350 " + airway_name(second) + " " + airway_fix(second, 15) + " " + bench_id((r + 1) % AIRPORT_COUNT, 4));
+			}
+
+			RouteStringParser route_parser(parser);
+			FlightRoute route("benchmark");
+			std::size_t points = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (const std::string& route_string : route_strings)
+			{
+				Assert::IsTrue(route_parser.parse(route_string, route));
+				points += route.enroute_points.size();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(1) << "route strings: " << ROUTE_COUNT << " routes, " << points / ROUTE_COUNT << " points each, in "
+				<< seconds * 1000 << " ms: " << ROUTE_COUNT / seconds << " routes/s, " << seconds * 1e6 / ROUTE_COUNT << " us per route\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+			Assert::AreEqual((std::size_t)ROUTE_COUNT * 24, points);
+		}
+
+		// route files of FlightRoute::save_to_file checked on one thread and on all of them
+		TEST_METHOD(BenchmarkRouteValidator)
+		{
+			const int ROUTE_COUNT = 2000;
+			const int ROUTE_POINTS = 200;
+			std::filesystem::path xplane_root = bench_path / "xplane";
+			write_xplane_data(xplane_root);
+			XPlaneParser parser(xplane_root.string());
+			Assert::IsTrue(parser.parse_earth_fix_dat_file());
+			Assert::IsTrue(parser.parse_earth_nav_dat_file());
+			Assert::IsTrue(parser.parse_apt_dat_file());
+			parser.enable_query_cache(AIRPORT_COUNT);
+
+			std::filesystem::path route_folder = bench_path / "routes";
+			std::filesystem::create_directories(route_folder);
+			std::vector<std::string> file_names;
+			for (int r = 0; r < ROUTE_COUNT; r++)
+			{
+				file_names.push_back((route_folder / ("route_" + std::to_string(r) + ".txt")).string());
+				std::ofstream o_str(file_names.back());
+				o_str << "dep=" << bench_id(r % AIRPORT_COUNT, 4) << ";" << bench_region(r % AIRPORT_COUNT) << "\n";
+				o_str << "dest=" << bench_id((r + 1) % AIRPORT_COUNT, 4) << ";" << bench_region((r + 1) % AIRPORT_COUNT) << "\n";
+				for (int k = 0; k < ROUTE_POINTS; k++)
+				{
+					int fix = (r * 31 + k * 7) % FIX_COUNT;
+					o_str << "route_" << k << "=" << bench_id(fix, 5) << ";" << bench_region(fix) << "\n";
+				}
+			}
+
+			unsigned thread_counts[] = { 1, std::max(1u, std::thread::hardware_concurrency()) };
+			for (unsigned thread_count : thread_counts)
+			{
+				RouteValidationOptions options;
+				options.thread_count = thread_count;
+				options.max_leg_km = 40000;
+				RouteValidator validator(parser, options);
+				auto start = std::chrono::steady_clock::now();
+				std::vector<RouteValidationReport> reports = validator.validate_route_files(file_names);
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+				std::ostringstream o_str;
+				o_str << std::fixed << std::setprecision(1) << "route validator, " << thread_count << " threads: " << ROUTE_COUNT << " route files of "
+					<< ROUTE_POINTS << " points in " << seconds * 1000 << " ms: " << ROUTE_COUNT / seconds << " routes/s\n";
+				Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+				for (const RouteValidationReport& report : reports)
+				{
+					Assert::IsTrue(report.is_valid());
+					Assert::AreEqual((std::size_t)(ROUTE_POINTS + 2), report.point_count);
+				}
+			}
+		}
+
+		// FlightRoute::save_to_file and load_from_file on long routes
+		TEST_METHOD(BenchmarkFlightRouteFile)
+		{
+			const int ROUTE_COUNT = 200;
+			const int ROUTE_POINTS = 500;
+			std::filesystem::path xplane_root = bench_path / "xplane";
+			write_xplane_data(xplane_root);
+			XPlaneParser parser(xplane_root.string());
+			Assert::IsTrue(parser.parse_earth_fix_dat_file());
+			Assert::IsTrue(parser.parse_earth_nav_dat_file());
+			Assert::IsTrue(parser.parse_apt_dat_file());
+			parser.enable_query_cache(AIRPORT_COUNT);
+
+			std::filesystem::path route_folder = bench_path / "flight-routes";
+			std::filesystem::create_directories(route_folder);
+			std::vector<std::string> file_names;
+			std::vector<FlightRoute> routes;
+			for (int r = 0; r < ROUTE_COUNT; r++)
+			{
+				file_names.push_back((route_folder / ("route_" + std::to_string(r) + ".txt")).string());
+				routes.emplace_back("benchmark");
+				Assert::IsTrue(parser.get_airport_by_icao_id(bench_id(r % AIRPORT_COUNT, 4), routes.back().departure_airport));
+				Assert::IsTrue(parser.get_airport_by_icao_id(bench_id((r + 1) % AIRPORT_COUNT, 4), routes.back().destination_airport));
+				for (int k = 0; k < ROUTE_POINTS; k++)
+				{
+					int fix = (r * 31 + k * 7) % FIX_COUNT;
+					routes.back().enroute_points.push_back(*parser.find_nav_points_by_icao_id(bench_region(fix), bench_id(fix, 5)).front());
+				}
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < ROUTE_COUNT; r++)
+				Assert::IsTrue(routes[r].save_to_file(file_names[r]));
+			double save_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			FlightRoute loaded("loaded");
+			start = std::chrono::steady_clock::now();
+			for (int r = 0; r < ROUTE_COUNT; r++)
+			{
+				Assert::IsTrue(loaded.load_from_file(file_names[r], parser));
+				Assert::AreEqual((std::size_t)ROUTE_POINTS, loaded.enroute_points.size());
+			}
+			double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			Assert::AreEqual(routes.back().enroute_points.back().get_icao_id().c_str(), loaded.enroute_points.back().get_icao_id().c_str());
+
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(1) << "flight route files: " << ROUTE_COUNT << " routes of " << ROUTE_POINTS << " points, save "
+				<< save_seconds * 1e6 / ROUTE_COUNT << " us per route, load " << load_seconds * 1e6 / ROUTE_COUNT << " us per route, "
+				<< ROUTE_COUNT * ROUTE_POINTS / load_seconds << " points/s\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+		}
+
+		// the leg cache of FlightRoute against computing every leg again after each edit
+		TEST_METHOD(BenchmarkRouteLegMetrics)
+		{
+			const int ROUTE_POINTS = 2000;
+			const int EDIT_COUNT = 2000;
+			std::vector<NavPoint> fixes;
+			for (int i = 0; i < ROUTE_POINTS + EDIT_COUNT; i++)
+				fixes.emplace_back(Coordinate(40 + (i % 97) * 0.1, -10 + (i % 389) * 0.1, 0), bench_id(i, 5), bench_region(i), Angle(0.0));
+
+			FlightRoute route("benchmark");
+			for (int i = 0; i < ROUTE_POINTS; i++)
+				route.enroute_points.push_back(fixes[i]);
+			route.get_total_distance_km();
+
+			// an insert and a remove in the middle, then the length and the distance to go from the first legs
+			double cached_total = 0;
+			auto start = std::chrono::steady_clock::now();
+			for (int e = 0; e < EDIT_COUNT; e++)
+			{
+				std::size_t index = (e * 7919) % ROUTE_POINTS;
+				route.insert_enroute_point(index, fixes[ROUTE_POINTS + e]);
+				route.remove_enroute_point((index + ROUTE_POINTS / 2) % ROUTE_POINTS);
+				cached_total += route.get_total_distance_km() - route.get_distance_to_go_km(e % 100);
+			}
+			double cached_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			// the same edits, every leg computed again from get_all_navpoints()
+			FlightRoute full_route("benchmark");
+			for (int i = 0; i < ROUTE_POINTS; i++)
+				full_route.enroute_points.push_back(fixes[i]);
+			double full_total = 0;
+			start = std::chrono::steady_clock::now();
+			for (int e = 0; e < EDIT_COUNT; e++)
+			{
+				std::size_t index = (e * 7919) % ROUTE_POINTS;
+				full_route.enroute_points.insert(full_route.enroute_points.begin() + index, fixes[ROUTE_POINTS + e]);
+				full_route.enroute_points.erase(full_route.enroute_points.begin() + (index + ROUTE_POINTS / 2) % ROUTE_POINTS);
+				std::vector<NavPoint> points = full_route.get_all_navpoints();
+				std::vector<double> distance_before_leg(points.size(), 0);
+				for (std::size_t leg = 0; leg + 1 < points.size(); leg++)
+				{
+					RelativePos rel_pos;
+					points[leg].get_coordinate().get_relative_pos_to(points[leg + 1].get_coordinate(), rel_pos);
+					distance_before_leg[leg + 1] = distance_before_leg[leg] + (std::isnan(rel_pos.dist_ortho) ? 0 : rel_pos.dist_ortho);
+				}
+				full_total += distance_before_leg[e % 100];
+			}
+			double full_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::ostringstream o_str;
+			o_str << std::fixed << std::setprecision(2) << "route leg metrics: " << ROUTE_POINTS << " points, " << EDIT_COUNT << " edits: "
+				<< cached_seconds * 1e6 / EDIT_COUNT << " us per edit with the leg cache, " << full_seconds * 1e6 / EDIT_COUNT << " us computing every leg\n";
+			Microsoft::VisualStudio::CppUnitTestFramework::Logger::WriteMessage(o_str.str().c_str());
+			Assert::AreEqual(full_total, cached_total, 1e-6 * full_total);
+		}
+	};
+}
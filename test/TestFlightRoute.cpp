@@ -0,0 +1,223 @@
+#include <filesystem>
+#include <fstream>
+#include <cmath>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestFlightRoute)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+		std::filesystem::path route_file;
+
+		void parse_nav_data(XPlaneParser& parser)
+		{
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+		}
+
+		// the legs of get_all_navpoints() computed again
+		static void check_legs(const FlightRoute& route)
+		{
+			std::vector<NavPoint> points = route.get_all_navpoints();
+			Assert::AreEqual(points.empty() ? 0 : (int)points.size() - 1, (int)route.get_leg_count());
+			double distance_to_go = 0;
+			for (std::size_t leg = route.get_leg_count(); leg-- > 0;)
+			{
+				RelativePos rel_pos;
+				points[leg].get_coordinate().get_relative_pos_to(points[leg + 1].get_coordinate(), rel_pos);
+				double distance = std::isnan(rel_pos.dist_ortho) ? 0 : rel_pos.dist_ortho;
+				Assert::AreEqual(distance, route.get_leg(leg).distance_km, 1e-9);
+				Assert::AreEqual(rel_pos.heading_ortho_departure.convert_to_double(), route.get_leg(leg).initial_true_course.convert_to_double(), 1e-9);
+				Assert::AreEqual(rel_pos.heading_ortho_arrival.convert_to_double(), route.get_leg(leg).final_true_course.convert_to_double(), 1e-9);
+				distance_to_go += distance;
+				Assert::AreEqual(distance_to_go, route.get_distance_to_go_km(leg), 1e-6);
+			}
+			Assert::AreEqual(distance_to_go, route.get_total_distance_km(), 1e-6);
+		}
+
+		void write_route_file(const std::string& content)
+		{
+			std::ofstream o_str(route_file, std::ios::binary);
+			o_str << content;
+		}
+	public:
+		TEST_METHOD_INITIALIZE(TestFlightRouteInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+			route_file = std::filesystem::temp_directory_path() / "navme-test-flight-route.txt";
+		}
+
+		TEST_METHOD_CLEANUP(TestFlightRouteCleanup)
+		{
+			std::filesystem::remove(route_file);
+		}
+
+		TEST_METHOD(TestSaveAndLoad)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			FlightRoute route("LHBP-LOWI");
+			Assert::IsTrue(parser.get_airport_by_icao_id("LHBP", route.departure_airport));
+			Assert::IsTrue(parser.get_airport_by_icao_id("LOWI", route.destination_airport));
+			Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", route.sid));
+			Assert::IsTrue(parser.get_procedure_by_id("BREN3A", "LOWI", route.star));
+			route.enroute_points.push_back(*parser.find_nav_points_by_icao_id("LH", "PTB").front());
+			route.enroute_points.push_back(*parser.find_nav_points_by_icao_id("LH", "BP702").front());
+			Assert::IsTrue(route.save_to_file(route_file.string()));
+
+			FlightRoute loaded("loaded");
+			Assert::IsTrue(loaded.load_from_file(route_file.string(), parser));
+			Assert::AreEqual("LHBP", loaded.departure_airport.get_icao_id().c_str());
+			Assert::AreEqual("LOWI", loaded.destination_airport.get_icao_id().c_str());
+			Assert::AreEqual("BADO2B", loaded.sid.get_name().c_str());
+			Assert::AreEqual("BREN3A", loaded.star.get_name().c_str());
+			Assert::IsTrue(loaded.approach.get_name().empty());
+			Assert::AreEqual(2, (int)loaded.enroute_points.size());
+			Assert::AreEqual("PTB", loaded.enroute_points[0].get_icao_id().c_str());
+			Assert::IsTrue(loaded.enroute_points[0].get_radio_type() != NavPoint::NONE);
+			Assert::AreEqual("BP702", loaded.enroute_points[1].get_icao_id().c_str());
+		}
+
+		TEST_METHOD(TestLoadRoutePointsOutOfOrder)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			write_route_file("  route_2 = BADOV ; LZ \r\nnot an entry\r\n\r\nroute_0=PTB;LH\r\napp=;\r\nroute_1=BP702;LH\r\n");
+
+			FlightRoute route("out of order");
+			route.enroute_points.push_back(*parser.find_nav_points_by_icao_id("LH", "BP701").front());
+			Assert::IsTrue(route.load_from_file(route_file.string(), parser));
+			Assert::AreEqual(3, (int)route.enroute_points.size());
+			Assert::AreEqual("PTB", route.enroute_points[0].get_icao_id().c_str());
+			Assert::AreEqual("BP702", route.enroute_points[1].get_icao_id().c_str());
+			Assert::AreEqual("BADOV", route.enroute_points[2].get_icao_id().c_str());
+			Assert::AreEqual("LZ", route.enroute_points[2].get_icao_region().c_str());
+		}
+
+		TEST_METHOD(TestLoadDuplicateIdents)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			// the same ident in the region twice: near Seattle first, then near Budapest
+			NavPointRecord record;
+			record.icao_id = "TWICE";
+			record.icao_region = "LH";
+			record.lat = 47.5;
+			record.lng = -122.3;
+			parser.add_nav_point(record);
+			record.lat = 47.3;
+			record.lng = 19.4;
+			parser.add_nav_point(record);
+
+			// the one near the previous point, as RouteValidator chooses it
+			write_route_file("route_0=PTB;LH\nroute_1=TWICE;LH\nroute_2=BP702;LH\n");
+			FlightRoute route("duplicates");
+			Assert::IsTrue(route.load_from_file(route_file.string(), parser));
+			Assert::AreEqual(3, (int)route.enroute_points.size());
+			Assert::AreEqual(19.4, route.enroute_points[1].get_coordinate().lng.convert_to_double(), 0.001);
+			RouteValidator validator(parser);
+			Assert::IsTrue(validator.validate_route_files({ route_file.string() })[0].is_valid());
+
+			// without a previous point: the first one
+			write_route_file("route_0=TWICE;LH\n");
+			Assert::IsTrue(route.load_from_file(route_file.string(), parser));
+			Assert::AreEqual(1, (int)route.enroute_points.size());
+			Assert::AreEqual(-122.3, route.enroute_points[0].get_coordinate().lng.convert_to_double(), 0.001);
+		}
+
+		TEST_METHOD(TestLegMetrics)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			auto fix = [&parser](const char* region, const char* icao_id) { return *parser.find_nav_points_by_icao_id(region, icao_id).front(); };
+			FlightRoute route("legs");
+			check_legs(route);
+			Assert::AreEqual(0.0, route.get_total_distance_km());
+
+			route.insert_enroute_point(0, fix("LH", "PTB"));
+			check_legs(route);
+			route.insert_enroute_point(1, fix("LH", "BP702"));
+			route.insert_enroute_point(1, fix("LH", "BP701"));
+			route.insert_enroute_point(0, fix("LZ", "BADOV"));
+			check_legs(route);
+			Assert::AreEqual("BADOV", route.get_navpoint(0).get_icao_id().c_str());
+			Assert::AreEqual("BP702", route.get_navpoint(3).get_icao_id().c_str());
+
+			// the SID ends at BADOV: a leg of 0 km
+			RNAVProc sid;
+			Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", sid));
+			route.set_sid(sid);
+			check_legs(route);
+			double total = route.get_total_distance_km();
+			route.remove_enroute_point(2);
+			check_legs(route);
+			Assert::IsTrue(route.get_total_distance_km() < total);
+			route.remove_enroute_point(route.enroute_points.size() - 1);
+			route.remove_enroute_point(0);
+			route.remove_enroute_point(99);
+			check_legs(route);
+
+			RNAVProc approach;
+			approach.add_nav_point(fix("LH", "BP704"));
+			approach.add_nav_point(fix("LH", "BP703"));
+			route.set_approach(approach);
+			route.set_star(approach);
+			check_legs(route);
+			route.set_sid(RNAVProc());
+			route.set_star(RNAVProc());
+			check_legs(route);
+			Assert::AreEqual("PTB", route.get_navpoint(0).get_icao_id().c_str());
+
+			// direct changes of the members, without invalidate_leg_metrics()
+			route.enroute_points.push_back(fix("LH", "BP865"));
+			check_legs(route);
+			route.enroute_points.back() = fix("LH", "BP701");
+			check_legs(route);
+			route.enroute_points.front() = fix("LH", "BP703");
+			check_legs(route);
+			route.set_sid(sid);
+			check_legs(route);
+			// another procedure of the same size: the fixes of the SID backward
+			RNAVProc other_sid;
+			for (std::size_t i = sid.get_nav_points().size(); i-- > 0;)
+				other_sid.add_nav_point(sid.get_nav_points()[i]);
+			route.sid = other_sid;
+			check_legs(route);
+			// an inner point changed in place still needs it
+			route.enroute_points[1] = fix("LH", "BP704");
+			route.invalidate_leg_metrics();
+			check_legs(route);
+		}
+
+		TEST_METHOD(TestLoadErrors)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			FlightRoute route("errors");
+
+			write_route_file("route_0=PTB;LH\nroute_1=NOFIX;LH\n");
+			Assert::IsFalse(route.load_from_file(route_file.string(), parser));
+			write_route_file("dep=XXXX;LH\n");
+			Assert::IsFalse(route.load_from_file(route_file.string(), parser));
+			Assert::IsFalse(route.load_from_file((route_file.parent_path() / "navme-no-such-route.txt").string(), parser));
+
+			std::vector<FlightRouteFileEntry> entries = FlightRoute::split_route_file("dep = LHBP;LH\nno entry\n\nsid=BADO2B\n");
+			Assert::AreEqual(2, (int)entries.size());
+			Assert::AreEqual("LHBP", std::string(entries[0].first).c_str());
+			Assert::AreEqual(4, (int)entries[1].line);
+			Assert::IsTrue(entries[1].second.empty());
+			Assert::AreEqual(12, FlightRoute::get_route_point_index("route_12"));
+			Assert::AreEqual(-1, FlightRoute::get_route_point_index("route_"));
+			Assert::AreEqual(-1, FlightRoute::get_route_point_index("route_1x"));
+			Assert::AreEqual(-1, FlightRoute::get_route_point_index("dest"));
+		}
+	};
+}
@@ -0,0 +1,122 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestNavDataLayers)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+		std::filesystem::path overlay_path;
+
+		void write_overlay_fix(double lat)
+		{
+			std::filesystem::create_directories(overlay_path / "Custom Data");
+			std::ofstream o_str(overlay_path / "Custom Data" / "earth_fix.dat", std::ios::trunc);
+			o_str << "I\n1101 Version - user overlay\n\n";
+			o_str << " " << std::fixed << std::setprecision(9) << lat << "   19.384388889  BP701 LHBP LH 4464727 BP701\n";
+			o_str << "99\n";
+		}
+	public:
+		TEST_METHOD_INITIALIZE(TestNavDataLayersInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+			overlay_path = std::filesystem::temp_directory_path() / "navme-test-overlay";
+			std::filesystem::remove_all(overlay_path);
+		}
+
+		TEST_METHOD(TestOverlayPriority)
+		{
+			NavDataLayers layers;
+			Assert::IsTrue(layers.set_layer("base", nav_data_path.string(), 0));
+			Assert::AreEqual(47.388305556, layers.find_nav_points_by_icao_id("LH", "BP701")[0]->get_coordinate().lat.convert_to_double(), 0.001);
+
+			write_overlay_fix(47.5);
+			Assert::IsTrue(layers.set_layer("overlay", overlay_path.string(), 10));
+			Assert::AreEqual(2, (int)layers.get_layer_names().size());
+			Assert::AreEqual("overlay", layers.get_layer_names().front().c_str());
+
+			// the overlay hides the base fix, everything else comes from the base
+			std::vector<NavPointHandle> bp701 = layers.find_nav_points_by_icao_id("LH", "BP701");
+			Assert::AreEqual(1, (int)bp701.size());
+			Assert::AreEqual(47.5, bp701[0]->get_coordinate().lat.convert_to_double(), 0.001);
+			Assert::AreEqual(1, (int)layers.find_nav_points_by_icao_id("all", "PTB").size());
+			Assert::AreEqual("base", layers.get_airport_layer_name("LHBP").c_str());
+			Assert::IsTrue(layers.find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+			Assert::IsTrue(layers.find_rnav_procs_by_airport_icao_id("LOWI").size() > 0);
+
+			// replacing the overlay does not touch the base and the old handles stay valid
+			write_overlay_fix(47.6);
+			Assert::IsTrue(layers.set_layer("overlay", overlay_path.string(), 10));
+			Assert::AreEqual(2, (int)layers.get_layer_names().size());
+			Assert::AreEqual(47.6, layers.find_nav_points_by_icao_id("LH", "BP701")[0]->get_coordinate().lat.convert_to_double(), 0.001);
+			Assert::AreEqual(47.5, bp701[0]->get_coordinate().lat.convert_to_double(), 0.001);
+
+			Assert::IsTrue(layers.remove_layer("overlay"));
+			Assert::IsFalse(layers.remove_layer("overlay"));
+			Assert::AreEqual(47.388305556, layers.find_nav_points_by_icao_id("LH", "BP701")[0]->get_coordinate().lat.convert_to_double(), 0.001);
+
+			std::filesystem::remove_all(overlay_path);
+		}
+
+		TEST_METHOD(TestPartialLayers)
+		{
+			NavDataLayers layers;
+			Assert::IsTrue(layers.set_layer("base", nav_data_path.string(), 0));
+			std::size_t lhbp_runways = layers.find_airport_by_icao_id("LHBP")->get_runways().size();
+
+			// the ILS records of an earth_nav.dat only layer do not hide the airports below
+			std::filesystem::create_directories(overlay_path / "Custom Data");
+			std::filesystem::copy_file(nav_data_path / "Custom Data" / "earth_nav.dat", overlay_path / "Custom Data" / "earth_nav.dat");
+			Assert::IsTrue(layers.set_layer("ils", overlay_path.string(), 10));
+			Assert::AreEqual("base", layers.get_airport_layer_name("LHBP").c_str());
+			Assert::AreEqual(lhbp_runways, layers.find_airport_by_icao_id("LHBP")->get_runways().size());
+			Assert::IsTrue(layers.find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+			Assert::IsTrue(layers.remove_layer("ils"));
+			std::filesystem::remove_all(overlay_path);
+
+			// a CIFP only layer: the procedures come from it, their fixes from the base
+			std::filesystem::create_directories(overlay_path / "Custom Data" / "CIFP");
+			std::filesystem::copy_file(nav_data_path / "Custom Data" / "CIFP" / "LHBP.dat", overlay_path / "Custom Data" / "CIFP" / "LHBP.dat");
+			Assert::IsTrue(layers.set_layer("cifp", overlay_path.string(), 10));
+			RNAVProcHandle proc = layers.find_procedure_by_id("BADO2B", "LHBP");
+			Assert::IsTrue(proc != nullptr);
+			Assert::IsTrue(proc->get_leg_count() > 0);
+			for (std::size_t i = 0; i < proc->get_leg_count(); i++)
+				Assert::IsTrue(proc->get_leg(i).fix != NULL);
+			Assert::AreEqual("BADOV", proc->get_leg(proc->get_leg_count() - 1).fix->get_icao_id().c_str());
+
+			// LOWI has no CIFP file in the overlay: the base answers
+			Assert::IsTrue(layers.find_rnav_procs_by_airport_icao_id("LOWI").size() > 0);
+			Assert::IsTrue(layers.find_procedure_by_id("BREN3A", "LOWI") != nullptr);
+			Assert::IsTrue(layers.find_procedure_by_id("BREN3A", "LOWI") != nullptr);
+
+			std::filesystem::remove_all(overlay_path);
+		}
+
+		TEST_METHOD(TestDefaultDataFallback)
+		{
+			std::filesystem::create_directories(overlay_path / "Resources" / "default data");
+			std::filesystem::copy_file(nav_data_path / "Custom Data" / "earth_fix.dat", overlay_path / "Resources" / "default data" / "earth_fix.dat");
+
+			XPlaneParser parser(overlay_path.string());
+			Assert::IsTrue(parser.parse_earth_fix_dat_file());
+			Assert::AreEqual(1, (int)parser.find_nav_points_by_icao_id("LH", "BP701").size());
+
+			// Custom Data wins over the default data
+			write_overlay_fix(47.5);
+			XPlaneParser custom_parser(overlay_path.string());
+			Assert::IsTrue(custom_parser.parse_earth_fix_dat_file());
+			Assert::AreEqual(47.5, custom_parser.find_nav_points_by_icao_id("LH", "BP701")[0]->get_coordinate().lat.convert_to_double(), 0.001);
+
+			std::filesystem::remove_all(overlay_path);
+		}
+	};
+}
@@ -0,0 +1,125 @@
+#include <filesystem>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestNavDataSource)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+	public:
+		TEST_METHOD_INITIALIZE(TestNavDataSourceInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+		}
+
+		TEST_METHOD(TestXPlaneSourceMatchesParser)
+		{
+			XPlaneParser reference(nav_data_path.string());
+			reference.parse_earth_fix_dat_file();
+			reference.parse_earth_nav_dat_file();
+			reference.parse_apt_dat_file();
+
+			XPlaneNavDataSource source(nav_data_path.string(), true);
+			XPlaneParser parser(nav_data_path.string());
+			Assert::IsTrue(parser.load_nav_data_source(source));
+			Assert::IsTrue(source.get_bytes_read() > 0);
+
+			Assert::AreEqual(reference.get_nav_points().size(), parser.get_nav_points().size());
+			Assert::AreEqual((int)NavPoint::VOR_DME, (int)parser.find_nav_points_by_icao_id("LH", "PTB")[0]->get_radio_type());
+
+			const Airport* lhbp = parser.find_airport_by_icao_id("LHBP");
+			Assert::IsTrue(lhbp != NULL);
+			Assert::AreEqual("Budapest", lhbp->get_city().c_str());
+			Assert::AreEqual(4, (int)lhbp->get_runways().size());
+			Assert::AreEqual(reference.find_airport_by_icao_id("LHBP")->get_coordinate().lat.convert_to_double(), lhbp->get_coordinate().lat.convert_to_double(), 0.001);
+
+			// the procedures were streamed with the CIFP files
+			RNAVProcHandle bado2b = parser.find_procedure_by_id("BADO2B", "LHBP");
+			Assert::IsTrue(bado2b != nullptr);
+			Assert::AreEqual(6, (int)bado2b->get_nav_points().size());
+			Assert::AreEqual(reference.find_rnav_procs_by_airport_icao_id("LHBP").size(), parser.find_rnav_procs_by_airport_icao_id("LHBP").size());
+		}
+
+		TEST_METHOD(TestArinc424Source)
+		{
+			Arinc424NavDataSource source((nav_data_path / "ARINC424" / "navdata.dat").string());
+			XPlaneParser parser(nav_data_path.string());
+			Assert::IsTrue(parser.load_nav_data_source(source));
+			// the header and the continuation records are skipped, so are the final approach legs
+			Assert::AreEqual((std::size_t)13, source.get_record_count());
+
+			std::vector<const NavPoint*> ptb = parser.find_nav_points_by_icao_id("LH", "PTB");
+			Assert::AreEqual(1, (int)ptb.size());
+			Assert::AreEqual((int)NavPoint::VOR_DME, (int)ptb[0]->get_radio_type());
+			Assert::AreEqual(11710, ptb[0]->get_radio_frequency());
+			Assert::AreEqual("PUSZTASZABOLCS", ptb[0]->get_name().c_str());
+			Assert::AreEqual(47.152222222, ptb[0]->get_coordinate().lat.convert_to_double(), 0.001);
+			Assert::AreEqual(18.742222222, ptb[0]->get_coordinate().lng.convert_to_double(), 0.001);
+			Assert::AreEqual(5.0, ptb[0]->get_magnetic_variation().convert_to_double(), 0.001);
+
+			Assert::AreEqual((int)NavPoint::DME, (int)parser.find_nav_points_by_icao_id("LH", "BPL")[0]->get_radio_type());
+			Assert::AreEqual(348, parser.find_nav_points_by_icao_id("LH", "BR")[0]->get_radio_frequency());
+			Assert::AreEqual(19.384388889, parser.find_nav_points_by_icao_id("LH", "BP701")[0]->get_coordinate().lng.convert_to_double(), 0.001);
+
+			const Airport* lhbp = parser.find_airport_by_icao_id("LHBP");
+			Assert::IsTrue(lhbp != NULL);
+			Assert::AreEqual("BUD", lhbp->get_iata_id().c_str());
+			Assert::AreEqual("LH", lhbp->get_icao_region().c_str());
+			Assert::AreEqual(10000, lhbp->get_transition_alt());
+			Assert::AreEqual(47.439444444, lhbp->get_coordinate().lat.convert_to_double(), 0.001);
+
+			const Runway* rwy = lhbp->get_runway_by_name("13L");
+			Assert::IsTrue(rwy != NULL);
+			Assert::AreEqual(3706, rwy->get_length());
+			Assert::AreEqual(45, rwy->get_width());
+			Assert::AreEqual(131, rwy->get_course());
+			Assert::IsTrue(rwy->has_threshold());
+			Assert::AreEqual(47.445277778, rwy->get_threshold().lat.convert_to_double(), 0.001);
+			Assert::AreEqual(496, rwy->get_threshold_elevation());
+			Assert::AreEqual("IBPL", rwy->get_localizer_id().c_str());
+
+			// the procedures come from the source, not from the CIFP files
+			Assert::IsFalse(parser.is_airport_file_parsed("LHBP"));
+			RNAVProcHandle bado2b = parser.find_procedure_by_id("BADO2B", "LHBP");
+			Assert::IsTrue(bado2b != nullptr);
+			Assert::AreEqual(2, (int)bado2b->get_nav_points().size());
+			Assert::AreEqual("RW13L", bado2b->get_runway_name().c_str());
+			Assert::AreEqual("BADOV", bado2b->get_nav_points()[1].get_icao_id().c_str());
+			Assert::AreEqual(2, (int)bado2b->get_leg_count());
+			ProcedureLeg leg = bado2b->get_leg(0);
+			Assert::AreEqual((int)PATH_DF, (int)leg.path_terminator);
+			Assert::AreEqual("BUD", leg.recommended_navaid_id.c_str());
+			Assert::AreEqual((int)SPEED_AT_OR_BELOW, (int)leg.speed_constraint);
+			Assert::AreEqual(230, leg.speed_limit);
+			leg = bado2b->get_leg(1);
+			Assert::AreEqual((int)PATH_TF, (int)leg.path_terminator);
+			Assert::AreEqual("BADOV", leg.fix->get_icao_id().c_str());
+			Assert::AreEqual(114.0, leg.course, 0.001);
+			Assert::AreEqual(4.0, leg.distance, 0.001);
+			Assert::AreEqual((int)ALTITUDE_AT_OR_ABOVE, (int)leg.altitude_constraint);
+			Assert::AreEqual(14000, leg.altitude1);
+
+			RNAVProcHandle approach = parser.find_procedure_by_id("I13L-CATUZ", "LHBP");
+			Assert::IsTrue(approach != nullptr);
+			Assert::AreEqual(2, (int)approach->get_nav_points().size());
+			Assert::AreEqual(2, (int)parser.find_rnav_procs_by_airport_icao_id("LHBP").size());
+		}
+
+		TEST_METHOD(TestArinc424Coordinates)
+		{
+			double lat = 0;
+			double lng = 0;
+			Assert::IsTrue(Arinc424NavDataSource::decode_latitude("N47264352", lat));
+			Assert::AreEqual(47.0 + 26.0 / 60 + 43.52 / 3600, lat, 0.0000001);
+			Assert::IsTrue(Arinc424NavDataSource::decode_longitude("W122181234", lng));
+			Assert::AreEqual(-(122.0 + 18.0 / 60 + 12.34 / 3600), lng, 0.0000001);
+			Assert::IsFalse(Arinc424NavDataSource::decode_latitude("         ", lat));
+			Assert::IsFalse(Arinc424NavDataSource::decode_longitude("E01915A718", lng));
+		}
+	};
+}
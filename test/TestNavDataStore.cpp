@@ -0,0 +1,101 @@
+#include <thread>
+#include <atomic>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestNavDataStore)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+	public:
+		TEST_METHOD_INITIALIZE(TestNavDataStoreInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+		}
+
+		TEST_METHOD(TestLoadAndAcquire)
+		{
+			NavDataStore store(nav_data_path.string());
+			Assert::IsTrue(store.acquire() == nullptr);
+			Assert::IsTrue(store.load());
+			Assert::AreEqual(1, (int)store.get_generation());
+
+			NavDataSnapshot snapshot = store.acquire();
+			Assert::AreEqual(1, (int)snapshot->get_nav_points_by_icao_id("ABGOL").size());
+			Assert::IsTrue(snapshot->find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+			Assert::AreEqual(3, (int)snapshot->get_airway_graph().get_airway_count());
+
+			// the view loads the CIFP files on demand, e.g. the runways of LOWI
+			Assert::IsTrue(snapshot->prefetch_airport_file("LOWI"));
+			RunwayMatch match;
+			const Airport* lowi = snapshot->find_airport_by_icao_id("LOWI");
+			const Runway* runway = lowi->get_runway_by_name("26");
+			Assert::IsTrue(snapshot->get_runway_index()->find_runway_at(runway->get_threshold(), 260, match));
+			Assert::IsTrue(match.airport == lowi);
+		}
+
+		TEST_METHOD(TestHotReload)
+		{
+			NavDataStore store(nav_data_path.string());
+			Assert::IsTrue(store.load());
+			NavDataSnapshot old_snapshot = store.acquire();
+			const Airport* old_lhbp = old_snapshot->find_airport_by_icao_id("LHBP");
+
+			std::atomic<bool> stop_readers = false;
+			std::atomic<int> failed_reads = 0;
+			std::vector<std::thread> readers;
+			for (int i = 0; i < 4; i++)
+			{
+				readers.emplace_back([&]() {
+					while (!stop_readers)
+					{
+						NavDataSnapshot snapshot = store.acquire();
+						if (snapshot->find_procedure_by_id("I31R-ATICO", "LHBP") == nullptr || snapshot->get_nav_points_by_icao_id("PTB").size() != 1)
+							failed_reads++;
+					}
+				});
+			}
+
+			std::shared_future<bool> reload = store.reload_async();
+			Assert::IsTrue(reload.get());
+			stop_readers = true;
+			for (auto& reader : readers)
+				reader.join();
+
+			Assert::AreEqual(0, (int)failed_reads);
+			Assert::AreEqual(2, (int)store.get_generation());
+			Assert::IsTrue(store.acquire() != old_snapshot);
+
+			// the old snapshot is still complete while it is held
+			Assert::AreEqual("LHBP", old_lhbp->get_icao_id().c_str());
+			Assert::AreEqual(4, (int)old_lhbp->get_runways().size());
+		}
+
+		TEST_METHOD(TestConcurrentReloads)
+		{
+			NavDataStore store(nav_data_path.string());
+			std::atomic<int> failed_reloads = 0;
+			std::vector<std::thread> reloaders;
+			for (int i = 0; i < 3; i++)
+			{
+				reloaders.emplace_back([&]() {
+					if (!store.reload_async().get())
+						failed_reloads++;
+				});
+			}
+			for (auto& reloader : reloaders)
+				reloader.join();
+
+			Assert::AreEqual(0, (int)failed_reloads);
+			Assert::AreEqual(3, (int)store.get_generation());
+			// a reload left running is waited for by the destructor
+			store.reload_async();
+		}
+	};
+}
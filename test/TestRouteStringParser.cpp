@@ -0,0 +1,133 @@
+#include <filesystem>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestRouteStringParser)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+
+		void parse_nav_data(XPlaneParser& parser)
+		{
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+			parser.parse_earth_awy_dat_file();
+		}
+
+		static std::string enroute_ids(const FlightRoute& route)
+		{
+			std::string ids;
+			for (const NavPoint& nav_point : route.enroute_points)
+				ids += (ids.empty() ? "" : " ") + nav_point.get_icao_id();
+			return ids;
+		}
+
+		static void add_fix(XPlaneParser& parser, const std::string& icao_id, const std::string& region, double lat, double lng)
+		{
+			NavPointRecord record;
+			record.icao_id = icao_id;
+			record.icao_region = region;
+			record.lat = lat;
+			record.lng = lng;
+			parser.add_nav_point(record);
+		}
+	public:
+		TEST_METHOD_INITIALIZE(TestRouteStringParserInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+		}
+
+		TEST_METHOD(TestTokenize)
+		{
+			std::vector<std::string_view> tokens = RouteStringParser::tokenize("  LHBP/N0450F350 BADO2B  DCT BADOV M082F350 UL601\tBP702 K0830S1130 LOWI \n");
+			Assert::AreEqual(6, (int)tokens.size());
+			const char* expected[] = { "LHBP", "BADO2B", "BADOV", "UL601", "BP702", "LOWI" };
+			for (int i = 0; i < 6; i++)
+				Assert::AreEqual(expected[i], std::string(tokens[i]).c_str());
+
+			// an ident is not taken for a speed/level group
+			tokens = RouteStringParser::tokenize("MIKE1 N0450 NOVEMBER");
+			Assert::AreEqual(3, (int)tokens.size());
+			Assert::IsTrue(RouteStringParser::tokenize(" DCT  ").empty());
+		}
+
+		TEST_METHOD(TestParseRouteString)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			RouteStringParser route_parser(parser);
+			FlightRoute route("LHBP-LOWI");
+
+			// BADOV is the end of the SID, L601 goes PTB BP701 BP702
+			Assert::IsTrue(route_parser.parse("LHBP BADO2B BADOV DCT PTB L601 BP702 BREN3A LOWI", route));
+			Assert::AreEqual("LHBP", route.departure_airport.get_icao_id().c_str());
+			Assert::AreEqual("BADO2B", route.sid.get_name().c_str());
+			Assert::AreEqual("PTB BP701 BP702", enroute_ids(route).c_str());
+			Assert::AreEqual("BREN3A", route.star.get_name().c_str());
+			Assert::AreEqual("LOWI", route.destination_airport.get_icao_id().c_str());
+			Assert::IsTrue(route.enroute_points.front().get_radio_type() != NavPoint::NONE);
+
+			// the airway right after the SID, from its last fix
+			Assert::IsFalse(route_parser.parse("LHBP BADO2B UL601 BP701", route));
+			Assert::AreEqual("BP702 BP701", enroute_ids(route).c_str());
+			Assert::AreEqual(1, (int)route_parser.get_errors().size());
+			Assert::AreEqual((int)ROUTE_STRING_AGAINST_ONE_WAY, (int)route_parser.get_errors()[0].type);
+			Assert::AreEqual("UL601", route_parser.get_errors()[0].token.c_str());
+
+			// without airports the route is only the enroute part
+			Assert::IsTrue(route_parser.parse("BP701 UL601 BADOV", route));
+			Assert::AreEqual("BP701 BP702 BADOV", enroute_ids(route).c_str());
+			Assert::IsTrue(route.departure_airport.get_icao_id().empty());
+			Assert::IsTrue(route.sid.get_name().empty());
+		}
+
+		TEST_METHOD(TestRouteStringErrors)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			RouteStringParser route_parser(parser);
+			FlightRoute route("errors");
+
+			Assert::IsFalse(route_parser.parse("PTB XXXXX BP702 M999 BP865 L601", route));
+			const std::vector<RouteStringError>& errors = route_parser.get_errors();
+			Assert::AreEqual(3, (int)errors.size());
+			Assert::AreEqual((int)ROUTE_STRING_UNKNOWN_FIX, (int)errors[0].type);
+			Assert::AreEqual(1, (int)errors[0].token_index);
+			// BP702 is not on M999: direct to BP865
+			Assert::AreEqual((int)ROUTE_STRING_NOT_ON_AIRWAY, (int)errors[1].type);
+			Assert::AreEqual("M999", errors[1].token.c_str());
+			Assert::AreEqual((int)ROUTE_STRING_MISSING_FIX, (int)errors[2].type);
+			Assert::AreEqual(5, (int)errors[2].token_index);
+			Assert::AreEqual("PTB BP702 BP865", enroute_ids(route).c_str());
+		}
+
+		TEST_METHOD(TestDuplicateIdents)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			// the same idents near Innsbruck
+			add_fix(parser, "BP703", "LO", 47.3, 11.5);
+			add_fix(parser, "BP704", "LO", 47.2, 11.2);
+			RouteStringParser route_parser(parser);
+			FlightRoute route("duplicates");
+
+			Assert::IsTrue(route_parser.parse("LOWI BP703 LHBP", route));
+			Assert::AreEqual("LO", route.enroute_points[0].get_icao_region().c_str());
+			Assert::IsTrue(route_parser.parse("LHBP BP703 LOWI", route));
+			Assert::AreEqual("LH", route.enroute_points[0].get_icao_region().c_str());
+
+			// the fix of the following airway wins over the nearer one
+			Assert::IsTrue(route_parser.parse("LOWI BP704 M999 BP703 LHBP", route));
+			Assert::AreEqual("BP704 BP703", enroute_ids(route).c_str());
+			Assert::AreEqual("LH", route.enroute_points[0].get_icao_region().c_str());
+			Assert::AreEqual("LH", route.enroute_points[1].get_icao_region().c_str());
+		}
+	};
+}
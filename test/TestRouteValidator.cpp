@@ -0,0 +1,185 @@
+#include <filesystem>
+#include <fstream>
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestRouteValidator)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+
+		void parse_nav_data(XPlaneParser& parser)
+		{
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+			parser.parse_earth_awy_dat_file();
+		}
+
+		const std::string valid_route = "dep=LHBP;LH\ndest=LOWI;LO\nsid=BADO2B;LHBP\nstar=BREN3A;LOWI\napp=;\nroute_1=BP702;LH\nroute_0=PTB;LH\n";
+		const std::string broken_route = "dep=XXXX;LH\r\nsid=NOSID1;LHBP\r\n\r\nroute_0 = PTB;LH\r\nroute_1=NOFIX;LH\r\nroute_2=BADOV;LZ\r\n";
+	public:
+		TEST_METHOD_INITIALIZE(TestRouteValidatorInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+		}
+
+		TEST_METHOD(TestValidateRouteFileContents)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			RouteValidator validator(parser);
+			::Logger::get_and_clear_stored_messages();
+			std::vector<RouteValidationReport> reports = validator.validate_route_file_contents({ valid_route, broken_route });
+			Assert::AreEqual(2, (int)reports.size());
+			// the missing airport (and its missing CIFP file) is only in the report
+			Assert::AreEqual(0, (int)::Logger::number_of_stored_messages());
+
+			// the route points are placed by their index
+			Assert::IsTrue(reports[0].is_valid());
+			std::size_t sid_points = parser.find_procedure_by_id("BADO2B", "LHBP")->get_nav_points().size();
+			std::size_t star_points = parser.find_procedure_by_id("BREN3A", "LOWI")->get_nav_points().size();
+			Assert::AreEqual(2 + sid_points + 2 + star_points, reports[0].point_count);
+			Assert::IsTrue(reports[0].distance_km > 600);
+
+			const std::vector<RouteIssue>& issues = reports[1].issues;
+			Assert::AreEqual(3, (int)issues.size());
+			Assert::AreEqual((int)ROUTE_ISSUE_MISSING_AIRPORT, (int)issues[0].type);
+			Assert::AreEqual(1, (int)issues[0].position);
+			Assert::AreEqual("XXXX", issues[0].item.c_str());
+			Assert::AreEqual((int)ROUTE_ISSUE_MISSING_PROCEDURE, (int)issues[1].type);
+			Assert::AreEqual("NOSID1", issues[1].item.c_str());
+			Assert::AreEqual((int)ROUTE_ISSUE_MISSING_FIX, (int)issues[2].type);
+			Assert::AreEqual(5, (int)issues[2].position);
+			Assert::AreEqual("NOFIX", issues[2].item.c_str());
+			Assert::AreEqual(2, (int)reports[1].point_count);
+
+			// an entry without region is skipped, as FlightRoute::load_from_file skips it
+			Assert::IsTrue(validator.validate_route_file_contents({ valid_route + "route_2=NOFIX;\n" })[0].is_valid());
+
+			// the airports and procedures of a batch are looked up once, not per route
+			parser.enable_query_cache(16);
+			std::vector<RouteValidationReport> batch = validator.validate_route_file_contents(std::vector<std::string>(20, valid_route));
+			Assert::IsTrue(batch[19].is_valid());
+			QueryCacheStats stats = parser.get_query_cache_stats();
+			Assert::AreEqual(2, (int)(stats.procedures.hits + stats.procedures.misses));
+			Assert::AreEqual(2, (int)(stats.airports.hits + stats.airports.misses));
+		}
+
+		TEST_METHOD(TestDuplicateIdents)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			// the same ident in the region twice: near Seattle first, then near Budapest
+			NavPointRecord record;
+			record.icao_id = "TWICE";
+			record.icao_region = "LH";
+			record.lat = 47.5;
+			record.lng = -122.3;
+			parser.add_nav_point(record);
+			record.lat = 47.3;
+			record.lng = 19.4;
+			parser.add_nav_point(record);
+			Assert::AreEqual(2, (int)parser.find_nav_points_by_icao_id("LH", "TWICE").size());
+
+			// the validator chooses the one near the previous point: no long leg
+			RouteValidator validator(parser);
+			Assert::IsTrue(validator.validate_route_file_contents({ "route_0=PTB;LH\nroute_1=TWICE;LH\nroute_2=BP702;LH\n" })[0].is_valid());
+		}
+
+		TEST_METHOD(TestLongLegs)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			// a fix of the same ident, but near Seattle
+			NavPointRecord record;
+			record.icao_id = "FARAW";
+			record.icao_region = "K1";
+			record.lat = 47.5;
+			record.lng = -122.3;
+			parser.add_nav_point(record);
+
+			RouteValidator validator(parser);
+			std::vector<RouteValidationReport> reports = validator.validate_route_file_contents({ "route_0=PTB;LH\nroute_1=FARAW;K1\nroute_2=BP702;LH\n" });
+			const std::vector<RouteIssue>& issues = reports[0].issues;
+			Assert::AreEqual(2, (int)issues.size());
+			Assert::AreEqual((int)ROUTE_ISSUE_LONG_LEG, (int)issues[0].type);
+			Assert::AreEqual(0, (int)issues[0].position);
+			Assert::AreEqual("PTB-FARAW", issues[0].item.c_str());
+			Assert::IsTrue(issues[0].leg_km > 8000);
+			Assert::AreEqual("FARAW-BP702", issues[1].item.c_str());
+
+			RouteValidationOptions options;
+			options.max_leg_km = 20000;
+			RouteValidator tolerant_validator(parser, options);
+			Assert::IsTrue(tolerant_validator.validate_route_file_contents({ "route_0=PTB;LH\nroute_1=FARAW;K1\n" })[0].is_valid());
+		}
+
+		TEST_METHOD(TestValidateRouteFilesInParallel)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			std::filesystem::path folder = std::filesystem::temp_directory_path() / "navme-test-route-validator";
+			std::filesystem::create_directories(folder);
+
+			std::vector<std::string> file_names;
+			for (int i = 0; i < 40; i++)
+			{
+				file_names.push_back((folder / ("route_" + std::to_string(i) + ".txt")).string());
+				std::ofstream o_str(file_names.back(), std::ios::binary);
+				o_str << (i % 3 == 0 ? broken_route : valid_route);
+			}
+			file_names.push_back((folder / "no-such-route.txt").string());
+
+			RouteValidationOptions options;
+			options.thread_count = 4;
+			RouteValidator validator(parser, options);
+			std::vector<RouteValidationReport> reports = validator.validate_route_files(file_names);
+			Assert::AreEqual(file_names.size(), reports.size());
+			for (int i = 0; i < 40; i++)
+			{
+				Assert::AreEqual(file_names[i].c_str(), reports[i].source.c_str());
+				Assert::AreEqual(i % 3 == 0 ? 3 : 0, (int)reports[i].issues.size());
+			}
+			Assert::AreEqual((int)ROUTE_ISSUE_UNREADABLE, (int)reports.back().issues[0].type);
+
+			std::filesystem::remove_all(folder);
+		}
+
+		TEST_METHOD(TestValidateRouteStrings)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parse_nav_data(parser);
+			RouteValidator validator(parser);
+			std::vector<RouteValidationReport> reports = validator.validate_route_strings({ "LHBP BADO2B BADOV DCT PTB L601 BP702 BREN3A LOWI", "PTB XXXXX BP702 M999 BP865" });
+			Assert::IsTrue(reports[0].is_valid());
+			Assert::IsTrue(reports[0].point_count >= 5);
+
+			const std::vector<RouteIssue>& issues = reports[1].issues;
+			Assert::AreEqual(2, (int)issues.size());
+			Assert::AreEqual((int)ROUTE_ISSUE_MISSING_FIX, (int)issues[0].type);
+			Assert::AreEqual(1, (int)issues[0].position);
+			Assert::AreEqual((int)ROUTE_ISSUE_AIRWAY, (int)issues[1].type);
+			Assert::AreEqual("M999", issues[1].item.c_str());
+			Assert::AreEqual(3, (int)reports[1].point_count);
+
+			// the procedure-like tokens at an airport without CIFP file are not logged
+			AirportRecord record;
+			record.icao_id = "LHXX";
+			record.icao_region = "LH";
+			record.has_position = true;
+			record.lat = 47.4;
+			record.lng = 19.2;
+			parser.add_airport(record);
+			::Logger::get_and_clear_stored_messages();
+			reports = validator.validate_route_strings({ "LHXX BADO2B BADOV DCT PTB" });
+			Assert::AreEqual(0, (int)::Logger::number_of_stored_messages());
+		}
+	};
+}
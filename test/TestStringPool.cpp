@@ -0,0 +1,88 @@
+#include "CppUnitTest.h"
+#include "NavMeLib.h"
+#include "Logger.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace test
+{
+	TEST_CLASS(TestStringPool)
+	{
+	private:
+		std::filesystem::path nav_data_path;
+	public:
+		TEST_METHOD_INITIALIZE(TestStringPoolInit)
+		{
+			nav_data_path = std::filesystem::current_path();
+			nav_data_path /= "../../test/test-data";
+		}
+
+		TEST_METHOD(TestInternSameString)
+		{
+			StringPool pool;
+			InternedString s1 = pool.intern("ENRT");
+			InternedString s2 = pool.intern(std::string("EN") + "RT");
+			InternedString s3 = pool.intern("LHBP");
+
+			Assert::IsTrue(&s1.str() == &s2.str());
+			Assert::IsTrue(s1 == s2);
+			Assert::IsFalse(s1 == s3);
+			Assert::IsTrue(s1 == "ENRT");
+			Assert::AreEqual(2, (int)pool.size());
+			Assert::IsTrue(InternedString().empty());
+
+			// own copies are compared by content and copied with their string
+			InternedString own("ENRT");
+			Assert::IsTrue(own == s1);
+			Assert::IsTrue(&own.str() != &s1.str());
+			InternedString own_copy = own;
+			Assert::IsTrue(&own_copy.str() != &own.str());
+			Assert::IsTrue(&s1.detached().str() != &s1.str());
+			Assert::AreEqual(2, (int)pool.size());
+		}
+
+		TEST_METHOD(TestParserSharesStrings)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+
+			RNAVProcHandle proc_1 = parser.find_procedure_by_id("BADO2B", "LHBP");
+			RNAVProcHandle proc_2 = parser.find_procedure_by_id("BADO2J", "LHBP");
+			Assert::IsTrue(&proc_1->get_airport_icao_id() == &proc_2->get_airport_icao_id());
+			Assert::IsTrue(&proc_1->get_region() == &proc_2->get_region());
+
+			// the copies have their own strings
+			RNAVProc copy;
+			Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", copy));
+			Assert::IsTrue(&copy.get_airport_icao_id() != &proc_1->get_airport_icao_id());
+			Assert::AreEqual("LHBP", copy.get_airport_icao_id().c_str());
+		}
+
+		TEST_METHOD(TestCopiesOutliveParser)
+		{
+			RNAVProcHandle proc_handle;
+			RNAVProc proc;
+			Airport airport;
+			std::list<NavPoint> nav_points;
+			{
+				XPlaneParser parser(nav_data_path.string());
+				parser.parse_earth_fix_dat_file();
+				parser.parse_earth_nav_dat_file();
+				parser.parse_apt_dat_file();
+				Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", proc));
+				proc_handle = parser.find_procedure_by_id("BADO2B", "LHBP");
+				Assert::IsTrue(parser.get_airport_by_icao_id("LHBP", airport));
+				nav_points = parser.get_nav_points_by_icao_id("PTB");
+			}
+
+			// the copies have own strings, the procedure handles keep the pool of the destroyed parser
+			Assert::AreEqual("BADO2B", proc_handle->get_name().c_str());
+			Assert::AreEqual("BADOV", proc_handle->get_nav_points().back().get_icao_id().c_str());
+			Assert::AreEqual("BADO2B", proc.get_name().c_str());
+			Assert::AreEqual("LHBP", proc.get_airport_icao_id().c_str());
+			Assert::IsFalse(airport.get_name().empty());
+			Assert::IsFalse(nav_points.front().get_name().empty());
+		}
+	};
+}
@@ -1,5 +1,10 @@
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <map>
 #include "CppUnitTest.h"
 #include "NavMeLib.h"
 #include "XPlane-navdata-parser\XPlaneParser.h"
@@ -101,7 +106,7 @@ namespace test
 			Assert::AreEqual("LH", proc.get_region().c_str());
 			Assert::AreEqual("RW13L", proc.get_runway_name().c_str());
 			Assert::IsTrue(RNAVProc::RNAVProcType::RNAV_SID == proc.get_type());
-			std::vector<NavPoint> nav_ids = proc.get_nav_points();
+			const SharedNavPoints& nav_ids = proc.get_nav_points();
 			Assert::AreEqual(6, (int)nav_ids.size());
 
 			Assert::AreEqual("DE13L", nav_ids[0].get_icao_id().c_str());
@@ -112,6 +117,213 @@ namespace test
 			Assert::AreEqual("BADOV", nav_ids[5].get_icao_id().c_str());
 		}
 
+		TEST_METHOD(TestProcedureFixesShared)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+
+			// the legs with the same fix share one NavPoint, across the procedures and their copies
+			std::vector<RNAVProcHandle> procs = parser.find_rnav_procs_by_airport_icao_id("LHBP");
+			Assert::IsTrue(procs.size() > 1);
+			std::map<std::string, const NavPoint*> fixes;
+			int shared_count = 0;
+			for (const RNAVProcHandle& proc : procs)
+			{
+				for (const NavPoint& nav_point : proc->get_nav_points())
+				{
+					auto inserted = fixes.insert(std::make_pair(nav_point.get_icao_region() + " " + nav_point.get_icao_id(), &nav_point));
+					Assert::IsTrue(inserted.first->second == &nav_point);
+					shared_count += inserted.second ? 0 : 1;
+				}
+			}
+			Assert::IsTrue(shared_count > 0);
+
+			RNAVProc copy = *procs[0];
+			Assert::IsTrue(&copy.get_nav_points()[0] == &procs[0]->get_nav_points()[0]);
+		}
+
+		TEST_METHOD(TestProcedureLegs)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+
+			RNAVProc proc;
+			Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", proc));
+			Assert::AreEqual(6, (int)proc.get_leg_count());
+
+			ProcedureLeg leg = proc.get_leg(0);
+			Assert::AreEqual((int)PATH_DF, (int)leg.path_terminator);
+			Assert::IsTrue(leg.fix == &proc.get_nav_points()[0]);
+			Assert::AreEqual((int)ALTITUDE_NONE, (int)leg.altitude_constraint);
+
+			//SID:020,5,BADO2B,RW13L,BP701,LH,P,C,EY  , ,   ,CF, ,BUD,LH,D, ,      ,1191,0066,1140,0040, ,     ,     ,     ,-,230, ...
+			leg = proc.get_leg(1);
+			Assert::AreEqual("CF", ProcedureLeg::path_terminator_code(leg.path_terminator));
+			Assert::AreEqual("BP701", leg.fix->get_icao_id().c_str());
+			Assert::AreEqual("BUD", leg.recommended_navaid_id.c_str());
+			Assert::AreEqual("LH", leg.recommended_navaid_region.c_str());
+			Assert::AreEqual(114.0, leg.course, 0.001);
+			Assert::AreEqual(4.0, leg.distance, 0.001);
+			Assert::IsFalse(leg.distance_is_time);
+			Assert::AreEqual((int)SPEED_AT_OR_BELOW, (int)leg.speed_constraint);
+			Assert::AreEqual(230, leg.speed_limit);
+
+			//SID:060,5,BADO2B,RW13L,BADOV,LZ,E,A,EEC , ,   ,TF, ... ,+,FL140, ...
+			leg = proc.get_leg(5);
+			Assert::AreEqual((int)PATH_TF, (int)leg.path_terminator);
+			Assert::AreEqual((int)ALTITUDE_AT_OR_ABOVE, (int)leg.altitude_constraint);
+			Assert::AreEqual(14000, leg.altitude1);
+			Assert::AreEqual((int)SPEED_NONE, (int)leg.speed_constraint);
+			Assert::IsTrue(leg.recommended_navaid_id.empty());
+
+			// a leg without a fix keeps its details
+			ProcedureLeg heading_leg;
+			heading_leg.path_terminator = PATH_VA;
+			heading_leg.course = 131.5;
+			heading_leg.altitude_constraint = ALTITUDE_AT_OR_ABOVE;
+			heading_leg.altitude1 = 1000;
+			proc.add_leg(heading_leg);
+			Assert::AreEqual(6, (int)proc.get_nav_points().size());
+			leg = proc.get_leg(6);
+			Assert::IsTrue(leg.fix == NULL);
+			Assert::AreEqual(131.5, leg.course, 0.001);
+			Assert::AreEqual(1000, leg.altitude1);
+
+			bool is_time = false;
+			Assert::AreEqual(1.5, ProcedureLeg::parse_tenths("T015", is_time), 0.001);
+			Assert::IsTrue(is_time);
+			Assert::AreEqual((int)PATH_UNKNOWN, (int)ProcedureLeg::parse_path_terminator("XX"));
+			Assert::AreEqual((std::size_t)24, sizeof(EncodedProcedureLeg));
+		}
+
+		TEST_METHOD(TestProcedurePath)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+
+			std::shared_ptr<const ProcedurePath> path = parser.get_procedure_path("BADO2B", "LHBP");
+			Assert::IsTrue(path != nullptr);
+			Assert::IsTrue(parser.get_procedure_path("BADO2B", "LHBP") == path);
+			Assert::IsTrue(parser.get_procedure_path("NOPROC", "LHBP") == nullptr);
+
+			RNAVProcHandle proc = parser.find_procedure_by_id("BADO2B", "LHBP");
+			const std::vector<PathPoint>& points = path->get_points();
+			const std::vector<uint32_t>& fix_points = path->get_fix_point_indices();
+			Assert::AreEqual(6, (int)fix_points.size());
+			Assert::AreEqual(0, (int)fix_points[0]);
+			Assert::AreEqual((int)points.size() - 1, (int)fix_points[5]);
+			for (int i = 0; i < 6; i++)
+			{
+				const Coordinate& fix = proc->get_nav_points()[i].get_coordinate();
+				Assert::AreEqual(fix.lat.convert_to_double(), (double)points[fix_points[i]].lat, 0.0001);
+				Assert::AreEqual(fix.lng.convert_to_double(), (double)points[fix_points[i]].lng, 0.0001);
+			}
+
+			// densified: no step is longer than 1 NM (within the float precision of the points)
+			for (std::size_t i = 1; i < points.size(); i++)
+			{
+				RelativePos rel_pos;
+				Coordinate(points[i - 1].lat, points[i - 1].lng, 0).get_relative_pos_to(Coordinate(points[i].lat, points[i].lng, 0), rel_pos);
+				Assert::IsTrue(rel_pos.dist_ortho < 1.852 * 1.02);
+			}
+			Assert::IsTrue(points.size() > 10);
+			Assert::AreEqual(points.size() * sizeof(PathPoint), path->get_memory_bytes() - sizeof(ProcedurePath) - (fix_points.capacity() + 1) * sizeof(uint32_t));
+			Assert::AreEqual(1, (int)proc->get_transitions().size());
+			Assert::AreEqual("RW13L", proc->get_transitions()[0].name.str().c_str());
+			Assert::AreEqual(1, (int)path->get_polyline_starts().size());
+			Assert::AreEqual(0, (int)path->get_polyline_starts()[0]);
+
+			// two runway transitions: two polylines, no segment from the end of the first to the start of the second
+			RNAVProc two_transitions("BADO2X", "LH", RNAVProc::RNAV_SID);
+			two_transitions.start_transition(InternedString("RW13L"));
+			ProcedureLeg leg;
+			leg.path_terminator = PATH_TF;
+			two_transitions.add_leg(leg, std::make_shared<const NavPoint>(*parser.find_nav_points_by_icao_id("LH", "BP701").front()));
+			two_transitions.add_leg(leg, std::make_shared<const NavPoint>(*parser.find_nav_points_by_icao_id("LH", "BP702").front()));
+			two_transitions.start_transition(InternedString("RW31R"));
+			two_transitions.add_leg(leg, std::make_shared<const NavPoint>(*parser.find_nav_points_by_icao_id("LH", "BP704").front()));
+			two_transitions.add_leg(leg, std::make_shared<const NavPoint>(*parser.find_nav_points_by_icao_id("LH", "BP703").front()));
+			ProcedurePathBuilder builder;
+			std::shared_ptr<const ProcedurePath> split_path = builder.build(two_transitions);
+			const std::vector<uint32_t>& starts = split_path->get_polyline_starts();
+			Assert::AreEqual(2, (int)starts.size());
+			Assert::AreEqual(0, (int)starts[0]);
+			Assert::AreEqual((int)split_path->get_fix_point_indices()[2], (int)starts[1]);
+			Assert::AreEqual((int)split_path->get_fix_point_indices()[1] + 1, (int)starts[1]);
+
+			// BADO2J shares BP702..BADOV with BADO2B: those segments are not computed again
+			Assert::IsTrue(parser.get_procedure_path("BADO2J", "LHBP") != nullptr);
+			QueryCacheStats stats = parser.get_query_cache_stats();
+			Assert::AreEqual(1, (int)stats.procedure_paths.hits);
+			Assert::AreEqual(3, (int)stats.procedure_path_segments.hits);
+
+			// the great circle bends toward the pole
+			std::vector<PathPoint> arc = ProcedurePathBuilder::densify(Coordinate(47.0, -10.0, 0), Coordinate(47.0, 10.0, 0), 100);
+			Assert::AreEqual(47.0, (double)arc.front().lat, 0.0001);
+			Assert::IsTrue(arc[arc.size() / 2].lat > 47.3);
+		}
+
+		TEST_METHOD(TestQueryHandles)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+
+			const Airport* lhbp = parser.find_airport_by_icao_id("LHBP");
+			Assert::IsTrue(lhbp != NULL);
+			Assert::AreEqual("Budapest", lhbp->get_city().c_str());
+
+			RNAVProcHandle proc = parser.find_procedure_by_id("BADO2B", "LHBP");
+			Assert::IsTrue(proc != nullptr);
+			Assert::AreEqual(6, (int)proc->get_nav_points().size());
+			Assert::IsTrue(proc == parser.find_procedure_by_id("BADO2B", "LHBP"));
+			Assert::IsTrue(parser.find_procedure_by_id("NOPROC", "LHBP") == nullptr);
+
+			// lazy load of another airport doesn't move the already returned entities
+			Assert::IsTrue(parser.find_rnav_procs_by_airport_icao_id("LOWI").size() > 0);
+			Assert::IsTrue(lhbp == parser.find_airport_by_icao_id("LHBP"));
+
+			std::vector<RNAVProcHandle> procs = parser.find_rnav_procs_by_airport_icao_id("LHBP");
+			Assert::AreEqual((int)parser.get_rnav_procs_by_airport_icao_id("LHBP").size(), (int)procs.size());
+		}
+
+		TEST_METHOD(TestQueryCache)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+			parser.enable_query_cache(2);
+
+			RNAVProc proc;
+			Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", proc));
+			Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", proc));
+			Assert::AreEqual(6, (int)proc.get_nav_points().size());
+
+			QueryCacheStats stats = parser.get_query_cache_stats();
+			Assert::AreEqual(1, (int)stats.procedures.hits);
+			Assert::AreEqual(1, (int)stats.procedures.misses);
+
+			Airport apt;
+			parser.get_airport_by_icao_id("LHBP", apt);
+			parser.get_airport_by_icao_id("LOWI", apt);
+			parser.get_airport_by_icao_id("KSEA", apt);
+			parser.get_airport_by_icao_id("LHBP", apt);
+			stats = parser.get_query_cache_stats();
+			Assert::AreEqual(0, (int)stats.airports.hits);
+			Assert::AreEqual(2, (int)stats.airports.evictions);
+			Assert::AreEqual("LHBP", apt.get_icao_id().c_str());
+
+			// reloading a global file drops the cached results
+			parser.parse_apt_dat_file();
+			Assert::AreEqual(0, (int)parser.get_query_cache_stats().procedures.size);
+			Assert::AreEqual(3, (int)parser.get_rnav_procs_by_airport_icao_id("LOWI").size());
+		}
+
 		TEST_METHOD(TestProcudureApproach)
 		{
 			XPlaneParser parser(nav_data_path.string());
@@ -125,7 +337,7 @@ namespace test
 			Assert::AreEqual("LHBP", proc.get_airport_icao_id().c_str());
 			Assert::AreEqual("LH", proc.get_region().c_str());
 			Assert::IsTrue(RNAVProc::RNAVProcType::RNAV_APPROACH == proc.get_type());
-			std::vector<NavPoint> nav_ids = proc.get_nav_points();
+			const SharedNavPoints& nav_ids = proc.get_nav_points();
 			Assert::AreEqual(2, (int)nav_ids.size());
 
 			Assert::AreEqual("ATICO", nav_ids[0].get_icao_id().c_str());
@@ -146,6 +358,176 @@ namespace test
 			Assert::AreEqual(4, (int)rwys.size());
 		}
 
+		TEST_METHOD(TestAirportIlsRunwayUpdate)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+
+			Airport apt;
+			parser.get_airport_by_icao_id("LHBP", apt);
+			const Runway* rwy = apt.get_runway_by_name("13L");
+			Assert::IsTrue(rwy != NULL);
+			Assert::AreEqual(10915, rwy->get_ils_freq());
+			Assert::AreEqual(127, rwy->get_course());
+
+			// assigning again shall replace and not append the runways
+			parser.get_airport_by_icao_id("LHBP", apt);
+			Assert::AreEqual(4, (int)apt.get_runways().size());
+		}
+
+		TEST_METHOD(TestRunwayIndex)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_apt_dat_file();
+
+			//100 45.00 2 1 0.25 1 3 0 13L 47.4454256 19.2575439 0 60 3 2 1 0 31R 47.4229160 19.2939505 0 60 3 2 1 0
+			const Airport* lhbp = parser.find_airport_by_icao_id("LHBP");
+			const Runway* rwy_13l = lhbp->get_runway_by_name("13L");
+			Assert::IsTrue(rwy_13l->has_threshold());
+			Assert::AreEqual(47.4454256, rwy_13l->get_threshold().lat.convert_to_double(), 0.001);
+			Assert::IsTrue(rwy_13l->has_true_heading());
+			Assert::AreEqual(132.4, rwy_13l->get_true_heading(), 0.5);
+			Assert::AreEqual(312.4, lhbp->get_runway_by_name("31R")->get_true_heading(), 0.5);
+
+			// the CIFP RWY records add the threshold elevation and the localizer
+			//RWY:RW13L,     ,      ,00496, ,BPL ,2,   ;N47264352,E019152718,0000;
+			Assert::IsTrue(parser.find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+			Assert::AreEqual(496, rwy_13l->get_threshold_elevation());
+			Assert::AreEqual("BPL", rwy_13l->get_localizer_id().c_str());
+			Assert::AreEqual(47.445422, rwy_13l->get_threshold().lat.convert_to_double(), 0.001);
+
+			std::shared_ptr<const RunwayIndex> index = parser.get_runway_index();
+			Assert::IsTrue(index->size() > 4);
+
+			// the middle of 13L/31R, rolling toward 31R
+			double mid_lat = (47.4454256 + 47.4229160) / 2;
+			double mid_lng = (19.2575439 + 19.2939505) / 2;
+			RunwayMatch match;
+			Assert::IsTrue(index->find_runway_at(Coordinate(mid_lat, mid_lng, 0), 133, match));
+			Assert::AreEqual("LHBP", match.airport->get_icao_id().c_str());
+			Assert::AreEqual("13L", match.runway->get_name().c_str());
+			Assert::AreEqual(rwy_13l->get_length() / 2.0, match.along_track_m, 50);
+			Assert::AreEqual(0.0, match.cross_track_m, 20);
+			Assert::IsTrue(index->find_runway_at(Coordinate(mid_lat, mid_lng, 0), 310, match));
+			Assert::AreEqual("31R", match.runway->get_name().c_str());
+			// 13L and 13R are parallel: 300 m beside the centerline is on neither
+			Assert::IsFalse(index->find_runway_at(Coordinate(mid_lat + 0.002, mid_lng + 0.003, 0), 135, match));
+
+			// 2 NM final of 13L
+			double heading = rwy_13l->get_true_heading() * 3.14159265358979 / 180;
+			double final_lat = 47.445422 - 3704 * cos(heading) / 111195;
+			double final_lng = 19.257533 - 3704 * sin(heading) / (111195 * cos(47.445 * 3.14159265358979 / 180));
+			Assert::IsTrue(index->find_lined_up_runway(Coordinate(final_lat, final_lng, 0), 134, match));
+			Assert::AreEqual("13L", match.runway->get_name().c_str());
+			Assert::AreEqual(-3704.0, match.along_track_m, 50);
+			Assert::IsFalse(index->find_lined_up_runway(Coordinate(final_lat, final_lng, 0), 90, match));
+			Assert::IsFalse(index->find_lined_up_runway(Coordinate(final_lat, final_lng, 0), 134, match, 2000));
+			Assert::IsFalse(index->find_runway_at(Coordinate(final_lat, final_lng, 0), 134, match));
+		}
+
+		TEST_METHOD(TestCifpLoadKeepsPublishedAirports)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_apt_dat_file();
+
+			// the airport grid: LOWI is 600 km from LHBP, the whole earth has every airport
+			Assert::AreEqual(1, (int)parser.find_airports_within_distance(Coordinate(47.439444444, 19.261944444, 0), 550).size());
+			Assert::AreEqual(2, (int)parser.find_airports_within_distance(Coordinate(47.439444444, 19.261944444, 0), 650).size());
+			Assert::AreEqual((int)parser.get_list_of_airport_iaco_codes().size(), (int)parser.find_airports_within_distance(Coordinate(-47, -170, 0), 20100).size());
+
+			// handed out before the CIFP file is loaded
+			std::vector<const Airport*> nearby = parser.find_airports_within_distance(Coordinate(47.439444444, 19.261944444, 0), 5);
+			Assert::AreEqual(1, (int)nearby.size());
+			const Airport* apt_lhbp = nearby[0];
+			Assert::AreEqual("LHBP", apt_lhbp->get_icao_id().c_str());
+			std::size_t runway_count = apt_lhbp->get_runways().size();
+			std::shared_ptr<const RunwayIndex> old_index = parser.get_runway_index();
+
+			Assert::IsTrue(parser.prefetch_airport_file("LHBP"));
+			Assert::AreEqual(runway_count, apt_lhbp->get_runways().size());
+			Assert::IsTrue(apt_lhbp->get_runway_by_name("13L")->get_localizer_id().empty());
+
+			//RWY:RW13L,     ,      ,00496, ,BPL ,2,   ;N47264352,E019152718,0000;
+			const Airport* cifp_lhbp = parser.find_airport_by_icao_id("LHBP");
+			Assert::IsTrue(cifp_lhbp != apt_lhbp);
+			Assert::AreEqual("BPL", cifp_lhbp->get_runway_by_name("13L")->get_localizer_id().c_str());
+			Assert::AreEqual(496, cifp_lhbp->get_runway_by_name("13L")->get_threshold_elevation());
+			Assert::IsTrue(parser.find_airports_within_distance(Coordinate(47.439444444, 19.261944444, 0), 5)[0] == cifp_lhbp);
+			Airport copy;
+			Assert::IsTrue(parser.get_airport_by_icao_id("LHBP", copy));
+			Assert::AreEqual("BPL", copy.get_runway_by_name("13L")->get_localizer_id().c_str());
+
+			// the runway index of the earlier load keeps the old version, the next one has the new
+			RunwayMatch match;
+			Assert::IsTrue(old_index->find_runway_at(Coordinate(47.4341708, 19.2757472, 0), 133, match));
+			Assert::IsTrue(match.airport == apt_lhbp);
+			std::shared_ptr<const RunwayIndex> index = parser.get_runway_index();
+			Assert::AreEqual(old_index->size(), index->size());
+			Assert::IsTrue(index->find_runway_at(Coordinate(47.4341708, 19.2757472, 0), 133, match));
+			Assert::IsTrue(match.airport == cifp_lhbp);
+			Assert::IsTrue(parser.get_runway_index() == index);
+		}
+
+		TEST_METHOD(TestAirwayGraph)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			Assert::IsTrue(parser.parse_earth_awy_dat_file());
+			//NOFIX LH 11 BP704 LH 11 N 1  50 245 M999
+			Assert::AreEqual(1, (int)parser.get_unresolved_airway_segment_count());
+
+			const AirwayGraph& graph = parser.get_airway_graph();
+			Assert::AreEqual(3, (int)graph.get_airway_count());
+			Assert::AreEqual(9, (int)graph.get_node_count());
+			Assert::IsTrue(graph.get_memory_bytes() > graph.get_edge_count() * sizeof(AirwayEdge));
+			Assert::IsTrue(graph.find_airway("Z999") == AirwayGraph::NO_AIRWAY);
+
+			// BP701 BP702 is shared by L601 and UL601
+			uint32_t l601 = graph.find_airway("L601");
+			uint32_t ul601 = graph.find_airway("UL601");
+			std::vector<std::span<const uint32_t>> chains = graph.get_airway_chains(l601);
+			Assert::AreEqual(1, (int)chains.size());
+			Assert::AreEqual(3, (int)chains[0].size());
+			Assert::AreEqual("PTB", graph.get_nav_point(chains[0][0])->get_icao_id().c_str());
+			Assert::AreEqual("BP702", graph.get_nav_point(chains[0][2])->get_icao_id().c_str());
+			uint32_t bp701 = chains[0][1];
+			int airways_to_bp702 = 0;
+			for (const AirwayEdge& edge : graph.get_edges(bp701))
+			{
+				if (edge.to != chains[0][2])
+					continue;
+				airways_to_bp702++;
+				Assert::AreEqual((int)AIRWAY_HIGH, (int)edge.level);
+				Assert::AreEqual(245, (int)edge.base_fl);
+				Assert::AreEqual(660, (int)edge.top_fl);
+				Assert::IsTrue(edge.two_way == 1);
+			}
+			Assert::AreEqual(2, airways_to_bp702);
+
+			// the VHF and the NDB ends are resolved by their type
+			Assert::IsTrue(graph.get_nav_point(chains[0][0])->get_radio_type() != NavPoint::NDB);
+			uint32_t m999 = graph.find_airway("M999");
+			chains = graph.get_airway_chains(m999);
+			Assert::AreEqual(2, (int)chains.size());
+			Assert::AreEqual(3, (int)chains[0].size());
+			Assert::IsTrue(graph.get_nav_point(chains[0][2])->get_radio_type() == NavPoint::NDB);
+
+			// UL601 is one way to BADOV, M999 one way from BP865 to ATICO
+			chains = graph.get_airway_chains(ul601);
+			Assert::AreEqual(1, (int)chains.size());
+			Assert::AreEqual("BADOV", graph.get_nav_point(chains[0].back())->get_icao_id().c_str());
+			uint32_t badov = chains[0].back();
+			Assert::AreEqual(0, (int)graph.get_edges(badov).size());
+			uint32_t bp865 = graph.get_airway_chains(m999)[0][0];
+			Assert::AreEqual("BP865", graph.get_nav_point(bp865)->get_icao_id().c_str());
+			Assert::AreEqual(1, (int)graph.get_edges(bp865).size());
+			Assert::AreEqual("ATICO", graph.get_nav_point(graph.get_edges(bp865)[0].to)->get_icao_id().c_str());
+			Assert::IsTrue(graph.find_node(graph.get_nav_point(badov)) == badov);
+		}
+
 		TEST_METHOD(TestParseAptDatFile)
 		{
 			XPlaneParser parser(nav_data_path.string());
@@ -166,6 +548,480 @@ namespace test
 			Assert::AreEqual(4, (int)rws_list.size()); //31L, 13R, 31R, 13L
 		}
 
+		TEST_METHOD(TestPackedIcaoKeys)
+		{
+			constexpr IcaoIdKey lhbp("LHBP");
+			constexpr IcaoRegionKey lh("LH");
+			static_assert(lhbp == IcaoIdKey("LHBP"), "constexpr key");
+			static_assert(IcaoIdKey("ABGOL") < IcaoIdKey("ABGOM"), "key order");
+
+			Assert::IsFalse(lhbp == IcaoIdKey("LHBPX"));
+			Assert::IsTrue(IcaoIdKey("LONGIDENT").is_truncated());
+			Assert::IsFalse(IcaoRegionKey("all").is_packed());
+
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+
+			std::list<NavPoint> result = parser.get_nav_points_by_icao_id("LH", "PTB");
+			Assert::AreEqual(1, (int)result.size());
+			Assert::IsTrue(result.front().get_icao_id_key() == IcaoIdKey("PTB"));
+			Assert::IsTrue(result.front().get_icao_region_key() == lh);
+			Assert::AreEqual(0, (int)parser.get_nav_points_by_icao_id("LZ", "PTB").size());
+		}
+
+		TEST_METHOD(TestNavPointTable)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+
+			std::shared_ptr<const NavPointTable> snapshot = parser.get_nav_point_table();
+			const NavPointTable& table = *snapshot;
+			Assert::AreEqual((int)parser.get_nav_points().size(), (int)table.size());
+
+			// VORs within 200km of LHBP
+			Coordinate lhbp(47.439444444, 19.261944444, 0);
+			uint32_t vor_mask = NavPointTable::radio_type_mask(NavPoint::VOR) | NavPointTable::radio_type_mask(NavPoint::VOR_DME);
+			std::vector<std::size_t> rows = table.find_within_distance(lhbp, 200, vor_mask);
+			Assert::AreEqual(1, (int)rows.size());
+			Assert::AreEqual("PTB", table.get_nav_point(rows[0])->get_icao_id().c_str());
+
+			std::vector<std::size_t> rows_parallel = table.find_within_distance(lhbp, 200, vor_mask, 4);
+			Assert::IsTrue(rows == rows_parallel);
+
+			// NDBs on 436 kHz
+			rows = table.find_by_frequency(436, NavPointTable::radio_type_mask(NavPoint::NDB));
+			Assert::AreEqual(1, (int)rows.size());
+			Assert::AreEqual("SME", table.get_nav_point(rows[0])->get_icao_id().c_str());
+
+			// the table follows the parser incrementally
+			std::size_t rows_before = table.size();
+			parser.parse_earth_fix_dat_file();
+			Assert::AreEqual((int)parser.get_nav_points().size(), (int)parser.get_nav_point_table()->size());
+			Assert::IsTrue(parser.get_nav_point_table()->size() > rows_before);
+			// the held snapshot is not changed
+			Assert::AreEqual(rows_before, table.size());
+		}
+
+		TEST_METHOD(TestReloadChangedCifpFiles)
+		{
+			std::filesystem::path temp_root = std::filesystem::temp_directory_path() / "navme-test-cifp-reload";
+			std::filesystem::remove_all(temp_root);
+			std::filesystem::copy(nav_data_path, temp_root, std::filesystem::copy_options::recursive);
+			std::filesystem::path lhbp_file = temp_root / "Custom Data" / "CIFP" / "LHBP.dat";
+
+			std::string original_content;
+			{
+				std::ifstream i_str(lhbp_file, std::ios::binary);
+				std::ostringstream o_str;
+				o_str << i_str.rdbuf();
+				original_content = o_str.str();
+			}
+
+			{
+				XPlaneParser parser(temp_root.string());
+				parser.parse_earth_fix_dat_file();
+				parser.parse_apt_dat_file();
+
+				RNAVProcHandle old_proc = parser.find_procedure_by_id("BADO2B", "LHBP");
+				Assert::IsTrue(old_proc != nullptr);
+				std::shared_ptr<const ProcedurePath> old_path = parser.get_procedure_path("BADO2B", "LHBP");
+				Assert::IsTrue(parser.find_procedure_by_id("ADIL2J", "LOWI") != nullptr);
+				int lhbp_proc_count = (int)parser.get_rnav_procs_by_airport_icao_id("LHBP").size();
+				AirportHandle old_airport = parser.find_airport_handle_by_icao_id("LHBP");
+				std::weak_ptr<const Airport> old_airport_version = old_airport;
+				Assert::AreEqual(0, (int)parser.reload_changed_cifp_files().size());
+
+				// the same content written again is not reloaded
+				{
+					std::ofstream o_str(lhbp_file, std::ios::binary | std::ios::trunc);
+					o_str << original_content;
+				}
+				Assert::AreEqual(0, (int)parser.reload_changed_cifp_files().size());
+
+				{
+					std::ofstream o_str(lhbp_file, std::ios::binary | std::ios::app);
+					o_str << "SID:010,5,TEST1A,RW13L,BP701,LH,P,C,EY  , ,   ,DF, , , , , ,      ,    ,    ,    ,    , ,     ,     ,     , ,   ,    ,   , , , , , , , , ;\n";
+				}
+				std::list<std::string> reloaded = parser.reload_changed_cifp_files();
+				Assert::AreEqual(1, (int)reloaded.size());
+				Assert::AreEqual("LHBP", reloaded.front().c_str());
+				Assert::IsTrue(parser.find_procedure_by_id("TEST1A", "LHBP") != nullptr);
+				// the path of a reloaded procedure is computed again
+				Assert::IsTrue(parser.get_procedure_path("BADO2B", "LHBP") != old_path);
+				Assert::AreEqual(lhbp_proc_count + 1, (int)parser.get_rnav_procs_by_airport_icao_id("LHBP").size());
+
+				// the handle of the replaced procedure is still valid
+				Assert::AreEqual("BADO2B", old_proc->get_name().c_str());
+				Assert::AreEqual(6, (int)old_proc->get_nav_points().size());
+
+				// so is the handle of the replaced airport version, which is freed with its last handle
+				Assert::IsTrue(parser.find_airport_by_icao_id("LHBP") != old_airport.get());
+				Assert::AreEqual("BPL", old_airport->get_runway_by_name("13L")->get_localizer_id().c_str());
+				old_airport.reset();
+				Assert::IsTrue(old_airport_version.expired());
+
+				// the watcher picks up the next change
+				parser.start_cifp_watcher(std::chrono::milliseconds(10));
+				{
+					std::ofstream o_str(lhbp_file, std::ios::binary | std::ios::trunc);
+					o_str << original_content;
+				}
+				for (int i = 0; i < 200 && parser.find_procedure_by_id("TEST1A", "LHBP") != nullptr; i++)
+					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				parser.stop_cifp_watcher();
+				Assert::IsTrue(parser.find_procedure_by_id("TEST1A", "LHBP") == nullptr);
+				Assert::AreEqual(lhbp_proc_count, (int)parser.get_rnav_procs_by_airport_icao_id("LHBP").size());
+
+				// a file without runways leaves the airport with its apt.dat data
+				Assert::AreEqual("BPL", parser.find_airport_by_icao_id("LHBP")->get_runway_by_name("13L")->get_localizer_id().c_str());
+				{
+					std::istringstream i_str(original_content);
+					std::ofstream o_str(lhbp_file, std::ios::binary | std::ios::trunc);
+					std::string line;
+					while (std::getline(i_str, line))
+					{
+						if (line.compare(0, 4, "RWY:") != 0)
+							o_str << line << "\n";
+					}
+				}
+				Assert::AreEqual(1, (int)parser.reload_changed_cifp_files().size());
+				Assert::AreEqual(lhbp_proc_count, (int)parser.get_rnav_procs_by_airport_icao_id("LHBP").size());
+				Assert::IsTrue(parser.find_airport_by_icao_id("LHBP")->get_runway_by_name("13L")->get_localizer_id().empty());
+
+				// a removed file takes its runways along, the airport falls back to the apt.dat data
+				{
+					std::ofstream o_str(lhbp_file, std::ios::binary | std::ios::trunc);
+					o_str << original_content;
+				}
+				Assert::AreEqual(1, (int)parser.reload_changed_cifp_files().size());
+				Assert::AreEqual("BPL", parser.find_airport_by_icao_id("LHBP")->get_runway_by_name("13L")->get_localizer_id().c_str());
+				std::filesystem::remove(lhbp_file);
+				reloaded = parser.reload_changed_cifp_files();
+				Assert::AreEqual(1, (int)reloaded.size());
+				Assert::IsTrue(parser.get_rnav_procs_by_airport_icao_id("LHBP").empty());
+				const Airport* apt_lhbp = parser.find_airport_by_icao_id("LHBP");
+				Assert::IsTrue(apt_lhbp->get_runway_by_name("13L")->get_localizer_id().empty());
+				RunwayMatch match;
+				Assert::IsTrue(parser.get_runway_index()->find_runway_at(Coordinate(47.4341708, 19.2757472, 0), 133, match));
+				Assert::IsTrue(match.airport == apt_lhbp);
+			}
+
+			std::filesystem::remove_all(temp_root);
+		}
+
+		TEST_METHOD(TestIncrementalLoader)
+		{
+			XPlaneParser reference_parser(nav_data_path.string());
+			reference_parser.parse_earth_fix_dat_file();
+			reference_parser.parse_earth_nav_dat_file();
+			reference_parser.parse_apt_dat_file();
+
+			XPlaneParser parser(nav_data_path.string());
+			XPlaneIncrementalLoader loader(parser);
+			Assert::IsTrue(loader.get_total_bytes() > 0);
+
+			// lookups of another thread during the steps
+			std::atomic<bool> loading = true;
+			std::atomic<int> query_count = 0;
+			std::thread query_thread([&]() {
+				do
+				{
+					parser.find_nav_points_by_icao_id("LH", "PTB");
+					parser.get_nav_points_by_icao_id("BP702");
+					query_count++;
+				} while (loading);
+			});
+
+			int steps = 0;
+			double last_progress = 0;
+			bool fix_available_early = false;
+			while (loader.step(std::chrono::microseconds(0), 5) == LOAD_IN_PROGRESS)
+			{
+				steps++;
+				Assert::IsTrue(loader.get_progress() >= last_progress);
+				last_progress = loader.get_progress();
+
+				// the parsed part is queryable while the load is in progress
+				if (parser.find_nav_points_by_icao_id("LH", "BP701").size() == 1 && loader.get_progress() < 1.0)
+					fix_available_early = true;
+			}
+
+			loading = false;
+			query_thread.join();
+			Assert::IsTrue(query_count > 0);
+			Assert::IsTrue(loader.get_status() == LOAD_FINISHED);
+			Assert::IsTrue(steps > 3);
+			Assert::IsTrue(fix_available_early);
+			Assert::AreEqual(1.0, loader.get_progress());
+			Assert::AreEqual((int)reference_parser.get_nav_points().size(), (int)parser.get_nav_points().size());
+			Assert::AreEqual((int)parser.get_nav_points().size(), (int)parser.get_nav_point_table()->size());
+
+			const Airport* lhbp = parser.find_airport_by_icao_id("LHBP");
+			Assert::IsTrue(lhbp != NULL);
+			Assert::AreEqual((int)reference_parser.find_airport_by_icao_id("LHBP")->get_runways().size(), (int)lhbp->get_runways().size());
+			Assert::AreEqual(reference_parser.find_airport_by_icao_id("LHBP")->get_coordinate().lat.convert_to_double(), lhbp->get_coordinate().lat.convert_to_double(), 0.000001);
+
+			// a finished load does nothing more
+			Assert::IsTrue(loader.step(std::chrono::microseconds(1000)) == LOAD_FINISHED);
+		}
+
+		TEST_METHOD(TestIncrementalLoaderCancel)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			XPlaneIncrementalLoader loader(parser);
+			Assert::IsTrue(loader.step(std::chrono::microseconds(0), 10) == LOAD_IN_PROGRESS);
+			loader.cancel();
+			Assert::IsTrue(loader.step(std::chrono::microseconds(0), 10) == LOAD_CANCELLED);
+			Assert::IsTrue(loader.get_status() == LOAD_CANCELLED);
+			Assert::IsTrue(loader.get_progress() < 1.0);
+		}
+
+		TEST_METHOD(TestAsyncLoader)
+		{
+			XPlaneParser reference_parser(nav_data_path.string());
+			reference_parser.parse_earth_fix_dat_file();
+			reference_parser.parse_earth_nav_dat_file();
+			reference_parser.parse_apt_dat_file();
+
+			XPlaneParser parser(nav_data_path.string());
+			XPlaneAsyncLoader loader(parser);
+			std::atomic<int> callback_count = 0;
+			std::atomic<std::uintmax_t> last_parsed_bytes = 0;
+			AsyncLoadFutures futures = loader.start([&](std::uintmax_t parsed_bytes, std::uintmax_t) {
+				callback_count++;
+				last_parsed_bytes = parsed_bytes;
+			}, { "LHBP", "LOWI" });
+
+			Assert::IsTrue(futures.fix_loaded.get());
+			Assert::IsTrue(futures.nav_loaded.get());
+			Assert::IsTrue(futures.apt_loaded.get());
+			Assert::IsTrue(futures.cifp_loaded.get());
+			loader.wait();
+
+			Assert::IsTrue(callback_count >= 3);
+			Assert::AreEqual((int)loader.get_total_bytes(), (int)last_parsed_bytes);
+			Assert::AreEqual((int)reference_parser.get_nav_points().size(), (int)parser.get_nav_points().size());
+			Assert::AreEqual((int)parser.get_nav_points().size(), (int)parser.get_nav_point_table()->size());
+			Assert::AreEqual((int)reference_parser.find_airport_by_icao_id("LOWI")->get_runways().size(), (int)parser.find_airport_by_icao_id("LOWI")->get_runways().size());
+			Assert::IsTrue(parser.find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+		}
+
+		TEST_METHOD(TestAsyncLoaderConcurrentQueries)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			XPlaneAsyncLoader loader(parser);
+			AsyncLoadFutures futures = loader.start(nullptr, { "LHBP" });
+
+			// the queries of this thread run while the loader threads add the points and airports
+			int query_count = 0;
+			Airport airport;
+			do
+			{
+				parser.find_nav_points_by_icao_id("LH", "BP701");
+				parser.get_nav_points_by_icao_id("PTB");
+				parser.find_airports_within_distance(Coordinate(47.4, 19.2, 0), 50);
+				parser.get_airport_by_icao_id("LOWI", airport);
+				query_count++;
+			} while (futures.cifp_loaded.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready);
+			loader.wait();
+
+			Assert::IsTrue(futures.cifp_loaded.get());
+			Assert::IsTrue(query_count > 0);
+			Assert::AreEqual(1, (int)parser.find_nav_points_by_icao_id("LH", "BP701").size());
+			Assert::IsTrue(parser.get_airport_by_icao_id("LOWI", airport));
+			Assert::AreEqual("LOWI", airport.get_icao_id().c_str());
+		}
+
+		TEST_METHOD(TestAsyncLoaderCancel)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			XPlaneAsyncLoader loader(parser);
+			loader.cancel();
+			AsyncLoadFutures futures = loader.start(nullptr, { "LHBP" });
+			Assert::IsFalse(futures.apt_loaded.get());
+			Assert::IsFalse(futures.cifp_loaded.get());
+			loader.wait();
+
+			// missing files
+			XPlaneParser empty_parser((nav_data_path / "missing").string());
+			XPlaneAsyncLoader empty_loader(empty_parser);
+			futures = empty_loader.start();
+			Assert::IsFalse(futures.fix_loaded.get());
+			Assert::IsFalse(futures.apt_loaded.get());
+			Assert::IsTrue(futures.cifp_loaded.get());
+		}
+
+		TEST_METHOD(TestRegionFilteredLoad)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			NavDataLoadFilter filter;
+			filter.icao_regions.push_back(IcaoRegionKey("LH"));
+			parser.set_load_filter(filter);
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+
+			Assert::IsTrue(parser.get_nav_points().size() > 0);
+			for (auto& nav_point : parser.get_nav_points())
+				Assert::AreEqual("LH", nav_point.get_icao_region().c_str());
+
+			Assert::AreEqual(1, (int)parser.get_nav_points_by_icao_id("PTB").size());
+			Assert::IsTrue(parser.find_airport_by_icao_id("LHBP") != NULL);
+			Assert::AreEqual(4, (int)parser.find_airport_by_icao_id("LHBP")->get_runways().size());
+			Assert::IsTrue(parser.find_airport_by_icao_id("KSEA") == NULL);
+			Assert::IsTrue(parser.find_airport_by_icao_id("LOWI") == NULL);
+		}
+
+		TEST_METHOD(TestBoundingBoxFilteredLoad)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			NavDataLoadFilter filter;
+			filter.use_bounding_box = true;
+			filter.min_lat = 46.5;
+			filter.max_lat = 48.0;
+			filter.min_lng = 10.5;
+			filter.max_lng = 12.0;
+			parser.set_load_filter(filter);
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+
+			for (auto& nav_point : parser.get_nav_points())
+			{
+				Assert::IsTrue(nav_point.get_coordinate().lat.convert_to_double() >= 46.5);
+				Assert::IsTrue(nav_point.get_coordinate().lng.convert_to_double() <= 12.0);
+			}
+			Assert::AreEqual(0, (int)parser.get_nav_points_by_icao_id("PTB").size());
+
+			const Airport* lowi = parser.find_airport_by_icao_id("LOWI");
+			Assert::IsTrue(lowi != NULL);
+			Assert::AreEqual("Innsbruck", lowi->get_city().c_str());
+			Assert::AreEqual(11000, lowi->get_transition_alt());
+			Assert::IsTrue(parser.find_airport_by_icao_id("LHBP") == NULL);
+		}
+
+		TEST_METHOD(TestShardedNavData)
+		{
+			std::filesystem::path tiles_root = std::filesystem::temp_directory_path() / "navme-test-tiles";
+			std::filesystem::remove_all(tiles_root);
+
+			XPlaneTileBuilder builder(nav_data_path.string(), tiles_root.string(), 5);
+			Assert::IsTrue(builder.build());
+			Assert::AreEqual("+45+015", XPlaneShardedNavData::tile_name(XPlaneShardedNavData::tile_index_of(47.43, 19.26, 5), 5).c_str());
+			Assert::IsTrue(std::filesystem::exists(tiles_root / "+45+015" / "Custom Data" / "earth_fix.dat"));
+
+			{
+				XPlaneShardedNavData sharded(tiles_root.string(), nav_data_path.string());
+				Assert::IsTrue(sharded.open());
+				Assert::AreEqual(0, (int)sharded.get_loaded_tile_count());
+
+				// ID lookups load the tile of the ID only
+				AirportHandle lowi = sharded.find_airport_by_icao_id("LOWI");
+				Assert::IsTrue(lowi != nullptr);
+				Assert::AreEqual(1, (int)sharded.get_loaded_tile_count());
+				Assert::IsTrue(sharded.find_airport_by_icao_id("XXXX") == nullptr);
+				std::vector<NavPointHandle> ptb = sharded.find_nav_points_by_icao_id("all", "PTB");
+				Assert::AreEqual(1, (int)ptb.size());
+				Assert::AreEqual(2, (int)sharded.get_loaded_tile_count());
+
+				// the position loads the tiles around the aircraft, the cap drops the old ones
+				sharded.set_memory_cap(1);
+				Assert::AreEqual(0, (int)sharded.get_loaded_tile_count());
+				sharded.set_position(Coordinate(47.43, 19.26, 0), 20);
+				Assert::AreEqual(1, (int)sharded.get_loaded_tile_count());
+				Assert::IsTrue(sharded.find_nav_points_within_distance(Coordinate(47.43, 19.26, 0), 100).size() > 0);
+
+				AirportHandle lhbp = sharded.find_airport_by_icao_id("LHBP");
+				Assert::IsTrue(lhbp != nullptr);
+				Assert::AreEqual(4, (int)lhbp->get_runways().size());
+				Assert::IsTrue(sharded.find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+				Assert::AreEqual(1, (int)sharded.get_loaded_tile_count());
+
+				// the handles keep their dropped tile alive, a reload reuses it
+				Assert::AreEqual("PTB", ptb[0]->get_icao_id().c_str());
+				Assert::AreEqual("Innsbruck", lowi->get_city().c_str());
+				Assert::IsTrue(sharded.get_retained_bytes() > 0);
+				Assert::IsTrue(sharded.find_nav_points_by_icao_id("all", "PTB")[0].get() == ptb[0].get());
+			}
+
+			// 1 degree tiles: BADOV is in the tile north of LHBP, the margin of the LHBP tile has it
+			std::filesystem::remove_all(tiles_root);
+			XPlaneTileBuilder small_builder(nav_data_path.string(), tiles_root.string(), 1);
+			Assert::IsTrue(small_builder.build());
+			Assert::AreNotEqual(XPlaneShardedNavData::tile_index_of(47.43, 19.26, 1), XPlaneShardedNavData::tile_index_of(48.02, 18.81, 1));
+			{
+				XPlaneParser parser(nav_data_path.string());
+				parser.parse_earth_fix_dat_file();
+				parser.parse_earth_nav_dat_file();
+				parser.parse_apt_dat_file();
+				RNAVProc expected;
+				Assert::IsTrue(parser.get_procedure_by_id("BADO2B", "LHBP", expected));
+
+				XPlaneShardedNavData sharded(tiles_root.string(), nav_data_path.string());
+				Assert::IsTrue(sharded.open());
+				RNAVProcHandle proc = sharded.find_procedure_by_id("BADO2B", "LHBP");
+				Assert::IsTrue(proc != nullptr);
+				Assert::AreEqual((int)expected.get_leg_count(), (int)proc->get_leg_count());
+				Assert::IsTrue(proc->get_leg_count() > 0);
+				bool badov_found = false;
+				for (std::size_t i = 0; i < proc->get_leg_count(); i++)
+				{
+					ProcedureLeg leg = proc->get_leg(i);
+					Assert::IsTrue(leg.fix != NULL);
+					Assert::AreEqual(expected.get_leg(i).fix->get_icao_id().c_str(), leg.fix->get_icao_id().c_str());
+					badov_found |= (leg.fix->get_icao_id() == "BADOV");
+				}
+				Assert::IsTrue(badov_found);
+
+				// the margin copies are not returned
+				Assert::AreEqual(1, (int)sharded.find_nav_points_by_icao_id("LZ", "BADOV").size());
+				Coordinate center(47.9, 19.0, 0);
+				Assert::AreEqual((int)parser.get_nav_point_table()->find_within_distance(center, 100).size(),
+					(int)sharded.find_nav_points_within_distance(center, 100).size());
+			}
+
+			std::filesystem::remove_all(tiles_root);
+		}
+
+		TEST_METHOD(TestCifpPrefetcher)
+		{
+			XPlaneParser parser(nav_data_path.string());
+			parser.parse_earth_fix_dat_file();
+			parser.parse_earth_nav_dat_file();
+			parser.parse_apt_dat_file();
+
+			Coordinate lhbp_position(47.439444444, 19.261944444, 0);
+			CifpPrefetchOptions options;
+			options.lookahead_km = 700;
+			options.corridor_half_width_km = 100;
+			CifpPrefetcher prefetcher(parser, options);
+
+			// LOWI is ahead on a westbound track only
+			std::vector<std::string> predicted = prefetcher.predict_airports(lhbp_position, 270);
+			Assert::AreEqual(2, (int)predicted.size());
+			Assert::AreEqual("LHBP", predicted[0].c_str());
+			Assert::AreEqual("LOWI", predicted[1].c_str());
+			Assert::AreEqual(1, (int)prefetcher.predict_airports(lhbp_position, 90).size());
+
+			prefetcher.update_position(lhbp_position, 90);
+			prefetcher.wait_idle();
+			Assert::IsTrue(parser.is_airport_file_parsed("LHBP"));
+			Assert::IsFalse(parser.is_airport_file_parsed("LOWI"));
+			Assert::AreEqual(1, (int)prefetcher.get_prefetched_files());
+
+			prefetcher.request_airports({ "LOWI", "KSEA" });
+			prefetcher.wait_idle();
+			Assert::IsTrue(parser.is_airport_file_parsed("LOWI"));
+			Assert::IsTrue(parser.is_airport_file_parsed("KSEA"));
+			Assert::AreEqual(3, (int)prefetcher.get_prefetched_files());
+
+			// the prefetched procedures are served by the normal queries
+			Assert::IsTrue(parser.find_procedure_by_id("BADO2B", "LHBP") != nullptr);
+			Assert::IsTrue(parser.find_procedure_by_id("ADIL2J", "LOWI") != nullptr);
+		}
+
 		TEST_METHOD_CLEANUP(TestXPlaneParserCleanup)
 		{
 